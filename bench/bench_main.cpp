@@ -0,0 +1,285 @@
+// logforge_bench: benchmarks por estágio do pipeline (leitura, parse, agregação, finalize,
+// writers), em ns/linha, MB/s e alocações/linha. Com --json, salva os resultados para o
+// scripts/bench_compare.py comparar com uma linha de base.
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef LOGFORGE_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "harness.hpp"
+#include "logforge/aggregator.hpp"
+#include "logforge/async_reader.hpp"
+#include "logforge/buffered_reader.hpp"
+#include "logforge/compressed_reader.hpp"
+#include "logforge/mmap_reader.hpp"
+#include "logforge/parser_nginx.hpp"
+#include "logforge/report_writer.hpp"
+
+namespace fs = std::filesystem;
+using logforge::bench::keep;
+using logforge::bench::Suite;
+
+static std::string arg_value(const std::vector<std::string>& args, const std::string& key,
+                             const std::string& def = "") {
+  for (std::size_t i = 0; i + 1 < args.size(); ++i) {
+    if (args[i] == key) return args[i + 1];
+  }
+  return def;
+}
+
+static int arg_int(const std::vector<std::string>& args, const std::string& key, int def) {
+  auto v = arg_value(args, key, "");
+  if (v.empty()) return def;
+  try { return std::stoi(v); } catch (...) { return def; }
+}
+
+static void usage() {
+  std::cout << "Uso: logforge_bench [--lines N] [--reps R] [--filter <substring>] [--log <arquivo>]\n"
+            << "                    [--json <resultados.json>]\n\n"
+            << "  --lines   linhas sintéticas por benchmark (padrão: 200000)\n"
+            << "  --reps    repetições medidas, depois de uma de aquecimento (padrão: 7)\n"
+            << "  --filter  só os benchmarks cujo nome contém a substring (ex.: parse/)\n"
+            << "  --log     usa as primeiras --lines linhas de um log real nos estágios \"limpos\"\n"
+            << "  --json    salva os resultados (compare com scripts/bench_compare.py)\n";
+}
+
+// Linhas no formato do gen_synth_log.py. `endpoints` distintos; `ua_len` > 0 alonga o
+// user agent e a querystring (linhas longas).
+static std::vector<std::string> synth_lines(std::size_t n, int endpoints, std::size_t ua_len, unsigned seed) {
+  static const char* kNames[] = {"/api/items", "/api/checkout", "/health", "/login", "/static/app.js", "/search"};
+  static const int kStatus[] = {200, 200, 200, 200, 404, 500, 502};
+  std::mt19937 rng(seed);
+  std::vector<std::string> lines;
+  lines.reserve(n);
+  const std::string long_ua = ua_len ? "Mozilla/5.0 " + std::string(ua_len, 'x') : std::string();
+  for (std::size_t i = 0; i < n; ++i) {
+    const std::size_t sec = i / 4;
+    char ts[32];
+    std::snprintf(ts, sizeof(ts), "%02d/Jan/2025:%02zu:%02zu:%02zu -0300", 1 + static_cast<int>(sec / 86400 % 28),
+                  sec / 3600 % 24, sec / 60 % 60, sec % 60);
+    std::string ep = endpoints <= 6 ? kNames[rng() % static_cast<unsigned>(endpoints)]
+                                    : "/api/items/" + std::to_string(rng() % static_cast<unsigned>(endpoints));
+    if (rng() % 10 < 3) ep += "?q=" + std::to_string(rng() % 999);
+    if (ua_len) ep += "&pad=" + std::string(ua_len / 2, 'q');
+    std::string line = "10.0." + std::to_string(rng() % 256) + "." + std::to_string(rng() % 256) + " - - [" + ts +
+                       "] \"" + (rng() % 100 < 85 ? "GET " : "POST ") + ep + " HTTP/1.1\" " +
+                       std::to_string(kStatus[rng() % 7]) + " " + std::to_string(10 + rng() % 5000) + " \"-\" \"" +
+                       (ua_len ? long_ua : std::string("curl/8.0")) + "\" 0." + std::to_string(100 + rng() % 900);
+    lines.push_back(std::move(line));
+  }
+  return lines;
+}
+
+// Linhas recusadas pelo parser em pontos diferentes: cortadas, lixo, status e request inválidos.
+static std::vector<std::string> malformed_lines(const std::vector<std::string>& clean, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::vector<std::string> out;
+  out.reserve(clean.size());
+  for (std::size_t i = 0; i < clean.size(); ++i) {
+    std::string l = clean[i];
+    switch (i % 4) {
+      case 0: l.resize(rng() % l.size()); break;
+      case 1: l = "GARBAGE " + std::to_string(rng()) + " not a log line at all"; break;
+      case 2: {
+        const auto q = l.find("\" ");
+        if (q != std::string::npos) l.replace(q + 2, 3, "abc");
+        break;
+      }
+      default: {
+        const auto q = l.find('"');
+        if (q != std::string::npos) l.erase(q, 1);
+      }
+    }
+    out.push_back(std::move(l));
+  }
+  return out;
+}
+
+static std::uint64_t total_bytes(const std::vector<std::string>& lines) {
+  std::uint64_t n = 0;
+  for (const auto& l : lines) n += l.size() + 1;
+  return n;
+}
+
+static std::vector<logforge::LogEntry> parse_all(const std::vector<std::string>& lines) {
+  const logforge::NginxParser parser;
+  std::vector<logforge::LogEntry> out;
+  out.reserve(lines.size());
+  for (const auto& l : lines) {
+    if (auto e = parser.parse_line(l)) out.push_back(*e);
+  }
+  return out;
+}
+
+static std::uint64_t dir_bytes(const fs::path& dir) {
+  std::uint64_t n = 0;
+  for (const auto& f : fs::directory_iterator(dir)) n += f.is_regular_file() ? f.file_size() : 0;
+  return n;
+}
+
+int main(int argc, char** argv) {
+  std::vector<std::string> args(argv + 1, argv + argc);
+  for (const auto& a : args) {
+    if (a == "--help" || a == "-h") {
+      usage();
+      return 0;
+    }
+  }
+  const auto n = static_cast<std::size_t>(std::max(1000, arg_int(args, "--lines", 200000)));
+  logforge::bench::Options opt;
+  opt.reps = std::max(1, arg_int(args, "--reps", 7));
+  opt.filter = arg_value(args, "--filter");
+  const std::string log_path = arg_value(args, "--log");
+  const std::string json_path = arg_value(args, "--json");
+
+  std::vector<std::string> clean;
+  if (!log_path.empty()) {
+    logforge::BufferedLineReader reader(log_path);
+    if (!reader.ok()) {
+      std::cerr << "Erro: não foi possível abrir: " << log_path << "\n";
+      return 2;
+    }
+    std::string line;
+    while (clean.size() < n && reader.next_line(line)) clean.push_back(line);
+  } else {
+    clean = synth_lines(n, 6, 0, 1);
+  }
+  const auto high_card = synth_lines(n, 100000, 0, 2);
+  const auto malformed = malformed_lines(clean, 3);
+  const auto long_lines = synth_lines(n / 10, 6, 2048, 4);
+  const std::uint64_t clean_bytes = total_bytes(clean);
+
+  const fs::path tmp = fs::temp_directory_path() / "logforge_bench";
+  fs::create_directories(tmp);
+  const std::string plain_path = (tmp / "clean.log").string();
+  {
+    std::ofstream ofs(plain_path, std::ios::binary);
+    for (const auto& l : clean) ofs << l << '\n';
+  }
+
+  Suite suite(opt);
+  Suite::print_header(std::cout);
+
+  // --- leitura ---
+  auto read_all = [&](logforge::LineSource& src) {
+    std::string_view line;
+    std::uint64_t sum = 0;
+    while (src.next_line(line)) sum += line.size();
+    keep(sum);
+  };
+  suite.run("read/buffered", clean.size(), clean_bytes, [&] {
+    logforge::BufferedLineReader r(plain_path);
+    read_all(r);
+  });
+  suite.run("read/mmap", clean.size(), clean_bytes, [&] {
+    logforge::MmapLineReader r(plain_path);
+    read_all(r);
+  });
+  suite.run("read/uring", clean.size(), clean_bytes, [&] {
+    logforge::AsyncLineReader r(plain_path);
+    read_all(r);
+  });
+#ifdef LOGFORGE_HAVE_ZLIB
+  const std::string gz_path = (tmp / "clean.log.gz").string();
+  if (gzFile gz = gzopen(gz_path.c_str(), "wb6")) {
+    for (const auto& l : clean) {
+      gzwrite(gz, l.data(), static_cast<unsigned>(l.size()));
+      gzputc(gz, '\n');
+    }
+    gzclose(gz);
+    suite.run("read/gzip", clean.size(), clean_bytes, [&] {
+      logforge::CompressedLineReader r(logforge::open_decoder(gz_path, logforge::Compression::Gzip));
+      read_all(r);
+    });
+  }
+#endif
+
+  // --- parse ---
+  const logforge::NginxParser parser;
+  auto parse_bench = [&](const std::string& name, const std::vector<std::string>& lines) {
+    suite.run(name, lines.size(), total_bytes(lines), [&] {
+      std::uint64_t ok = 0;
+      for (const auto& l : lines) {
+        if (auto e = parser.parse_line(l)) ok += static_cast<std::uint64_t>(e->status);
+      }
+      keep(ok);
+    });
+  };
+  parse_bench("parse/clean", clean);
+  parse_bench("parse/malformed", malformed);
+  parse_bench("parse/long", long_lines);
+
+  // --- agregação ---
+  const auto low_rows = parse_all(clean);
+  const auto high_rows = parse_all(high_card);
+  std::unique_ptr<logforge::Aggregator> agg;
+  auto aggregate_bench = [&](const std::string& name, const std::vector<logforge::LogEntry>& rows,
+                             std::uint64_t bytes) {
+    suite.run(
+        name, rows.size(), bytes, [&] { agg = std::make_unique<logforge::Aggregator>(); },
+        [&] {
+          for (const auto& e : rows) agg->add_valid(e);
+        });
+  };
+  aggregate_bench("aggregate/low_card", low_rows, clean_bytes);
+  aggregate_bench("aggregate/high_card", high_rows, total_bytes(high_card));
+
+  // --- finalize e writers (sobre o estado de alta cardinalidade: o caso caro) ---
+  logforge::Aggregator filled;
+  for (const auto& e : high_rows) filled.add_valid(e);
+  logforge::Aggregator filled_low;
+  for (const auto& e : low_rows) filled_low.add_valid(e);
+  suite.run("finalize/low_card", low_rows.size(), 0, [&] { keep(filled_low.finalize().total_lines); });
+  suite.run("finalize/high_card", high_rows.size(), 0, [&] { keep(filled.finalize().total_lines); });
+
+  const auto report = filled.finalize();
+  const auto view = logforge::make_report_view(report, filled.top_n());
+  const fs::path json_dir = tmp / "json", csv_dir = tmp / "csv";
+  fs::create_directories(json_dir);
+  fs::create_directories(csv_dir);
+  auto write_bench = [&](const std::string& name, const fs::path& dir, auto write) {
+    if (!suite.selected(name)) return;
+    if (!write(dir.string())) {
+      std::cerr << "Erro: falhou ao escrever em " << dir << "\n";
+      return;
+    }
+    suite.run(name, high_rows.size(), dir_bytes(dir), [&] { keep(write(dir.string()) ? 1 : 0); });
+  };
+  write_bench("write/json", json_dir,
+              [&](const std::string& dir) { return logforge::write_report_json(report, view, dir); });
+  write_bench("write/csv", csv_dir,
+              [&](const std::string& dir) { return logforge::write_report_csv(report, view, dir); });
+
+  std::error_code ec;
+  fs::remove_all(tmp, ec);
+
+  std::cout << "\nitens = linhas de entrada (" << n << " por estágio; parse/long: " << long_lines.size()
+            << "); MB/s da entrada, ou da saída nos write/*\n";
+
+  if (!json_path.empty()) {
+    std::ostringstream meta;
+    meta << "{\"lines\": " << n << ", \"log\": \"" << (log_path.empty() ? "synthetic" : "file")
+         << "\", \"compiler\": \"" << __VERSION__ << "\", \"build\": \""
+#ifdef NDEBUG
+         << "release"
+#else
+         << "debug"
+#endif
+         << "\"}";
+    if (!suite.write_json(json_path, meta.str())) {
+      std::cerr << "Erro: não foi possível escrever " << json_path << "\n";
+      return 3;
+    }
+    std::cout << "resultados: " << json_path << "\n";
+  }
+  return 0;
+}
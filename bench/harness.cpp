@@ -0,0 +1,132 @@
+#include "harness.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+
+// Alocador global com contador (como em tests/test_alloc.cpp): substitui operator new/delete
+// só no binário de benchmark.
+static std::atomic<std::uint64_t> g_allocs{0};
+
+void* operator new(std::size_t n) {
+  g_allocs.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(n ? n : 1)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace logforge::bench {
+
+using Clock = std::chrono::steady_clock;
+
+static std::atomic<std::uint64_t> g_sink{0};
+
+std::uint64_t alloc_count() { return g_allocs.load(std::memory_order_relaxed); }
+
+void keep(std::uint64_t v) { g_sink.fetch_add(v, std::memory_order_relaxed); }
+
+static double median_of(std::vector<double> v) {
+  if (v.empty()) return 0.0;
+  std::sort(v.begin(), v.end());
+  const std::size_t n = v.size();
+  return (n % 2) ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2.0;
+}
+
+double Result::median() const { return median_of(ns_per_item); }
+
+double Result::min() const {
+  return ns_per_item.empty() ? 0.0 : *std::min_element(ns_per_item.begin(), ns_per_item.end());
+}
+
+double Result::mad() const {
+  const double m = median();
+  std::vector<double> dev;
+  dev.reserve(ns_per_item.size());
+  for (double x : ns_per_item) dev.push_back(std::fabs(x - m));
+  return median_of(std::move(dev));
+}
+
+double Result::bytes_per_sec() const {
+  const double ns = median() * static_cast<double>(items);
+  return ns > 0.0 ? static_cast<double>(bytes) * 1e9 / ns : 0.0;
+}
+
+bool Suite::selected(const std::string& name) const {
+  return opt_.filter.empty() || name.find(opt_.filter) != std::string::npos;
+}
+
+void Suite::run(const std::string& name, std::uint64_t items, std::uint64_t bytes, const std::function<void()>& setup,
+                const std::function<void()>& body) {
+  if (!selected(name) || items == 0) return;
+  Result r;
+  r.name = name;
+  r.items = items;
+  r.bytes = bytes;
+  std::uint64_t allocs = 0;
+  for (int rep = 0; rep <= opt_.reps; ++rep) {
+    setup();
+    const auto a0 = alloc_count();
+    const auto t0 = Clock::now();
+    body();
+    const auto t1 = Clock::now();
+    const auto a1 = alloc_count();
+    if (rep == 0) continue; // aquecimento: caches, páginas, primeiras alocações
+    allocs += a1 - a0;
+    r.ns_per_item.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count() / static_cast<double>(items));
+  }
+  r.allocs_per_item = static_cast<double>(allocs) / (static_cast<double>(items) * opt_.reps);
+  results_.push_back(std::move(r));
+  print_row(std::cout, results_.back());
+}
+
+void Suite::print_header(std::ostream& out) {
+  out << std::left << std::setw(28) << "benchmark" << std::right << std::setw(12) << "ns/item" << std::setw(10)
+      << "±mad" << std::setw(12) << "MB/s" << std::setw(14) << "allocs/item" << "\n";
+}
+
+void Suite::print_row(std::ostream& out, const Result& r) {
+  const auto flags = out.flags();
+  out << std::left << std::setw(28) << r.name << std::right << std::fixed << std::setprecision(1) << std::setw(12)
+      << r.median() << std::setw(10) << r.mad() << std::setw(12) << r.bytes_per_sec() / (1024.0 * 1024.0)
+      << std::setprecision(3) << std::setw(14) << r.allocs_per_item << "\n";
+  out.flags(flags);
+}
+
+static void put_json_string(std::ostream& out, const std::string& s) {
+  out << '"';
+  for (char c : s) {
+    if (c == '"' || c == '\\') out << '\\';
+    out << c;
+  }
+  out << '"';
+}
+
+bool Suite::write_json(const std::string& path, const std::string& meta_json) const {
+  std::ofstream ofs(path);
+  if (!ofs.is_open()) return false;
+  ofs << std::setprecision(6);
+  ofs << "{\n  \"schema\": 1,\n  \"meta\": " << meta_json << ",\n  \"reps\": " << opt_.reps
+      << ",\n  \"results\": [\n";
+  for (std::size_t i = 0; i < results_.size(); ++i) {
+    const Result& r = results_[i];
+    ofs << "    {\"name\": ";
+    put_json_string(ofs, r.name);
+    ofs << ", \"items\": " << r.items << ", \"bytes\": " << r.bytes << ", \"ns_per_item\": " << r.median()
+        << ", \"ns_per_item_min\": " << r.min() << ", \"ns_per_item_mad\": " << r.mad()
+        << ", \"bytes_per_sec\": " << r.bytes_per_sec() << ", \"allocs_per_item\": " << r.allocs_per_item
+        << ", \"samples\": [";
+    for (std::size_t k = 0; k < r.ns_per_item.size(); ++k) ofs << (k ? ", " : "") << r.ns_per_item[k];
+    ofs << "]}" << (i + 1 < results_.size() ? "," : "") << "\n";
+  }
+  ofs << "  ]\n}\n";
+  return static_cast<bool>(ofs);
+}
+
+} // namespace logforge::bench
@@ -0,0 +1,64 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace logforge::bench {
+
+// Alocações feitas até agora (operator new global com contador, só neste binário).
+std::uint64_t alloc_count();
+
+// Impede o compilador de descartar um resultado calculado só para o benchmark.
+void keep(std::uint64_t v);
+
+struct Options {
+  int reps = 7;       // repetições medidas (mais uma de aquecimento, descartada)
+  std::string filter; // só roda os benchmarks cujo nome contém isto
+};
+
+// Resultado de um benchmark. Itens = linhas (ou o que o nome indicar); os tempos são por
+// item e por repetição.
+struct Result {
+  std::string name;
+  std::uint64_t items = 0;
+  std::uint64_t bytes = 0; // bytes processados por repetição (entrada; saída nos writers)
+  std::vector<double> ns_per_item;
+  double allocs_per_item = 0.0;
+
+  double median() const;
+  double min() const;
+  // Desvio absoluto mediano: ruído da medida, usado pelo compare para o limiar.
+  double mad() const;
+  double bytes_per_sec() const;
+};
+
+class Suite {
+public:
+  explicit Suite(Options opt) : opt_(std::move(opt)) {}
+
+  bool selected(const std::string& name) const;
+
+  // setup() antes de cada repetição, fora do tempo (ex.: agregador novo); body() processa
+  // `items` itens e `bytes` bytes. Alocações contam só dentro de body().
+  void run(const std::string& name, std::uint64_t items, std::uint64_t bytes, const std::function<void()>& setup,
+           const std::function<void()>& body);
+  void run(const std::string& name, std::uint64_t items, std::uint64_t bytes, const std::function<void()>& body) {
+    run(name, items, bytes, [] {}, body);
+  }
+
+  const std::vector<Result>& results() const { return results_; }
+  // Tabela no stdout: o cabeçalho antes, uma linha por benchmark assim que termina.
+  static void print_header(std::ostream& out);
+  static void print_row(std::ostream& out, const Result& r);
+  // JSON lido pelo scripts/bench_compare.py.
+  bool write_json(const std::string& path, const std::string& meta_json) const;
+
+private:
+  Options opt_;
+  std::vector<Result> results_;
+};
+
+} // namespace logforge::bench
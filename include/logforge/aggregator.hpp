@@ -1,61 +1,212 @@
 #pragma once
 #include <cstdint>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
+#include "dense_counts.hpp"
+#include "endpoint_stats.hpp"
+#include "entry_batch.hpp"
+#include "group_by.hpp"
+#include "hyperloglog.hpp"
+#include "latency_sketch.hpp"
 #include "log_entry.hpp"
+#include "run_stats.hpp"
+#include "space_saving.hpp"
+#include "symbol_table.hpp"
+#include "time_windows.hpp"
 
 namespace logforge {
 
+// Latências em ms (resolução de microssegundos); -1 se não houver amostras.
 struct LatencyStats {
   std::uint64_t count = 0;
-  int min_ms = -1;
-  int max_ms = -1;
+  double min_ms = -1;
+  double max_ms = -1;
   double avg_ms = 0.0;
-  int p50_ms = -1;
-  int p95_ms = -1;
-  int p99_ms = -1;
+  double p50_ms = -1;
+  double p95_ms = -1;
+  double p99_ms = -1;
+  double relative_error = 0.0;                      // erro relativo máximo dos quantis
+  std::vector<std::pair<double, double>> quantiles; // (q, ms) pedidos em --quantiles
+};
+
+// Linha de endpoint_latency.csv / seção "endpoint_latency" do JSON.
+struct EndpointLatencyRow {
+  std::string endpoint;
+  std::uint64_t count = 0;       // contagem (superestimada em até count_error)
+  std::uint64_t count_error = 0; // 0 no modo exato
+  std::uint64_t status_classes[5] = {};
+  double error_rate = 0.0;       // 5xx / requisições observadas
+  double p50_ms = -1;
+  double p95_ms = -1;
+  double p99_ms = -1;
+  std::uint64_t unique_clients = 0; // só com --unique-clients (estimativa HyperLogLog)
 };
 
 struct Report {
   std::uint64_t total_lines = 0;
   std::uint64_t parsed_lines = 0;
   std::uint64_t invalid_lines = 0;
+  std::uint64_t filtered_lines = 0; // descartadas pelo --where (entram em total_lines)
 
   std::unordered_map<int, std::uint64_t> status_counts;
   std::unordered_map<std::string, std::uint64_t> endpoint_counts;
-  std::unordered_map<std::string, std::uint64_t> per_minute_counts;
+  // Modo --topk-mode approx: endpoint_counts só tem as chaves monitoradas, com contagem
+  // superestimada em até endpoint_count_errors[chave] (<= parsed_lines / capacidade).
+  bool endpoint_counts_approximate = false;
+  std::unordered_map<std::string, std::uint64_t> endpoint_count_errors;
+  std::unordered_map<std::int64_t, std::uint64_t> per_minute_counts; // chave: minuto desde a época
 
   LatencyStats latency;
+
+  // --unique-clients: IPs distintos (HyperLogLog), também por endpoint e por janela.
+  bool unique_clients_enabled = false;
+  std::uint64_t unique_clients = 0;
+  int unique_clients_precision = 0;
+  double unique_clients_error = 0.0; // erro padrão relativo
+
+  // Modo --endpoint-stats: ordenado por count desc (empate: endpoint asc).
+  bool endpoint_latency_enabled = false;
+  bool endpoint_latency_approximate = false; // true se a cardinalidade passou do orçamento
+  std::vector<EndpointLatencyRow> endpoint_latency;
+
+  // Janelas de tempo (--window): por início crescente.
+  bool windows_enabled = false;
+  int window_width_min = 0;
+  int window_sliding = 0;
+  std::uint64_t window_late = 0; // linhas atrasadas demais para o anel (fora das janelas)
+  std::vector<WindowRow> windows;
+
+  // --group-by: todos os grupos, por count desc (empate: chave asc).
+  bool group_by_enabled = false;
+  GroupBySpec group_by_spec;
+  std::vector<GroupRow> group_by;
+};
+
+enum class TopKMode {
+  Exact,  // contagem exata de todos os endpoints (memória cresce com a cardinalidade)
+  Approx, // Space-Saving com `topk_capacity` contadores (memória fixa)
+};
+
+struct AggregatorOptions {
+  int top_n = 20;
+  double latency_error = 0.01;  // erro relativo do sketch de latência
+  std::vector<double> quantiles; // quantis extras para o relatório (ex.: 0.999)
+  // Máximo de endpoints com estatísticas próprias (0 = desligado). Acima disso vira
+  // heavy hitters (Space-Saving): memória fixa, exato só para os endpoints frequentes.
+  // Implica topk_mode = Approx (com topk_capacity >= endpoint_stats_capacity).
+  std::size_t endpoint_stats_capacity = 0;
+  TopKMode topk_mode = TopKMode::Exact;
+  std::size_t topk_capacity = 10000;
+  WindowOptions windows; // width_min = 0: sem janelas de tempo
+  GroupBySpec group_by;  // dims vazio: sem --group-by
+  // Precisão p do HyperLogLog de clientes distintos (--unique-clients; 0 = desligado):
+  // até 2^p bytes por sketch (global, por endpoint do --endpoint-stats e por janela).
+  int hll_precision = 0;
+  // --stats: tempos por estágio e motivos de recusa (ver RunStats). Não entra em snapshots.
+  // Sem LOGFORGE_STATS na compilação, é ignorado.
+  bool stats = false;
 };
 
 class Aggregator {
 public:
   explicit Aggregator(int top_n = 20);
+  explicit Aggregator(const AggregatorOptions& opt);
 
   void add_valid(const LogEntry& e);
-  void add_invalid();
+  // Um lote inteiro (válidas, inválidas e filtradas), coluna por coluna; o estado final é o
+  // mesmo de chamar add_valid em cada linha, na ordem.
+  void add_batch(const EntryBatch& b);
+  void add_invalid(std::uint64_t n = 1);
+  void add_filtered(std::uint64_t n = 1);
+
+  // Caminho colunar (varredura do índice): contagens já agrupadas por coluna, sem cruzar
+  // uma coluna com a outra. Só equivale a add_valid quando nada por linha é preciso
+  // (ver needs_rows()); add_rows conta as linhas, os demais só somam na sua coluna.
+  bool needs_rows() const { return endpoint_stats_.has_value() || windows_.has_value() || group_by_.has_value(); }
+  // remote_addr, method, bytes e user_agent das linhas são usados (--unique-clients ou
+  // --group-by com eles)? Se não, o parser pode deixar de extraí-los.
+  bool needs_client_fields() const {
+    return clients_.enabled() || (group_by_ && group_by_->spec().needs_client_fields());
+  }
+  void add_rows(std::uint64_t n);
+  void add_status(int status, std::uint64_t n);
+  void add_endpoint(std::string_view endpoint, std::uint64_t n);
+  void add_minute(std::int64_t minute, std::uint64_t n);
+  void add_latency(std::uint64_t latency_us) { latency_.add(latency_us); }
+
+  // Soma o estado de outro agregador (ex.: de outra thread) neste.
+  // O resultado é idêntico a ter processado as duas entradas aqui.
+  void merge(const Aggregator& other);
+  // false se `other` tiver sido configurado de forma que o merge perderia dados
+  // (erro de latência, modo ou capacidade do top-K aproximado, --endpoint-stats e a
+  // capacidade dele, largura das janelas, --group-by ou precisão do --unique-clients
+  // diferentes).
+  bool mergeable_with(const Aggregator& other) const;
+
+  // Estado completo antes do finalize (opções, contadores, mapas, sketches), compacto em
+  // varints. deserialize substitui tudo, inclusive as opções; false se os dados forem inválidos.
+  void serialize(std::string& out) const;
+  bool deserialize(std::string_view& in);
 
   // Finaliza e computa percentis de latência.
-  Report finalize();
+  // Não destrutivo: o estado de streaming fica intacto, então pode ser chamado
+  // periodicamente (modo --follow) e a agregação continua depois.
+  Report finalize() const;
+
+  // Medidas do --stats, ou nullptr (desligado, ou compilado sem LOGFORGE_STATS: aí é uma
+  // constante e os ganchos de quem chama somem).
+  RunStats* stats() {
+    if constexpr (!kStatsCompiled) return nullptr;
+    return stats_ ? &*stats_ : nullptr;
+  }
+  const RunStats* stats() const {
+    if constexpr (!kStatsCompiled) return nullptr;
+    return stats_ ? &*stats_ : nullptr;
+  }
+  // Tamanho e ocupação das estruturas internas (para o --stats).
+  std::vector<TableStats> table_stats() const;
 
-  int top_n() const { return top_n_; }
+  int top_n() const { return opt_.top_n; }
+  const AggregatorOptions& options() const { return opt_; }
 
 private:
-  int top_n_;
+  AggregatorOptions opt_;
 
+  // Só os contadores escalares; status_counts/per_minute_counts de Report são montados no
+  // finalize() a partir de status_ e minutes_.
   Report report_;
+  StatusCounts status_;
+  MinuteCounts minutes_;
+
+  // Endpoints internados: o mapa de strings de Report só é montado no finalize().
+  SymbolTable endpoints_;
+  std::vector<std::uint64_t> endpoint_counts_; // indexado pelo id do símbolo
+
+  // Modo aproximado: substitui endpoints_/endpoint_counts_.
+  std::optional<SpaceSaving<NoPayload>> endpoint_topk_;
+
+  // Latência em microssegundos (sketch log-linear, mergeable e de memória limitada).
+  LatencySketch latency_;
+
+  // IPs distintos no total (desligado com hll_precision = 0).
+  HyperLogLog clients_;
+
+  // Estatísticas por endpoint (só com endpoint_stats_capacity > 0).
+  std::optional<SpaceSaving<EndpointStats>> endpoint_stats_;
+
+  // Janelas de tempo (só com windows.width_min > 0).
+  std::optional<TimeWindows> windows_;
+
+  // Agregação por dimensões arbitrárias (só com --group-by).
+  std::optional<GroupBy> group_by_;
 
-  // Latência por histograma (aproximado, mas streaming-friendly).
-  static constexpr int kBucketMs = 50;
-  static constexpr int kMaxMs = 10000;
-  static constexpr int kBucketCount = (kMaxMs / kBucketMs) + 2; // + overflow
-  std::vector<std::uint64_t> latency_hist_;
-  std::uint64_t latency_sum_ms_ = 0;
+  std::optional<RunStats> stats_;
 
-  void add_latency(int latency_ms);
-  int percentile_from_hist(double p) const;
+  void build_endpoint_latency(Report& r) const;
 };
 
 } // namespace logforge
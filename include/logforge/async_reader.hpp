@@ -0,0 +1,118 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "line_source.hpp"
+
+namespace logforge {
+
+// Como o AsyncLineReader busca os blocos.
+enum class AsyncBackend {
+  Auto,  // io_uring se o kernel deixar (build com LOGFORGE_HAVE_URING), senão Pread
+  Uring, // leituras submetidas direto ao kernel, sem thread extra
+  Pread, // uma thread de I/O faz pread em ordem
+};
+
+const char* async_backend_name(AsyncBackend b);
+// O backend que Auto escolhe neste processo (testa io_uring_setup uma vez).
+AsyncBackend resolve_async_backend();
+
+struct AsyncReadOptions {
+  std::size_t block_size = 1 << 20; // arredondado para múltiplo de 4 KiB
+  std::size_t depth = 4;            // blocos em voo (read-ahead)
+  // O_DIRECT: não passa pelo page cache (varreduras de uma vez só). Se o sistema de
+  // arquivos recusar (ex.: tmpfs), lê normalmente.
+  bool direct = false;
+  AsyncBackend backend = AsyncBackend::Auto;
+};
+
+class ReadQueue; // backend de leitura (async_reader.cpp)
+
+// Fonte de linhas com leitura assíncrona: mantém `depth` blocos alinhados em voo enquanto
+// o parser consome o bloco atual, então a espera pelo disco se sobrepõe ao parse em vez de
+// parar a cada recarga. As linhas dentro de um bloco saem como views nele; as que
+// atravessam a borda entre blocos são costuradas numa cópia.
+//
+// Como as outras fontes, devolve as linhas que começam em [range.begin, range.end); só a
+// faixa entra no read-ahead, e o resto da última linha é lido sob demanda.
+//
+// Em lotes (hold_views), um bloco esgotado só volta ao read-ahead no release_views, e as
+// linhas costuradas ficam guardadas até lá. Enquanto o lote segura blocos, sobram menos
+// para ler à frente; release_due pede o fim do lote antes de o anel ficar sem slot livre.
+class AsyncLineReader final : public LineSource {
+public:
+  explicit AsyncLineReader(const std::string& path, ByteRange range = {}, AsyncReadOptions opt = {});
+  ~AsyncLineReader() override;
+
+  AsyncLineReader(const AsyncLineReader&) = delete;
+  AsyncLineReader& operator=(const AsyncLineReader&) = delete;
+
+  // Antes da leitura: arquivo aberto. Depois do fim: false se alguma leitura falhou.
+  bool ok() const override { return ok_; }
+  bool next_line(std::string_view& out) override;
+
+  bool stable_views() const override { return true; }
+  void hold_views() override { hold_ = true; }
+  bool release_due() const override { return hold_ && consumed_ - released_ + 1 >= ring_.size(); }
+  void release_views() override;
+
+  AsyncBackend backend() const { return backend_; }
+  bool direct() const { return direct_; } // O_DIRECT em uso (pedido e aceito pelo FS)
+
+  // Medidas para o --bench e o logforge_bench.
+  std::uint64_t bytes_read() const { return bytes_read_; }
+  double wait_seconds() const { return wait_sec_; } // parado esperando bloco
+
+private:
+  struct Block {
+    char* data = nullptr;    // alinhado em kAlign (exigência do O_DIRECT)
+    std::size_t size = 0;    // bytes válidos
+    std::uint64_t off = 0;   // posição do bloco no arquivo
+  };
+
+  int fd_ = -1;
+  bool ok_ = false;
+  bool direct_ = false;
+  AsyncBackend backend_ = AsyncBackend::Pread;
+  std::size_t block_size_ = 0;
+  std::uint64_t file_size_ = 0;
+  std::uint64_t end_ = 0;      // linhas que começam antes disso
+  std::uint64_t next_off_ = 0; // próximo bloco a submeter
+
+  // Anel: submitted_/consumed_/released_ são contadores monotônicos; slot = n % ring_.size().
+  // [released_, consumed_) são blocos esgotados ainda seguros pelo lote (vazio sem hold_).
+  std::vector<Block> ring_;
+  std::uint64_t submitted_ = 0;
+  std::uint64_t consumed_ = 0;
+  std::uint64_t released_ = 0;
+  std::unique_ptr<ReadQueue> queue_; // destruído antes dos buffers (espera o que está em voo)
+  Block spare_;                      // lido com pread quando o lote segura o anel inteiro
+
+  // Estado do consumidor.
+  const Block* cur_ = nullptr;
+  std::size_t pos_ = 0;
+  std::size_t skip_ = 0;        // range.begin - início alinhado do primeiro bloco
+  std::uint64_t line_begin_ = 0; // posição no arquivo da linha em andamento
+  std::string carry_;           // linha que atravessa blocos
+  std::string line_;
+  bool done_ = false;
+  bool hold_ = false;
+  // Linhas costuradas do lote (deque: push_back não move as strings já entregues).
+  std::deque<std::string> stitched_;
+  std::size_t stitched_used_ = 0;
+
+  std::uint64_t bytes_read_ = 0;
+  double wait_sec_ = 0.0;
+
+  void submit();
+  void refill();
+  bool fill_rest(Block& b);
+  bool acquire();
+  std::string_view take_carry();
+};
+
+} // namespace logforge
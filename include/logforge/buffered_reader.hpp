@@ -1,21 +1,32 @@
 #pragma once
+#include <cstdint>
 #include <fstream>
 #include <string>
 #include <vector>
 
+#include "line_source.hpp"
+
 namespace logforge {
 
 // Leitor de linhas com buffer grande (reduz overhead de I/O).
-class BufferedLineReader {
+class BufferedLineReader final : public LineSource {
 public:
   explicit BufferedLineReader(const std::string& path, std::size_t buffer_size = 1 << 20);
 
-  bool ok() const { return ifs_.is_open() && ifs_.good(); }
+  // Lê apenas as linhas que começam em [begin, end) (usado no modo com threads).
+  BufferedLineReader(const std::string& path, std::uint64_t begin, std::uint64_t end,
+                     std::size_t buffer_size = 1 << 20);
+
+  bool ok() const override { return ifs_.is_open() && ifs_.good(); }
   bool next_line(std::string& out);
+  bool next_line(std::string_view& out) override;
 
 private:
   std::ifstream ifs_;
   std::vector<char> buffer_;
+  std::string line_;
+  std::uint64_t pos_ = 0;
+  std::uint64_t end_ = UINT64_MAX;
 };
 
 } // namespace logforge
@@ -0,0 +1,189 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "aggregator.hpp"
+#include "filter.hpp"
+#include "ingest.hpp"
+#include "log_entry.hpp"
+#include "symbol_table.hpp"
+
+namespace logforge {
+
+// Índice colunar das linhas já parseadas, para várias análises sobre o mesmo log sem
+// pagar o parse de novo (logforge index / logforge query).
+//
+// Layout (inteiros em little-endian, seções alinhadas em 8 bytes para serem lidas direto
+// do arquivo mapeado):
+//   cabeçalho (64 bytes): "LFINDX" | u16 versão | linhas totais/inválidas | linhas no índice |
+//                         linhas por bloco | nº de blocos | offsets do dicionário e do
+//                         diretório | tamanho do arquivo
+//   blocos de até `block_rows` linhas, coluna após coluna:
+//     endpoint  u32 (id no dicionário)
+//     status    u16 (i32 se algum status do bloco não couber)
+//     latência  u32 com latency_us + 1, 0 = sem latência (u64 se não couber)
+//     minuto    varints zigzag: delta para o anterior (o primeiro, para o mínimo do bloco)
+//   dicionário: u64 n | u64 offsets[n + 1] | bytes dos endpoints
+//   diretório: um registro de 64 bytes por bloco com offset, linhas, larguras das colunas
+//              e o zone map (minuto e status mínimo/máximo, classes de status presentes)
+//
+// O endpoint guardado é o do parser (sem querystring); --normalize é aplicado na consulta,
+// uma vez por entrada do dicionário.
+// 2: minutos em UTC (a versão 1 guardava o horário local sem o fuso; é recusada).
+inline constexpr std::uint16_t kIndexVersion = 2;
+inline constexpr std::uint32_t kIndexBlockRows = 64 * 1024;
+
+// Grava o índice bloco a bloco (a memória fica no bloco atual + dicionário). O cabeçalho
+// só é preenchido no finish(); até lá o arquivo é um ".tmp", renomeado no final.
+class IndexWriter {
+public:
+  explicit IndexWriter(std::string path, std::uint32_t block_rows = kIndexBlockRows);
+  ~IndexWriter();
+
+  IndexWriter(const IndexWriter&) = delete;
+  IndexWriter& operator=(const IndexWriter&) = delete;
+
+  bool ok() const { return ok_; }
+
+  void add_valid(const LogEntry& e);
+  void add_invalid() { total_lines_++; invalid_lines_++; }
+
+  // Grava o último bloco, o dicionário, o diretório e o cabeçalho; false em erro de escrita.
+  bool finish();
+
+  std::uint64_t rows() const { return rows_; }
+  std::uint64_t blocks() const { return dir_.size() / kDirEntrySize; }
+  std::size_t endpoints() const { return dict_.size(); }
+
+  static constexpr std::size_t kDirEntrySize = 64;
+
+private:
+  std::string path_;
+  std::string tmp_path_;
+  std::ofstream ofs_;
+  bool ok_ = false;
+  const std::uint32_t block_rows_;
+
+  std::uint64_t total_lines_ = 0;
+  std::uint64_t invalid_lines_ = 0;
+  std::uint64_t rows_ = 0;
+  std::uint64_t offset_ = 0; // bytes gravados até agora
+
+  SymbolTable dict_;
+  std::string dir_; // registros do diretório já serializados
+
+  // Bloco atual.
+  std::vector<std::uint32_t> ids_;
+  std::vector<int> status_;
+  std::vector<std::int64_t> latency_;
+  std::vector<std::int64_t> minute_;
+
+  void flush_block();
+  void write(const void* data, std::size_t n);
+  void pad();
+};
+
+struct IndexBuildStats {
+  std::uint64_t total_lines = 0;
+  std::uint64_t rows = 0;
+  std::uint64_t blocks = 0;
+  std::uint64_t endpoints = 0;
+  std::uint64_t bytes = 0; // tamanho do índice
+};
+
+// Lê as linhas de `paths` (ver open_line_source: aceita gzip/zstd) e grava o índice em
+// `index_path`. Sequencial; usa opt.reader, opt.isa e opt.parser (opt.normalizer é ignorado).
+bool build_index(const std::vector<std::string>& paths, const IngestOptions& opt, const std::string& index_path,
+                 IndexBuildStats* stats, std::string& err);
+
+// Índice aberto via mmap, só leitura.
+class ColumnIndex {
+public:
+  ColumnIndex() = default;
+  ~ColumnIndex();
+
+  ColumnIndex(const ColumnIndex&) = delete;
+  ColumnIndex& operator=(const ColumnIndex&) = delete;
+
+  // false (com `err`) se o arquivo não existir, for de outra versão ou estiver inconsistente.
+  bool open(const std::string& path, std::string& err);
+
+  std::uint64_t total_lines() const { return total_lines_; }
+  std::uint64_t invalid_lines() const { return invalid_lines_; }
+  std::uint64_t rows() const { return rows_; }
+  std::size_t block_count() const { return blocks_.size(); }
+  std::size_t dictionary_size() const { return dict_size_; }
+  std::string_view endpoint(std::uint32_t id) const;
+
+  struct Block {
+    std::uint64_t offset = 0;
+    std::uint32_t rows = 0;
+    std::uint8_t status_width = 2;  // 2 (u16) ou 4 (i32)
+    std::uint8_t latency_width = 4; // 4 (u32) ou 8 (u64)
+    std::uint8_t status_classes = 0; // bit c-1: há status da classe c (1xx..5xx)
+    std::uint32_t minute_bytes = 0;
+    std::int64_t min_minute = 0;
+    std::int64_t max_minute = 0;
+    std::int32_t min_status = 0;
+    std::int32_t max_status = 0;
+  };
+  const Block& block(std::size_t i) const { return blocks_[i]; }
+  const char* data() const { return data_; }
+
+private:
+  const char* data_ = nullptr;
+  std::size_t size_ = 0;
+
+  std::uint64_t total_lines_ = 0;
+  std::uint64_t invalid_lines_ = 0;
+  std::uint64_t rows_ = 0;
+  std::uint64_t dict_size_ = 0;
+  const char* dict_offsets_ = nullptr;
+  const char* dict_bytes_ = nullptr;
+  std::vector<Block> blocks_;
+
+  void close();
+};
+
+// Filtro da consulta. Os limites de minuto usam o mesmo relógio de per_minute_counts.
+struct IndexQuery {
+  std::int64_t from_minute = INT64_MIN; // inclusivo
+  std::int64_t to_minute = INT64_MAX;   // exclusivo
+  int status_min = INT32_MIN;
+  int status_max = INT32_MAX;
+  // --where avaliado linha a linha nos blocos que passaram pelo zone map (nullptr = sem).
+  const Filter* where = nullptr;
+
+  bool filtered() const {
+    return from_minute != INT64_MIN || to_minute != INT64_MAX || status_min != INT32_MIN || status_max != INT32_MAX ||
+           where != nullptr;
+  }
+};
+
+struct IndexScanStats {
+  std::uint64_t blocks = 0;
+  std::uint64_t blocks_skipped = 0; // descartados só pelo zone map
+  std::uint64_t rows_scanned = 0;
+  std::uint64_t rows_matched = 0;
+};
+
+// Re-agrega o índice em `out`. Blocos fora do filtro são pulados pelo zone map; nos demais,
+// o filtro vira um vetor de seleção (laço sem desvios) e as colunas são somadas em laços
+// apertados sobre os arrays mapeados. Sem --endpoint-stats/--window a agregação é por
+// coluna (ids do dicionário em contagens densas, minutos em sequências iguais); com eles,
+// as linhas selecionadas passam por Aggregator::add_valid.
+//
+// As linhas inválidas do log original também são somadas e as que não passaram no filtro
+// contam em filtered_lines: o relatório é o mesmo do processamento do texto com --where.
+// Os blocos são divididos entre `threads` workers, cada um com um Aggregator local.
+void query_index(const ColumnIndex& index, const IndexQuery& q, const PathNormalizer* normalizer, int threads,
+                 Aggregator& out, IndexScanStats* stats = nullptr);
+
+// true se o --group-by só lê colunas que o índice guarda (endpoint, status, minuto e
+// latência); método, ip, UA e bytes não são indexados.
+bool index_can_group(const GroupBySpec& spec);
+
+} // namespace logforge
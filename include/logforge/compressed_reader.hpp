@@ -0,0 +1,110 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "line_source.hpp"
+
+namespace logforge {
+
+enum class Compression { None, Gzip, Zstd };
+
+// Detecta pelos magic bytes (gzip: 1f 8b; zstd: 28 b5 2f fd), não pela extensão.
+// O que não é arquivo regular (pipe, FIFO, /dev/stdin) é sempre None, sem ser aberto.
+Compression detect_compression(const std::string& path);
+// false se o build não tem a biblioteca (LOGFORGE_HAVE_ZLIB / LOGFORGE_HAVE_ZSTD).
+bool compression_supported(Compression c);
+const char* compression_name(Compression c);
+
+// Descompressor em streaming de um arquivo (ou de uma faixa de frames zstd).
+class Decoder {
+public:
+  virtual ~Decoder() = default;
+  // false se não abriu ou se os dados estão corrompidos/truncados. Pode ser chamado de
+  // outra thread enquanto read() roda (o CompressedLineReader descomprime numa thread própria).
+  virtual bool ok() const = 0;
+  // Preenche até `cap` bytes descomprimidos; 0 = fim dos dados (ou erro: ver ok()).
+  virtual std::size_t read(char* out, std::size_t cap) = 0;
+};
+
+// gzip aceita só o arquivo inteiro (membros concatenados são lidos em sequência): com
+// outra faixa devolve nullptr. zstd aceita faixas alinhadas em frames (ver split_zstd_frames).
+std::unique_ptr<Decoder> open_decoder(const std::string& path, Compression c, ByteRange range = {});
+
+// Agrupa os frames de um .zst em até `parts` faixas contíguas de tamanho parecido,
+// para descompressão paralela. Arquivos de um frame só (ou sem zstd) dão uma faixa.
+// Vazio se o arquivo não puder ser lido.
+std::vector<ByteRange> split_zstd_frames(const std::string& path, int parts);
+
+// LineSource sobre um Decoder, em pipeline: uma thread descomprime blocos num anel
+// limitado enquanto a thread chamadora separa linhas e parseia. O anel limita a memória
+// (blocks × block_size) e faz o produtor esperar quando o parser fica para trás.
+//
+// Com capture_edges, o trecho até o primeiro '\n' e o que sobra depois do último não viram
+// linhas: ficam em head()/tail() para quem descomprime faixas em paralelo costurar as
+// linhas que atravessam a fronteira entre frames.
+class CompressedLineReader final : public LineSource {
+public:
+  explicit CompressedLineReader(std::unique_ptr<Decoder> decoder, bool capture_edges = false,
+                                std::size_t block_size = 1 << 20, std::size_t blocks = 4);
+  ~CompressedLineReader() override;
+
+  CompressedLineReader(const CompressedLineReader&) = delete;
+  CompressedLineReader& operator=(const CompressedLineReader&) = delete;
+
+  // Antes da leitura: decoder aberto. Depois do fim: false se os dados eram inválidos.
+  bool ok() const override;
+  bool next_line(std::string_view& out) override;
+
+  const std::string& head() const { return head_; }
+  const std::string& tail() const { return tail_; }
+  bool saw_newline() const { return saw_newline_; }
+
+  // Medidas para o --bench (válidas depois que next_line devolveu false).
+  std::uint64_t decompressed_bytes() const { return decompressed_bytes_; }
+  double decompress_seconds() const { return decompress_sec_; }
+  double wait_seconds() const { return wait_sec_; }
+
+private:
+  struct Block {
+    std::vector<char> data;
+    std::size_t size = 0;
+  };
+
+  std::unique_ptr<Decoder> decoder_;
+  const bool capture_edges_;
+
+  // Anel SPSC: produced_/consumed_ são contadores monotônicos; slot = n % ring_.size().
+  std::vector<Block> ring_;
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::uint64_t produced_ = 0;
+  std::uint64_t consumed_ = 0;
+  bool finished_ = false;
+  bool stop_ = false;
+  std::thread producer_;
+
+  // Estado do consumidor.
+  const Block* cur_ = nullptr;
+  std::size_t pos_ = 0;
+  std::string carry_; // linha que atravessa blocos
+  std::string line_;
+  std::string head_;
+  std::string tail_;
+  bool saw_newline_ = false;
+  bool done_ = false;
+
+  std::uint64_t decompressed_bytes_ = 0;
+  double decompress_sec_ = 0.0;
+  double wait_sec_ = 0.0;
+
+  void produce();
+  bool emit(std::string_view piece, std::string_view& out);
+};
+
+} // namespace logforge
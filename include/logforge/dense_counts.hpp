@@ -0,0 +1,152 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+namespace logforge {
+
+// Contagens por status HTTP: array denso para 0..599 (todo código real cai aí, um add é um
+// incremento indexado) e mapa ordenado para o resto (códigos inválidos ou negativos).
+class StatusCounts {
+public:
+  static constexpr int kDense = 600;
+
+  void add(int status, std::uint64_t n = 1) {
+    if (static_cast<unsigned>(status) < static_cast<unsigned>(kDense)) dense_[static_cast<unsigned>(status)] += n;
+    else other_[status] += n;
+  }
+
+  void merge(const StatusCounts& o) {
+    for (int s = 0; s < kDense; ++s) dense_[s] += o.dense_[s];
+    for (const auto& [s, c] : o.other_) other_[s] += c;
+  }
+
+  // Códigos com contagem > 0, em ordem crescente: f(status, count).
+  template <typename F>
+  void for_each(F&& f) const {
+    auto it = other_.begin();
+    for (; it != other_.end() && it->first < 0; ++it) f(it->first, it->second);
+    for (int s = 0; s < kDense; ++s) {
+      if (dense_[s]) f(s, dense_[s]);
+    }
+    for (; it != other_.end(); ++it) f(it->first, it->second);
+  }
+
+  std::size_t size() const {
+    std::size_t n = other_.size();
+    for (auto c : dense_) n += (c != 0);
+    return n;
+  }
+
+  std::unordered_map<int, std::uint64_t> to_map() const {
+    std::unordered_map<int, std::uint64_t> m;
+    m.reserve(size());
+    for_each([&](int s, std::uint64_t c) { m.emplace(s, c); });
+    return m;
+  }
+
+private:
+  std::array<std::uint64_t, kDense> dense_{};
+  std::map<int, std::uint64_t> other_;
+};
+
+// Contagens por minuto (desde a época). Logs cobrem um intervalo contínuo de tempo, então
+// as contagens ficam num vetor denso a partir de base_: o add do caso comum é uma subtração
+// e um incremento, sem hash nem nó alocado. O vetor cresce para os dois lados (com folga,
+// dobrando) até kMaxSpan minutos; minutos que o levariam além disso (timestamps absurdos)
+// vão para um mapa esparso, e voltam ao vetor se ele depois crescer até cobri-los.
+class MinuteCounts {
+public:
+  static constexpr std::uint64_t kMaxSpan = std::uint64_t{1} << 20; // ~2 anos, 8 MiB
+
+  void add(std::int64_t minute, std::uint64_t n = 1) {
+    const std::uint64_t i = static_cast<std::uint64_t>(minute) - static_cast<std::uint64_t>(base_);
+    if (i < dense_.size()) dense_[static_cast<std::size_t>(i)] += n;
+    else add_slow(minute, n);
+  }
+
+  void merge(const MinuteCounts& o) {
+    o.for_each([&](std::int64_t m, std::uint64_t c) { add(m, c); });
+  }
+
+  // Minutos com contagem > 0, em ordem crescente: f(minute, count). O esparso nunca tem
+  // minutos dentro do intervalo denso.
+  template <typename F>
+  void for_each(F&& f) const {
+    auto it = sparse_.begin();
+    for (; it != sparse_.end() && it->first < base_; ++it) f(it->first, it->second);
+    for (std::size_t i = 0; i < dense_.size(); ++i) {
+      if (dense_[i]) f(base_ + static_cast<std::int64_t>(i), dense_[i]);
+    }
+    for (; it != sparse_.end(); ++it) f(it->first, it->second);
+  }
+
+  std::size_t size() const {
+    std::size_t n = sparse_.size();
+    for (auto c : dense_) n += (c != 0);
+    return n;
+  }
+
+  // Minutos cobertos pelo vetor denso (alocados, inclusive os zerados).
+  std::size_t span() const { return dense_.size(); }
+
+  std::unordered_map<std::int64_t, std::uint64_t> to_map() const {
+    std::unordered_map<std::int64_t, std::uint64_t> m;
+    m.reserve(size());
+    for_each([&](std::int64_t k, std::uint64_t c) { m.emplace(k, c); });
+    return m;
+  }
+
+private:
+  std::int64_t base_ = 0;
+  std::vector<std::uint64_t> dense_;
+  std::map<std::int64_t, std::uint64_t> sparse_;
+
+  void add_slow(std::int64_t minute, std::uint64_t n) {
+    if (dense_.empty()) {
+      resize(minute, minute, false);
+    } else {
+      const std::int64_t top = base_ + static_cast<std::int64_t>(dense_.size() - 1);
+      const std::int64_t lo = std::min(base_, minute), hi = std::max(top, minute);
+      if (static_cast<std::uint64_t>(hi) - static_cast<std::uint64_t>(lo) >= kMaxSpan) {
+        sparse_[minute] += n;
+        return;
+      }
+      resize(lo, hi, minute < base_);
+    }
+    dense_[static_cast<std::size_t>(static_cast<std::uint64_t>(minute) - static_cast<std::uint64_t>(base_))] += n;
+  }
+
+  // Passa o vetor a cobrir [lo, hi] com folga do lado em que cresceu, sem sair do int64, e
+  // traz para ele os minutos esparsos que ficaram dentro.
+  void resize(std::int64_t lo, std::int64_t hi, bool downward) {
+    const std::uint64_t span = static_cast<std::uint64_t>(hi) - static_cast<std::uint64_t>(lo) + 1;
+    std::uint64_t want = std::min(kMaxSpan, std::max<std::uint64_t>({span, 2 * dense_.size(), 64}));
+    const std::uint64_t room_down = static_cast<std::uint64_t>(lo) - static_cast<std::uint64_t>(INT64_MIN);
+    const std::uint64_t room_up = static_cast<std::uint64_t>(INT64_MAX) - static_cast<std::uint64_t>(hi);
+    const std::uint64_t extra = std::min(want - span, room_down + room_up);
+    const std::uint64_t below = downward ? std::min(extra, room_down) : extra - std::min(extra, room_up);
+    const auto base = static_cast<std::int64_t>(static_cast<std::uint64_t>(lo) - below);
+
+    std::vector<std::uint64_t> dense(static_cast<std::size_t>(span + extra), 0);
+    if (!dense_.empty()) {
+      const std::uint64_t off = static_cast<std::uint64_t>(base_) - static_cast<std::uint64_t>(base);
+      std::copy(dense_.begin(), dense_.end(), dense.begin() + static_cast<std::ptrdiff_t>(off));
+    }
+    dense_.swap(dense);
+    base_ = base;
+
+    const std::int64_t top = base_ + static_cast<std::int64_t>(dense_.size() - 1);
+    for (auto it = sparse_.lower_bound(base_); it != sparse_.end() && it->first <= top;) {
+      dense_[static_cast<std::size_t>(static_cast<std::uint64_t>(it->first) - static_cast<std::uint64_t>(base_))] +=
+          it->second;
+      it = sparse_.erase(it);
+    }
+  }
+};
+
+} // namespace logforge
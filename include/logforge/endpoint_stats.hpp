@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "hyperloglog.hpp"
+#include "latency_sketch.hpp"
+#include "varint.hpp"
+
+namespace logforge {
+
+// Estatísticas de um endpoint no modo --endpoint-stats.
+// O sketch usa precisão menor e teto de buckets para caber muitos endpoints:
+// ~3% de erro relativo e no máximo 256 buckets (16 oitavas, ex.: 1 ms .. 65 s) por chave.
+// Com --unique-clients, `clients` conta os IPs distintos (no máximo 2^p bytes por chave);
+// a precisão vem do protótipo (ver SpaceSaving e TimeWindows) e 0 deixa desligado.
+struct EndpointStats {
+  static constexpr double kLatencyError = 0.05;
+  static constexpr std::uint32_t kMaxBuckets = 256;
+
+  std::uint64_t count = 0;             // requisições vistas desde que a chave é monitorada
+  std::uint64_t status_classes[5] = {}; // 1xx .. 5xx
+  LatencySketch latency{kLatencyError, kMaxBuckets};
+  HyperLogLog clients;
+
+  // `client_hash`: hll_hash do endereço do cliente (nullptr = linha sem cliente).
+  void add(int status, std::int64_t latency_us, const std::uint64_t* client_hash = nullptr) {
+    count++;
+    if (status >= 100 && status < 600) status_classes[status / 100 - 1]++;
+    if (latency_us >= 0) latency.add(static_cast<std::uint64_t>(latency_us));
+    if (client_hash) clients.add_hash(*client_hash);
+  }
+
+  void clear() {
+    count = 0;
+    for (auto& c : status_classes) c = 0;
+    latency.clear();
+    clients.clear();
+  }
+
+  void merge(const EndpointStats& o) {
+    count += o.count;
+    for (int i = 0; i < 5; ++i) status_classes[i] += o.status_classes[i];
+    latency.merge(o.latency);
+    clients.merge(o.clients);
+  }
+
+  void serialize(std::string& out) const {
+    put_varint(out, count);
+    for (auto c : status_classes) put_varint(out, c);
+    latency.serialize(out);
+    clients.serialize(out);
+  }
+
+  bool deserialize(std::string_view& in) {
+    EndpointStats s;
+    if (!get_varint(in, s.count)) return false;
+    for (auto& c : s.status_classes) {
+      if (!get_varint(in, c)) return false;
+    }
+    if (!s.latency.deserialize(in) || !s.clients.deserialize(in)) return false;
+    *this = std::move(s);
+    return true;
+  }
+};
+
+} // namespace logforge
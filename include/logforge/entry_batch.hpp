@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "log_entry.hpp"
+#include "path_normalizer.hpp"
+
+namespace logforge {
+
+// Lote de linhas parseadas em colunas (structure of arrays): cada campo do LogEntry vira
+// um array contíguo, consumido pelo Aggregator::add_batch em laços curtos por coluna.
+// Reaproveitável: clear() só zera os contadores, sem tocar na memória. As views apontam
+// para as linhas do lote, que precisam viver até o consumo.
+struct EntryBatch {
+  static constexpr std::size_t kCapacity = 128;
+
+  std::size_t size = 0;       // linhas válidas (linhas 0..size-1 das colunas)
+  std::uint64_t invalid = 0;  // linhas do lote que o parser recusou
+  std::uint64_t filtered = 0; // linhas do lote descartadas pelo --where
+
+  std::string_view endpoint[kCapacity];
+  int status[kCapacity];
+  std::int64_t latency_us[kCapacity];
+  std::int64_t minute[kCapacity];
+  std::string_view method[kCapacity];
+  std::string_view remote_addr[kCapacity];
+  std::string_view user_agent[kCapacity];
+  std::int64_t bytes[kCapacity];
+  // Posições (nas linhas passadas ao parse_batch) das `invalid` linhas recusadas, para o
+  // diagnóstico do --stats; não são escritas sem LOGFORGE_STATS (kStatsCompiled).
+  std::uint16_t rejected[kCapacity];
+
+  void clear() {
+    size = 0;
+    invalid = 0;
+    filtered = 0;
+  }
+
+  void push(const LogEntry& e) {
+    const std::size_t i = size++;
+    endpoint[i] = e.endpoint;
+    status[i] = e.status;
+    latency_us[i] = e.latency_us;
+    minute[i] = e.minute;
+    method[i] = e.method;
+    remote_addr[i] = e.remote_addr;
+    user_agent[i] = e.user_agent;
+    bytes[i] = e.bytes;
+  }
+
+  // Linha i de volta em LogEntry (consumidores por linha: --group-by).
+  LogEntry row(std::size_t i) const {
+    LogEntry e;
+    e.endpoint = endpoint[i];
+    e.status = status[i];
+    e.latency_us = latency_us[i];
+    e.minute = minute[i];
+    e.method = method[i];
+    e.remote_addr = remote_addr[i];
+    e.user_agent = user_agent[i];
+    e.bytes = bytes[i];
+    return e;
+  }
+
+  // --normalize sobre a coluna de endpoints. Cada linha tem o seu buffer, então as views
+  // reescritas continuam válidas até o próximo lote.
+  void normalize(const PathNormalizer& normalizer) {
+    for (std::size_t i = 0; i < size; ++i) endpoint[i] = normalizer.normalize(endpoint[i], norm_buf_[i]);
+  }
+
+private:
+  std::string norm_buf_[kCapacity];
+};
+
+} // namespace logforge
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace logforge {
+
+// Acompanha um arquivo que cresce (tail -F), lendo só os bytes novos.
+//
+// Trata as duas formas de rotação do logrotate:
+//  - rename + novo arquivo: o inode do path muda; o restante do arquivo antigo é drenado
+//    (inclusive a última linha sem '\n') e o novo é aberto do início;
+//  - copytruncate: o tamanho fica menor que o offset; volta ao início do mesmo arquivo
+//    (uma linha parcial pendente é descartada).
+//
+// As esperas usam inotify no diretório do arquivo (Linux); sem inotify, wait() só dorme.
+class FileTailer {
+public:
+  explicit FileTailer(std::string path, std::size_t chunk_size = 1 << 20);
+  ~FileTailer();
+
+  FileTailer(const FileTailer&) = delete;
+  FileTailer& operator=(const FileTailer&) = delete;
+
+  // true se o arquivo foi aberto (no construtor ou depois, quando passou a existir).
+  bool ok() const { return fd_ >= 0; }
+
+  // Lê tudo que foi anexado desde a última chamada e entrega as linhas completas
+  // (sem o '\n'). A linha parcial do fim fica guardada até chegar o '\n'.
+  // Retorna o número de bytes lidos.
+  std::uint64_t poll(const std::function<void(std::string_view)>& on_line);
+
+  // Bloqueia até haver eventos no diretório ou `timeout_ms` expirar.
+  // Retorna true se algum evento foi do arquivo acompanhado (falsos positivos são
+  // inofensivos: poll() sem dados é barato).
+  bool wait(int timeout_ms);
+
+  std::uint64_t offset() const { return offset_; }
+  std::uint64_t rotations() const { return rotations_; }
+  std::uint64_t truncations() const { return truncations_; }
+
+private:
+  std::string path_;
+  std::string name_; // basename, para filtrar eventos do diretório
+  int fd_ = -1;
+  std::uint64_t dev_ = 0;
+  std::uint64_t ino_ = 0;
+  std::uint64_t offset_ = 0;
+  std::uint64_t rotations_ = 0;
+  std::uint64_t truncations_ = 0;
+
+  int inotify_fd_ = -1;
+
+  std::vector<char> buf_;
+  std::string partial_;
+
+  bool open_current();
+  std::uint64_t drain(const std::function<void(std::string_view)>& on_line);
+};
+
+} // namespace logforge
@@ -0,0 +1,100 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "log_entry.hpp"
+
+namespace logforge {
+
+// Campos na ordem em que o NginxParser os extrai: depois de cada um, os predicados que só
+// dependem dele e dos anteriores já podem descartar a linha.
+enum class FilterStage : std::uint8_t { Time, Status, Endpoint, Latency };
+inline constexpr int kFilterStages = 4;
+
+// Expressão do --where, compilada uma vez num programa de desvios plano.
+//
+//   status = 5xx and endpoint = /api/* and time >= 13:00 and time < 14:00
+//   (status >= 500 or latency > 1.5s) and not endpoint = /health
+//
+// Campos e valores:
+//   status    =, != com 404, 5xx ou 500-599; <, <=, >, >= com número
+//   endpoint  =, != com o path exato ou um glob ('*' e '?'); é o endpoint do parser, antes
+//             do --normalize (sinônimo: path)
+//   latency   comparações com unidade us, ms (padrão) ou s; linhas sem latência só
+//             satisfazem as negações (!=, not)
+//   time      comparações com "HH:MM" (hora do dia) ou "AAAA-MM-DD[ HH:MM]" (absoluto;
+//             aspas por causa do espaço), no relógio de per_minute (UTC)
+// Operadores: and/&&, or/||, not/!, parênteses.
+//
+// Cada predicado é uma instrução com dois destinos (próxima instrução se verdadeiro/falso, ou
+// aceita/rejeita), então and/or/not já saem com curto-circuito e a avaliação é um laço sem
+// recursão. Os termos do `and` de topo são agrupados pelo último campo que leem: o programa
+// de cada estágio roda assim que o campo fica disponível (ver NginxParser::parse_line com
+// filtro), e uma condição de tempo corta a linha antes do resto do parse.
+class Filter {
+public:
+  // false (com `err`) se a expressão for inválida; o filtro fica vazio nesse caso.
+  bool compile(std::string_view expr, std::string& err);
+
+  bool empty() const { return code_.empty(); }
+
+  // Só os termos do estágio `s`: quem chama garante que os campos até `s` estão preenchidos.
+  bool pass(FilterStage s, const LogEntry& e) const { return run(entry_[static_cast<int>(s)], e); }
+
+  // Expressão inteira (todos os campos preenchidos).
+  bool matches(const LogEntry& e) const {
+    for (int s = 0; s < kFilterStages; ++s) {
+      if (!run(entry_[s], e)) return false;
+    }
+    return true;
+  }
+
+  std::size_t instruction_count() const { return code_.size(); }
+
+private:
+  static constexpr std::int32_t kAccept = -1;
+  static constexpr std::int32_t kReject = -2;
+
+  // Faixas inclusivas [a, b]; as comparações (=, <, >=, ...) viram faixas e `!=`/not trocam
+  // os destinos da instrução.
+  enum class Op : std::uint8_t {
+    StatusIn,
+    LatencyIn,    // a >= 0: sem latência (-1) nunca está na faixa
+    MinuteIn,
+    DayMinuteIn,  // minuto do dia (0..1439)
+    EndpointEq,   // endpoint == strings_[str]
+    EndpointPrefix,
+    EndpointGlob,
+  };
+
+  struct Instr {
+    Op op = Op::StatusIn;
+    std::uint32_t str = 0;
+    std::int64_t a = 0;
+    std::int64_t b = 0;
+    std::int32_t on_true = kAccept;
+    std::int32_t on_false = kReject;
+  };
+
+  std::vector<Instr> code_;
+  std::vector<std::string> strings_;
+  std::int32_t entry_[kFilterStages] = {kAccept, kAccept, kAccept, kAccept};
+
+  bool run(std::int32_t pc, const LogEntry& e) const {
+    while (pc >= 0) {
+      const Instr& in = code_[static_cast<std::size_t>(pc)];
+      pc = test(in, e) ? in.on_true : in.on_false;
+    }
+    return pc == kAccept;
+  }
+  bool test(const Instr& in, const LogEntry& e) const;
+
+  friend class FilterCompiler;
+};
+
+// Casa `s` com o glob `pattern` ('*' = qualquer sequência, '?' = um caractere).
+bool glob_match(std::string_view pattern, std::string_view s);
+
+} // namespace logforge
@@ -0,0 +1,274 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+namespace logforge {
+
+// Finalizador do MurmurHash3: espalha todos os bits de x (inclusive nos bits baixos,
+// que escolhem o slot).
+inline std::uint64_t mix64(std::uint64_t x) {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+// Hash de strings de 64 bits, 8 bytes por passo, com o mix64 no final. A cauda é lida com
+// cargas de tamanho fixo (a última palavra se sobrepõe à anterior), sem memcpy de tamanho
+// variável.
+inline std::uint64_t hash_string(std::string_view s) {
+  constexpr std::uint64_t k = 0x9e3779b97f4a7c15ULL;
+  const char* p = s.data();
+  const std::size_t n = s.size();
+  auto load64 = [](const char* q) {
+    std::uint64_t w;
+    std::memcpy(&w, q, 8);
+    return w;
+  };
+  auto load32 = [](const char* q) {
+    std::uint32_t w;
+    std::memcpy(&w, q, 4);
+    return static_cast<std::uint64_t>(w);
+  };
+  std::uint64_t h = n * k;
+  if (n > 8) {
+    for (std::size_t i = 0; i + 8 < n; i += 8) h = (h ^ load64(p + i)) * k;
+    h ^= load64(p + n - 8);
+  } else if (n >= 4) {
+    h ^= (load32(p) << 32) | load32(p + n - 4);
+  } else if (n > 0) {
+    h ^= (static_cast<std::uint64_t>(static_cast<unsigned char>(p[0])) << 16) |
+         (static_cast<std::uint64_t>(static_cast<unsigned char>(p[n / 2])) << 8) |
+         static_cast<unsigned char>(p[n - 1]);
+  }
+  return mix64(h);
+}
+
+// Tabela hash de endereçamento aberto (sondagem linear) para chaves pequenas e triviais:
+// ids internados, tuplas empacotadas. Sem nó por entrada como em std::unordered_map:
+// controle, chaves e valores ficam em arrays contíguos. O byte de controle de cada slot
+// guarda 7 bits do hash (0 = vazio), e a sondagem só compara a chave quando ele bate.
+// Não há remoção: os agregadores só crescem.
+//
+// `Hash` devolve 64 bits bem misturados (ver mix64); os bits baixos escolhem o slot e os
+// altos viram o byte de controle.
+template <typename K, typename V, typename Hash>
+class FlatHashMap {
+public:
+  explicit FlatHashMap(std::size_t expected = 0) { rehash(capacity_for(expected)); }
+
+  // Valor de `key`; insere V{} se ausente (e marca `inserted`).
+  V& find_or_insert(const K& key, bool& inserted) {
+    const std::uint64_t h = Hash{}(key);
+    const std::uint8_t t = tag(h);
+    std::size_t i = static_cast<std::size_t>(h) & mask_;
+    while (ctrl_[i] != 0) {
+      if (ctrl_[i] == t && keys_[i] == key) {
+        inserted = false;
+        return values_[i];
+      }
+      i = (i + 1) & mask_;
+    }
+    inserted = true;
+    if ((size_ + 1) * 4 > ctrl_.size() * 3) {
+      rehash(ctrl_.size() * 2);
+      return find_or_insert(key, inserted);
+    }
+    ctrl_[i] = t;
+    keys_[i] = key;
+    values_[i] = V{};
+    size_++;
+    return values_[i];
+  }
+
+  V& operator[](const K& key) {
+    bool inserted = false;
+    return find_or_insert(key, inserted);
+  }
+
+  const V* find(const K& key) const {
+    const std::uint64_t h = Hash{}(key);
+    const std::uint8_t t = tag(h);
+    for (std::size_t i = static_cast<std::size_t>(h) & mask_; ctrl_[i] != 0; i = (i + 1) & mask_) {
+      if (ctrl_[i] == t && keys_[i] == key) return &values_[i];
+    }
+    return nullptr;
+  }
+
+  std::size_t size() const { return size_; }
+  std::size_t memory_bytes() const { return ctrl_.size() * (1 + sizeof(K) + sizeof(V)); }
+
+  // f(chave, valor) para cada entrada, na ordem dos slots (não determinística entre tabelas).
+  template <typename F>
+  void for_each(F&& f) const {
+    for (std::size_t i = 0; i < ctrl_.size(); ++i) {
+      if (ctrl_[i] != 0) f(keys_[i], values_[i]);
+    }
+  }
+
+  void clear() {
+    std::fill(ctrl_.begin(), ctrl_.end(), std::uint8_t{0});
+    size_ = 0;
+  }
+
+private:
+  std::vector<std::uint8_t> ctrl_;
+  std::vector<K> keys_;
+  std::vector<V> values_;
+  std::size_t mask_ = 0;
+  std::size_t size_ = 0;
+
+  static std::uint8_t tag(std::uint64_t h) { return static_cast<std::uint8_t>(0x80 | (h >> 57)); }
+
+  static std::size_t capacity_for(std::size_t n) {
+    std::size_t cap = 16;
+    while (cap * 3 < n * 4) cap *= 2;
+    return cap;
+  }
+
+  void rehash(std::size_t cap) {
+    std::vector<std::uint8_t> ctrl(cap, 0);
+    std::vector<K> keys(cap);
+    std::vector<V> values(cap);
+    const std::size_t mask = cap - 1;
+    for (std::size_t i = 0; i < ctrl_.size(); ++i) {
+      if (ctrl_[i] == 0) continue;
+      std::size_t j = static_cast<std::size_t>(Hash{}(keys_[i])) & mask;
+      while (ctrl[j] != 0) j = (j + 1) & mask;
+      ctrl[j] = ctrl_[i];
+      keys[j] = keys_[i];
+      values[j] = values_[i];
+    }
+    ctrl_.swap(ctrl);
+    keys_.swap(keys);
+    values_.swap(values);
+    mask_ = mask;
+  }
+};
+
+// Índice string -> id de endereçamento aberto, para chaves guardadas em outro lugar (arena
+// da SymbolTable, entradas do SpaceSaving). Cada slot tem a view da chave, o hash completo e
+// o id, num array contíguo: a busca compara o hash antes dos bytes e o rehash não re-hasheia.
+// Quem já tem o hash (ex.: calculado uma vez por linha e usado em vários índices) passa ele
+// direto. Remoção por deslocamento para trás, sem lápides.
+class StringIndex {
+public:
+  static constexpr std::uint32_t kNone = UINT32_MAX;
+
+  explicit StringIndex(std::size_t expected = 0) { rehash(capacity_for(expected)); }
+  StringIndex(const StringIndex&) = default;
+  StringIndex& operator=(const StringIndex&) = default;
+  // O objeto movido fica vazio (sem slots até o próximo insert).
+  StringIndex(StringIndex&& o) noexcept : slots_(std::move(o.slots_)), mask_(o.mask_), size_(o.size_) {
+    o.slots_.clear();
+    o.size_ = 0;
+  }
+  StringIndex& operator=(StringIndex&& o) noexcept {
+    if (this == &o) return *this;
+    slots_ = std::move(o.slots_);
+    mask_ = o.mask_;
+    size_ = o.size_;
+    o.slots_.clear();
+    o.size_ = 0;
+    return *this;
+  }
+
+  std::uint32_t find(std::string_view key, std::uint64_t h) const {
+    if (size_ == 0) return kNone; // inclui o objeto movido, sem slots
+    for (std::size_t i = h & mask_; slots_[i].id != kNone; i = (i + 1) & mask_) {
+      if (matches(slots_[i], key, h)) return slots_[i].id;
+    }
+    return kNone;
+  }
+
+  // false (sem mudar nada) se a chave já estiver no índice. A view precisa continuar válida
+  // enquanto a chave estiver aqui.
+  bool insert(std::string_view key, std::uint64_t h, std::uint32_t id) {
+    if ((size_ + 1) * 4 > slots_.size() * 3) rehash(slots_.size() * 2);
+    std::size_t i = h & mask_;
+    for (; slots_[i].id != kNone; i = (i + 1) & mask_) {
+      if (matches(slots_[i], key, h)) return false;
+    }
+    slots_[i] = Slot{key.data(), h, static_cast<std::uint32_t>(key.size()), id};
+    size_++;
+    return true;
+  }
+
+  void erase(std::string_view key, std::uint64_t h) {
+    if (size_ == 0) return;
+    std::size_t i = h & mask_;
+    for (; slots_[i].id != kNone; i = (i + 1) & mask_) {
+      if (matches(slots_[i], key, h)) break;
+    }
+    if (slots_[i].id == kNone) return;
+    // Puxa para o buraco cada entrada seguinte do grupo cujo slot ideal não fica entre o
+    // buraco e ela (senão a busca pararia no buraco antes de achá-la).
+    for (std::size_t j = (i + 1) & mask_; slots_[j].id != kNone; j = (j + 1) & mask_) {
+      const std::size_t ideal = slots_[j].hash & mask_;
+      if (((j - ideal) & mask_) >= ((j - i) & mask_)) {
+        slots_[i] = slots_[j];
+        i = j;
+      }
+    }
+    slots_[i] = Slot{};
+    size_--;
+  }
+
+  void clear() {
+    std::fill(slots_.begin(), slots_.end(), Slot{});
+    size_ = 0;
+  }
+
+  void reserve(std::size_t n) {
+    if (capacity_for(n) > slots_.size()) rehash(capacity_for(n));
+  }
+
+  std::size_t size() const { return size_; }
+  std::size_t capacity() const { return slots_.size(); }
+  double load_factor() const { return slots_.empty() ? 0.0 : static_cast<double>(size_) / static_cast<double>(slots_.size()); }
+  std::size_t memory_bytes() const { return slots_.size() * sizeof(Slot); }
+
+private:
+  struct Slot {
+    const char* data = nullptr;
+    std::uint64_t hash = 0;
+    std::uint32_t len = 0;
+    std::uint32_t id = kNone; // kNone = vazio
+  };
+
+  std::vector<Slot> slots_;
+  std::size_t mask_ = 0;
+  std::size_t size_ = 0;
+
+  static bool matches(const Slot& s, std::string_view key, std::uint64_t h) {
+    return s.hash == h && s.len == key.size() && (key.empty() || std::memcmp(s.data, key.data(), key.size()) == 0);
+  }
+
+  static std::size_t capacity_for(std::size_t n) {
+    std::size_t cap = 16;
+    while (cap * 3 < n * 4) cap *= 2;
+    return cap;
+  }
+
+  void rehash(std::size_t cap) {
+    cap = std::max<std::size_t>(cap, 16);
+    std::vector<Slot> slots(cap);
+    const std::size_t mask = cap - 1;
+    for (const auto& s : slots_) {
+      if (s.id == kNone) continue;
+      std::size_t j = s.hash & mask;
+      while (slots[j].id != kNone) j = (j + 1) & mask;
+      slots[j] = s;
+    }
+    slots_.swap(slots);
+    mask_ = mask;
+  }
+};
+
+} // namespace logforge
@@ -0,0 +1,31 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "aggregator.hpp"
+#include "ingest.hpp"
+
+namespace logforge {
+
+struct FollowOptions {
+  int interval_sec = 10;                      // reescreve report.json a cada N segundos
+  const std::atomic<bool>* stop = nullptr;    // sinalizado pelo handler de SIGINT/SIGTERM
+};
+
+struct FollowStats {
+  std::uint64_t bytes = 0;
+  std::uint64_t snapshots = 0;   // quantas vezes report.json foi reescrito
+  std::uint64_t rotations = 0;
+  std::uint64_t truncations = 0;
+};
+
+// Modo --follow: processa o arquivo desde o início e continua acompanhando o que é
+// anexado (sobrevive ao logrotate). O trabalho por iteração é proporcional aos bytes
+// novos; a cada `interval_sec` o relatório é finalizado sem destruir o estado e
+// report.json é reescrito atomicamente. Ao parar, escreve JSON + CSVs uma última vez.
+// Retorna false se o arquivo não puder ser aberto ou um relatório não puder ser escrito.
+bool follow_file(const std::string& path, const std::string& out_dir, const IngestOptions& opt,
+                 const FollowOptions& fopt, Aggregator& agg, FollowStats* stats = nullptr);
+
+} // namespace logforge
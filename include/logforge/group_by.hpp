@@ -0,0 +1,118 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "flat_hash.hpp"
+#include "latency_sketch.hpp"
+#include "log_entry.hpp"
+#include "symbol_table.hpp"
+
+namespace logforge {
+
+// Dimensões do --group-by (campos de LogEntry).
+enum class GroupDim : std::uint8_t { Endpoint, Status, StatusClass, Method, Ip, UserAgent, Minute };
+inline constexpr int kGroupDims = 7;
+
+const char* group_dim_name(GroupDim d);
+
+// --group-by endpoint,status_class --agg count,sum(bytes),p95,distinct(ip)
+struct GroupBySpec {
+  static constexpr std::size_t kMaxDims = 4;
+
+  std::vector<GroupDim> dims;     // 1..kMaxDims, sem repetição; vazio = desligado
+  bool sum_bytes = false;         // sum(bytes)
+  std::vector<double> quantiles;  // p50, p99.9, ... (latência por grupo)
+  std::vector<GroupDim> distinct; // distinct(ip), ...: valores distintos por grupo
+
+  bool enabled() const { return !dims.empty(); }
+  bool operator==(const GroupBySpec& o) const {
+    return dims == o.dims && sum_bytes == o.sum_bytes && quantiles == o.quantiles && distinct == o.distinct;
+  }
+  bool operator!=(const GroupBySpec& o) const { return !(*this == o); }
+
+  // Colunas dos agregados, na ordem de GroupRow: count, sum_bytes, p95_ms, distinct_ip...
+  std::vector<std::string> aggregate_columns() const;
+  // Usa method, ip, ua ou bytes (como dimensão, distinct ou sum(bytes))?
+  bool needs_client_fields() const;
+};
+
+// `dims`: dimensões separadas por vírgula (endpoint, status, status_class, method, ip, ua,
+// minute); `aggs`: count, sum(bytes), pNN, distinct(<dimensão>) (vazio = só count).
+// false (com `err`) se algo for inválido.
+bool parse_group_by(std::string_view dims, std::string_view aggs, GroupBySpec& out, std::string& err);
+
+// Linha de group_by.csv / seção "group_by" do JSON.
+struct GroupRow {
+  std::vector<std::string> key;        // um valor por dimensão, já formatado
+  std::uint64_t count = 0;
+  std::uint64_t bytes = 0;             // só com sum(bytes); linhas sem bytes somam 0
+  std::vector<double> quantiles_ms;    // -1 se o grupo não tiver latência
+  std::vector<std::uint64_t> distinct; // exato
+};
+
+// Agregação por hash sobre dimensões arbitrárias.
+//
+// Cada valor de dimensão vira um inteiro: strings (endpoint, método, ip, UA) são internadas
+// numa SymbolTable por dimensão e os números (status, classe, minuto) entram direto. A tupla
+// desses inteiros é a chave de uma FlatHashMap que dá o id denso do grupo; os agregados
+// ficam em vetores paralelos indexados por esse id (só os pedidos existem). distinct(x)
+// usa um único conjunto plano de pares (grupo, valor): o par novo incrementa o grupo.
+//
+// merge() traduz os ids internados do outro lado e é exato (inclusive o distinct), então
+// o resultado não depende da partição entre threads ou snapshots.
+class GroupBy {
+public:
+  explicit GroupBy(const GroupBySpec& spec);
+
+  void add(const LogEntry& e);
+  void merge(const GroupBy& other);
+
+  // Ordenado por count desc (empate: chave asc).
+  std::vector<GroupRow> rows() const;
+
+  std::size_t size() const { return keys_.size(); }
+  const GroupBySpec& spec() const { return spec_; }
+
+  // Estado completo (spec, strings, grupos e pares distintos) para snapshots.
+  void serialize(std::string& out) const;
+  // Substitui o estado, inclusive a spec; false se os dados forem inválidos.
+  bool deserialize(std::string_view& in);
+
+private:
+  using Key = std::array<std::uint64_t, GroupBySpec::kMaxDims>;
+  using Pair = std::array<std::uint64_t, 2>; // (grupo, valor) do distinct
+
+  struct KeyHash {
+    std::uint64_t operator()(const Key& k) const {
+      std::uint64_t h = 0;
+      for (auto v : k) h = mix64(h ^ v) + v;
+      return mix64(h);
+    }
+  };
+  struct PairHash {
+    std::uint64_t operator()(const Pair& p) const { return mix64(mix64(p[0]) ^ p[1]); }
+  };
+
+  GroupBySpec spec_;
+  SymbolTable strings_[kGroupDims]; // só as dimensões de string usadas têm entradas
+
+  FlatHashMap<Key, std::uint32_t, KeyHash> index_;
+  std::vector<Key> keys_;             // id do grupo -> chave
+  std::vector<std::uint64_t> counts_;
+  std::vector<std::uint64_t> bytes_;  // só com sum(bytes)
+  std::vector<LatencySketch> latency_; // só com quantis
+
+  // Um conjunto e um contador por grupo para cada distinct(x).
+  std::vector<FlatHashMap<Pair, std::uint8_t, PairHash>> distinct_sets_;
+  std::vector<std::vector<std::uint64_t>> distinct_counts_;
+
+  std::uint64_t value_of(GroupDim d, const LogEntry& e);
+  std::string format_value(GroupDim d, std::uint64_t v) const;
+  std::uint32_t group_of(const Key& k);
+  void add_distinct(std::size_t i, std::uint64_t group, std::uint64_t value);
+};
+
+} // namespace logforge
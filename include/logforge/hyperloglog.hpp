@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace logforge {
+
+// Hash de 64 bits estável entre plataformas (FNV-1a + finalizador do MurmurHash3): os
+// registradores vão para snapshots, então não dá para usar std::hash.
+std::uint64_t hll_hash(std::string_view s);
+
+// Contagem aproximada de valores distintos (HyperLogLog++).
+//
+// Como no HLL++: hash de 64 bits (sem correção para cardinalidades grandes) e uma
+// representação esparsa para poucos valores — lista ordenada de (índice com 25 bits, rho),
+// estimada por linear counting em 2^25 buckets, praticamente exata. Quando a lista ocuparia
+// mais que os 2^p registradores de 1 byte, vira densa. No lugar das tabelas empíricas de
+// viés do HLL++, a estimativa densa usa o estimador melhorado de Ertl (2017), sem viés
+// em toda a faixa.
+//
+// Memória: no máximo 2^p bytes (p = 12: 4 KB, erro padrão ~1.6%), independente do tráfego.
+// merge() é exato (máximo por registrador): o resultado não depende da partição.
+// Com precisão 0 o sketch fica desligado: não conta nada e não ocupa memória.
+class HyperLogLog {
+public:
+  static constexpr int kMinPrecision = 4;
+  static constexpr int kMaxPrecision = 18;
+  static constexpr int kDefaultPrecision = 12;
+
+  explicit HyperLogLog(int precision = 0);
+
+  bool enabled() const { return p_ != 0; }
+  int precision() const { return p_; }
+  bool sparse() const { return dense_.empty(); }
+
+  void add_hash(std::uint64_t h);
+  void add(std::string_view s) { add_hash(hll_hash(s)); }
+
+  // false se as precisões forem diferentes (um lado desligado adota o outro).
+  bool merge(const HyperLogLog& other);
+
+  std::uint64_t estimate() const;
+  // Erro padrão relativo da representação densa (1.04 / sqrt(2^p)).
+  double relative_error() const;
+
+  // Esvazia mantendo a precisão (volta à representação esparsa).
+  void clear();
+
+  std::size_t memory_bytes() const {
+    return sizeof(*this) + sparse_.capacity() * sizeof(std::uint32_t) + dense_.capacity();
+  }
+
+  // Precisão, modo e conteúdo (esparso em delta, denso em bytes crus).
+  void serialize(std::string& out) const;
+  // Substitui o estado, inclusive a precisão; false se os dados forem inválidos.
+  bool deserialize(std::string_view& in);
+
+private:
+  static constexpr int kSparseBits = 25;
+
+  int p_ = 0;
+  // Esparso: (índice de 25 bits << 6) | rho, ordenado e único por índice.
+  std::vector<std::uint32_t> sparse_;
+  std::vector<std::uint8_t> dense_; // 2^p registradores, quando denso
+
+  void add_sparse(std::uint32_t entry);
+  void add_dense_entry(std::uint32_t entry);
+  void to_dense();
+};
+
+} // namespace logforge
@@ -0,0 +1,195 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "aggregator.hpp"
+#include "compressed_reader.hpp"
+#include "entry_batch.hpp"
+#include "line_source.hpp"
+#include "nginx_scan.hpp"
+#include "parser_nginx.hpp"
+#include "path_normalizer.hpp"
+#include "run_stats.hpp"
+
+namespace logforge {
+
+struct IngestOptions {
+  int threads = 1;
+  ReaderKind reader = ReaderKind::Mmap;
+  bool direct_io = false; // O_DIRECT no ReaderKind::Async (--direct)
+  Isa isa = detect_isa(); // ISA do tokenizador do NginxParser
+  // Parse e agregação em lotes de EntryBatch::kCapacity linhas quando a fonte permite
+  // (mmap); false = uma linha por vez, como no --follow (--no-batch, para comparar).
+  bool batch = true;
+  // Parser de outro formato (--format, --log-format, ...; ver make_parser). nullptr = o
+  // NginxParser embutido, sem chamada virtual por linha. Pertence a quem chama.
+  const Parser* parser = nullptr;
+  // Normalização de paths antes da agregação (nullptr = desligada). Pertence a quem chama.
+  const PathNormalizer* normalizer = nullptr;
+  // Filtro --where aplicado durante o parse (nullptr = todas as linhas). Pertence a quem chama.
+  const Filter* filter = nullptr;
+};
+
+// Medidas da leitura, para o --bench e o --stats (tempos somados entre threads).
+struct IngestStats {
+  // Multi-arquivo (ingest_files).
+  std::size_t files = 0;
+  std::size_t tasks = 0;       // pedaços distribuídos entre os workers
+  std::uint64_t steals = 0;    // pedaços pegos da fila de outro worker
+  std::string failed_path;     // primeiro arquivo que falhou
+
+  Compression compression = Compression::None;
+  int streams = 0;                      // faixas descomprimidas em paralelo
+  std::uint64_t decompressed_bytes = 0;
+  double decompress_sec = 0.0;          // threads de descompressão
+  double parse_sec = 0.0;               // threads de parse, sem a espera por blocos
+
+  SourceStats sources; // leitores que rodaram de fato
+};
+
+// Lote de linhas -> EntryBatch -> sink, em pedaços de EntryBatch::kCapacity. Com o tipo
+// concreto do parser (final), o parse de cada linha é chamado sem vtable; com `Parser`, o
+// despacho é um só por pedaço. SinkT: qualquer tipo com add_batch(const EntryBatch&) (ex.:
+// Aggregator). As linhas precisam continuar válidas até o sink consumir o pedaço.
+// Com `stats` (--stats), cada pedaço é cronometrado (parse; normalização + sink) e as linhas
+// recusadas passam pelo diagnóstico do parser.
+template <typename ParserT, typename SinkT>
+void process_batch(const ParserT& parser, std::span<const std::string_view> lines, const Filter* filter,
+                   const PathNormalizer* normalizer, EntryBatch& batch, SinkT& sink, RunStats* stats = nullptr) {
+  const bool timed = kStatsCompiled && stats;
+  for (std::size_t i = 0; i < lines.size(); i += EntryBatch::kCapacity) {
+    const auto chunk = lines.subspan(i, std::min(EntryBatch::kCapacity, lines.size() - i));
+    batch.clear();
+    const std::uint64_t t0 = timed ? stats_clock() : 0;
+    parser.parse_batch(chunk, filter, batch);
+    const std::uint64_t t1 = timed ? stats_clock() : 0;
+    if (normalizer) batch.normalize(*normalizer);
+    sink.add_batch(batch);
+    if (timed) {
+      stats->add(Stage::Parse, t1 - t0);
+      stats->add(Stage::Aggregate, stats_clock() - t1);
+      for (std::size_t k = 0; k < batch.invalid; ++k) {
+        const auto line = chunk[batch.rejected[k]];
+        stats->reject(parser.reject_reason(line), line);
+      }
+    }
+  }
+}
+
+// Parser -> normalização -> Aggregator para uma linha. Estado por thread
+// (buffers reaproveitados), usado tanto no modo batch quanto no --follow.
+class LinePipeline {
+public:
+  LinePipeline(const IngestOptions& opt, Aggregator& agg)
+      : parser_(opt.isa, agg.needs_client_fields()), format_(opt.parser), normalizer_(opt.normalizer), filter_(opt.filter), agg_(agg),
+        stats_(agg.stats()) {}
+
+  void process(std::string_view line) {
+    if (kStatsCompiled && stats_ && ++tick_ % RunStats::kSampleEvery == 0) {
+      process_timed(line);
+      return;
+    }
+    if (format_) {
+      LogEntry e;
+      accept(format_->parse(line, filter_, e), e, line);
+      return;
+    }
+    if (filter_) {
+      process_filtered(line);
+      return;
+    }
+    auto entry = parser_.parse_line(line);
+    if (!entry) {
+      agg_.add_invalid();
+      if (kStatsCompiled && stats_) stats_->reject(parser_.reject_reason(line), line);
+      return;
+    }
+    if (normalizer_) entry->endpoint = normalizer_->normalize(entry->endpoint, norm_buf_);
+    agg_.add_valid(*entry);
+  }
+
+  void process_filtered(std::string_view line) {
+    LogEntry e;
+    accept(parser_.parse_line(line, *filter_, e), e, line);
+  }
+
+  // Várias linhas de uma vez (ver process_batch), para fontes cujas views continuam válidas
+  // (LineSource::stable_views). Mesmo resultado que process em cada linha.
+  void process_lines(std::span<const std::string_view> lines) {
+    if (!batch_) batch_ = std::make_unique<EntryBatch>();
+    if (format_) process_batch(*format_, lines, filter_, normalizer_, *batch_, agg_, stats_);
+    else process_batch(parser_, lines, filter_, normalizer_, *batch_, agg_, stats_);
+  }
+
+private:
+  NginxParser parser_;
+  const Parser* format_;
+  const PathNormalizer* normalizer_;
+  const Filter* filter_;
+  Aggregator& agg_;
+  std::string norm_buf_;
+  std::unique_ptr<EntryBatch> batch_; // só no modo em lote (~16 KB)
+  RunStats* stats_;                   // --stats (nullptr = desligado)
+  std::uint64_t tick_ = 0;            // linhas vistas, para a amostragem do --stats
+
+  // Uma linha cronometrada (1 em RunStats::kSampleEvery): parse, depois normalização +
+  // agregação; os tempos entram multiplicados pela taxa de amostragem.
+  void process_timed(std::string_view line) {
+    LogEntry e;
+    const std::uint64_t t0 = stats_clock();
+    const ParseResult r = format_ ? format_->parse(line, filter_, e) : parser_.parse(line, filter_, e);
+    const std::uint64_t t1 = stats_clock();
+    accept(r, e, line);
+    stats_->add(Stage::Parse, (t1 - t0) * RunStats::kSampleEvery);
+    stats_->add(Stage::Aggregate, (stats_clock() - t1) * RunStats::kSampleEvery);
+  }
+
+  void accept(ParseResult r, LogEntry& e, std::string_view line) {
+    switch (r) {
+      case ParseResult::Invalid:
+        agg_.add_invalid();
+        if (kStatsCompiled && stats_) {
+          stats_->reject(format_ ? format_->reject_reason(line) : parser_.reject_reason(line), line);
+        }
+        return;
+      case ParseResult::Filtered: agg_.add_filtered(); return;
+      case ParseResult::Ok: break;
+    }
+    if (normalizer_) e.endpoint = normalizer_->normalize(e.endpoint, norm_buf_);
+    agg_.add_valid(e);
+  }
+};
+
+// Divide o arquivo em até `parts` faixas alinhadas em '\n'.
+// Retorna vazio se o arquivo não puder ser aberto. O que não é arquivo regular (pipe, FIFO,
+// /dev/stdin) não tem tamanho nem volta atrás: vira uma faixa só, {0, UINT64_MAX}.
+std::vector<ByteRange> split_file(const std::string& path, int parts);
+
+// Processa as linhas que começam dentro de `range` (Reader -> Parser -> Aggregator). Com
+// `sources`, conta o leitor usado.
+bool ingest_range(const std::string& path, ByteRange range, const IngestOptions& opt,
+                  Aggregator& agg, SourceStats* sources = nullptr);
+
+// Processa o arquivo inteiro com `opt.threads` workers, cada um com um Aggregator local,
+// e combina tudo em `out` via Aggregator::merge.
+//
+// Entrada gzip/zstd é detectada pelos magic bytes e descomprimida em pipeline com o parse.
+// zstd com vários frames (zstd -T0, pzstd, ...) é dividido em faixas de frames processadas
+// em paralelo; as linhas que atravessam a fronteira entre faixas são costuradas no final.
+// gzip é sempre sequencial (não há como achar fronteiras sem descomprimir).
+bool ingest_file(const std::string& path, const IngestOptions& opt, Aggregator& out,
+                 IngestStats* stats = nullptr);
+
+// Vários arquivos (ver expand_inputs) num relatório só. Arquivos grandes viram pedaços
+// (faixas alinhadas em linha; zstd: grupos de frames) e os pequenos vão inteiros. Os
+// pedaços são distribuídos do maior para o menor em filas por worker; quem esvazia a sua
+// rouba do fim da fila de outro (work stealing), então um arquivo 50x maior que os demais
+// não deixa núcleos parados. Cada worker alimenta um Aggregator local, combinado em `out`.
+bool ingest_files(const std::vector<std::string>& paths, const IngestOptions& opt, Aggregator& out,
+                  IngestStats* stats = nullptr);
+
+} // namespace logforge
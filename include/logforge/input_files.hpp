@@ -0,0 +1,15 @@
+#pragma once
+#include <string>
+#include <vector>
+
+namespace logforge {
+
+// Expande as entradas do --in em arquivos regulares:
+//  - diretório: os arquivos regulares dentro dele (sem recursão, ocultos ignorados);
+//  - padrão com * ? [ ]: glob(3), útil quando o shell não expandiu ('logs/*.log.gz');
+//  - qualquer outro valor: o próprio caminho.
+// A ordem segue a das entradas (cada diretório/glob em ordem alfabética), sem repetidos.
+// Retorna false (com `err`) se alguma entrada não existir ou não casar com nada.
+bool expand_inputs(const std::vector<std::string>& specs, std::vector<std::string>& out, std::string& err);
+
+} // namespace logforge
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "log_format.hpp"
+
+namespace logforge {
+
+// Parser de JSON lines (um objeto por linha, ex.: log_format escape=json do nginx) que não
+// monta DOM: percorre as chaves do objeto de topo, guarda só os valores das chaves
+// conhecidas (string_view na linha, aspas removidas, escapes mantidos) e pula o resto —
+// objetos e arrays aninhados inclusive — sem interpretar. Para assim que todos os campos
+// mapeados apareceram. As aspas saem da máscara estrutural da linha (a mesma do
+// NginxParser, montada numa passada SIMD), então cada string custa uma busca de bit.
+//
+// Chaves padrão (a primeira que aparecer ganha):
+//   tempo     time_local, time_iso8601, time, timestamp, @timestamp, ts, msec — o tipo do
+//             valor decide: "10/Oct/2000:13:55:36 -0700", ISO 8601 ou número (época em s;
+//             acima de 1e11, em ms)
+//   status    status, status_code
+//   request   request ("GET /x HTTP/1.1")     uri: request_uri, uri, path, url
+//   method    request_method, method          client: remote_addr, client_ip, client, ip
+//   ua        http_user_agent, user_agent     bytes: body_bytes_sent, bytes_sent, bytes
+//   latência  request_time, duration (s); upstream_response_time (s);
+//             latency_ms, duration_ms; latency_us, duration_us
+class JsonLinesParser final : public Parser {
+public:
+  explicit JsonLinesParser(Isa isa = detect_isa());
+
+  // Troca chaves: "status=code,uri=req_path,latency_ms=took" (campos: time, status, request,
+  // uri, method, client, ua, bytes, latency, latency_ms, latency_us). Cada campo citado
+  // substitui as chaves padrão do seu grupo (request/uri são um grupo; as três latências,
+  // outro). false (com err) se a especificação for inválida.
+  bool set_keys(std::string_view spec, std::string& err);
+
+  ParseResult parse(std::string_view line, const Filter* filter, LogEntry& out) const override;
+  void parse_batch(std::span<const std::string_view> lines, const Filter* filter, EntryBatch& out) const override;
+
+private:
+  // Grupos de campos (tempo, status, endpoint, método, cliente, ua, bytes, latência): em cada
+  // um vale a primeira chave que aparecer na linha.
+  struct Key {
+    std::string name;
+    FormatField field = FormatField::Skip; // TimeLocal = tempo, tipo decidido pelo valor
+    std::uint8_t group = 0;
+  };
+
+  Isa isa_;
+  std::vector<Key> keys_;
+  std::vector<std::uint8_t> by_len_[32]; // índices em keys_ por tamanho da chave (até 31)
+  std::uint32_t wanted_ = 0;             // grupos com alguma chave: achou todos, para
+
+  void add_key(std::string_view name, FormatField field);
+  const Key* find_key(std::string_view name) const;
+
+  // `next_quote(from)`: primeira '"' em [from, fim) ou npos.
+  template <typename NextQuote>
+  ParseResult parse_object(std::string_view line, NextQuote&& next_quote, const Filter* filter, LogEntry& out) const;
+};
+
+} // namespace logforge
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace logforge {
+
+// Histograma log-linear (estilo HdrHistogram) de latências em microssegundos.
+//
+// Valores < 2^(b+1) têm bucket exato; acima disso cada oitava [2^k, 2^(k+1)) é dividida
+// em 2^b buckets iguais, então o erro relativo do quantil fica <= 1 / 2^(b+1).
+// O número de buckets é limitado pela faixa de 64 bits (~(65 - b) * 2^b), não pela entrada.
+// Opcionalmente `max_buckets` impõe um teto menor: os buckets mais baixos são colapsados
+// (como no DDSketch), preservando a precisão dos quantis altos.
+//
+// merge() soma buckets e é exato: o estado final não depende da ordem/partição da entrada.
+class LatencySketch {
+public:
+  explicit LatencySketch(double relative_error = 0.01, std::uint32_t max_buckets = 0);
+
+  void add(std::uint64_t value_us, std::uint64_t n = 1);
+  // Coluna de latências de um lote; valores negativos (sem latência) são ignorados.
+  void add_batch(const std::int64_t* values_us, std::size_t n);
+  // false se os sketches tiverem configurações diferentes.
+  bool merge(const LatencySketch& other);
+
+  std::uint64_t count() const { return count_; }
+  std::uint64_t sum() const { return sum_; }
+  std::uint64_t min() const { return min_; }
+  std::uint64_t max() const { return max_; }
+
+  // Esvazia mantendo a configuração e a memória dos buckets (reuso sem realocar).
+  void clear();
+
+  // Quantil q em [0, 1] (microssegundos); -1 se vazio.
+  double quantile(double q) const;
+  // Erro relativo garantido pelos buckets (sem colapso).
+  double relative_error() const;
+
+  std::size_t bucket_count() const { return counts_.size(); }
+  std::size_t memory_bytes() const { return sizeof(*this) + counts_.capacity() * sizeof(std::uint64_t); }
+
+  // Formato compacto: varints + só os buckets não-vazios (delta de índice).
+  void serialize(std::string& out) const;
+  // Lê de `in` (avançando) e substitui o estado; false se os dados forem inválidos.
+  bool deserialize(std::string_view& in);
+
+private:
+  int sub_bits_;
+  std::uint32_t max_buckets_;
+
+  std::uint64_t count_ = 0;
+  std::uint64_t sum_ = 0;
+  std::uint64_t min_ = 0;
+  std::uint64_t max_ = 0;
+
+  // Buckets densos [offset_, offset_ + counts_.size()).
+  std::int64_t offset_ = 0;
+  std::vector<std::uint64_t> counts_;
+
+  std::int64_t index_of(std::uint64_t v) const;
+  std::uint64_t lower_bound_of(std::int64_t idx) const;
+  std::uint64_t width_of(std::int64_t idx) const;
+  void add_at(std::int64_t idx, std::uint64_t n);
+};
+
+} // namespace logforge
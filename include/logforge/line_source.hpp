@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace logforge {
+
+// Faixa de bytes [begin, end) de um arquivo; begin sempre é início de linha.
+struct ByteRange {
+  std::uint64_t begin = 0;
+  std::uint64_t end = UINT64_MAX;
+};
+
+// Fonte de linhas. A view devolvida por next_line só é válida até a próxima chamada.
+class LineSource {
+public:
+  virtual ~LineSource() = default;
+  virtual bool ok() const = 0;
+  virtual bool next_line(std::string_view& out) = 0;
+
+  // Lotes. true se, depois de hold_views(), as views continuam válidas até release_views():
+  // aí as linhas podem ser juntadas antes do parse. O mmap vale até ser destruído; o leitor
+  // assíncrono segura os blocos do lote em vez de devolvê-los ao read-ahead.
+  virtual bool stable_views() const { return false; }
+  virtual void hold_views() {}
+  // Com as views seguras: true quando a fonte não consegue entregar outra linha sem que as
+  // anteriores sejam liberadas (o lote precisa ser processado antes do próximo next_line).
+  virtual bool release_due() const { return false; }
+  virtual void release_views() {}
+};
+
+enum class ReaderKind {
+  Stream, // std::ifstream + getline (copia cada linha)
+  Mmap,   // arquivo mapeado em memória (zero-copy)
+  Async,  // blocos alinhados lidos à frente via io_uring (ou pread numa thread)
+};
+
+// Leitores que rodaram de fato, por fonte aberta: o --reader pedido pode cair em outro
+// (pipe/FIFO -> stream, gzip/zstd -> descompressão, io_uring negado -> pread, O_DIRECT
+// recusado pelo sistema de arquivos -> page cache). Para o --bench e o --stats.
+struct SourceStats {
+  std::size_t mmap = 0;
+  std::size_t stream = 0;
+  std::size_t compressed = 0;
+  std::size_t uring = 0;     // AsyncLineReader com io_uring
+  std::size_t pread = 0;     // AsyncLineReader com a thread de pread
+  std::size_t direct = 0;    // assíncronas com O_DIRECT em uso até o fim
+  std::size_t batched = 0;   // lidas em lotes; as demais, linha a linha
+  double io_wait_sec = 0.0;  // AsyncLineReader parado esperando bloco (somado entre fontes)
+
+  std::size_t sources() const { return mmap + stream + compressed + uring + pread; }
+  void merge(const SourceStats& o) {
+    mmap += o.mmap;
+    stream += o.stream;
+    compressed += o.compressed;
+    uring += o.uring;
+    pread += o.pread;
+    direct += o.direct;
+    batched += o.batched;
+    io_wait_sec += o.io_wait_sec;
+  }
+};
+
+// Conta `src` (depois de lida) em `out`.
+void record_source(const LineSource& src, bool batched, SourceStats& out);
+
+// Abre a fonte pedida; se o mmap ou a leitura assíncrona não forem possíveis, cai para
+// Stream. Pipes e FIFOs (ex.: /dev/stdin) vão direto para Stream. `direct` pede O_DIRECT ao leitor Async (ignorado pelos outros).
+// Arquivos gzip/zstd (detectados pelos magic bytes) são descomprimidos em pipeline,
+// ignorando `kind`. zstd aceita `range` em bytes comprimidos, alinhada em frames; gzip só
+// o arquivo inteiro (outra faixa dá uma fonte com ok() false; ver open_decoder).
+std::unique_ptr<LineSource> open_line_source(const std::string& path, ReaderKind kind,
+                                             ByteRange range = {}, bool direct = false);
+
+} // namespace logforge
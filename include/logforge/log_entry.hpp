@@ -1,15 +1,26 @@
 #pragma once
 #include <cstdint>
-#include <string>
+#include <limits>
+#include <string_view>
 
 namespace logforge {
 
+// Sem minuto associado.
+inline constexpr std::int64_t kNoMinute = std::numeric_limits<std::int64_t>::min();
+
 // Representa uma linha de log já normalizada.
+// Não aloca: as string_views apontam para a linha original e só valem enquanto ela existir.
 struct LogEntry {
-  std::string endpoint;       // ex: "/api/items" (sem querystring)
-  int status = 0;             // ex: 200
-  int latency_ms = -1;        // -1 se não houver
-  std::string minute_key;     // ex: "2000-10-10 13:55" (para pico por minuto)
+  std::string_view endpoint;         // ex: "/api/items" (sem querystring)
+  int status = 0;                    // ex: 200
+  std::int64_t latency_us = -1;      // request_time em microssegundos; -1 se não houver
+  std::int64_t minute = kNoMinute;   // minutos desde 1970-01-01 00:00 (ver time_util.hpp)
+
+  // Campos que só o --group-by usa; vazios/-1 se a linha não os tiver.
+  std::string_view method{};         // ex: "GET"
+  std::string_view remote_addr{};    // ex: "127.0.0.1"
+  std::string_view user_agent{};     // conteúdo do terceiro par de aspas
+  std::int64_t bytes = -1;           // body_bytes_sent; -1 se "-" ou ausente
 };
 
 } // namespace logforge
@@ -0,0 +1,508 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "nginx_scan.hpp"
+#include "parser.hpp"
+
+namespace logforge {
+
+// Campos que um formato de log pode trazer. Variáveis que o LogForge não usa viram Skip:
+// são puladas sem conversão nenhuma.
+enum class FormatField : std::uint8_t {
+  None,         // passo só com literal
+  Skip,
+  RemoteAddr,   // $remote_addr, %h, %a
+  TimeLocal,    // $time_local, %t: 10/Oct/2000:13:55:36 -0700
+  TimeIso8601,  // $time_iso8601: 2000-10-10T13:55:36-07:00
+  TimeEpoch,    // $msec, %{sec}t: segundos desde a época (UTC)
+  TimeEpochMs,  // %{msec}t
+  Request,      // $request, %r: METHOD PATH PROTO
+  Method,       // $request_method, %m
+  Uri,          // $request_uri, $uri, %U
+  Status,       // $status, %s, %>s
+  BodyBytes,    // $body_bytes_sent, $bytes_sent, %b, %B, %O
+  UserAgent,    // $http_user_agent, %{User-Agent}i
+  RequestTime,  // $request_time, %T, %{s}T: segundos
+  LatencyMs,    // %{ms}T
+  LatencyUs,    // %D, %{us}T
+  UpstreamTime, // $upstream_response_time: segundos, vários upstreams somados
+};
+inline constexpr int kFormatFields = 17;
+
+// Um passo do plano: confere o literal e captura o campo até o byte `stop`.
+struct FormatStep {
+  static constexpr std::size_t kMaxLiteral = 14; // literais maiores viram vários passos
+
+  char lit[kMaxLiteral] = {};
+  std::uint8_t lit_len = 0;
+  FormatField field = FormatField::None;
+  char stop = 0;         // primeiro byte do literal seguinte; 0 = até o fim da linha
+  bool quoted = false;   // campo entre aspas: \" não encerra
+};
+
+// Formato compilado num plano de pulos: literal, campo até o próximo delimitador, literal...
+// Cada campo é achado com um memchr pelo primeiro byte do literal que vem depois dele, sem
+// olhar os bytes de dentro. Tamanho fixo para poder ser montado em constexpr.
+struct FormatPlan {
+  static constexpr std::size_t kMaxSteps = 40;
+
+  FormatStep steps[kMaxSteps] = {};
+  std::size_t size = 0;
+  bool has[kFormatFields] = {};  // campos presentes no formato
+  const char* error = nullptr;   // nullptr = compilou
+};
+
+enum class FormatDialect { Nginx, Apache };
+
+namespace format_detail {
+
+struct Var {
+  std::string_view name;
+  FormatField field;
+};
+
+// Variáveis do nginx que o LogForge usa (o resto é Skip).
+inline constexpr Var kNginxVars[] = {
+    {"remote_addr", FormatField::RemoteAddr},       {"realip_remote_addr", FormatField::RemoteAddr},
+    {"time_local", FormatField::TimeLocal},         {"time_iso8601", FormatField::TimeIso8601},
+    {"msec", FormatField::TimeEpoch},               {"request", FormatField::Request},
+    {"request_method", FormatField::Method},        {"request_uri", FormatField::Uri},
+    {"uri", FormatField::Uri},                      {"document_uri", FormatField::Uri},
+    {"status", FormatField::Status},                {"body_bytes_sent", FormatField::BodyBytes},
+    {"bytes_sent", FormatField::BodyBytes},         {"http_user_agent", FormatField::UserAgent},
+    {"request_time", FormatField::RequestTime},     {"upstream_response_time", FormatField::UpstreamTime},
+};
+
+constexpr FormatField nginx_var(std::string_view name) {
+  for (const auto& v : kNginxVars) {
+    if (v.name == name) return v.field;
+  }
+  return FormatField::Skip;
+}
+
+constexpr bool ieq(std::string_view a, std::string_view b) {
+  if (a.size() != b.size()) return false;
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    char x = a[i], y = b[i];
+    if (x >= 'A' && x <= 'Z') x = static_cast<char>(x - 'A' + 'a');
+    if (y >= 'A' && y <= 'Z') y = static_cast<char>(y - 'A' + 'a');
+    if (x != y) return false;
+  }
+  return true;
+}
+
+// Diretiva %{arg}X do Apache.
+constexpr FormatField apache_directive(char d, std::string_view arg) {
+  switch (d) {
+    case 'h': case 'a': return FormatField::RemoteAddr;
+    case 'r': return FormatField::Request;
+    case 'm': return FormatField::Method;
+    case 'U': return FormatField::Uri;
+    case 's': return FormatField::Status;
+    case 'b': case 'B': case 'O': return FormatField::BodyBytes;
+    case 'D': return FormatField::LatencyUs;
+    case 'T':
+      if (arg.empty() || arg == "s") return FormatField::RequestTime;
+      if (arg == "ms") return FormatField::LatencyMs;
+      if (arg == "us") return FormatField::LatencyUs;
+      return FormatField::Skip;
+    case 't':
+      if (arg == "sec") return FormatField::TimeEpoch;
+      if (arg == "msec") return FormatField::TimeEpochMs;
+      return FormatField::Skip; // strftime próprio: não dá para interpretar
+    case 'i': return ieq(arg, "User-Agent") ? FormatField::UserAgent : FormatField::Skip;
+    default: return FormatField::Skip;
+  }
+}
+
+constexpr bool is_var_char(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+// Monta o plano passo a passo: o literal pendente vai junto com o próximo campo.
+class PlanBuilder {
+public:
+  constexpr explicit PlanBuilder(FormatPlan& p) : p_(p) {}
+
+  constexpr void literal(char c) {
+    if (lit_len_ == FormatStep::kMaxLiteral) emit(FormatField::None);
+    lit_[lit_len_++] = c;
+    after_field_ = false;
+  }
+
+  constexpr void field(FormatField f) {
+    // Dois campos colados não têm delimitador entre eles: o segundo só pode ser pulado
+    // junto com o primeiro (ex.: $uri$is_args$args, %U%q).
+    if (after_field_) {
+      if (f != FormatField::Skip) fail("campos colados sem separador entre eles");
+      return;
+    }
+    emit(f);
+    after_field_ = true;
+  }
+
+  constexpr void fail(const char* msg) {
+    if (!p_.error) p_.error = msg;
+  }
+
+  constexpr void finish() {
+    if (lit_len_ != 0) emit(FormatField::None);
+    for (std::size_t i = 0; i < p_.size; ++i) {
+      FormatStep& s = p_.steps[i];
+      if (s.field == FormatField::None) continue;
+      // O campo termina no primeiro byte do literal seguinte (ou no fim da linha).
+      s.stop = (i + 1 < p_.size) ? p_.steps[i + 1].lit[0] : 0;
+      s.quoted = s.stop == '"' && s.lit_len != 0 && s.lit[s.lit_len - 1] == '"';
+    }
+    if (!p_.has[static_cast<int>(FormatField::Status)]) fail("o formato não tem o status");
+    if (!p_.has[static_cast<int>(FormatField::Request)] && !p_.has[static_cast<int>(FormatField::Uri)])
+      fail("o formato não tem a request nem a URI");
+  }
+
+private:
+  FormatPlan& p_;
+  char lit_[FormatStep::kMaxLiteral] = {};
+  std::uint8_t lit_len_ = 0;
+  bool after_field_ = false;
+
+  constexpr void emit(FormatField f) {
+    if (p_.size == FormatPlan::kMaxSteps) {
+      fail("formato longo demais");
+      lit_len_ = 0;
+      return;
+    }
+    FormatStep& s = p_.steps[p_.size++];
+    for (std::size_t i = 0; i < lit_len_; ++i) s.lit[i] = lit_[i];
+    s.lit_len = lit_len_;
+    s.field = f;
+    p_.has[static_cast<int>(f)] = true;
+    lit_len_ = 0;
+  }
+};
+
+} // namespace format_detail
+
+// Compila um `log_format` do nginx ($var ou ${var}) ou um `LogFormat` do Apache (%h, %>s,
+// %{User-Agent}i, ...; \" e \t como no httpd.conf). Roda em constexpr: os formatos
+// embutidos saem prontos do compilador. O formato precisa ter status e request (ou URI);
+// tempo, latência e os campos do --group-by são opcionais.
+//
+// Limitação do plano de pulos: um campo não pode conter o primeiro byte do literal que vem
+// depois dele (ex.: $upstream_response_time "0.1, 0.2" seguido de espaço). Entre aspas não
+// há esse problema: o nginx escapa aspas como \x22 e o Apache como \".
+constexpr FormatPlan compile_log_format(FormatDialect dialect, std::string_view fmt) {
+  FormatPlan p;
+  format_detail::PlanBuilder b(p);
+  std::size_t i = 0;
+  while (i < fmt.size() && !p.error) {
+    const char c = fmt[i];
+    if (dialect == FormatDialect::Nginx && c == '$') {
+      std::size_t s = i + 1, e = s;
+      const bool braces = s < fmt.size() && fmt[s] == '{';
+      if (braces) s = e = s + 1;
+      while (e < fmt.size() && format_detail::is_var_char(fmt[e])) ++e;
+      if (e == s || (braces && (e == fmt.size() || fmt[e] != '}'))) {
+        b.fail("variável do nginx inválida");
+        break;
+      }
+      b.field(format_detail::nginx_var(fmt.substr(s, e - s)));
+      i = braces ? e + 1 : e;
+    } else if (dialect == FormatDialect::Apache && c == '%') {
+      std::size_t j = i + 1;
+      if (j < fmt.size() && fmt[j] == '%') {
+        b.literal('%');
+        i = j + 1;
+        continue;
+      }
+      // Modificadores (%>s, %<s, %!200,304{...}i) não mudam o valor logado.
+      while (j < fmt.size() && (fmt[j] == '<' || fmt[j] == '>' || fmt[j] == '!' || fmt[j] == ',' ||
+                                (fmt[j] >= '0' && fmt[j] <= '9')))
+        ++j;
+      std::string_view arg;
+      if (j < fmt.size() && fmt[j] == '{') {
+        const std::size_t close = fmt.find('}', j);
+        if (close == std::string_view::npos) {
+          b.fail("%{ sem }");
+          break;
+        }
+        arg = fmt.substr(j + 1, close - j - 1);
+        j = close + 1;
+      }
+      if (j == fmt.size()) {
+        b.fail("diretiva do Apache incompleta");
+        break;
+      }
+      const char d = fmt[j];
+      if (d == 't' && arg.empty()) { // %t é [10/Oct/2000:13:55:36 -0700], com colchetes
+        b.literal('[');
+        b.field(FormatField::TimeLocal);
+        b.literal(']');
+      } else {
+        b.field(format_detail::apache_directive(d, arg));
+      }
+      i = j + 1;
+    } else if (dialect == FormatDialect::Apache && c == '\\' && i + 1 < fmt.size()) {
+      const char n = fmt[i + 1];
+      b.literal(n == 't' ? '\t' : n == 'n' ? '\n' : n);
+      i += 2;
+    } else {
+      b.literal(c);
+      ++i;
+    }
+  }
+  b.finish();
+  return p;
+}
+
+constexpr bool same_format_step(const FormatStep& x, const FormatStep& y) {
+  if (x.lit_len != y.lit_len || x.field != y.field || x.stop != y.stop || x.quoted != y.quoted) return false;
+  for (std::size_t k = 0; k < x.lit_len; ++k) {
+    if (x.lit[k] != y.lit[k]) return false;
+  }
+  return true;
+}
+
+// Dois planos com os mesmos passos (o texto do formato pode diferir: ${var}, %>s/%s...).
+constexpr bool same_format_plan(const FormatPlan& a, const FormatPlan& b) {
+  if (a.size != b.size || (a.error == nullptr) != (b.error == nullptr)) return false;
+  for (std::size_t i = 0; i < a.size; ++i) {
+    if (!same_format_step(a.steps[i], b.steps[i])) return false;
+  }
+  return true;
+}
+
+// Quantos passos iniciais `a` e `b` têm em comum.
+constexpr std::size_t common_format_prefix(const FormatPlan& a, const FormatPlan& b) {
+  std::size_t n = 0;
+  while (n < a.size && n < b.size && same_format_step(a.steps[n], b.steps[n])) ++n;
+  return n;
+}
+
+// Máscara de `stop` entre as estruturais ('[', ']', '"', ' '); nullptr para outros bytes.
+inline const std::uint64_t* format_stop_mask(const StructuralMasks& m, char stop) {
+  switch (stop) {
+    case ' ': return m.space;
+    case '"': return m.quote;
+    case '[': return m.open;
+    case ']': return m.close;
+    default: return nullptr;
+  }
+}
+
+// Fim do campo que começa em `pos`: o próximo `stop` (ignorando \" se `quoted`) ou, com
+// stop == 0, o fim da linha sem os brancos finais. npos se o delimitador não aparecer. Com
+// as máscaras da linha (`m`), o delimitador sai de uma busca de bit em vez de um memchr.
+inline std::size_t format_field_end(std::string_view line, std::size_t pos, char stop, bool quoted,
+                                    const StructuralMasks* m) {
+  constexpr auto npos = StructuralMasks::npos;
+  if (stop == 0) {
+    std::size_t end = line.size();
+    while (end > pos && (line[end - 1] == ' ' || line[end - 1] == '\t' || line[end - 1] == '\r')) --end;
+    return end;
+  }
+  const std::uint64_t* mask = m ? format_stop_mask(*m, stop) : nullptr;
+  std::size_t from = pos;
+  for (;;) {
+    std::size_t end;
+    if (mask) {
+      end = m->next(mask, from);
+      if (end == npos) return npos;
+    } else {
+      const void* hit = std::memchr(line.data() + from, stop, line.size() - from);
+      if (!hit) return npos;
+      end = static_cast<std::size_t>(static_cast<const char*>(hit) - line.data());
+    }
+    if (!quoted) return end;
+    std::size_t bs = 0;
+    while (end - bs > pos && line[end - bs - 1] == '\\') ++bs;
+    if (bs % 2 == 0) return end;
+    from = end + 1;
+  }
+}
+
+// Executa um passo; false se o literal não bater ou o delimitador não aparecer.
+inline bool run_format_step(const FormatStep& s, std::string_view line, std::size_t& pos, std::string_view* cap,
+                            const StructuralMasks* m) {
+  if (s.lit_len != 0) {
+    if (line.size() - pos < s.lit_len) return false;
+    for (std::size_t k = 0; k < s.lit_len; ++k) { // literais curtos: mais barato que memcmp
+      if (line[pos + k] != s.lit[k]) return false;
+    }
+    pos += s.lit_len;
+  }
+  if (s.field == FormatField::None) return true;
+  const std::size_t end = format_field_end(line, pos, s.stop, s.quoted, m);
+  if (end == StructuralMasks::npos) return false;
+  cap[static_cast<int>(s.field)] = line.substr(pos, end - pos);
+  pos = end;
+  return true;
+}
+
+// Depois do último passo só pode sobrar espaço.
+inline bool format_rest_blank(std::string_view line, std::size_t pos) {
+  for (; pos < line.size(); ++pos) {
+    if (line[pos] != ' ' && line[pos] != '\t' && line[pos] != '\r') return false;
+  }
+  return true;
+}
+
+// Converte os campos capturados (`has` diz quais existem) num LogEntry, aplicando o filtro
+// estágio a estágio como o NginxParser. Compartilhado pelos planos e pelo JSON lines.
+ParseResult finish_format_entry(const bool* has, const std::string_view* cap, const Filter* filter, LogEntry& out);
+// O mesmo para um plano embutido: os campos ausentes saem do código. Instanciado em
+// log_format.cpp para kCombinedPlan, kTimedPlan e kCommonPlan.
+template <const FormatPlan& Plan>
+ParseResult finish_plan_entry(const std::string_view* cap, const Filter* filter, LogEntry& out);
+
+// Passo `I` de um plano conhecido na compilação (run_format_step com o passo constante): o
+// literal vira comparações de bytes imediatos, a máscara do delimitador é escolhida na
+// compilação e os campos Skip não são guardados.
+template <const FormatPlan& Plan, std::size_t I>
+inline bool run_plan_step(std::string_view line, std::size_t& pos, std::string_view* cap, const StructuralMasks* m) {
+  constexpr const FormatStep& s = Plan.steps[I];
+  if constexpr (s.lit_len != 0) {
+    if (line.size() - pos < s.lit_len) return false;
+    for (std::size_t k = 0; k < s.lit_len; ++k) {
+      if (line[pos + k] != s.lit[k]) return false;
+    }
+    pos += s.lit_len;
+  }
+  if constexpr (s.field == FormatField::None) {
+    return true;
+  } else {
+    const std::size_t end = format_field_end(line, pos, s.stop, s.quoted, m);
+    if (end == StructuralMasks::npos) return false;
+    if constexpr (s.field != FormatField::Skip) cap[static_cast<int>(s.field)] = line.substr(pos, end - pos);
+    pos = end;
+    return true;
+  }
+}
+
+template <const FormatPlan& Plan, std::size_t... I>
+inline bool run_plan_steps(std::size_t n, std::string_view line, std::size_t& pos, std::string_view* cap,
+                           const StructuralMasks* m, std::index_sequence<I...>) {
+  return ((I >= n || run_plan_step<Plan, I>(line, pos, cap, m)) && ...);
+}
+
+// Os `n` primeiros passos de `Plan`, desenrolados.
+template <const FormatPlan& Plan>
+bool run_plan_prefix(std::size_t n, std::string_view line, std::size_t& pos, std::string_view* cap,
+                     const StructuralMasks* m) {
+  return run_plan_steps<Plan>(n, line, pos, cap, m, std::make_index_sequence<Plan.size>{});
+}
+
+// Plano compilado em tempo de execução (--log-format, --apache-format). Como no
+// NginxParser, as máscaras estruturais da linha são montadas numa passada com a ISA dada.
+// Os passos iniciais que o formato tem em comum com um embutido (o combined com campos a
+// mais no fim, o caso comum) rodam desenrolados como no StaticFormatParser, e se os campos
+// presentes forem os do embutido a conversão também é a dele; o resto é interpretado.
+class FormatParser final : public Parser {
+public:
+  explicit FormatParser(const FormatPlan& plan, Isa isa = detect_isa());
+
+  ParseResult parse(std::string_view line, const Filter* filter, LogEntry& out) const override {
+    StructuralMasks m;
+    const StructuralMasks* masks = nullptr;
+    if (line.size() <= StructuralMasks::kMaxLen) { // linhas muito longas: memchr
+      build_masks(isa_, line, m);
+      masks = &m;
+    }
+    std::string_view cap[kFormatFields];
+    std::size_t pos = 0;
+    if (prefix_len_ != 0 && !prefix_(prefix_len_, line, pos, cap, masks)) return ParseResult::Invalid;
+    for (std::size_t i = prefix_len_; i < plan_.size; ++i) {
+      if (!run_format_step(plan_.steps[i], line, pos, cap, masks)) return ParseResult::Invalid;
+    }
+    if (!format_rest_blank(line, pos)) return ParseResult::Invalid;
+    if (finish_) return finish_(cap, filter, out);
+    return finish_format_entry(plan_.has, cap, filter, out);
+  }
+
+  void parse_batch(std::span<const std::string_view> lines, const Filter* filter, EntryBatch& out) const override {
+    parse_rows(*this, lines, filter, out);
+  }
+
+  const FormatPlan& plan() const { return plan_; }
+  // Passos que rodam desenrolados (prefixo comum com um formato embutido).
+  std::size_t unrolled_steps() const { return prefix_len_; }
+
+private:
+  using PrefixFn = bool (*)(std::size_t, std::string_view, std::size_t&, std::string_view*, const StructuralMasks*);
+  using FinishFn = ParseResult (*)(const std::string_view*, const Filter*, LogEntry&);
+
+  FormatPlan plan_;
+  Isa isa_;
+  PrefixFn prefix_ = nullptr;
+  std::size_t prefix_len_ = 0;
+  FinishFn finish_ = nullptr; // nullptr: finish_format_entry com plan_.has
+};
+
+// Plano conhecido em tempo de compilação: os passos são desenrolados e cada literal,
+// delimitador e campo vira constante no código gerado.
+template <const FormatPlan& Plan>
+class StaticFormatParser final : public Parser {
+  static_assert(Plan.error == nullptr, "formato embutido inválido");
+
+public:
+  explicit StaticFormatParser(Isa isa = detect_isa()) : isa_(isa_supported(isa) ? isa : Isa::Scalar) {}
+
+  ParseResult parse(std::string_view line, const Filter* filter, LogEntry& out) const override {
+    StructuralMasks m;
+    const StructuralMasks* masks = nullptr;
+    if (line.size() <= StructuralMasks::kMaxLen) {
+      build_masks(isa_, line, m);
+      masks = &m;
+    }
+    std::string_view cap[kFormatFields];
+    if (!scan(line, cap, masks, std::make_index_sequence<Plan.size>{})) return ParseResult::Invalid;
+    return finish_plan_entry<Plan>(cap, filter, out);
+  }
+
+  void parse_batch(std::span<const std::string_view> lines, const Filter* filter, EntryBatch& out) const override {
+    parse_rows(*this, lines, filter, out);
+  }
+
+private:
+  Isa isa_;
+
+  template <std::size_t... I>
+  static bool scan(std::string_view line, std::string_view* cap, const StructuralMasks* m, std::index_sequence<I...>) {
+    std::size_t pos = 0;
+    return (run_plan_step<Plan, I>(line, pos, cap, m) && ...) && format_rest_blank(line, pos);
+  }
+};
+
+// Formatos embutidos.
+inline constexpr FormatPlan kCombinedPlan = compile_log_format(
+    FormatDialect::Nginx,
+    "$remote_addr - $remote_user [$time_local] \"$request\" $status $body_bytes_sent \"$http_referer\" "
+    "\"$http_user_agent\"");
+// combined + $request_time: o layout do NginxParser, na versão gerada.
+inline constexpr FormatPlan kTimedPlan = compile_log_format(
+    FormatDialect::Nginx,
+    "$remote_addr - $remote_user [$time_local] \"$request\" $status $body_bytes_sent \"$http_referer\" "
+    "\"$http_user_agent\" $request_time");
+inline constexpr FormatPlan kCommonPlan = compile_log_format(FormatDialect::Apache, "%h %l %u %t \"%r\" %>s %b");
+
+// Escolha do parser pela linha de comando.
+struct FormatOptions {
+  std::string name = "nginx"; // --format: nginx | combined | common | timed | json
+  std::string log_format;     // --log-format (nginx)
+  std::string apache_format;  // --apache-format
+  std::string json_keys;      // --json-keys (implica json)
+  Isa isa = detect_isa();     // --isa: máscaras estruturais dos parsers gerados
+};
+
+// nullptr (com `err`) se o formato for inválido. Um --log-format/--apache-format igual a um
+// formato embutido usa o StaticFormatParser dele. Para "nginx" sem formato próprio devolve
+// nullptr sem erro: quem chama fica com o NginxParser embutido (IngestOptions::parser).
+// Um --log-format colado do nginx.conf ('...' '...' em várias partes) também é aceito.
+std::unique_ptr<Parser> make_parser(const FormatOptions& opt, std::string& err);
+
+} // namespace logforge
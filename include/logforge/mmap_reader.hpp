@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+#include "line_source.hpp"
+
+namespace logforge {
+
+// Leitor zero-copy: mapeia o arquivo e devolve views direto na memória mapeada.
+// A busca por '\n' usa memchr (vetorizado na libc).
+class MmapLineReader final : public LineSource {
+public:
+  explicit MmapLineReader(const std::string& path, ByteRange range = {});
+  ~MmapLineReader() override;
+
+  MmapLineReader(const MmapLineReader&) = delete;
+  MmapLineReader& operator=(const MmapLineReader&) = delete;
+
+  bool ok() const override { return ok_; }
+  bool next_line(std::string_view& out) override;
+  bool stable_views() const override { return true; }
+
+private:
+  const char* data_ = nullptr;
+  std::size_t size_ = 0;   // tamanho mapeado (arquivo inteiro)
+  std::size_t pos_ = 0;
+  std::size_t end_ = 0;    // linhas que começam em [pos_, end_)
+  bool ok_ = false;
+};
+
+} // namespace logforge
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace logforge {
+
+// Conjunto de instruções usado para montar as bitmasks estruturais.
+enum class Isa { Scalar, Sse2, Avx2 };
+
+Isa detect_isa(); // melhor ISA suportada pela CPU atual
+bool isa_supported(Isa isa);
+const char* isa_name(Isa isa);
+bool parse_isa(std::string_view name, Isa& out);
+
+// Posições dos delimitadores '[', ']', '"' e ' ' de uma linha, 1 bit por byte
+// (bit i da palavra w = byte 64*w + i). Montadas em uma única passada, estilo simdjson.
+struct StructuralMasks {
+  static constexpr std::size_t kMaxWords = 64; // linhas de até 4 KiB
+  static constexpr std::size_t kMaxLen = kMaxWords * 64;
+  static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+  std::uint64_t open[kMaxWords];
+  std::uint64_t close[kMaxWords];
+  std::uint64_t quote[kMaxWords];
+  std::uint64_t space[kMaxWords];
+  std::size_t len = 0;
+
+  // Primeira posição >= from marcada em `m` (npos se não houver).
+  std::size_t next(const std::uint64_t* m, std::size_t from) const;
+  // Última posição < before marcada em `m` (npos se não houver).
+  std::size_t prev(const std::uint64_t* m, std::size_t before) const;
+};
+
+// Monta as máscaras de `line` (line.size() <= kMaxLen).
+void build_masks(Isa isa, std::string_view line, StructuralMasks& out);
+
+} // namespace logforge
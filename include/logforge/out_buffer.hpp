@@ -0,0 +1,78 @@
+#pragma once
+#include <charconv>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace logforge {
+
+// Escrita bufferizada num arquivo para os writers de relatório: texto copiado em blocos,
+// números formatados com std::to_chars direto no buffer (sem ostream nem locale) e um
+// write(2) a cada kCapacity bytes. double sai como no ostream padrão (%g, 6 dígitos
+// significativos), então o texto é o mesmo de um `ofs << x`.
+class OutBuffer {
+public:
+  static constexpr std::size_t kCapacity = 64 * 1024;
+
+  OutBuffer() : buf_(new char[kCapacity]) {}
+  ~OutBuffer();
+  OutBuffer(const OutBuffer&) = delete;
+  OutBuffer& operator=(const OutBuffer&) = delete;
+
+  // Cria/trunca `path` (modo 0666 menos o umask, como o ofstream). false se não abrir.
+  bool open(const std::string& path);
+  // Esvazia o buffer e fecha; false se alguma escrita (ou o close) falhou.
+  bool close();
+
+  OutBuffer& operator<<(std::string_view s) {
+    if (s.size() <= kCapacity - len_) {
+      s.copy(buf_.get() + len_, s.size());
+      len_ += s.size();
+    } else {
+      write_long(s);
+    }
+    return *this;
+  }
+  OutBuffer& operator<<(const char* s) { return *this << std::string_view(s); }
+  OutBuffer& operator<<(const std::string& s) { return *this << std::string_view(s); }
+  OutBuffer& operator<<(char c) {
+    if (len_ == kCapacity) flush();
+    buf_[len_++] = c;
+    return *this;
+  }
+
+  template <typename T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool> &&
+                                             !std::is_same_v<T, char>,
+                                         int> = 0>
+  OutBuffer& operator<<(T v) {
+    char* p = reserve(24);
+    len_ += static_cast<std::size_t>(std::to_chars(p, p + 24, v).ptr - p);
+    return *this;
+  }
+  OutBuffer& operator<<(double v) {
+    char* p = reserve(32);
+    len_ += static_cast<std::size_t>(std::to_chars(p, p + 32, v, std::chars_format::general, 6).ptr - p);
+    return *this;
+  }
+
+  // Espaço para escrever até `n` (<= kCapacity) bytes direto no buffer; confirme com commit().
+  char* reserve(std::size_t n) {
+    if (kCapacity - len_ < n) flush();
+    return buf_.get() + len_;
+  }
+  void commit(std::size_t n) { len_ += n; }
+
+private:
+  int fd_ = -1;
+  bool ok_ = true;
+  std::size_t len_ = 0;
+  std::unique_ptr<char[]> buf_;
+
+  void flush();
+  void write_long(std::string_view s);
+  void write_all(const char* p, std::size_t n);
+};
+
+} // namespace logforge
@@ -1,15 +1,88 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <optional>
+#include <span>
 #include <string_view>
 
+#include "entry_batch.hpp"
 #include "log_entry.hpp"
+#include "stats_config.hpp"
 
 namespace logforge {
 
+class Filter;
+
+enum class ParseResult { Ok, Invalid, Filtered };
+
+// Por que uma linha foi recusada (diagnóstico do --stats; o parse em si só diz Invalid).
+enum class RejectReason : std::uint8_t {
+  MissingBracket, // sem o [timestamp] entre colchetes
+  BadTimestamp,   // data/hora ilegível
+  MissingQuote,   // sem o "request" entre aspas
+  BadRequest,     // request fora de METHOD PATH PROTO, ou path vazio
+  BadStatus,      // status não numérico
+  Mismatch,       // a referência aceitou a linha que o parse recusou (divergência: é bug)
+  Other,          // parser sem diagnóstico (formatos gerados, JSON)
+};
+inline constexpr std::size_t kRejectReasons = 7;
+const char* reject_reason_name(RejectReason r);
+
 class Parser {
 public:
   virtual ~Parser() = default;
-  virtual std::optional<LogEntry> parse_line(std::string_view line) const = 0;
+
+  // Parse em `out` aplicando o --where (nullptr = sem filtro). Filtered: a linha é válida e
+  // não passou no filtro; uma linha inválida é sempre Invalid, com ou sem filtro.
+  virtual ParseResult parse(std::string_view line, const Filter* filter, LogEntry& out) const = 0;
+
+  // Várias linhas direto nas colunas de `out` (acrescenta; cabe a quem chama não passar de
+  // EntryBatch::kCapacity). Uma chamada virtual por lote: as classes finais sobrescrevem
+  // com parse_rows(*this, ...), em que o parse de cada linha é chamado sem despacho.
+  virtual void parse_batch(std::span<const std::string_view> lines, const Filter* filter, EntryBatch& out) const;
+
+  // Motivo da recusa de uma linha que parse() devolveu como Invalid. Só é chamado para as
+  // linhas recusadas, com o --stats ligado: pode refazer o parse devagar.
+  virtual RejectReason reject_reason(std::string_view line) const {
+    (void)line;
+    return RejectReason::Other;
+  }
+
+  virtual std::optional<LogEntry> parse_line(std::string_view line) const {
+    LogEntry e;
+    if (parse(line, nullptr, e) != ParseResult::Ok) return std::nullopt;
+    return e;
+  }
 };
 
+// Laço de parse_batch. Com P final, p.parse não passa pela vtable e pode ser inlinado.
+template <typename P>
+inline void parse_rows(const P& p, std::span<const std::string_view> lines, const Filter* filter, EntryBatch& out) {
+  LogEntry e;
+  for (std::size_t i = 0; i < lines.size(); ++i) {
+    switch (p.parse(lines[i], filter, e)) {
+      case ParseResult::Ok: out.push(e); break;
+      case ParseResult::Invalid:
+        // As posições só servem ao diagnóstico do --stats.
+        if constexpr (kStatsCompiled)
+          out.rejected[out.invalid % EntryBatch::kCapacity] = static_cast<std::uint16_t>(i);
+        out.invalid++;
+        break;
+      case ParseResult::Filtered: out.filtered++; break;
+    }
+  }
+}
+
+inline void Parser::parse_batch(std::span<const std::string_view> lines, const Filter* filter, EntryBatch& out) const {
+  parse_rows(*this, lines, filter, out);
+}
+
+// Conversões de campo comuns a todos os parsers (parser_nginx.cpp).
+// Path da request -> endpoint: URL absoluta vira só o path, sem querystring; vazio vira "/".
+std::string_view endpoint_from_path(std::string_view path);
+// request_time em segundos -> µs (-1 se não for número válido em [0, 3600)).
+std::int64_t latency_from_seconds(std::string_view tok);
+// body_bytes_sent -> inteiro (-1 se "-" ou inválido).
+std::int64_t bytes_from_token(std::string_view tok);
+
 } // namespace logforge
@@ -1,7 +1,10 @@
 #pragma once
+#include <cstdint>
 #include <optional>
 #include <string_view>
 
+#include "filter.hpp"
+#include "nginx_scan.hpp"
 #include "parser.hpp"
 
 namespace logforge {
@@ -9,14 +12,41 @@ namespace logforge {
 // Parser para um formato comum do Nginx:
 // 127.0.0.1 - - [10/Oct/2000:13:55:36 -0700] "GET /path?x=1 HTTP/1.1" 200 2326 "-" "UA" 0.245
 // (Último token opcional = request_time em segundos)
+//
+// parse_line faz uma passada única montando bitmasks dos delimitadores (AVX2/SSE2/escalar,
+// escolhido em tempo de execução); parse_line_reference é a versão original com find/rfind,
+// mantida como referência para o teste diferencial. Outros layouts: ver log_format.hpp.
+
 class NginxParser final : public Parser {
 public:
+  // client_fields = false: o caminho rápido não extrai remote_addr, method, bytes nem
+  // user_agent (só o --group-by com esses campos e o --unique-clients precisam deles).
+  explicit NginxParser(Isa isa = detect_isa(), bool client_fields = true);
+
   std::optional<LogEntry> parse_line(std::string_view line) const override;
+  std::optional<LogEntry> parse_line_reference(std::string_view line) const;
+
+  // Como parse_line, aplicando o --where estágio a estágio: tempo, status, endpoint e
+  // latência, nessa ordem, cada um logo depois de extraído. Uma linha descartada cedo só
+  // paga o resto da validação, não a extração; inválida conta como Invalid, não Filtered.
+  ParseResult parse_line(std::string_view line, const Filter& filter, LogEntry& out) const;
+
+  ParseResult parse(std::string_view line, const Filter* filter, LogEntry& out) const override;
+  void parse_batch(std::span<const std::string_view> lines, const Filter* filter, EntryBatch& out) const override;
+  // Refaz a linha pela versão de referência, parando no primeiro campo que falha.
+  RejectReason reject_reason(std::string_view line) const override;
+
+  Isa isa() const { return isa_; }
+  bool client_fields() const { return client_fields_; }
 
 private:
-  static std::string strip_query(std::string_view path);
-  static std::optional<std::string> parse_minute_key(std::string_view bracket_time);
-  static int month_to_int(std::string_view mon);
+  Isa isa_;
+  bool client_fields_;
+
+  std::optional<LogEntry> parse_reference(std::string_view line, RejectReason& why) const;
+
+  template <typename Gate>
+  ParseResult parse_fast(std::string_view line, LogEntry& e, Gate&& gate) const;
 };
 
 } // namespace logforge
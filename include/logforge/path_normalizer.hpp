@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace logforge {
+
+// Reescreve paths em templates antes da agregação, ex.:
+//   /api/items/42                                   -> /api/items/{id}
+//   /users/3f2b6c1e-8a4d-4c1b-9e7f-0a1b2c3d4e5f     -> /users/{uuid}
+//   /blobs/9f86d081884c7d659a2feaa0c55ad015         -> /blobs/{hex}
+//
+// Regras do usuário (uma por linha no arquivo; '#' comenta) têm prioridade sobre os detectores:
+//   /api/users/{user}/orders   -> {user} casa qualquer segmento
+//   /static/**                 -> '**' (só no fim) casa o resto do path
+// Segmentos literais ganham de {param}. As regras são compiladas numa trie de segmentos.
+class PathNormalizer {
+public:
+  PathNormalizer();
+
+  bool add_rule(std::string_view pattern, std::string& error);
+  bool load_rules(const std::string& path, std::string& error);
+
+  // Devolve `path` se nada mudar; senão escreve em `buf` e devolve uma view dele.
+  // const e sem estado por chamada: pode ser compartilhado entre threads (um buf por thread).
+  std::string_view normalize(std::string_view path, std::string& buf) const;
+
+  std::size_t rule_count() const { return rules_; }
+
+private:
+  struct Node {
+    std::vector<std::pair<std::string, std::uint32_t>> literals;
+    std::int32_t param = -1;  // filho {param}
+    std::string param_name;   // "{user}" (já com chaves) do filho param
+    bool tail = false;        // '**' termina aqui
+    bool terminal = false;    // alguma regra termina neste nó
+  };
+
+  static constexpr std::size_t kMaxSegments = 64;
+
+  std::vector<Node> nodes_;
+  std::size_t rules_ = 0;
+
+  bool match_rules(std::string_view path, std::string& buf) const;
+  bool match(std::uint32_t node, const std::string_view* segs, std::size_t i, std::size_t n,
+             const std::string** repl) const;
+  static std::string_view detect(std::string_view seg);
+};
+
+} // namespace logforge
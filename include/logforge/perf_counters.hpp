@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace logforge {
+
+// Contadores de hardware do processo (perf_event_open, Linux) para o --bench: ciclos,
+// instruções, misses de leitura no L1d e no último nível de cache. L2 não é um evento
+// genérico do perf (só existe como evento bruto, específico de cada CPU), então fica de fora.
+// Cada contador é aberto separado e herdado pelas threads criadas depois do start(); os que
+// a CPU/VM não tiver (ou perf_event_paranoid não permitir) somem da leitura.
+class PerfCounters {
+public:
+  struct Reading {
+    const char* name;
+    std::uint64_t value; // escalado pelo tempo em que o contador esteve ativo
+  };
+
+  PerfCounters();
+  ~PerfCounters();
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  // false se nenhum contador abriu; error() diz por quê.
+  bool available() const { return !fds_.empty(); }
+  const std::string& error() const { return error_; }
+
+  void start();
+  std::vector<Reading> stop();
+
+private:
+  std::vector<int> fds_;
+  std::vector<const char*> names_;
+  std::string error_;
+};
+
+} // namespace logforge
@@ -1,9 +1,58 @@
 #pragma once
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <string_view>
+#include <vector>
+
 #include "aggregator.hpp"
 
 namespace logforge {
 
+struct RankedEndpoint {
+  std::string_view endpoint; // aponta para a chave em Report::endpoint_counts
+  std::uint64_t count = 0;
+  std::uint64_t error = 0;   // só no modo aproximado
+};
+
+// Visão ordenada de um Report, calculada uma vez e compartilhada pelos writers (o JSON e
+// os CSVs listam as mesmas coisas na mesma ordem). Só vale enquanto o Report existir.
+struct ReportView {
+  int top_n = 0;
+  std::vector<RankedEndpoint> top_endpoints;                   // count desc, empate por endpoint asc
+  std::vector<std::pair<int, std::uint64_t>> status;           // status asc
+  std::vector<std::pair<std::int64_t, std::uint64_t>> minutes; // minuto asc
+};
+
+// Top N via partial_sort (sem copiar strings nem ordenar o mapa inteiro); status e minutos
+// ordenados uma vez.
+ReportView make_report_view(const Report& r, int top_n);
+
+class OutBuffer;
+
+// Um arquivo do relatório: nome dentro do diretório de saída e quem escreve o conteúdo.
+struct ReportFile {
+  std::string name;
+  std::function<void(OutBuffer&)> write;
+};
+
+// report.json / os CSVs (os opcionais só quando a opção está ligada). As funções
+// referenciam `r` e `view`, que precisam viver até os arquivos serem escritos.
+std::vector<ReportFile> json_report_files(const Report& r, const ReportView& view);
+std::vector<ReportFile> csv_report_files(const Report& r, const ReportView& view);
+
+// Escreve os arquivos em `out_dir` (criado se preciso), em paralelo em até `threads`
+// threads (0 = um por núcleo). Cada um vai para <nome>.tmp e é renomeado no fim: quem lê
+// (ex.: no modo --follow) nunca vê um arquivo pela metade. Arquivos novos seguem o umask;
+// os que já existiam mantêm o modo. false se algum falhou.
+bool publish_report_files(const std::vector<ReportFile>& files, const std::string& out_dir, int threads = 0);
+
+bool write_report_json(const Report& r, const ReportView& view, const std::string& out_dir);
+bool write_report_csv(const Report& r, const ReportView& view, const std::string& out_dir);
+// JSON e CSVs juntos, todos os arquivos em paralelo (`threads` como em publish_report_files).
+bool write_reports(const Report& r, const ReportView& view, const std::string& out_dir, int threads = 0);
+
+// Atalhos que montam a visão internamente.
 bool write_report_json(const Report& r, const std::string& out_dir, int top_n);
 bool write_report_csv(const Report& r, const std::string& out_dir, int top_n);
 
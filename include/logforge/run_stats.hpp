@@ -0,0 +1,68 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+#include "parser.hpp"
+#include "stats_config.hpp"
+
+namespace logforge {
+
+enum class Stage : std::uint8_t { Read, Parse, Aggregate, Finalize, Write };
+inline constexpr std::size_t kStages = 5;
+const char* stage_name(Stage s);
+
+// Relógio dos estágios: contador de ciclos de referência (TSC) no x86, ns nos demais.
+inline std::uint64_t stats_clock() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+#endif
+}
+// Unidade de stats_clock() para a saída ("ciclos TSC" ou "ns").
+const char* stats_clock_unit();
+
+// Medidas de uma execução, por thread (uma por Aggregator) e somadas no merge.
+struct RunStats {
+  // No modo linha a linha só 1 em kSampleEvery linhas é cronometrada, e o tempo é
+  // multiplicado por kSampleEvery (estimativa); nos lotes, cada lote é cronometrado.
+  static constexpr std::uint64_t kSampleEvery = 16;
+  static constexpr std::size_t kSamplesPerReason = 2;
+  static constexpr std::size_t kSampleChars = 200;
+
+  std::array<std::uint64_t, kStages> ticks{};
+  std::array<std::uint64_t, kRejectReasons> rejects{};
+  struct Sample {
+    RejectReason reason;
+    std::string line; // cortada em kSampleChars
+  };
+  std::vector<Sample> samples; // as primeiras linhas recusadas de cada motivo
+
+  void add(Stage s, std::uint64_t t) { ticks[static_cast<std::size_t>(s)] += t; }
+  void reject(RejectReason r, std::string_view line);
+  void merge(const RunStats& o);
+};
+
+// Uma estrutura do Aggregator: tamanho, capacidade e memória aproximada.
+struct TableStats {
+  std::string name;
+  std::size_t size = 0;
+  std::size_t capacity = 0; // slots (tabelas hash) ou limite (Space-Saving); 0 = sem limite
+  std::size_t bytes = 0;    // 0 = não estimado
+};
+
+// Pico de memória residente do processo em KiB (0 se indisponível).
+std::uint64_t peak_rss_kib();
+
+} // namespace logforge
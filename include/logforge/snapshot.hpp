@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "aggregator.hpp"
+
+namespace logforge {
+
+// Snapshot binário do estado de um Aggregator antes do finalize, para juntar depois
+// (ex.: snapshots por hora -> relatório do dia sem reparsear os logs).
+//
+// Layout (inteiros fixos em little-endian):
+//   "LFSNAP" | u16 versão | u64 tamanho do payload | u64 FNV-1a do payload | payload
+// O payload é Aggregator::serialize (varints). O cabeçalho fixo permite validar antes de
+// parsear; a leitura mapeia o arquivo e decodifica direto da memória mapeada.
+// 2: filtered_lines; 3: --group-by; 4: --unique-clients; 5: minutos em UTC (antes, no
+// horário local de cada linha, sem o fuso: não dá para converter, só gerar de novo).
+inline constexpr std::uint16_t kSnapshotVersion = 5;
+
+// Escrita sequencial única num arquivo temporário + rename (nunca deixa snapshot parcial).
+bool write_snapshot(const Aggregator& agg, const std::string& path);
+
+// Substitui `out` pelo estado do snapshot; false (com `err`) se o arquivo não existir,
+// for de outra versão ou estiver corrompido.
+bool read_snapshot(const std::string& path, Aggregator& out, std::string& err);
+
+// Lê e combina vários snapshots em `out` (as opções vêm do primeiro). false se algum for
+// inválido ou incompatível com o primeiro (ver Aggregator::mergeable_with).
+bool merge_snapshots(const std::vector<std::string>& paths, Aggregator& out, std::string& err);
+
+} // namespace logforge
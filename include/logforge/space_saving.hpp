@@ -0,0 +1,268 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "flat_hash.hpp"
+#include "varint.hpp"
+
+namespace logforge {
+
+// Payload vazio para quando só as contagens interessam.
+struct NoPayload {
+  void merge(const NoPayload&) {}
+  void serialize(std::string&) const {}
+  bool deserialize(std::string_view&) { return true; }
+};
+
+// Heavy hitters com memória fixa (Space-Saving, Metwally et al. 2005).
+//
+// Monitora no máximo `capacity` chaves. Enquanto cabe tudo, as contagens são exatas.
+// Cheio, uma chave nova substitui a de menor contagem m e herda count = m + n, error = m.
+// Com N = total de ocorrências:
+//   count - error <= frequência real <= count   e   error <= N / capacity;
+//   toda chave com frequência > N / capacity está monitorada.
+//
+// Cada chave carrega um Payload (ex.: estatísticas) que recomeça vazio quando a chave entra.
+// Payload precisa de merge(const Payload&) e, para snapshots, de serialize/deserialize.
+template <typename Payload>
+class SpaceSaving {
+public:
+  struct Entry {
+    std::string key;
+    std::uint64_t count = 0;
+    std::uint64_t error = 0;
+    Payload payload;
+  };
+
+  explicit SpaceSaving(std::size_t capacity, Payload prototype = Payload{})
+      : capacity_(std::max<std::size_t>(capacity, 1)), prototype_(std::move(prototype)) {
+    slots_.reserve(capacity_); // endereços estáveis: index_ guarda views das chaves
+  }
+
+  SpaceSaving(const SpaceSaving& other) { *this = other; }
+  SpaceSaving& operator=(const SpaceSaving& other) {
+    if (this == &other) return *this;
+    capacity_ = other.capacity_;
+    prototype_ = other.prototype_;
+    total_ = other.total_;
+    evicted_ = other.evicted_;
+    slots_.clear();
+    slots_.reserve(capacity_);
+    slots_.insert(slots_.end(), other.slots_.begin(), other.slots_.end());
+    order_ = other.order_;
+    pos_ = other.pos_;
+    rebuild_index();
+    return *this;
+  }
+  SpaceSaving(SpaceSaving&&) noexcept = default;
+  SpaceSaving& operator=(SpaceSaving&&) noexcept = default;
+
+  // Conta `n` ocorrências de `key` e devolve o payload da chave para ser atualizado.
+  Payload& offer(std::string_view key, std::uint64_t n = 1) { return offer_hashed(key, hash_string(key), n); }
+
+  // offer com o hash_string(key) já calculado (o mesmo hash serve a vários índices).
+  Payload& offer_hashed(std::string_view key, std::uint64_t h, std::uint64_t n = 1) {
+    total_ += n;
+    std::uint32_t slot = index_.find(key, h);
+    if (slot != StringIndex::kNone) {
+      bump(pos_[slot], n);
+      return slots_[slot].payload;
+    }
+    if (slots_.size() < capacity_) {
+      slot = static_cast<std::uint32_t>(slots_.size());
+      slots_.push_back(Entry{std::string(key), 0, 0, prototype_});
+      index_.insert(slots_.back().key, h, slot);
+      hashes_.push_back(h);
+      pos_.push_back(static_cast<std::uint32_t>(order_.size()));
+      order_.push_back(slot); // contagem 0: fim da ordem decrescente
+    } else {
+      // Substitui a chave de menor contagem (última posição).
+      slot = order_.back();
+      Entry& e = slots_[slot];
+      index_.erase(e.key, hashes_[slot]);
+      e.key.assign(key);
+      e.error = e.count;
+      e.payload = prototype_;
+      index_.insert(e.key, h, slot);
+      hashes_[slot] = h;
+      evicted_ = true;
+    }
+    bump(pos_[slot], n);
+    return slots_[slot].payload;
+  }
+
+  // Combina dois resumos (Agarwal et al., "Mergeable Summaries"). Uma chave ausente de um
+  // resumo que já descartou chaves pode ter tido até min_count() ocorrências nele.
+  void merge(const SpaceSaving& other) {
+    if (other.slots_.empty()) {
+      total_ += other.total_;
+      return;
+    }
+    const std::uint64_t ma = evicted_ ? min_count() : 0;
+    const std::uint64_t mb = other.evicted_ ? other.min_count() : 0;
+
+    std::vector<Entry> items;
+    items.reserve(slots_.size() + other.slots_.size());
+    for (auto& e : slots_) {
+      Entry m = e;
+      if (const Entry* found = other.find(e.key)) {
+        const Entry& o = *found;
+        m.count += o.count;
+        m.error += o.error;
+        m.payload.merge(o.payload);
+      } else {
+        m.count += mb;
+        m.error += mb;
+      }
+      items.push_back(std::move(m));
+    }
+    for (auto& o : other.slots_) {
+      if (find(o.key)) continue;
+      Entry m = o;
+      m.count += ma;
+      m.error += ma;
+      items.push_back(std::move(m));
+    }
+
+    std::sort(items.begin(), items.end(), [](const Entry& a, const Entry& b) {
+      return (a.count == b.count) ? (a.key < b.key) : (a.count > b.count);
+    });
+    if (items.size() > capacity_) {
+      items.resize(capacity_);
+      evicted_ = true;
+    }
+    evicted_ = evicted_ || other.evicted_;
+    total_ += other.total_;
+
+    slots_.clear();
+    slots_.reserve(capacity_);
+    for (auto& m : items) slots_.push_back(std::move(m));
+    order_.resize(slots_.size());
+    pos_.resize(slots_.size());
+    for (std::uint32_t i = 0; i < slots_.size(); ++i) order_[i] = pos_[i] = i;
+    rebuild_index();
+  }
+
+  // Formato: capacity, total, evicted, n e as entradas em ordem decrescente de contagem
+  // (key com tamanho, count, error, payload).
+  void serialize(std::string& out) const {
+    put_varint(out, capacity_);
+    put_varint(out, total_);
+    put_varint(out, evicted_ ? 1 : 0);
+    put_varint(out, order_.size());
+    for (auto slot : order_) {
+      const Entry& e = slots_[slot];
+      put_varint(out, e.key.size());
+      out.append(e.key);
+      put_varint(out, e.count);
+      put_varint(out, e.error);
+      e.payload.serialize(out);
+    }
+  }
+
+  // Substitui o estado (o protótipo do payload é mantido); false se os dados forem inválidos.
+  bool deserialize(std::string_view& in) {
+    std::uint64_t capacity = 0, total = 0, evicted = 0, n = 0;
+    if (!get_varint(in, capacity) || !get_varint(in, total) || !get_varint(in, evicted) || !get_varint(in, n))
+      return false;
+    if (capacity == 0 || capacity > (1ull << 26) || n > capacity || evicted > 1) return false;
+
+    SpaceSaving s(static_cast<std::size_t>(capacity), prototype_);
+    s.total_ = total;
+    s.evicted_ = (evicted != 0);
+    for (std::uint64_t i = 0; i < n; ++i) {
+      std::uint64_t len = 0;
+      if (!get_varint(in, len) || len > in.size()) return false;
+      Entry e{std::string(in.substr(0, static_cast<std::size_t>(len))), 0, 0, prototype_};
+      in.remove_prefix(static_cast<std::size_t>(len));
+      if (!get_varint(in, e.count) || !get_varint(in, e.error) || !e.payload.deserialize(in)) return false;
+      if (e.error > e.count || (i > 0 && e.count > s.slots_.back().count)) return false;
+      s.slots_.push_back(std::move(e));
+    }
+    s.order_.resize(s.slots_.size());
+    s.pos_.resize(s.slots_.size());
+    for (std::uint32_t i = 0; i < s.slots_.size(); ++i) s.order_[i] = s.pos_[i] = i;
+    if (!s.rebuild_index()) return false; // chave repetida
+
+    *this = std::move(s);
+    return true;
+  }
+
+  const Entry* find(std::string_view key) const {
+    const auto slot = index_.find(key, hash_string(key));
+    return slot == StringIndex::kNone ? nullptr : &slots_[slot];
+  }
+
+  // Entradas em ordem decrescente de contagem (empates em ordem arbitrária).
+  template <typename F>
+  void for_each(F&& f) const {
+    for (auto slot : order_) f(slots_[slot]);
+  }
+
+  std::size_t size() const { return slots_.size(); }
+  std::size_t capacity() const { return capacity_; }
+  std::uint64_t total() const { return total_; }
+  // true se alguma chave já foi descartada (contagens deixam de ser exatas).
+  bool approximate() const { return evicted_; }
+  std::uint64_t min_count() const { return order_.empty() ? 0 : slots_[order_.back()].count; }
+  // Limite superior do erro de qualquer contagem.
+  std::uint64_t max_error() const { return evicted_ ? min_count() : 0; }
+
+private:
+  std::size_t capacity_ = 1;
+  Payload prototype_;
+  std::uint64_t total_ = 0;
+  bool evicted_ = false;
+
+  std::vector<Entry> slots_;
+  std::vector<std::uint32_t> order_; // slots em ordem decrescente de contagem
+  std::vector<std::uint32_t> pos_;   // slot -> posição em order_
+  StringIndex index_;
+  std::vector<std::uint64_t> hashes_; // slot -> hash_string(key), para a expulsão não re-hashear
+
+  std::uint64_t count_at(std::size_t p) const { return slots_[order_[p]].count; }
+
+  // Soma n à contagem da posição p mantendo order_ ordenado.
+  void bump(std::size_t p, std::uint64_t n) {
+    const std::uint32_t slot = order_[p];
+    const std::uint64_t c = slots_[slot].count + n;
+    // Primeira posição em [0, p) com contagem < c: a entrada sobe para lá.
+    std::size_t lo = 0, hi = p;
+    while (lo < hi) {
+      const std::size_t mid = (lo + hi) / 2;
+      if (count_at(mid) >= c) lo = mid + 1;
+      else hi = mid;
+    }
+    if (lo < p) {
+      if (n == 1) {
+        // Caso comum: [lo, p] tem todos a mesma contagem, basta trocar.
+        std::swap(order_[lo], order_[p]);
+        pos_[order_[p]] = static_cast<std::uint32_t>(p);
+      } else {
+        std::rotate(order_.begin() + static_cast<long>(lo), order_.begin() + static_cast<long>(p),
+                    order_.begin() + static_cast<long>(p) + 1);
+        for (std::size_t k = lo + 1; k <= p; ++k) pos_[order_[k]] = static_cast<std::uint32_t>(k);
+      }
+      pos_[slot] = static_cast<std::uint32_t>(lo);
+    }
+    slots_[slot].count = c;
+  }
+
+  // false se houver chave repetida.
+  bool rebuild_index() {
+    index_.clear();
+    index_.reserve(slots_.size());
+    hashes_.resize(slots_.size());
+    bool unique = true;
+    for (std::uint32_t i = 0; i < slots_.size(); ++i) {
+      hashes_[i] = hash_string(slots_[i].key);
+      unique &= index_.insert(slots_[i].key, hashes_[i], i);
+    }
+    return unique;
+  }
+};
+
+} // namespace logforge
@@ -0,0 +1,14 @@
+#pragma once
+
+namespace logforge {
+
+// Instrumentação do --stats. Compilada só com LOGFORGE_STATS (cmake -DLOGFORGE_WITH_STATS,
+// padrão ON); sem ela kStatsCompiled é false, Aggregator::stats() é sempre nullptr e todos
+// os ganchos somem na compilação. Header à parte para o parser.hpp, que o run_stats.hpp inclui.
+#ifdef LOGFORGE_STATS
+inline constexpr bool kStatsCompiled = true;
+#else
+inline constexpr bool kStatsCompiled = false;
+#endif
+
+} // namespace logforge
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "flat_hash.hpp"
+
+namespace logforge {
+
+// Tabela de símbolos: associa cada string distinta a um id denso (0, 1, 2...).
+// As strings ficam numa arena de blocos grandes; lookup de string já conhecida não aloca.
+class SymbolTable {
+public:
+  SymbolTable() = default;
+  SymbolTable(const SymbolTable& other);
+  SymbolTable& operator=(const SymbolTable& other);
+  SymbolTable(SymbolTable&&) noexcept = default;
+  SymbolTable& operator=(SymbolTable&&) noexcept = default;
+
+  std::uint32_t intern(std::string_view s) { return intern(s, hash_string(s)); }
+  // Com o hash_string(s) já calculado.
+  std::uint32_t intern(std::string_view s, std::uint64_t hash);
+  std::string_view name(std::uint32_t id) const { return names_[id]; }
+  std::size_t size() const { return names_.size(); }
+  std::size_t index_capacity() const { return index_.capacity(); }
+  // Arena + índice + views (aproximado).
+  std::size_t memory_bytes() const {
+    return chunks_.size() * kChunkSize + index_.memory_bytes() + names_.capacity() * sizeof(std::string_view);
+  }
+
+private:
+  static constexpr std::size_t kChunkSize = 64 * 1024;
+
+  std::vector<std::unique_ptr<char[]>> chunks_;
+  std::size_t chunk_used_ = 0;
+  std::size_t chunk_cap_ = 0;
+
+  std::vector<std::string_view> names_;
+  StringIndex index_;
+
+  std::string_view store(std::string_view s);
+};
+
+} // namespace logforge
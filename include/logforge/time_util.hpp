@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace logforge {
+
+// Dias desde 1970-01-01 no calendário gregoriano proléptico.
+std::int64_t days_from_civil(int year, int month, int day);
+
+// Minutos desde 1970-01-01 00:00 para a data/hora dada.
+std::int64_t epoch_minute(int year, int month, int day, int hour, int minute);
+
+// Formata minutos desde a época como "YYYY-MM-DD HH:MM" (só usado nos relatórios).
+std::string format_minute(std::int64_t epoch_min);
+// O mesmo texto escrito em `out` (com espaço para kMinuteTextMax bytes, sem '\0'), sem
+// alocar; devolve o tamanho (16, a não ser em anos fora de 0..9999).
+inline constexpr std::size_t kMinuteTextMax = 32;
+std::size_t format_minute(std::int64_t epoch_min, char* out);
+
+// Inverso de format_minute: "YYYY-MM-DD HH:MM" (ou com 'T' no lugar do espaço) ou só
+// "YYYY-MM-DD" (00:00). nullopt se o texto não estiver nesse formato.
+std::optional<std::int64_t> parse_minute_text(std::string_view s);
+
+// Timestamps dos formatos de log -> minutos UTC desde a época: o fuso da linha é
+// descontado, então hosts em fusos diferentes caem nos mesmos minutos de per_minute (sem
+// fuso no texto, o horário é tomado como UTC). nullopt se o texto não estiver no formato.
+//
+// "10/Oct/2000:13:55:36 -0700" ($time_local do nginx, %t do Apache, sem os colchetes). Na
+// largura fixa de 26 bytes, o texto sem os segundos é comparado com o da última linha
+// decodificada pela thread (três palavras de 8 bytes e um byte) e, se for igual, o minuto
+// volta direto; senão os campos são lidos em posições fixas, com a validação acumulada
+// sem desvios. Outras larguras caem num parse com find.
+std::optional<std::int64_t> parse_time_local(std::string_view t);
+// "2000-10-10T13:55:36-07:00" ($time_iso8601; frações de segundo, 'Z' e "+hhmm" também valem).
+std::optional<std::int64_t> parse_time_iso8601(std::string_view t);
+
+} // namespace logforge
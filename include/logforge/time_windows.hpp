@@ -0,0 +1,111 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "endpoint_stats.hpp"
+
+namespace logforge {
+
+struct WindowOptions {
+  int width_min = 0;       // largura da janela tumbling em minutos (0 = desligado; ex.: 1, 5, 60)
+  std::size_t ring = 60;   // janelas abertas no anel; mais velhas: ver keep_closed
+  int sliding = 0;         // janelas somadas no agregado deslizante de cada linha (0 = sem)
+  // false (modo --follow): janelas expulsas do anel são descartadas, a memória fica
+  // limitada ao anel e linhas mais velhas que ele só contam em late(). true (batch): viram
+  // registros compactos (sketch serializado) e as linhas atrasadas ainda entram nelas.
+  bool keep_closed = true;
+  int hll_precision = 0;   // clientes distintos por janela (HyperLogLog; 0 = desligado)
+};
+
+struct WindowRow {
+  std::int64_t start_minute = 0; // minuto desde a época do início da janela
+  std::uint64_t count = 0;
+  std::uint64_t status_classes[5] = {}; // 1xx .. 5xx
+  double rps = 0.0;
+  double error_rate = 0.0; // 5xx / count
+  double p50_ms = -1.0;
+  double p95_ms = -1.0;
+  double p99_ms = -1.0;
+  // Agregado das últimas `sliding` janelas terminando nesta (lacunas contam como vazias).
+  std::uint64_t sliding_count = 0;
+  double sliding_rps = 0.0;
+  double sliding_error_rate = 0.0;
+  double sliding_p99_ms = -1.0;
+  // Só com hll_precision > 0: IPs distintos estimados na janela e no agregado deslizante.
+  std::uint64_t unique_clients = 0;
+  std::uint64_t sliding_unique_clients = 0;
+};
+
+// Janelas de tempo tumbling indexadas por epoch-minute / largura, num anel de tamanho fixo.
+//
+// Cada janela tem as classes de status e um sketch de latência (mesmo payload do
+// --endpoint-stats). Quando o tempo avança além do anel, a janela mais velha é expulsa:
+// vira um registro compacto (keep_closed) ou é descartada. Linhas fora de ordem caem na
+// janela certa enquanto ela estiver no anel. Mais velhas que isso: com keep_closed, somam
+// por janela à parte e entram nas fechadas na saída (rows, serialize, merge); sem ele, só
+// contam em late().
+//
+// merge() é exato por janela. Com keep_closed, nenhuma linha se perde e o resultado não
+// depende de como as linhas foram divididas entre threads; sem ele (--follow, uma thread só),
+// o que vira late depende da ordem.
+class TimeWindows {
+public:
+  explicit TimeWindows(const WindowOptions& opt);
+
+  // `client_hash`: hll_hash do cliente (nullptr = sem cliente ou hll_precision = 0).
+  void add(std::int64_t minute, int status, std::int64_t latency_us, const std::uint64_t* client_hash = nullptr);
+  void merge(const TimeWindows& other);
+
+  // Todas as janelas conhecidas (fechadas + anel), por início crescente.
+  std::vector<WindowRow> rows() const;
+
+  // Estado completo (opções, anel e janelas fechadas) para snapshots.
+  void serialize(std::string& out) const;
+  // Substitui o estado, inclusive as opções; false se os dados forem inválidos.
+  bool deserialize(std::string_view& in);
+
+  const WindowOptions& options() const { return opt_; }
+  std::uint64_t late() const { return late_; }
+  std::size_t closed_count() const;
+
+private:
+  static constexpr std::int64_t kNoWindow = INT64_MIN;
+
+  struct Slot {
+    std::int64_t id = kNoWindow;
+    EndpointStats stats;
+  };
+  struct ClosedWindow {
+    std::uint64_t count = 0;
+    std::uint64_t status_classes[5] = {};
+    std::string latency; // LatencySketch::serialize
+    HyperLogLog clients; // já compacto (esparso ou 2^p bytes)
+  };
+
+  WindowOptions opt_;
+  std::vector<Slot> ring_;
+  std::int64_t head_ = kNoWindow; // id da janela mais recente vista
+  std::map<std::int64_t, ClosedWindow> closed_;
+  // keep_closed: linhas de janelas que já tinham saído do anel, juntadas por janela (uma
+  // reserialização do sketch por janela, não por linha).
+  std::map<std::int64_t, EndpointStats> late_windows_;
+  std::uint64_t late_ = 0;
+
+  std::int64_t window_of(std::int64_t minute) const;
+  Slot& slot(std::int64_t id);
+  bool in_ring(std::int64_t id) const;
+  void advance(std::int64_t id);
+  void close(Slot& s);
+  void merge_closed(std::int64_t id, const EndpointStats& st);
+  void merge_window(std::int64_t id, const EndpointStats& st);
+  // Fechadas + late_windows_, por id crescente, já abertas.
+  std::vector<std::pair<std::int64_t, EndpointStats>> closed_stats() const;
+
+  static EndpointStats open(const ClosedWindow& c);
+  static ClosedWindow compact(const EndpointStats& st);
+};
+
+} // namespace logforge
@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+"""Compara dois resultados do logforge_bench (--json): linha de base x atual.
+
+Um benchmark só conta como mais lento/mais rápido se a diferença das medianas passar do
+limiar de ruído: o maior entre --min-pct e --k vezes o ruído das duas medidas (desvio
+absoluto mediano das repetições, escalado para desvio padrão). Alocações por item são
+determinísticas e comparadas direto. Sai com 1 se houver regressão.
+"""
+import argparse
+import json
+import sys
+
+MAD_TO_SIGMA = 1.4826
+
+
+def load(path):
+    with open(path, encoding="utf-8") as f:
+        data = json.load(f)
+    if data.get("schema") != 1:
+        sys.exit(f"{path}: schema desconhecido: {data.get('schema')}")
+    return data, {r["name"]: r for r in data["results"]}
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("base", help="JSON da linha de base")
+    ap.add_argument("current", help="JSON da versão atual")
+    ap.add_argument("--min-pct", type=float, default=5.0, help="limiar mínimo em %% (padrão: 5)")
+    ap.add_argument("--k", type=float, default=3.0, help="quantos desvios de ruído contam como mudança (padrão: 3)")
+    ap.add_argument("--alloc-tol", type=float, default=0.01, help="tolerância em alocações/item (padrão: 0,01)")
+    args = ap.parse_args()
+
+    base_meta, base = load(args.base)
+    cur_meta, cur = load(args.current)
+    for key in ("lines", "log", "build"):
+        if base_meta["meta"].get(key) != cur_meta["meta"].get(key):
+            print(f"aviso: meta.{key} difere ({base_meta['meta'].get(key)} x {cur_meta['meta'].get(key)})")
+
+    regressions = 0
+    print(f"{'benchmark':28}{'base ns':>11}{'atual ns':>11}{'delta':>9}{'limiar':>9}  resultado")
+    for name, b in base.items():
+        c = cur.get(name)
+        if c is None:
+            print(f"{name:28}{b['ns_per_item']:>11.1f}{'-':>11}{'':>9}{'':>9}  ausente na atual")
+            continue
+        bm, cm = b["ns_per_item"], c["ns_per_item"]
+        if bm <= 0:
+            continue
+        noise = MAD_TO_SIGMA * (b["ns_per_item_mad"] ** 2 + c["ns_per_item_mad"] ** 2) ** 0.5
+        limit = max(args.min_pct / 100.0, args.k * noise / bm)
+        delta = cm / bm - 1.0
+        if delta > limit:
+            verdict = "MAIS LENTO"
+            regressions += 1
+        elif delta < -limit:
+            verdict = "mais rápido"
+        else:
+            verdict = "igual (ruído)"
+        da = c["allocs_per_item"] - b["allocs_per_item"]
+        if da > args.alloc_tol:
+            verdict += f"; ALOCA MAIS (+{da:.3f}/item)"
+            regressions += 1
+        elif da < -args.alloc_tol:
+            verdict += f"; aloca menos ({da:.3f}/item)"
+        print(f"{name:28}{bm:>11.1f}{cm:>11.1f}{delta * 100:>8.1f}%{limit * 100:>8.1f}%  {verdict}")
+    for name in cur:
+        if name not in base:
+            print(f"{name:28}{'-':>11}{cur[name]['ns_per_item']:>11.1f}{'':>9}{'':>9}  novo")
+
+    if regressions:
+        print(f"\n{regressions} regressão(ões) acima do ruído")
+        return 1
+    print("\nsem regressões acima do ruído")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -9,4 +9,13 @@ python3 scripts/gen_synth_log.py --out out/synthetic.log --lines 200000 --start
 cmake -S . -B build -DCMAKE_BUILD_TYPE=Release
 cmake --build build -j
 
-./build/logforge --in out/synthetic.log --out out/report --bench
+# Throughput por ISA do tokenizador (só as suportadas pela CPU)
+for isa in scalar sse2 avx2; do
+  ./build/logforge --in out/synthetic.log --out out/report --bench --isa "$isa" || true
+done
+
+# Benchmarks por estágio; com BASELINE=<resultados.json> compara contra uma linha de base
+./build/bench/logforge_bench --json out/bench.json
+if [[ -n "${BASELINE:-}" ]]; then
+  python3 scripts/bench_compare.py "$BASELINE" out/bench.json
+fi
@@ -1,6 +1,7 @@
 #!/usr/bin/env python3
 import random
 import time
+import uuid
 from datetime import datetime, timedelta
 
 ENDPOINTS = ["/api/items", "/api/checkout", "/health", "/login", "/static/app.js", "/search"]
@@ -17,6 +18,8 @@ def main():
   ap.add_argument("--out", default="synthetic.log")
   ap.add_argument("--lines", type=int, default=100000)
   ap.add_argument("--start", default="2025-01-01 00:00:00")
+  ap.add_argument("--ids", action="store_true",
+                  help="alta cardinalidade: IDs numéricos/UUID/hex no path (ex.: /api/items/123)")
   args = ap.parse_args()
 
   dt = datetime.strptime(args.start, "%Y-%m-%d %H:%M:%S")
@@ -25,6 +28,14 @@ def main():
     for i in range(args.lines):
       dt += timedelta(seconds=random.randint(0, 2))
       ep = random.choice(ENDPOINTS)
+      if args.ids:
+        r = random.random()
+        if r < 0.4:
+          ep = f"/api/items/{random.randint(1, 10_000_000)}"
+        elif r < 0.6:
+          ep = f"/users/{uuid.uuid4()}/orders"
+        elif r < 0.7:
+          ep = f"/blobs/{random.getrandbits(128):032x}"
       st = random.choice(STATUS)
       ua = random.choice(UAS)
       method = "GET" if random.random() < 0.85 else "POST"
@@ -1,68 +1,448 @@
 #include "logforge/aggregator.hpp"
 
 #include <algorithm>
-#include <cmath>
+#include <cstring>
 
-namespace logforge {
+#include "logforge/varint.hpp"
 
-Aggregator::Aggregator(int top_n) : top_n_(top_n), latency_hist_(kBucketCount, 0) {}
+namespace logforge {
 
-void Aggregator::add_invalid() {
-  report_.total_lines++;
-  report_.invalid_lines++;
+static AggregatorOptions with_top_n(int top_n) {
+  AggregatorOptions opt;
+  opt.top_n = top_n;
+  return opt;
 }
 
-void Aggregator::add_latency(int latency_ms) {
-  if (latency_ms < 0) return;
+Aggregator::Aggregator(int top_n) : Aggregator(with_top_n(top_n)) {}
 
-  report_.latency.count++;
-  latency_sum_ms_ += static_cast<std::uint64_t>(latency_ms);
-
-  if (report_.latency.min_ms == -1 || latency_ms < report_.latency.min_ms) report_.latency.min_ms = latency_ms;
-  if (report_.latency.max_ms == -1 || latency_ms > report_.latency.max_ms) report_.latency.max_ms = latency_ms;
+Aggregator::Aggregator(const AggregatorOptions& opt)
+    : opt_(opt), latency_(opt.latency_error), clients_(opt.hll_precision) {
+  opt_.hll_precision = clients_.precision();
+  opt_.windows.hll_precision = opt_.hll_precision;
+  if (opt_.endpoint_stats_capacity > 0) {
+    // Com --endpoint-stats a memória toda fica limitada: o top-K também vira Space-Saving
+    // (senão endpoints_ cresceria com cada path distinto). Até topk_capacity endpoints
+    // distintos as contagens continuam exatas (count_error = 0).
+    opt_.topk_mode = TopKMode::Approx;
+    opt_.topk_capacity = std::max(opt_.topk_capacity, opt_.endpoint_stats_capacity);
+    EndpointStats prototype;
+    prototype.clients = HyperLogLog(opt_.hll_precision);
+    endpoint_stats_.emplace(opt_.endpoint_stats_capacity, prototype);
+  }
+  if (opt_.topk_mode == TopKMode::Approx) endpoint_topk_.emplace(opt_.topk_capacity);
+  if (opt_.windows.width_min > 0) windows_.emplace(opt_.windows);
+  if (opt_.group_by.enabled()) group_by_.emplace(opt_.group_by);
+  if (kStatsCompiled && opt_.stats) stats_.emplace();
+}
 
-  int idx = latency_ms / kBucketMs;
-  if (idx < 0) idx = 0;
-  if (idx >= kBucketCount - 1) idx = kBucketCount - 1; // overflow bucket
-  latency_hist_[static_cast<std::size_t>(idx)]++;
+void Aggregator::add_invalid(std::uint64_t n) {
+  report_.total_lines += n;
+  report_.invalid_lines += n;
 }
 
 void Aggregator::add_valid(const LogEntry& e) {
   report_.total_lines++;
   report_.parsed_lines++;
 
-  report_.status_counts[e.status]++;
-  report_.endpoint_counts[e.endpoint]++;
-  if (!e.minute_key.empty()) report_.per_minute_counts[e.minute_key]++;
+  status_.add(e.status);
+  // Um hash do endpoint por linha, compartilhado pelo índice do top-K e pelo --endpoint-stats.
+  const std::uint64_t endpoint_hash = hash_string(e.endpoint);
+  if (endpoint_topk_) {
+    endpoint_topk_->offer_hashed(e.endpoint, endpoint_hash);
+  } else {
+    const auto id = endpoints_.intern(e.endpoint, endpoint_hash);
+    if (id == endpoint_counts_.size()) endpoint_counts_.push_back(0);
+    endpoint_counts_[id]++;
+  }
+  if (e.minute != kNoMinute) minutes_.add(e.minute);
+
+  if (e.latency_us >= 0) latency_.add(static_cast<std::uint64_t>(e.latency_us));
+
+  // Um hash por linha, compartilhado pelos sketches global, por endpoint e por janela.
+  std::uint64_t client_hash = 0;
+  const std::uint64_t* client = nullptr;
+  if (clients_.enabled() && !e.remote_addr.empty()) {
+    client_hash = hll_hash(e.remote_addr);
+    client = &client_hash;
+    clients_.add_hash(client_hash);
+  }
+
+  if (endpoint_stats_) endpoint_stats_->offer_hashed(e.endpoint, endpoint_hash).add(e.status, e.latency_us, client);
+  if (windows_ && e.minute != kNoMinute) windows_->add(e.minute, e.status, e.latency_us, client);
+  if (group_by_) group_by_->add(e);
+}
+
+void Aggregator::add_batch(const EntryBatch& b) {
+  const std::size_t n = b.size;
+  report_.total_lines += n + b.invalid + b.filtered;
+  report_.parsed_lines += n;
+  report_.invalid_lines += b.invalid;
+  report_.filtered_lines += b.filtered;
+
+  for (std::size_t i = 0; i < n; ++i) status_.add(b.status[i]);
+
+  // Minutos: o log vem em ordem de tempo, então o lote é quase sempre um ou dois trechos
+  // do mesmo minuto — um add por trecho.
+  for (std::size_t i = 0; i < n;) {
+    const std::int64_t minute = b.minute[i];
+    std::size_t j = i + 1;
+    while (j < n && b.minute[j] == minute) ++j;
+    if (minute != kNoMinute) minutes_.add(minute, j - i);
+    i = j;
+  }
+
+  latency_.add_batch(b.latency_us, n);
+
+  // Hash do cliente uma vez por linha, compartilhado como em add_valid.
+  std::uint64_t client_hash[EntryBatch::kCapacity];
+  const std::uint64_t* client[EntryBatch::kCapacity];
+  for (std::size_t i = 0; i < n; ++i) client[i] = nullptr;
+  if (clients_.enabled()) {
+    for (std::size_t i = 0; i < n; ++i) {
+      if (b.remote_addr[i].empty()) continue;
+      client_hash[i] = hll_hash(b.remote_addr[i]);
+      client[i] = &client_hash[i];
+      clients_.add_hash(client_hash[i]);
+    }
+  }
+
+  // O que depende do endpoint fica num laço só: as buscas da tabela de símbolos e do
+  // --endpoint-stats pela mesma chave se sobrepõem (em laços separados, ficam em série).
+  for (std::size_t i = 0; i < n; ++i) {
+    const std::uint64_t endpoint_hash = hash_string(b.endpoint[i]);
+    if (endpoint_topk_) {
+      endpoint_topk_->offer_hashed(b.endpoint[i], endpoint_hash);
+    } else {
+      const auto id = endpoints_.intern(b.endpoint[i], endpoint_hash);
+      if (id == endpoint_counts_.size()) endpoint_counts_.push_back(0);
+      endpoint_counts_[id]++;
+    }
+    if (endpoint_stats_)
+      endpoint_stats_->offer_hashed(b.endpoint[i], endpoint_hash).add(b.status[i], b.latency_us[i], client[i]);
+    if (windows_ && b.minute[i] != kNoMinute) windows_->add(b.minute[i], b.status[i], b.latency_us[i], client[i]);
+    if (group_by_) group_by_->add(b.row(i));
+  }
+}
+
+void Aggregator::add_filtered(std::uint64_t n) {
+  report_.total_lines += n;
+  report_.filtered_lines += n;
+}
+
+void Aggregator::add_rows(std::uint64_t n) {
+  report_.total_lines += n;
+  report_.parsed_lines += n;
+}
+
+void Aggregator::add_status(int status, std::uint64_t n) { status_.add(status, n); }
+
+void Aggregator::add_endpoint(std::string_view endpoint, std::uint64_t n) {
+  if (endpoint_topk_) {
+    endpoint_topk_->offer(endpoint, n);
+    return;
+  }
+  const auto id = endpoints_.intern(endpoint);
+  if (id == endpoint_counts_.size()) endpoint_counts_.push_back(0);
+  endpoint_counts_[id] += n;
+}
+
+void Aggregator::add_minute(std::int64_t minute, std::uint64_t n) {
+  if (minute != kNoMinute) minutes_.add(minute, n);
+}
+
+void Aggregator::merge(const Aggregator& other) {
+  const Report& o = other.report_;
+  report_.total_lines += o.total_lines;
+  report_.parsed_lines += o.parsed_lines;
+  report_.invalid_lines += o.invalid_lines;
+  report_.filtered_lines += o.filtered_lines;
+
+  status_.merge(other.status_);
+  for (std::uint32_t i = 0; i < other.endpoints_.size(); ++i) {
+    const auto id = endpoints_.intern(other.endpoints_.name(i));
+    if (id == endpoint_counts_.size()) endpoint_counts_.push_back(0);
+    endpoint_counts_[id] += other.endpoint_counts_[i];
+  }
+  if (endpoint_topk_ && other.endpoint_topk_) endpoint_topk_->merge(*other.endpoint_topk_);
+  minutes_.merge(other.minutes_);
+
+  latency_.merge(other.latency_);
+  clients_.merge(other.clients_);
+  if (endpoint_stats_ && other.endpoint_stats_) endpoint_stats_->merge(*other.endpoint_stats_);
+  if (windows_ && other.windows_) windows_->merge(*other.windows_);
+  if (group_by_ && other.group_by_) group_by_->merge(*other.group_by_);
+  if (stats_ && other.stats_) stats_->merge(*other.stats_);
+}
+
+bool Aggregator::mergeable_with(const Aggregator& other) const {
+  // Capacidades do Space-Saving: o merge fica com a deste, e o limite do erro por entrada
+  // (parsed_lines / capacidade) não valeria para as contagens vindas de uma menor.
+  const bool same_topk = !endpoint_topk_ || opt_.topk_capacity == other.opt_.topk_capacity;
+  return opt_.latency_error == other.opt_.latency_error && opt_.topk_mode == other.opt_.topk_mode && same_topk &&
+         endpoint_stats_.has_value() == other.endpoint_stats_.has_value() &&
+         opt_.endpoint_stats_capacity == other.opt_.endpoint_stats_capacity &&
+         opt_.windows.width_min == other.opt_.windows.width_min && opt_.group_by == other.opt_.group_by &&
+         opt_.hll_precision == other.opt_.hll_precision;
+}
+
+static std::uint64_t double_bits(double d) {
+  std::uint64_t u = 0;
+  std::memcpy(&u, &d, sizeof(u));
+  return u;
+}
+
+static double bits_double(std::uint64_t u) {
+  double d = 0.0;
+  std::memcpy(&d, &u, sizeof(d));
+  return d;
+}
 
-  add_latency(e.latency_ms);
+// Contagens com chave inteira (StatusCounts, MinuteCounts): já saem em ordem crescente, com
+// a chave em delta (zigzag), determinístico.
+template <typename Counts>
+static void put_counts(std::string& out, const Counts& counts) {
+  put_varint(out, counts.size());
+  std::int64_t prev = 0;
+  counts.for_each([&](auto k, std::uint64_t c) {
+    put_varint(out, zigzag(static_cast<std::int64_t>(k) - prev));
+    put_varint(out, c);
+    prev = static_cast<std::int64_t>(k);
+  });
 }
 
-int Aggregator::percentile_from_hist(double p) const {
-  if (report_.latency.count == 0) return -1;
-  if (p <= 0.0) return report_.latency.min_ms;
-  if (p >= 1.0) return report_.latency.max_ms;
+template <typename K, typename Counts>
+static bool get_counts(std::string_view& in, Counts& counts) {
+  std::uint64_t n = 0;
+  if (!get_varint(in, n) || n > in.size()) return false;
+  std::int64_t key = 0;
+  for (std::uint64_t i = 0; i < n; ++i) {
+    std::uint64_t d = 0, c = 0;
+    if (!get_varint(in, d) || !get_varint(in, c)) return false;
+    key += unzigzag(d);
+    counts.add(static_cast<K>(key), c);
+  }
+  return true;
+}
+
+void Aggregator::serialize(std::string& out) const {
+  put_varint(out, static_cast<std::uint64_t>(opt_.top_n));
+  put_varint(out, double_bits(opt_.latency_error));
+  put_varint(out, opt_.quantiles.size());
+  for (double q : opt_.quantiles) put_varint(out, double_bits(q));
+  put_varint(out, opt_.endpoint_stats_capacity);
+  put_varint(out, opt_.topk_mode == TopKMode::Approx ? 1 : 0);
+  put_varint(out, opt_.topk_capacity);
+
+  put_varint(out, report_.total_lines);
+  put_varint(out, report_.parsed_lines);
+  put_varint(out, report_.invalid_lines);
+  put_varint(out, report_.filtered_lines);
+  put_counts(out, status_);
+  put_counts(out, minutes_);
+
+  // Endpoints: no modo exato, tabela de strings (tamanhos, depois um blob único) + contagens.
+  if (endpoint_topk_) {
+    endpoint_topk_->serialize(out);
+  } else {
+    put_varint(out, endpoints_.size());
+    for (std::uint32_t i = 0; i < endpoints_.size(); ++i) put_varint(out, endpoints_.name(i).size());
+    for (std::uint32_t i = 0; i < endpoints_.size(); ++i) out.append(endpoints_.name(i));
+    for (auto c : endpoint_counts_) put_varint(out, c);
+  }
+
+  latency_.serialize(out);
+  clients_.serialize(out);
 
-  const auto target = static_cast<std::uint64_t>(std::ceil(p * report_.latency.count));
-  std::uint64_t cum = 0;
-  for (std::size_t i = 0; i < latency_hist_.size(); ++i) {
-    cum += latency_hist_[i];
-    if (cum >= target) {
-      int ms = static_cast<int>(i) * kBucketMs;
-      return ms;
+  put_varint(out, endpoint_stats_ ? 1 : 0);
+  if (endpoint_stats_) endpoint_stats_->serialize(out);
+  put_varint(out, windows_ ? 1 : 0);
+  if (windows_) windows_->serialize(out);
+  put_varint(out, group_by_ ? 1 : 0);
+  if (group_by_) group_by_->serialize(out);
+}
+
+bool Aggregator::deserialize(std::string_view& in) {
+  AggregatorOptions opt;
+  std::uint64_t top_n = 0, bits = 0, nq = 0, es_cap = 0, approx = 0, topk_cap = 0;
+  if (!get_varint(in, top_n) || !get_varint(in, bits) || !get_varint(in, nq) || nq > in.size()) return false;
+  opt.top_n = static_cast<int>(std::min<std::uint64_t>(top_n, INT32_MAX));
+  opt.latency_error = bits_double(bits);
+  if (!(opt.latency_error > 0.0 && opt.latency_error < 1.0)) return false;
+  for (std::uint64_t i = 0; i < nq; ++i) {
+    if (!get_varint(in, bits)) return false;
+    opt.quantiles.push_back(bits_double(bits));
+  }
+  if (!get_varint(in, es_cap) || !get_varint(in, approx) || !get_varint(in, topk_cap) || approx > 1) return false;
+  opt.endpoint_stats_capacity = static_cast<std::size_t>(es_cap);
+  opt.topk_mode = approx ? TopKMode::Approx : TopKMode::Exact;
+  opt.topk_capacity = static_cast<std::size_t>(std::max<std::uint64_t>(topk_cap, 1));
+
+  // As estruturas opcionais vêm do próprio snapshot; aqui ficam desligadas até lá.
+  AggregatorOptions base = opt;
+  base.endpoint_stats_capacity = 0;
+  base.topk_mode = TopKMode::Exact;
+  Aggregator a(base);
+  a.opt_ = opt;
+
+  Report& r = a.report_;
+  if (!get_varint(in, r.total_lines) || !get_varint(in, r.parsed_lines) || !get_varint(in, r.invalid_lines) ||
+      !get_varint(in, r.filtered_lines))
+    return false;
+  if (!get_counts<int>(in, a.status_) || !get_counts<std::int64_t>(in, a.minutes_)) return false;
+
+  if (opt.topk_mode == TopKMode::Approx) {
+    a.endpoint_topk_.emplace(opt.topk_capacity);
+    if (!a.endpoint_topk_->deserialize(in)) return false;
+  } else {
+    std::uint64_t n = 0;
+    if (!get_varint(in, n) || n > in.size()) return false;
+    std::vector<std::uint64_t> lens(static_cast<std::size_t>(n));
+    std::uint64_t blob = 0;
+    for (auto& len : lens) {
+      if (!get_varint(in, len)) return false;
+      blob += len;
+    }
+    if (blob > in.size()) return false;
+    for (auto len : lens) {
+      if (a.endpoints_.intern(in.substr(0, static_cast<std::size_t>(len))) != a.endpoint_counts_.size()) return false;
+      a.endpoint_counts_.push_back(0);
+      in.remove_prefix(static_cast<std::size_t>(len));
+    }
+    for (auto& c : a.endpoint_counts_) {
+      if (!get_varint(in, c)) return false;
     }
   }
-  return report_.latency.max_ms;
+
+  if (!a.latency_.deserialize(in) || !a.clients_.deserialize(in)) return false;
+  a.opt_.hll_precision = a.clients_.precision();
+
+  std::uint64_t has = 0;
+  if (!get_varint(in, has) || has > 1) return false;
+  if (has) {
+    EndpointStats prototype;
+    prototype.clients = HyperLogLog(a.opt_.hll_precision);
+    a.endpoint_stats_.emplace(std::max<std::size_t>(opt.endpoint_stats_capacity, 1), prototype);
+    if (!a.endpoint_stats_->deserialize(in)) return false;
+  }
+  if (!get_varint(in, has) || has > 1) return false;
+  if (has) {
+    a.windows_.emplace(WindowOptions{});
+    if (!a.windows_->deserialize(in)) return false;
+    a.opt_.windows = a.windows_->options();
+  }
+  if (!get_varint(in, has) || has > 1) return false;
+  if (has) {
+    a.group_by_.emplace(GroupBySpec{});
+    if (!a.group_by_->deserialize(in)) return false;
+    a.opt_.group_by = a.group_by_->spec();
+  }
+
+  *this = std::move(a);
+  return true;
+}
+
+std::vector<TableStats> Aggregator::table_stats() const {
+  std::vector<TableStats> t;
+  if (endpoint_topk_) {
+    t.push_back({"endpoints (top-K)", endpoint_topk_->size(), endpoint_topk_->capacity(), 0});
+  } else {
+    t.push_back({"endpoints", endpoints_.size(), endpoints_.index_capacity(), endpoints_.memory_bytes()});
+  }
+  t.push_back({"status", status_.size(), 0, sizeof(StatusCounts)});
+  t.push_back({"minutos", minutes_.size(), minutes_.span(), minutes_.span() * sizeof(std::uint64_t)});
+  t.push_back({"latencia (buckets)", latency_.bucket_count(), 0, latency_.memory_bytes()});
+  if (clients_.enabled()) t.push_back({"clientes (HLL)", 0, 0, clients_.memory_bytes()});
+  if (endpoint_stats_) t.push_back({"endpoint-stats", endpoint_stats_->size(), endpoint_stats_->capacity(), 0});
+  if (windows_) t.push_back({"janelas fechadas", windows_->closed_count(), 0, 0});
+  if (group_by_) t.push_back({"grupos", group_by_->size(), 0, 0});
+  return t;
+}
+
+static double us_to_ms(double us) { return us / 1000.0; }
+
+void Aggregator::build_endpoint_latency(Report& r) const {
+  r.endpoint_latency_enabled = true;
+  r.endpoint_latency_approximate = endpoint_stats_->approximate();
+
+  auto& rows = r.endpoint_latency;
+  rows.clear();
+  rows.reserve(endpoint_stats_->size());
+  endpoint_stats_->for_each([&](const auto& e) {
+    EndpointLatencyRow row;
+    row.endpoint = e.key;
+    row.count = e.count;
+    row.count_error = e.error;
+    const EndpointStats& st = e.payload;
+    for (int i = 0; i < 5; ++i) row.status_classes[i] = st.status_classes[i];
+    if (st.count > 0) row.error_rate = static_cast<double>(st.status_classes[4]) / static_cast<double>(st.count);
+    if (st.latency.count() > 0) {
+      row.p50_ms = us_to_ms(st.latency.quantile(0.50));
+      row.p95_ms = us_to_ms(st.latency.quantile(0.95));
+      row.p99_ms = us_to_ms(st.latency.quantile(0.99));
+    }
+    row.unique_clients = st.clients.estimate();
+    rows.push_back(std::move(row));
+  });
+  std::sort(rows.begin(), rows.end(), [](const auto& a, const auto& b) {
+    return (a.count == b.count) ? (a.endpoint < b.endpoint) : (a.count > b.count);
+  });
 }
 
-Report Aggregator::finalize() {
-  if (report_.latency.count > 0) {
-    report_.latency.avg_ms = static_cast<double>(latency_sum_ms_) / static_cast<double>(report_.latency.count);
-    report_.latency.p50_ms = percentile_from_hist(0.50);
-    report_.latency.p95_ms = percentile_from_hist(0.95);
-    report_.latency.p99_ms = percentile_from_hist(0.99);
+Report Aggregator::finalize() const {
+  Report r = report_;
+  r.status_counts = status_.to_map();
+  r.per_minute_counts = minutes_.to_map();
+  r.endpoint_counts.clear();
+  r.endpoint_count_errors.clear();
+  if (endpoint_topk_) {
+    r.endpoint_counts_approximate = endpoint_topk_->approximate();
+    r.endpoint_counts.reserve(endpoint_topk_->size());
+    endpoint_topk_->for_each([&](const auto& e) {
+      r.endpoint_counts.emplace(e.key, e.count);
+      if (e.error) r.endpoint_count_errors.emplace(e.key, e.error);
+    });
+  } else {
+    r.endpoint_counts.reserve(endpoints_.size());
+    for (std::uint32_t i = 0; i < endpoints_.size(); ++i) {
+      r.endpoint_counts.emplace(std::string(endpoints_.name(i)), endpoint_counts_[i]);
+    }
+  }
+
+  LatencyStats& l = r.latency;
+  l.count = latency_.count();
+  l.relative_error = latency_.relative_error();
+  l.quantiles.clear();
+  if (l.count > 0) {
+    l.min_ms = us_to_ms(static_cast<double>(latency_.min()));
+    l.max_ms = us_to_ms(static_cast<double>(latency_.max()));
+    l.avg_ms = us_to_ms(static_cast<double>(latency_.sum()) / static_cast<double>(l.count));
+    l.p50_ms = us_to_ms(latency_.quantile(0.50));
+    l.p95_ms = us_to_ms(latency_.quantile(0.95));
+    l.p99_ms = us_to_ms(latency_.quantile(0.99));
+    for (double q : opt_.quantiles) l.quantiles.emplace_back(q, us_to_ms(latency_.quantile(q)));
+  }
+
+  if (clients_.enabled()) {
+    r.unique_clients_enabled = true;
+    r.unique_clients = clients_.estimate();
+    r.unique_clients_precision = clients_.precision();
+    r.unique_clients_error = clients_.relative_error();
+  }
+
+  if (endpoint_stats_) build_endpoint_latency(r);
+  if (windows_) {
+    r.windows_enabled = true;
+    r.window_width_min = windows_->options().width_min;
+    r.window_sliding = windows_->options().sliding;
+    r.window_late = windows_->late();
+    r.windows = windows_->rows();
+  }
+  if (group_by_) {
+    r.group_by_enabled = true;
+    r.group_by_spec = group_by_->spec();
+    r.group_by = group_by_->rows();
   }
-  return report_;
+  return r;
 }
 
 } // namespace logforge
@@ -0,0 +1,501 @@
+#include "logforge/async_reader.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+#ifdef LOGFORGE_HAVE_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+namespace logforge {
+
+using SteadyClock = std::chrono::steady_clock;
+
+// Alinhamento de buffer, offset e tamanho exigido pelo O_DIRECT (cobre setores de 512 B e 4 KiB).
+static constexpr std::size_t kAlign = 4096;
+
+static ssize_t pread_full(int fd, char* buf, std::size_t len, std::uint64_t off) {
+  ssize_t n;
+  do n = ::pread(fd, buf, len, static_cast<off_t>(off));
+  while (n < 0 && errno == EINTR);
+  return n;
+}
+
+// Fila de leituras em voo, uma por slot do anel.
+class ReadQueue {
+public:
+  virtual ~ReadQueue() = default;
+  virtual void submit(std::size_t slot, char* buf, std::size_t len, std::uint64_t off) = 0;
+  // Espera a leitura do slot: bytes lidos ou -errno.
+  virtual long wait(std::size_t slot) = 0;
+  // Espera tudo que está em voo. false se não deu para esperar: o kernel ainda pode
+  // escrever nos buffers, que então não podem ser liberados.
+  virtual bool drain() { return true; }
+};
+
+// Sem io_uring: uma thread faz os pread na ordem de submissão.
+class PreadQueue final : public ReadQueue {
+public:
+  PreadQueue(int fd, std::size_t slots) : fd_(fd), result_(slots, 0), done_(slots, 1) {
+    worker_ = std::thread([this] { run(); });
+  }
+  ~PreadQueue() override {
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    worker_.join(); // termina o pread em andamento; os pendentes são descartados
+  }
+
+  void submit(std::size_t slot, char* buf, std::size_t len, std::uint64_t off) override {
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      done_[slot] = 0;
+      pending_.push_back({slot, buf, len, off});
+    }
+    cv_.notify_all();
+  }
+
+  long wait(std::size_t slot) override {
+    std::unique_lock<std::mutex> lk(mu_);
+    cv_.wait(lk, [&] { return done_[slot] != 0; });
+    return result_[slot];
+  }
+
+private:
+  struct Request {
+    std::size_t slot;
+    char* buf;
+    std::size_t len;
+    std::uint64_t off;
+  };
+
+  int fd_;
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::deque<Request> pending_;
+  std::vector<long> result_;
+  std::vector<char> done_;
+  bool stop_ = false;
+  std::thread worker_;
+
+  void run() {
+    for (;;) {
+      Request r{};
+      {
+        std::unique_lock<std::mutex> lk(mu_);
+        cv_.wait(lk, [&] { return stop_ || !pending_.empty(); });
+        if (stop_) return;
+        r = pending_.front();
+        pending_.pop_front();
+      }
+      const ssize_t n = pread_full(fd_, r.buf, r.len, r.off);
+      const long res = n < 0 ? -static_cast<long>(errno) : static_cast<long>(n);
+      {
+        std::lock_guard<std::mutex> lk(mu_);
+        result_[r.slot] = res;
+        done_[r.slot] = 1;
+      }
+      cv_.notify_all();
+    }
+  }
+};
+
+#ifdef LOGFORGE_HAVE_URING
+// io_uring pelas syscalls cruas (sem liburing): um anel por leitor, READV com um iovec por
+// slot. Só a thread dona do leitor mexe nos anéis; as barreiras são as do protocolo do kernel.
+class UringQueue final : public ReadQueue {
+public:
+  // nullptr se o kernel não tem io_uring ou o nega (ex.: seccomp em containers).
+  static std::unique_ptr<UringQueue> create(int fd, std::size_t slots) {
+    std::unique_ptr<UringQueue> q(new UringQueue(fd, slots));
+    return q->init() ? std::move(q) : nullptr;
+  }
+
+  ~UringQueue() override {
+    drain();
+    if (sqes_) ::munmap(sqes_, sqes_size_);
+    if (cq_ptr_ && cq_ptr_ != sq_ptr_) ::munmap(cq_ptr_, cq_size_);
+    if (sq_ptr_) ::munmap(sq_ptr_, sq_size_);
+    if (ring_fd_ >= 0) ::close(ring_fd_);
+  }
+
+  void submit(std::size_t slot, char* buf, std::size_t len, std::uint64_t off) override {
+    iov_[slot] = {buf, len};
+    const unsigned tail = *sq_tail_;
+    const unsigned idx = tail & *sq_mask_;
+    io_uring_sqe& sqe = sqes_[idx];
+    std::memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = IORING_OP_READV;
+    sqe.fd = fd_;
+    sqe.addr = reinterpret_cast<std::uint64_t>(&iov_[slot]);
+    sqe.len = 1;
+    sqe.off = off;
+    sqe.user_data = slot;
+    sq_array_[idx] = idx;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    done_[slot] = 0;
+    in_flight_[slot] = 1;
+    if (enter(1, 0, 0) < 0) {
+      // Não foi submetida: desfaz a entrada e reporta no wait.
+      __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+      result_[slot] = -static_cast<long>(errno);
+      done_[slot] = 1;
+      in_flight_[slot] = 0;
+    }
+  }
+
+  long wait(std::size_t slot) override {
+    reap();
+    while (!done_[slot]) {
+      // Se o enter falhar, a leitura continua com o kernel: o slot segue em voo até o CQE
+      // dele ser colhido (ou até drain desistir).
+      if (enter(0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) return -static_cast<long>(errno);
+      reap();
+    }
+    in_flight_[slot] = 0;
+    return result_[slot];
+  }
+
+  bool drain() override {
+    for (std::size_t s = 0; s < in_flight_.size(); ++s) {
+      if (in_flight_[s] && wait(s) < 0 && in_flight_[s]) return false;
+    }
+    return true;
+  }
+
+private:
+  int fd_;
+  int ring_fd_ = -1;
+  void* sq_ptr_ = nullptr;
+  void* cq_ptr_ = nullptr;
+  std::size_t sq_size_ = 0;
+  std::size_t cq_size_ = 0;
+  io_uring_sqe* sqes_ = nullptr;
+  std::size_t sqes_size_ = 0;
+  unsigned* sq_tail_ = nullptr;
+  unsigned* sq_mask_ = nullptr;
+  unsigned* sq_array_ = nullptr;
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  unsigned* cq_mask_ = nullptr;
+  io_uring_cqe* cqes_ = nullptr;
+  std::vector<iovec> iov_;
+  std::vector<long> result_;
+  std::vector<char> done_;
+  std::vector<char> in_flight_;
+
+  UringQueue(int fd, std::size_t slots)
+      : fd_(fd), iov_(slots), result_(slots, 0), done_(slots, 1), in_flight_(slots, 0) {}
+
+  bool init() {
+    io_uring_params p{};
+    const long rfd = ::syscall(__NR_io_uring_setup, static_cast<unsigned>(iov_.size()), &p);
+    if (rfd < 0) return false;
+    ring_fd_ = static_cast<int>(rfd);
+
+    sq_size_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cq_size_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    const bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+
+    void* sq = ::mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                      IORING_OFF_SQ_RING);
+    if (sq == MAP_FAILED) return false;
+    sq_ptr_ = sq;
+    if (single) {
+      cq_ptr_ = sq_ptr_;
+    } else {
+      void* cq = ::mmap(nullptr, cq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                        IORING_OFF_CQ_RING);
+      if (cq == MAP_FAILED) return false;
+      cq_ptr_ = cq;
+    }
+    sqes_size_ = p.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                        IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) return false;
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    auto* sqb = static_cast<char*>(sq_ptr_);
+    sq_tail_ = reinterpret_cast<unsigned*>(sqb + p.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned*>(sqb + p.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sqb + p.sq_off.array);
+    auto* cqb = static_cast<char*>(cq_ptr_);
+    cq_head_ = reinterpret_cast<unsigned*>(cqb + p.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cqb + p.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned*>(cqb + p.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cqb + p.cq_off.cqes);
+    return true;
+  }
+
+  long enter(unsigned to_submit, unsigned min_complete, unsigned flags) {
+    long rc;
+    do rc = ::syscall(__NR_io_uring_enter, ring_fd_, to_submit, min_complete, flags, nullptr, 0);
+    while (rc < 0 && errno == EINTR && to_submit > 0);
+    return rc;
+  }
+
+  void reap() {
+    unsigned head = *cq_head_;
+    const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+      const io_uring_cqe& cqe = cqes_[head & *cq_mask_];
+      const auto slot = static_cast<std::size_t>(cqe.user_data);
+      result_[slot] = cqe.res;
+      done_[slot] = 1;
+      ++head;
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+  }
+};
+#endif
+
+const char* async_backend_name(AsyncBackend b) {
+  switch (b) {
+    case AsyncBackend::Uring: return "io_uring";
+    case AsyncBackend::Pread: return "pread";
+    case AsyncBackend::Auto: break;
+  }
+  return "auto";
+}
+
+AsyncBackend resolve_async_backend() {
+  static const AsyncBackend resolved = [] {
+#ifdef LOGFORGE_HAVE_URING
+    io_uring_params p{};
+    const long fd = ::syscall(__NR_io_uring_setup, 2u, &p);
+    if (fd >= 0) {
+      ::close(static_cast<int>(fd));
+      return AsyncBackend::Uring;
+    }
+#endif
+    return AsyncBackend::Pread;
+  }();
+  return resolved;
+}
+
+AsyncLineReader::AsyncLineReader(const std::string& path, ByteRange range, AsyncReadOptions opt) {
+  block_size_ = std::max(kAlign, (opt.block_size + kAlign - 1) / kAlign * kAlign);
+
+  if (opt.direct) {
+    fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT);
+    direct_ = fd_ >= 0;
+  }
+  if (fd_ < 0) fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd_ < 0) return;
+
+  struct stat st {};
+  if (::fstat(fd_, &st) != 0 || !S_ISREG(st.st_mode)) return; // pipes etc.: use o Stream
+  file_size_ = static_cast<std::uint64_t>(st.st_size);
+  const std::uint64_t begin = std::min(range.begin, file_size_);
+  end_ = std::min(range.end, file_size_);
+  next_off_ = begin / kAlign * kAlign;
+  skip_ = static_cast<std::size_t>(begin - next_off_);
+  line_begin_ = begin;
+
+  ring_.resize(std::max<std::size_t>(opt.depth, 2));
+  for (auto& b : ring_) {
+    b.data = static_cast<char*>(std::aligned_alloc(kAlign, block_size_));
+    if (!b.data) return;
+  }
+
+  if (direct_) {
+    // Alguns FS aceitam o open com O_DIRECT e recusam a leitura: testa com um bloco mínimo.
+    if (begin < end_ && pread_full(fd_, ring_[0].data, kAlign, next_off_) < 0 && errno == EINVAL) {
+      ::fcntl(fd_, F_SETFL, ::fcntl(fd_, F_GETFL) & ~O_DIRECT);
+      direct_ = false;
+    }
+  } else {
+    ::posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+  }
+
+  backend_ = (opt.backend == AsyncBackend::Auto) ? resolve_async_backend() : opt.backend;
+#ifdef LOGFORGE_HAVE_URING
+  if (backend_ == AsyncBackend::Uring) queue_ = UringQueue::create(fd_, ring_.size());
+#endif
+  if (!queue_) {
+    backend_ = AsyncBackend::Pread;
+    queue_ = std::make_unique<PreadQueue>(fd_, ring_.size());
+  }
+
+  ok_ = true;
+  if (begin >= end_) {
+    done_ = true;
+    return;
+  }
+  refill();
+}
+
+AsyncLineReader::~AsyncLineReader() {
+  // Sem conseguir esperar as leituras em voo, os blocos ficam vazados: liberar memória em
+  // que o kernel ainda pode escrever seria pior.
+  const bool drained = !queue_ || queue_->drain();
+  queue_.reset();
+  if (drained) {
+    for (auto& b : ring_) std::free(b.data);
+  }
+  std::free(spare_.data);
+  if (fd_ >= 0) ::close(fd_);
+}
+
+void AsyncLineReader::submit() {
+  const std::size_t slot = static_cast<std::size_t>(submitted_ % ring_.size());
+  Block& b = ring_[slot];
+  b.off = next_off_;
+  b.size = 0;
+  queue_->submit(slot, b.data, block_size_, b.off);
+  next_off_ += block_size_;
+  ++submitted_;
+}
+
+// Põe no read-ahead os slots livres (nem em voo, nem seguros pelo lote).
+void AsyncLineReader::refill() {
+  while (submitted_ - released_ < ring_.size() && next_off_ < end_) submit();
+}
+
+void AsyncLineReader::release_views() {
+  released_ = consumed_;
+  stitched_used_ = 0;
+  if (!done_) refill();
+}
+
+// A linha costurada em carry_ vira a saída. Em lote, cada uma fica numa string própria até
+// o release_views; linha a linha, line_ basta.
+std::string_view AsyncLineReader::take_carry() {
+  std::string* dst = &line_;
+  if (hold_) {
+    if (stitched_used_ == stitched_.size()) stitched_.emplace_back();
+    dst = &stitched_[stitched_used_++];
+  }
+  dst->swap(carry_);
+  carry_.clear();
+  return *dst;
+}
+
+// Completa uma leitura curta antes do fim do arquivo (rara) de forma síncrona.
+bool AsyncLineReader::fill_rest(Block& b) {
+  while (b.size < block_size_ && b.off + b.size < file_size_) {
+    const ssize_t n = pread_full(fd_, b.data + b.size, block_size_ - b.size, b.off + b.size);
+    if (n < 0 && errno == EINVAL && direct_) {
+      // O resto não está alinhado: segue sem O_DIRECT.
+      ::fcntl(fd_, F_SETFL, ::fcntl(fd_, F_GETFL) & ~O_DIRECT);
+      direct_ = false;
+      continue;
+    }
+    if (n < 0) return false;
+    if (n == 0) break; // arquivo encolheu
+    b.size += static_cast<std::size_t>(n);
+  }
+  return true;
+}
+
+// Espera o próximo bloco em ordem; false no fim (ou erro: ok_ fica false).
+bool AsyncLineReader::acquire() {
+  Block* b = nullptr;
+  const auto t0 = SteadyClock::now();
+  if (submitted_ == consumed_) {
+    // Read-ahead da faixa esgotado: só continua se a linha em andamento passa da borda.
+    if (carry_.empty() || next_off_ >= file_size_) return false;
+    if (submitted_ - released_ < ring_.size()) {
+      submit();
+    } else {
+      // Linha maior que os blocos livres com o lote segurando o resto do anel: lê num
+      // bloco avulso, fora do anel, de que nenhuma view sai (ver next_line).
+      if (!spare_.data) spare_.data = static_cast<char*>(std::aligned_alloc(kAlign, block_size_));
+      spare_.off = next_off_;
+      const ssize_t n = spare_.data ? pread_full(fd_, spare_.data, block_size_, next_off_) : -1;
+      if (n < 0) {
+        ok_ = false;
+        return false;
+      }
+      spare_.size = static_cast<std::size_t>(n);
+      next_off_ += block_size_;
+      b = &spare_;
+    }
+  }
+  if (!b) {
+    b = &ring_[static_cast<std::size_t>(consumed_ % ring_.size())];
+    const long r = queue_->wait(static_cast<std::size_t>(consumed_ % ring_.size()));
+    if (r < 0) {
+      ok_ = false;
+      return false;
+    }
+    b->size = static_cast<std::size_t>(r);
+  }
+  const bool filled = fill_rest(*b);
+  wait_sec_ += std::chrono::duration<double>(SteadyClock::now() - t0).count();
+  if (!filled) {
+    ok_ = false;
+    return false;
+  }
+  bytes_read_ += b->size;
+  if (b->size == 0) return false;
+
+  cur_ = b;
+  pos_ = std::min(skip_, b->size);
+  skip_ = 0;
+  return true;
+}
+
+bool AsyncLineReader::next_line(std::string_view& out) {
+  while (!done_) {
+    if (cur_) {
+      const char* base = cur_->data;
+      while (pos_ < cur_->size) {
+        if (carry_.empty()) {
+          line_begin_ = cur_->off + pos_;
+          if (line_begin_ >= end_) {
+            done_ = true;
+            return false;
+          }
+        }
+        const char* p = base + pos_;
+        const auto* nl = static_cast<const char*>(std::memchr(p, '\n', cur_->size - pos_));
+        if (!nl) {
+          carry_.append(p, base + cur_->size);
+          pos_ = cur_->size;
+          break;
+        }
+        pos_ = static_cast<std::size_t>(nl - base) + 1;
+        out = std::string_view(p, static_cast<std::size_t>(nl - p));
+        if (!carry_.empty() || (hold_ && cur_ == &spare_)) { // o bloco avulso é reaproveitado
+          carry_.append(out);
+          out = take_carry();
+        }
+        return true;
+      }
+
+      // Bloco esgotado: o slot volta para o read-ahead (em lote, só no release_views).
+      if (cur_ != &spare_) ++consumed_;
+      cur_ = nullptr;
+      if (!hold_) released_ = consumed_;
+      refill();
+    }
+
+    if (!acquire()) {
+      // Fim: o que sobrou sem '\n' é a última linha.
+      done_ = true;
+      if (!ok_ || carry_.empty()) return false;
+      out = take_carry();
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace logforge
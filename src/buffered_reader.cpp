@@ -12,10 +12,26 @@ BufferedLineReader::BufferedLineReader(const std::string& path, std::size_t buff
   }
 }
 
+BufferedLineReader::BufferedLineReader(const std::string& path, std::uint64_t begin,
+                                       std::uint64_t end, std::size_t buffer_size)
+    : BufferedLineReader(path, buffer_size) {
+  pos_ = begin;
+  end_ = end;
+  if (ifs_.is_open() && begin > 0) ifs_.seekg(static_cast<std::streamoff>(begin));
+}
+
 bool BufferedLineReader::next_line(std::string& out) {
-  if (!ifs_.good())
+  if (!ifs_.good() || pos_ >= end_)
     return false;
-  return static_cast<bool>(std::getline(ifs_, out));
+  if (!std::getline(ifs_, out)) return false;
+  pos_ += out.size() + 1; // + '\n'
+  return true;
+}
+
+bool BufferedLineReader::next_line(std::string_view& out) {
+  if (!next_line(line_)) return false;
+  out = line_;
+  return true;
 }
 
 } // namespace logforge
@@ -0,0 +1,571 @@
+#include "logforge/column_index.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <memory>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+#include "logforge/varint.hpp"
+
+namespace logforge {
+
+// As colunas são lidas direto do arquivo mapeado como arrays nativos.
+static_assert(std::endian::native == std::endian::little, "índice colunar assume little-endian");
+
+static constexpr char kMagic[6] = {'L', 'F', 'I', 'N', 'D', 'X'};
+static constexpr std::size_t kHeaderSize = 64;
+static constexpr std::size_t kDirEntrySize = IndexWriter::kDirEntrySize;
+
+static std::uint64_t align8(std::uint64_t n) { return (n + 7) & ~std::uint64_t{7}; }
+
+template <typename T>
+static void put_at(char* p, std::size_t off, T v) {
+  std::memcpy(p + off, &v, sizeof(v));
+}
+
+template <typename T>
+static T get_at(const char* p, std::size_t off) {
+  T v{};
+  std::memcpy(&v, p + off, sizeof(v));
+  return v;
+}
+
+// ---------------------------------------------------------------- escrita
+
+IndexWriter::IndexWriter(std::string path, std::uint32_t block_rows)
+    : path_(std::move(path)), tmp_path_(path_ + ".tmp"), block_rows_(std::max<std::uint32_t>(block_rows, 1)) {
+  ofs_.open(tmp_path_, std::ios::binary | std::ios::trunc);
+  ok_ = ofs_.is_open();
+  const char header[kHeaderSize] = {};
+  write(header, sizeof(header)); // preenchido no finish()
+  ids_.reserve(block_rows_);
+  status_.reserve(block_rows_);
+  latency_.reserve(block_rows_);
+  minute_.reserve(block_rows_);
+}
+
+IndexWriter::~IndexWriter() {
+  if (!ok_) return;
+  // Sem finish() (erro no meio da leitura): não deixa o ".tmp" para trás.
+  ofs_.close();
+  std::error_code ec;
+  std::filesystem::remove(tmp_path_, ec);
+}
+
+void IndexWriter::write(const void* data, std::size_t n) {
+  ofs_.write(static_cast<const char*>(data), static_cast<std::streamsize>(n));
+  offset_ += n;
+}
+
+void IndexWriter::pad() {
+  static constexpr char zeros[8] = {};
+  write(zeros, align8(offset_) - offset_);
+}
+
+void IndexWriter::add_valid(const LogEntry& e) {
+  ids_.push_back(dict_.intern(e.endpoint));
+  status_.push_back(e.status);
+  latency_.push_back(e.latency_us);
+  minute_.push_back(e.minute);
+  total_lines_++;
+  rows_++;
+  if (ids_.size() == block_rows_) flush_block();
+}
+
+// Coluna de largura fixa convertida para T.
+template <typename T, typename Src, typename F>
+static void pack_column(const std::vector<Src>& src, F convert, std::vector<char>& buf) {
+  buf.resize(src.size() * sizeof(T));
+  for (std::size_t i = 0; i < src.size(); ++i) put_at<T>(buf.data(), i * sizeof(T), convert(src[i]));
+}
+
+void IndexWriter::flush_block() {
+  const std::size_t n = ids_.size();
+  if (n == 0) return;
+
+  std::int64_t min_minute = minute_[0], max_minute = minute_[0];
+  int min_status = status_[0], max_status = status_[0];
+  std::uint8_t classes = 0;
+  bool narrow_latency = true;
+  for (std::size_t i = 0; i < n; ++i) {
+    min_minute = std::min(min_minute, minute_[i]);
+    max_minute = std::max(max_minute, minute_[i]);
+    min_status = std::min(min_status, status_[i]);
+    max_status = std::max(max_status, status_[i]);
+    const int c = status_[i] / 100;
+    if (c >= 1 && c <= 5) classes |= static_cast<std::uint8_t>(1u << (c - 1));
+    if (latency_[i] >= static_cast<std::int64_t>(UINT32_MAX)) narrow_latency = false;
+  }
+  const bool narrow_status = min_status >= 0 && max_status <= UINT16_MAX;
+  const std::uint64_t block_offset = offset_;
+
+  std::vector<char> buf;
+  write(ids_.data(), n * sizeof(std::uint32_t));
+  pad();
+  if (narrow_status) {
+    pack_column<std::uint16_t>(status_, [](int v) { return static_cast<std::uint16_t>(v); }, buf);
+  } else {
+    pack_column<std::int32_t>(status_, [](int v) { return std::int32_t{v}; }, buf);
+  }
+  write(buf.data(), buf.size());
+  pad();
+  // latency_us + 1, com 0 = sem latência.
+  auto biased = [](std::int64_t l) { return l < 0 ? std::uint64_t{0} : static_cast<std::uint64_t>(l) + 1; };
+  if (narrow_latency) {
+    pack_column<std::uint32_t>(latency_, [&](std::int64_t l) { return static_cast<std::uint32_t>(biased(l)); }, buf);
+  } else {
+    pack_column<std::uint64_t>(latency_, biased, buf);
+  }
+  write(buf.data(), buf.size());
+  pad();
+  // Deltas em aritmética sem sinal: dá a volta sem UB mesmo com kNoMinute.
+  std::string minutes;
+  std::uint64_t prev = static_cast<std::uint64_t>(min_minute);
+  for (auto m : minute_) {
+    put_varint(minutes, zigzag(static_cast<std::int64_t>(static_cast<std::uint64_t>(m) - prev)));
+    prev = static_cast<std::uint64_t>(m);
+  }
+  write(minutes.data(), minutes.size());
+  pad();
+
+  char entry[kDirEntrySize] = {};
+  put_at<std::uint64_t>(entry, 0, block_offset);
+  put_at<std::uint32_t>(entry, 8, static_cast<std::uint32_t>(n));
+  entry[12] = narrow_status ? 2 : 4;
+  entry[13] = narrow_latency ? 4 : 8;
+  entry[14] = static_cast<char>(classes);
+  put_at<std::uint32_t>(entry, 16, static_cast<std::uint32_t>(minutes.size()));
+  put_at<std::int64_t>(entry, 24, min_minute);
+  put_at<std::int64_t>(entry, 32, max_minute);
+  put_at<std::int32_t>(entry, 40, min_status);
+  put_at<std::int32_t>(entry, 44, max_status);
+  dir_.append(entry, sizeof(entry));
+
+  ids_.clear();
+  status_.clear();
+  latency_.clear();
+  minute_.clear();
+}
+
+bool IndexWriter::finish() {
+  if (!ok_) return false;
+  flush_block();
+
+  const std::uint64_t dict_offset = offset_;
+  const std::uint64_t n = dict_.size();
+  write(&n, sizeof(n));
+  std::uint64_t pos = 0;
+  write(&pos, sizeof(pos));
+  for (std::uint32_t i = 0; i < n; ++i) {
+    pos += dict_.name(i).size();
+    write(&pos, sizeof(pos));
+  }
+  for (std::uint32_t i = 0; i < n; ++i) write(dict_.name(i).data(), dict_.name(i).size());
+  pad();
+
+  const std::uint64_t dir_offset = offset_;
+  write(dir_.data(), dir_.size());
+
+  char header[kHeaderSize] = {};
+  std::memcpy(header, kMagic, sizeof(kMagic));
+  put_at<std::uint16_t>(header, 6, kIndexVersion);
+  put_at<std::uint64_t>(header, 8, total_lines_);
+  put_at<std::uint64_t>(header, 16, invalid_lines_);
+  put_at<std::uint64_t>(header, 24, rows_);
+  put_at<std::uint32_t>(header, 32, block_rows_);
+  put_at<std::uint32_t>(header, 36, static_cast<std::uint32_t>(blocks()));
+  put_at<std::uint64_t>(header, 40, dict_offset);
+  put_at<std::uint64_t>(header, 48, dir_offset);
+  put_at<std::uint64_t>(header, 56, offset_);
+  ofs_.seekp(0);
+  ofs_.write(header, sizeof(header));
+  ofs_.close();
+  ok_ = false; // finish() só uma vez
+  if (!ofs_) return false;
+
+  std::error_code ec;
+  std::filesystem::rename(tmp_path_, path_, ec);
+  return !ec;
+}
+
+bool build_index(const std::vector<std::string>& paths, const IngestOptions& opt, const std::string& index_path,
+                 IndexBuildStats* stats, std::string& err) {
+  IndexWriter writer(index_path);
+  if (!writer.ok()) {
+    err = "não foi possível criar: " + index_path;
+    return false;
+  }
+  const NginxParser nginx(opt.isa, false); // o índice não guarda os campos do cliente
+  const Parser& parser = opt.parser ? *opt.parser : nginx;
+  std::uint64_t total = 0;
+  for (const auto& path : paths) {
+    auto src = open_line_source(path, opt.reader, {}, opt.direct_io);
+    if (!src || !src->ok()) {
+      err = "não foi possível abrir: " + path;
+      return false;
+    }
+    std::string_view line;
+    while (src->next_line(line)) {
+      total++;
+      if (auto e = parser.parse_line(line)) {
+        writer.add_valid(*e);
+      } else {
+        writer.add_invalid();
+      }
+    }
+    if (!src->ok()) {
+      err = "dados inválidos ou truncados: " + path;
+      return false;
+    }
+  }
+  const auto rows = writer.rows();
+  if (!writer.finish()) {
+    err = "falhou ao escrever: " + index_path;
+    return false;
+  }
+  if (stats) {
+    stats->total_lines = total;
+    stats->rows = rows;
+    stats->blocks = writer.blocks();
+    stats->endpoints = writer.endpoints();
+    stats->bytes = std::filesystem::file_size(index_path);
+  }
+  return true;
+}
+
+// ---------------------------------------------------------------- leitura
+
+ColumnIndex::~ColumnIndex() { close(); }
+
+void ColumnIndex::close() {
+  if (data_) ::munmap(const_cast<char*>(data_), size_);
+  data_ = nullptr;
+  size_ = 0;
+  blocks_.clear();
+}
+
+bool ColumnIndex::open(const std::string& path, std::string& err) {
+  close();
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    err = "não foi possível abrir: " + path;
+    return false;
+  }
+  struct stat st {};
+  if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < kHeaderSize) {
+    ::close(fd);
+    err = "índice truncado: " + path;
+    return false;
+  }
+  const auto size = static_cast<std::size_t>(st.st_size);
+  void* p = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (p == MAP_FAILED) {
+    err = "falha no mmap: " + path;
+    return false;
+  }
+  data_ = static_cast<const char*>(p);
+  size_ = size;
+
+  auto fail = [&](const std::string& what) {
+    err = what + ": " + path;
+    close();
+    return false;
+  };
+  if (std::memcmp(data_, kMagic, sizeof(kMagic)) != 0) return fail("não é um índice do LogForge");
+  if (get_at<std::uint16_t>(data_, 6) < kIndexVersion) {
+    return fail("índice de versão antiga (" + std::to_string(get_at<std::uint16_t>(data_, 6)) +
+                ", minutos no horário local); refaça com logforge index");
+  }
+  if (get_at<std::uint16_t>(data_, 6) != kIndexVersion) {
+    return fail("versão de índice não suportada (" + std::to_string(get_at<std::uint16_t>(data_, 6)) + ")");
+  }
+  if (get_at<std::uint64_t>(data_, 56) != size) return fail("índice truncado");
+
+  total_lines_ = get_at<std::uint64_t>(data_, 8);
+  invalid_lines_ = get_at<std::uint64_t>(data_, 16);
+  rows_ = get_at<std::uint64_t>(data_, 24);
+  const auto block_rows = get_at<std::uint32_t>(data_, 32);
+  const auto nblocks = get_at<std::uint32_t>(data_, 36);
+  const auto dict_offset = get_at<std::uint64_t>(data_, 40);
+  const auto dir_offset = get_at<std::uint64_t>(data_, 48);
+  if (dict_offset < kHeaderSize || dict_offset > dir_offset || dict_offset % 8 != 0 ||
+      dir_offset + std::uint64_t{nblocks} * kDirEntrySize != size || rows_ + invalid_lines_ != total_lines_)
+    return fail("índice corrompido");
+
+  // Dicionário: offsets crescentes dentro da seção.
+  dict_size_ = get_at<std::uint64_t>(data_, dict_offset);
+  const std::uint64_t dict_room = dir_offset - dict_offset - 8;
+  if (dict_size_ >= dict_room / 8) return fail("índice corrompido");
+  dict_offsets_ = data_ + dict_offset + 8;
+  dict_bytes_ = dict_offsets_ + (dict_size_ + 1) * 8;
+  const std::uint64_t bytes_room = dict_room - (dict_size_ + 1) * 8;
+  std::uint64_t prev = 0;
+  for (std::uint64_t i = 0; i <= dict_size_; ++i) {
+    const auto off = get_at<std::uint64_t>(dict_offsets_, i * 8);
+    if (off < prev || off > bytes_room || (i == 0 && off != 0)) return fail("índice corrompido");
+    prev = off;
+  }
+
+  // Diretório: cada bloco precisa caber antes do dicionário.
+  blocks_.resize(nblocks);
+  std::uint64_t rows = 0;
+  for (std::uint32_t i = 0; i < nblocks; ++i) {
+    const char* e = data_ + dir_offset + std::uint64_t{i} * kDirEntrySize;
+    Block& b = blocks_[i];
+    b.offset = get_at<std::uint64_t>(e, 0);
+    b.rows = get_at<std::uint32_t>(e, 8);
+    b.status_width = static_cast<std::uint8_t>(e[12]);
+    b.latency_width = static_cast<std::uint8_t>(e[13]);
+    b.status_classes = static_cast<std::uint8_t>(e[14]);
+    b.minute_bytes = get_at<std::uint32_t>(e, 16);
+    b.min_minute = get_at<std::int64_t>(e, 24);
+    b.max_minute = get_at<std::int64_t>(e, 32);
+    b.min_status = get_at<std::int32_t>(e, 40);
+    b.max_status = get_at<std::int32_t>(e, 44);
+    const std::uint64_t n = b.rows;
+    const std::uint64_t bytes = align8(n * 4) + align8(n * b.status_width) + align8(n * b.latency_width) +
+                                align8(b.minute_bytes);
+    if (n == 0 || n > block_rows || (b.status_width != 2 && b.status_width != 4) ||
+        (b.latency_width != 4 && b.latency_width != 8) || b.offset < kHeaderSize || b.offset % 8 != 0 ||
+        b.offset > dict_offset || bytes > dict_offset - b.offset)
+      return fail("índice corrompido");
+    rows += n;
+  }
+  if (rows != rows_) return fail("índice corrompido");
+  return true;
+}
+
+std::string_view ColumnIndex::endpoint(std::uint32_t id) const {
+  if (id >= dict_size_) return {};
+  const auto b = get_at<std::uint64_t>(dict_offsets_, std::size_t{id} * 8);
+  const auto e = get_at<std::uint64_t>(dict_offsets_, (std::size_t{id} + 1) * 8);
+  return std::string_view(dict_bytes_ + b, e - b);
+}
+
+// ---------------------------------------------------------------- consulta
+
+// Estado de um worker da consulta.
+struct ScanWorker {
+  Aggregator& agg;
+  std::vector<std::uint64_t> endpoint_counts; // por id do dicionário (+1: ids inválidos)
+  std::vector<std::uint64_t> status_counts;   // blocos com status u16
+  std::vector<std::int64_t> minutes;          // coluna de minutos decodificada
+  std::vector<std::uint32_t> sel;             // vetor de seleção do filtro
+  IndexScanStats stats;
+};
+
+static void decode_minutes(const char* p, const ColumnIndex::Block& b, std::vector<std::int64_t>& out) {
+  std::string_view in(p, b.minute_bytes);
+  auto cur = static_cast<std::uint64_t>(b.min_minute);
+  for (std::uint32_t i = 0; i < b.rows; ++i) {
+    std::uint64_t d = 0;
+    if (!get_varint(in, d)) {
+      std::fill(out.begin() + i, out.begin() + b.rows, kNoMinute);
+      return;
+    }
+    cur += static_cast<std::uint64_t>(unzigzag(d));
+    out[i] = static_cast<std::int64_t>(cur);
+  }
+}
+
+template <typename S, typename L>
+static void scan_block(const ColumnIndex& index, const ColumnIndex::Block& b, const IndexQuery& q, bool all,
+                       const std::vector<std::string_view>& names, ScanWorker& w) {
+  const std::uint32_t n = b.rows;
+  const char* p = index.data() + b.offset;
+  const auto* ids = reinterpret_cast<const std::uint32_t*>(p);
+  p += align8(std::uint64_t{n} * 4);
+  const auto* status = reinterpret_cast<const S*>(p);
+  p += align8(std::uint64_t{n} * sizeof(S));
+  const auto* latency = reinterpret_cast<const L*>(p);
+  p += align8(std::uint64_t{n} * sizeof(L));
+  const std::int64_t* minutes = w.minutes.data();
+  decode_minutes(p, b, w.minutes);
+
+  // Filtro: vetor de seleção sem desvios (o índice entra sempre, o contador só avança se passou).
+  std::uint32_t matched = n;
+  if (q.where) {
+    // --where: expressão arbitrária, uma avaliação por linha (endpoint antes do --normalize).
+    std::uint32_t* sel = w.sel.data();
+    matched = 0;
+    for (std::uint32_t i = 0; i < n; ++i) {
+      LogEntry e;
+      e.minute = minutes[i];
+      e.status = status[i];
+      e.endpoint = index.endpoint(ids[i]);
+      e.latency_us = static_cast<std::int64_t>(latency[i]) - 1;
+      if (e.minute >= q.from_minute && e.minute < q.to_minute && e.status >= q.status_min &&
+          e.status <= q.status_max && q.where->matches(e))
+        sel[matched++] = i;
+    }
+  } else if (!all) {
+    std::uint32_t* sel = w.sel.data();
+    matched = 0;
+    for (std::uint32_t i = 0; i < n; ++i) {
+      const std::int64_t m = minutes[i];
+      const int s = status[i];
+      sel[matched] = i;
+      matched += static_cast<std::uint32_t>((m >= q.from_minute) & (m < q.to_minute) & (s >= q.status_min) &
+                                            (s <= q.status_max));
+    }
+  }
+  w.stats.rows_scanned += n;
+  w.stats.rows_matched += matched;
+  if (matched == 0) return;
+
+  const std::uint32_t bad_id = static_cast<std::uint32_t>(names.size() - 1);
+  auto for_each_row = [&](auto&& f) {
+    if (all) {
+      for (std::uint32_t i = 0; i < n; ++i) f(i);
+    } else {
+      for (std::uint32_t k = 0; k < matched; ++k) f(w.sel[k]);
+    }
+  };
+
+  if (w.agg.needs_rows()) {
+    for_each_row([&](std::uint32_t i) {
+      LogEntry e;
+      e.endpoint = names[std::min(ids[i], bad_id)];
+      e.status = status[i];
+      e.latency_us = static_cast<std::int64_t>(latency[i]) - 1;
+      e.minute = minutes[i];
+      w.agg.add_valid(e);
+    });
+    return;
+  }
+
+  // Por coluna: contagens densas, latência direto no sketch, minutos em sequências iguais.
+  w.agg.add_rows(matched);
+  std::uint64_t* ep = w.endpoint_counts.data();
+  std::int64_t run_minute = kNoMinute;
+  std::uint64_t run = 0;
+  for_each_row([&](std::uint32_t i) {
+    ep[std::min(ids[i], bad_id)]++;
+    if constexpr (sizeof(S) == 2) {
+      w.status_counts[status[i]]++;
+    } else {
+      w.agg.add_status(status[i], 1);
+    }
+    if (latency[i]) w.agg.add_latency(static_cast<std::uint64_t>(latency[i]) - 1);
+    if (minutes[i] != run_minute) {
+      w.agg.add_minute(run_minute, run);
+      run_minute = minutes[i];
+      run = 0;
+    }
+    run++;
+  });
+  w.agg.add_minute(run_minute, run);
+}
+
+static void scan_blocks(const ColumnIndex& index, const IndexQuery& q, const std::vector<std::string_view>& names,
+                        std::atomic<std::size_t>& next, ScanWorker& w) {
+  for (std::size_t i = next.fetch_add(1); i < index.block_count(); i = next.fetch_add(1)) {
+    const auto& b = index.block(i);
+    w.stats.blocks++;
+    // Zone map: bloco inteiro fora (pula) ou inteiro dentro (sem filtro por linha).
+    if (b.max_minute < q.from_minute || b.min_minute >= q.to_minute || b.max_status < q.status_min ||
+        b.min_status > q.status_max) {
+      w.stats.blocks_skipped++;
+      continue;
+    }
+    // Filtro dentro de uma classe só (ex.: 500-599) e o bloco não tem essa classe.
+    const int cls = q.status_min / 100;
+    if (cls >= 1 && cls <= 5 && q.status_max / 100 == cls && !(b.status_classes & (1u << (cls - 1)))) {
+      w.stats.blocks_skipped++;
+      continue;
+    }
+    const bool all = !q.where && b.min_minute >= q.from_minute && b.max_minute < q.to_minute && b.min_status >= q.status_min &&
+                     b.max_status <= q.status_max;
+    if (w.minutes.size() < b.rows) {
+      w.minutes.resize(b.rows);
+      w.sel.resize(b.rows);
+    }
+    if (b.status_width == 2) {
+      if (b.latency_width == 4) {
+        scan_block<std::uint16_t, std::uint32_t>(index, b, q, all, names, w);
+      } else {
+        scan_block<std::uint16_t, std::uint64_t>(index, b, q, all, names, w);
+      }
+    } else {
+      if (b.latency_width == 4) {
+        scan_block<std::int32_t, std::uint32_t>(index, b, q, all, names, w);
+      } else {
+        scan_block<std::int32_t, std::uint64_t>(index, b, q, all, names, w);
+      }
+    }
+  }
+
+  // Contagens densas -> agregador (uma chamada por endpoint/status distinto).
+  for (std::size_t id = 0; id < w.endpoint_counts.size(); ++id) {
+    if (w.endpoint_counts[id]) w.agg.add_endpoint(names[id], w.endpoint_counts[id]);
+  }
+  for (std::size_t s = 0; s < w.status_counts.size(); ++s) {
+    if (w.status_counts[s]) w.agg.add_status(static_cast<int>(s), w.status_counts[s]);
+  }
+}
+
+void query_index(const ColumnIndex& index, const IndexQuery& q, const PathNormalizer* normalizer, int threads,
+                 Aggregator& out, IndexScanStats* stats) {
+  // Dicionário (normalizado uma vez por entrada) + "" para ids fora do dicionário.
+  std::vector<std::string> normalized;
+  std::vector<std::string_view> names(index.dictionary_size() + 1);
+  if (normalizer) normalized.resize(index.dictionary_size());
+  std::string buf;
+  for (std::uint32_t id = 0; id < index.dictionary_size(); ++id) {
+    names[id] = index.endpoint(id);
+    if (normalizer) {
+      normalized[id] = std::string(normalizer->normalize(names[id], buf));
+      names[id] = normalized[id];
+    }
+  }
+
+  const int workers = std::max(1, std::min<int>(threads, static_cast<int>(index.block_count())));
+  std::vector<std::unique_ptr<Aggregator>> locals;
+  std::vector<ScanWorker> ws;
+  ws.reserve(static_cast<std::size_t>(workers));
+  for (int t = 0; t < workers; ++t) {
+    Aggregator* agg = &out;
+    if (t > 0) {
+      locals.push_back(std::make_unique<Aggregator>(out.options()));
+      agg = locals.back().get();
+    }
+    ws.push_back(ScanWorker{*agg, {}, {}, {}, {}, {}});
+    if (!out.needs_rows()) {
+      ws.back().endpoint_counts.assign(names.size(), 0);
+      ws.back().status_counts.assign(UINT16_MAX + 1, 0);
+    }
+  }
+
+  std::atomic<std::size_t> next{0};
+  std::vector<std::thread> pool;
+  for (int t = 1; t < workers; ++t) {
+    pool.emplace_back([&, t] { scan_blocks(index, q, names, next, ws[static_cast<std::size_t>(t)]); });
+  }
+  scan_blocks(index, q, names, next, ws[0]);
+  for (auto& th : pool) th.join();
+
+  for (auto& l : locals) out.merge(*l);
+
+  IndexScanStats total;
+  for (auto& w : ws) {
+    total.blocks += w.stats.blocks;
+    total.blocks_skipped += w.stats.blocks_skipped;
+    total.rows_scanned += w.stats.rows_scanned;
+    total.rows_matched += w.stats.rows_matched;
+  }
+  out.add_invalid(index.invalid_lines());
+  out.add_filtered(index.rows() - total.rows_matched);
+  if (stats) *stats = total;
+}
+
+bool index_can_group(const GroupBySpec& spec) { return !spec.needs_client_fields(); }
+
+} // namespace logforge
@@ -0,0 +1,396 @@
+#include "logforge/compressed_reader.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef LOGFORGE_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef LOGFORGE_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace logforge {
+
+using SteadyClock = std::chrono::steady_clock;
+
+static double seconds_since(SteadyClock::time_point t0) {
+  return std::chrono::duration<double>(SteadyClock::now() - t0).count();
+}
+
+Compression detect_compression(const std::string& path) {
+  // Pipes e FIFOs não são abertos: ler o magic consumiria bytes que não voltam (e fechar
+  // a ponta de leitura pode derrubar quem escreve com SIGPIPE).
+  struct stat st {};
+  if (::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) return Compression::None;
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return Compression::None;
+  unsigned char m[4] = {};
+  const ssize_t n = ::read(fd, m, sizeof(m));
+  ::close(fd);
+  if (n >= 2 && m[0] == 0x1f && m[1] == 0x8b) return Compression::Gzip;
+  if (n >= 4 && m[0] == 0x28 && m[1] == 0xb5 && m[2] == 0x2f && m[3] == 0xfd) return Compression::Zstd;
+  return Compression::None;
+}
+
+bool compression_supported(Compression c) {
+  switch (c) {
+    case Compression::None: return true;
+#ifdef LOGFORGE_HAVE_ZLIB
+    case Compression::Gzip: return true;
+#endif
+#ifdef LOGFORGE_HAVE_ZSTD
+    case Compression::Zstd: return true;
+#endif
+    default: return false;
+  }
+}
+
+const char* compression_name(Compression c) {
+  switch (c) {
+    case Compression::Gzip: return "gzip";
+    case Compression::Zstd: return "zstd";
+    case Compression::None: break;
+  }
+  return "none";
+}
+
+// Lê `fd` em [pos, end) em pedaços; base comum dos decodificadores.
+class FileInput {
+public:
+  FileInput(const std::string& path, ByteRange range) : pos_(range.begin), end_(range.end) {
+    fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ >= 0) ::posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+  }
+  ~FileInput() {
+    if (fd_ >= 0) ::close(fd_);
+  }
+  bool ok() const { return fd_ >= 0; }
+
+  // Bytes lidos (0 = fim da faixa); -1 em erro.
+  ssize_t read(void* buf, std::size_t cap) {
+    if (pos_ >= end_) return 0;
+    cap = static_cast<std::size_t>(std::min<std::uint64_t>(cap, end_ - pos_));
+    ssize_t n;
+    do n = ::pread(fd_, buf, cap, static_cast<off_t>(pos_));
+    while (n < 0 && errno == EINTR);
+    if (n > 0) pos_ += static_cast<std::uint64_t>(n);
+    return n;
+  }
+
+private:
+  int fd_ = -1;
+  std::uint64_t pos_;
+  std::uint64_t end_;
+};
+
+static constexpr std::size_t kInputChunk = 256 * 1024;
+
+#ifdef LOGFORGE_HAVE_ZLIB
+class GzipDecoder final : public Decoder {
+public:
+  explicit GzipDecoder(const std::string& path) : in_(path, {}), buf_(kInputChunk) {
+    // 15 + 32: janela máxima e detecção automática do cabeçalho gzip/zlib.
+    init_ = in_.ok() && inflateInit2(&zs_, 15 + 32) == Z_OK;
+  }
+  ~GzipDecoder() override {
+    if (init_) inflateEnd(&zs_);
+  }
+
+  bool ok() const override { return init_ && !error_; }
+
+  std::size_t read(char* out, std::size_t cap) override {
+    if (!ok() || done_) return 0;
+    zs_.next_out = reinterpret_cast<Bytef*>(out);
+    zs_.avail_out = static_cast<uInt>(cap);
+    while (zs_.avail_out > 0) {
+      if (zs_.avail_in == 0) {
+        const ssize_t n = in_.read(buf_.data(), buf_.size());
+        if (n < 0) {
+          error_ = true;
+          break;
+        }
+        if (n == 0) {
+          if (!member_done_) error_ = true; // truncado no meio de um membro
+          done_ = true;
+          break;
+        }
+        zs_.next_in = buf_.data();
+        zs_.avail_in = static_cast<uInt>(n);
+      }
+
+      const int rc = inflate(&zs_, Z_NO_FLUSH);
+      if (rc == Z_STREAM_END) {
+        // Membros concatenados (cat a.gz b.gz, gzip -a): recomeça no próximo.
+        member_done_ = true;
+        inflateReset(&zs_);
+      } else if (rc == Z_OK || rc == Z_BUF_ERROR) {
+        member_done_ = false;
+      } else {
+        // Lixo depois de um membro completo (ex.: padding de zeros) encerra a leitura.
+        if (!member_done_) error_ = true;
+        done_ = true;
+        break;
+      }
+    }
+    return cap - zs_.avail_out;
+  }
+
+private:
+  FileInput in_;
+  std::vector<unsigned char> buf_;
+  z_stream zs_{};
+  bool init_ = false;
+  std::atomic<bool> error_{false}; // escrito pela thread que descomprime, lido por ok()
+  bool done_ = false;
+  bool member_done_ = true;
+};
+#endif
+
+#ifdef LOGFORGE_HAVE_ZSTD
+class ZstdDecoder final : public Decoder {
+public:
+  ZstdDecoder(const std::string& path, ByteRange range)
+      : in_(path, range), buf_(ZSTD_DStreamInSize()), ctx_(ZSTD_createDCtx()) {}
+  ~ZstdDecoder() override { ZSTD_freeDCtx(ctx_); }
+
+  bool ok() const override { return in_.ok() && ctx_ && !error_; }
+
+  std::size_t read(char* out, std::size_t cap) override {
+    if (!ok() || done_) return 0;
+    ZSTD_outBuffer ob{out, cap, 0};
+    while (ob.pos < ob.size) {
+      if (ib_.pos == ib_.size) {
+        const ssize_t n = in_.read(buf_.data(), buf_.size());
+        if (n < 0) {
+          error_ = true;
+          break;
+        }
+        if (n == 0) {
+          if (!frame_done_) error_ = true; // truncado no meio de um frame
+          done_ = true;
+          break;
+        }
+        ib_ = ZSTD_inBuffer{buf_.data(), static_cast<std::size_t>(n), 0};
+      }
+      const std::size_t rc = ZSTD_decompressStream(ctx_, &ob, &ib_);
+      if (ZSTD_isError(rc)) {
+        error_ = true;
+        done_ = true;
+        break;
+      }
+      frame_done_ = (rc == 0);
+    }
+    return ob.pos;
+  }
+
+private:
+  FileInput in_;
+  std::vector<char> buf_;
+  ZSTD_DCtx* ctx_;
+  ZSTD_inBuffer ib_{nullptr, 0, 0};
+  std::atomic<bool> error_{false}; // escrito pela thread que descomprime, lido por ok()
+  bool done_ = false;
+  bool frame_done_ = true;
+};
+#endif
+
+std::unique_ptr<Decoder> open_decoder(const std::string& path, Compression c, ByteRange range) {
+  (void)path;
+  (void)range;
+  switch (c) {
+#ifdef LOGFORGE_HAVE_ZLIB
+    case Compression::Gzip:
+      // Não há como começar no meio de um membro gzip: só o arquivo inteiro.
+      if (range.begin != 0 || range.end != UINT64_MAX) return nullptr;
+      return std::make_unique<GzipDecoder>(path);
+#endif
+#ifdef LOGFORGE_HAVE_ZSTD
+    case Compression::Zstd: return std::make_unique<ZstdDecoder>(path, range);
+#endif
+    default: return nullptr;
+  }
+}
+
+std::vector<ByteRange> split_zstd_frames(const std::string& path, int parts) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return {};
+  struct stat st {};
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    return {};
+  }
+  const auto size = static_cast<std::uint64_t>(st.st_size);
+  std::vector<ByteRange> ranges;
+
+#ifdef LOGFORGE_HAVE_ZSTD
+  if (parts > 1 && size > 0) {
+    void* p = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p != MAP_FAILED) {
+      // Só os cabeçalhos/tamanhos de bloco são lidos; o conteúdo não é descomprimido.
+      const auto* data = static_cast<const char*>(p);
+      std::vector<std::uint64_t> frame_ends;
+      std::uint64_t pos = 0;
+      while (pos < size) {
+        const std::size_t n = ZSTD_findFrameCompressedSize(data + pos, size - pos);
+        if (ZSTD_isError(n) || n == 0) break;
+        pos += n;
+        frame_ends.push_back(pos);
+      }
+      ::munmap(p, size);
+
+      if (pos == size && frame_ends.size() > 1) {
+        std::uint64_t begin = 0;
+        std::size_t f = 0;
+        for (int i = 1; i <= parts && f < frame_ends.size(); ++i) {
+          const std::uint64_t nominal = size / static_cast<std::uint64_t>(parts) * static_cast<std::uint64_t>(i);
+          while (f + 1 < frame_ends.size() && (frame_ends[f] < nominal || i == parts)) ++f;
+          ranges.push_back({begin, frame_ends[f]});
+          begin = frame_ends[f++];
+        }
+      }
+    }
+  }
+#else
+  (void)parts;
+#endif
+
+  ::close(fd);
+  if (ranges.empty()) ranges.push_back({0, size});
+  return ranges;
+}
+
+CompressedLineReader::CompressedLineReader(std::unique_ptr<Decoder> decoder, bool capture_edges,
+                                           std::size_t block_size, std::size_t blocks)
+    : decoder_(std::move(decoder)), capture_edges_(capture_edges), ring_(std::max<std::size_t>(blocks, 2)) {
+  if (!decoder_ || !decoder_->ok()) {
+    done_ = true;
+    return;
+  }
+  for (auto& b : ring_) b.data.resize(std::max<std::size_t>(block_size, 1));
+  producer_ = std::thread([this] { produce(); });
+}
+
+CompressedLineReader::~CompressedLineReader() {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  if (producer_.joinable()) producer_.join();
+}
+
+bool CompressedLineReader::ok() const { return decoder_ && decoder_->ok(); }
+
+void CompressedLineReader::produce() {
+  const auto n = static_cast<std::uint64_t>(ring_.size());
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lk(mu_);
+      cv_.wait(lk, [&] { return stop_ || produced_ - consumed_ < n; });
+      if (stop_) break;
+    }
+
+    // O slot produced_ % n não está com o consumidor (anel não cheio): escreve sem lock.
+    Block& b = ring_[produced_ % n];
+    const auto t0 = SteadyClock::now();
+    b.size = 0;
+    while (b.size < b.data.size()) {
+      const std::size_t got = decoder_->read(b.data.data() + b.size, b.data.size() - b.size);
+      if (got == 0) break;
+      b.size += got;
+    }
+    decompress_sec_ += seconds_since(t0);
+    decompressed_bytes_ += b.size;
+
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      if (b.size == 0) finished_ = true;
+      else ++produced_;
+    }
+    cv_.notify_all();
+    if (b.size == 0) break;
+  }
+}
+
+bool CompressedLineReader::emit(std::string_view piece, std::string_view& out) {
+  if (capture_edges_ && !saw_newline_) {
+    saw_newline_ = true;
+    head_.assign(piece);
+    return false;
+  }
+  saw_newline_ = true;
+  out = piece;
+  return true;
+}
+
+bool CompressedLineReader::next_line(std::string_view& out) {
+  const auto n = static_cast<std::uint64_t>(ring_.size());
+  while (!done_) {
+    if (cur_) {
+      const char* begin = cur_->data.data();
+      while (pos_ < cur_->size) {
+        const char* p = begin + pos_;
+        const auto* nl = static_cast<const char*>(std::memchr(p, '\n', cur_->size - pos_));
+        if (!nl) {
+          carry_.append(p, begin + cur_->size);
+          pos_ = cur_->size;
+          break;
+        }
+        pos_ = static_cast<std::size_t>(nl - begin) + 1;
+        std::string_view piece(p, static_cast<std::size_t>(nl - p));
+        if (!carry_.empty()) {
+          carry_.append(piece);
+          line_.swap(carry_);
+          carry_.clear();
+          piece = line_;
+        }
+        if (emit(piece, out)) return true;
+      }
+
+      // Bloco esgotado: devolve o slot ao produtor.
+      {
+        std::lock_guard<std::mutex> lk(mu_);
+        ++consumed_;
+      }
+      cv_.notify_all();
+      cur_ = nullptr;
+    }
+
+    const auto t0 = SteadyClock::now();
+    {
+      std::unique_lock<std::mutex> lk(mu_);
+      cv_.wait(lk, [&] { return produced_ > consumed_ || finished_; });
+      if (produced_ > consumed_) {
+        cur_ = &ring_[consumed_ % n];
+        pos_ = 0;
+      }
+    }
+    wait_sec_ += seconds_since(t0);
+
+    if (!cur_) {
+      // Fim: o que sobrou sem '\n' é a última linha (ou o tail, na costura).
+      done_ = true;
+      if (carry_.empty()) return false;
+      if (capture_edges_) {
+        tail_.swap(carry_);
+        carry_.clear();
+        return false;
+      }
+      line_.swap(carry_);
+      carry_.clear();
+      out = line_;
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace logforge
@@ -0,0 +1,154 @@
+#include "logforge/file_tailer.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+namespace logforge {
+
+FileTailer::FileTailer(std::string path, std::size_t chunk_size)
+    : path_(std::move(path)), buf_(chunk_size > 0 ? chunk_size : 1) {
+  const auto slash = path_.rfind('/');
+  name_ = (slash == std::string::npos) ? path_ : path_.substr(slash + 1);
+
+#ifdef __linux__
+  // Observa o diretório (e não o arquivo): assim rename/create da rotação também acordam.
+  inotify_fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (inotify_fd_ >= 0) {
+    const std::string dir = (slash == std::string::npos) ? "." : (slash == 0 ? "/" : path_.substr(0, slash));
+    const auto mask = IN_MODIFY | IN_CREATE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_CLOSE_WRITE;
+    if (::inotify_add_watch(inotify_fd_, dir.c_str(), mask) < 0) {
+      ::close(inotify_fd_);
+      inotify_fd_ = -1;
+    }
+  }
+#endif
+
+  open_current();
+}
+
+FileTailer::~FileTailer() {
+  if (fd_ >= 0) ::close(fd_);
+  if (inotify_fd_ >= 0) ::close(inotify_fd_);
+}
+
+bool FileTailer::open_current() {
+  int fd = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return false;
+
+  struct stat st {};
+  if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    ::close(fd);
+    return false;
+  }
+  fd_ = fd;
+  dev_ = static_cast<std::uint64_t>(st.st_dev);
+  ino_ = static_cast<std::uint64_t>(st.st_ino);
+  offset_ = 0;
+  return true;
+}
+
+std::uint64_t FileTailer::drain(const std::function<void(std::string_view)>& on_line) {
+  std::uint64_t total = 0;
+  for (;;) {
+    const ssize_t n = ::read(fd_, buf_.data(), buf_.size());
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+
+    offset_ += static_cast<std::uint64_t>(n);
+    total += static_cast<std::uint64_t>(n);
+
+    const char* p = buf_.data();
+    const char* end = p + n;
+    while (p < end) {
+      const auto* nl = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+      if (!nl) {
+        partial_.append(p, end);
+        break;
+      }
+      if (partial_.empty()) {
+        on_line(std::string_view(p, static_cast<std::size_t>(nl - p)));
+      } else {
+        partial_.append(p, nl);
+        on_line(partial_);
+        partial_.clear();
+      }
+      p = nl + 1;
+    }
+  }
+  return total;
+}
+
+std::uint64_t FileTailer::poll(const std::function<void(std::string_view)>& on_line) {
+  if (fd_ < 0 && !open_current()) return 0;
+
+  std::uint64_t total = 0;
+  for (;;) {
+    // copytruncate: o arquivo encolheu abaixo do que já foi lido.
+    struct stat st {};
+    if (::fstat(fd_, &st) == 0 && static_cast<std::uint64_t>(st.st_size) < offset_) {
+      ::lseek(fd_, 0, SEEK_SET);
+      offset_ = 0;
+      partial_.clear();
+      ++truncations_;
+    }
+
+    total += drain(on_line);
+
+    // rename + create: o path agora aponta para outro inode.
+    struct stat cur {};
+    if (::stat(path_.c_str(), &cur) != 0) break; // ainda não recriado: segue no antigo
+    if (static_cast<std::uint64_t>(cur.st_dev) == dev_ && static_cast<std::uint64_t>(cur.st_ino) == ino_) break;
+
+    // O antigo pode ter recebido escrita entre o drain e o stat; o que sobrar é final.
+    total += drain(on_line);
+    if (!partial_.empty()) {
+      on_line(partial_);
+      partial_.clear();
+    }
+    ::close(fd_);
+    fd_ = -1;
+    ++rotations_;
+    if (!open_current()) break;
+  }
+  return total;
+}
+
+bool FileTailer::wait(int timeout_ms) {
+  if (timeout_ms < 0) timeout_ms = 0;
+#ifdef __linux__
+  if (inotify_fd_ >= 0) {
+    struct pollfd pfd {};
+    pfd.fd = inotify_fd_;
+    pfd.events = POLLIN;
+    if (::poll(&pfd, 1, timeout_ms) <= 0) return false;
+
+    // Drena os eventos; só interessam os do nosso arquivo.
+    alignas(struct inotify_event) char events[4096];
+    bool relevant = false;
+    for (;;) {
+      const ssize_t n = ::read(inotify_fd_, events, sizeof(events));
+      if (n <= 0) break;
+      for (ssize_t i = 0; i < n;) {
+        const auto* ev = reinterpret_cast<const struct inotify_event*>(events + i);
+        if (ev->len > 0 && name_ == ev->name) relevant = true;
+        i += static_cast<ssize_t>(sizeof(struct inotify_event) + ev->len);
+      }
+    }
+    return relevant;
+  }
+#endif
+  std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+  return true;
+}
+
+} // namespace logforge
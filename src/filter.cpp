@@ -0,0 +1,414 @@
+#include "logforge/filter.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <limits>
+
+#include "logforge/time_util.hpp"
+
+namespace logforge {
+
+bool glob_match(std::string_view p, std::string_view s) {
+  // Backtracking só no último '*' visto: linear na prática.
+  std::size_t pi = 0, si = 0;
+  std::size_t star = std::string_view::npos, mark = 0;
+  while (si < s.size()) {
+    if (pi < p.size() && (p[pi] == '?' || p[pi] == s[si])) {
+      ++pi;
+      ++si;
+    } else if (pi < p.size() && p[pi] == '*') {
+      star = pi++;
+      mark = si;
+    } else if (star != std::string_view::npos) {
+      pi = star + 1;
+      si = ++mark;
+    } else {
+      return false;
+    }
+  }
+  while (pi < p.size() && p[pi] == '*') ++pi;
+  return pi == p.size();
+}
+
+bool Filter::test(const Instr& in, const LogEntry& e) const {
+  switch (in.op) {
+    case Op::StatusIn:
+      return e.status >= in.a && e.status <= in.b;
+    case Op::LatencyIn:
+      return e.latency_us >= in.a && e.latency_us <= in.b;
+    case Op::MinuteIn:
+      return e.minute != kNoMinute && e.minute >= in.a && e.minute <= in.b;
+    case Op::DayMinuteIn: {
+      if (e.minute == kNoMinute) return false;
+      std::int64_t d = e.minute % 1440;
+      if (d < 0) d += 1440;
+      return d >= in.a && d <= in.b;
+    }
+    case Op::EndpointEq:
+      return e.endpoint == strings_[in.str];
+    case Op::EndpointPrefix:
+      return e.endpoint.starts_with(strings_[in.str]);
+    case Op::EndpointGlob:
+      return glob_match(strings_[in.str], e.endpoint);
+  }
+  return false;
+}
+
+// Descida recursiva -> árvore -> programa de desvios.
+class FilterCompiler {
+public:
+  FilterCompiler(std::string_view text, Filter& f) : text_(text), f_(f) {}
+
+  bool run(std::string& err) {
+    next();
+    Node root;
+    if (!parse_or(root)) {
+      err = err_;
+      return false;
+    }
+    if (tok_.kind != Tok::End) {
+      err = error_at("sobra texto: '" + std::string(tok_.text) + "'");
+      return false;
+    }
+
+    // Termos do and de topo, agrupados pelo estágio do último campo que leem.
+    std::vector<const Node*> terms;
+    flatten_and(root, terms);
+    for (int s = kFilterStages - 1; s >= 0; --s) {
+      std::int32_t next_pc = Filter::kAccept;
+      for (auto it = terms.rbegin(); it != terms.rend(); ++it) {
+        if ((*it)->stage == s) next_pc = emit(**it, next_pc, Filter::kReject);
+      }
+      f_.entry_[s] = next_pc;
+    }
+    return true;
+  }
+
+private:
+  enum class Tok { End, Word, Quoted, LParen, RParen, And, Or, Not, Cmp };
+  enum class Cmp { Eq, Ne, Lt, Le, Gt, Ge };
+
+  struct Token {
+    Tok kind = Tok::End;
+    std::string_view text;
+    Cmp cmp = Cmp::Eq;
+    std::size_t pos = 0;
+  };
+
+  struct Node {
+    enum class Kind { Pred, And, Or, Not } kind = Kind::Pred;
+    Filter::Instr pred;
+    std::vector<Node> kids;
+    int stage = 0;
+  };
+
+  std::string_view text_;
+  Filter& f_;
+  std::size_t pos_ = 0;
+  Token tok_;
+  std::string err_;
+
+  std::string error_at(const std::string& msg) const {
+    return msg + " (posição " + std::to_string(tok_.pos + 1) + ")";
+  }
+  bool fail(const std::string& msg) {
+    err_ = error_at(msg);
+    return false;
+  }
+
+  static bool is_word_char(char c) {
+    return !std::isspace(static_cast<unsigned char>(c)) && c != '(' && c != ')' && c != '"' && c != '=' &&
+           c != '!' && c != '<' && c != '>' && c != '&' && c != '|';
+  }
+
+  void next() {
+    while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) ++pos_;
+    tok_ = Token{};
+    tok_.pos = pos_;
+    if (pos_ >= text_.size()) return;
+
+    const std::string_view rest = text_.substr(pos_);
+    auto take = [&](Tok kind, std::size_t n, Cmp cmp = Cmp::Eq) {
+      tok_.kind = kind;
+      tok_.cmp = cmp;
+      tok_.text = rest.substr(0, n);
+      pos_ += n;
+    };
+    if (rest.starts_with("&&")) return take(Tok::And, 2);
+    if (rest.starts_with("||")) return take(Tok::Or, 2);
+    if (rest.starts_with("==")) return take(Tok::Cmp, 2, Cmp::Eq);
+    if (rest.starts_with("!=")) return take(Tok::Cmp, 2, Cmp::Ne);
+    if (rest.starts_with("<=")) return take(Tok::Cmp, 2, Cmp::Le);
+    if (rest.starts_with(">=")) return take(Tok::Cmp, 2, Cmp::Ge);
+    switch (rest[0]) {
+      case '=': return take(Tok::Cmp, 1, Cmp::Eq);
+      case '<': return take(Tok::Cmp, 1, Cmp::Lt);
+      case '>': return take(Tok::Cmp, 1, Cmp::Gt);
+      case '!': return take(Tok::Not, 1);
+      case '(': return take(Tok::LParen, 1);
+      case ')': return take(Tok::RParen, 1);
+      default: break;
+    }
+    if (rest[0] == '"') {
+      const auto close = rest.find('"', 1);
+      if (close == std::string_view::npos) {
+        tok_.kind = Tok::Word; // erro aparece no parse do valor
+        tok_.text = rest;
+        pos_ = text_.size();
+        return;
+      }
+      tok_.kind = Tok::Quoted;
+      tok_.text = rest.substr(1, close - 1);
+      pos_ += close + 1;
+      return;
+    }
+    std::size_t n = 0;
+    while (n < rest.size() && is_word_char(rest[n])) ++n;
+    if (n == 0) n = 1; // '&' ou '|' soltos
+    take(Tok::Word, n);
+    if (tok_.text == "and") tok_.kind = Tok::And;
+    if (tok_.text == "or") tok_.kind = Tok::Or;
+    if (tok_.text == "not") tok_.kind = Tok::Not;
+  }
+
+  bool parse_or(Node& out) {
+    if (!parse_and(out)) return false;
+    while (tok_.kind == Tok::Or) {
+      next();
+      Node rhs;
+      if (!parse_and(rhs)) return false;
+      join(Node::Kind::Or, out, std::move(rhs));
+    }
+    return true;
+  }
+
+  bool parse_and(Node& out) {
+    if (!parse_unary(out)) return false;
+    while (tok_.kind == Tok::And) {
+      next();
+      Node rhs;
+      if (!parse_unary(rhs)) return false;
+      join(Node::Kind::And, out, std::move(rhs));
+    }
+    return true;
+  }
+
+  static void join(Node::Kind kind, Node& lhs, Node&& rhs) {
+    if (lhs.kind != kind) {
+      Node n;
+      n.kind = kind;
+      n.stage = lhs.stage;
+      n.kids.push_back(std::move(lhs));
+      lhs = std::move(n);
+    }
+    lhs.stage = std::max(lhs.stage, rhs.stage);
+    lhs.kids.push_back(std::move(rhs));
+  }
+
+  bool parse_unary(Node& out) {
+    if (tok_.kind == Tok::Not) {
+      next();
+      Node kid;
+      if (!parse_unary(kid)) return false;
+      out = Node{};
+      out.kind = Node::Kind::Not;
+      out.stage = kid.stage;
+      out.kids.push_back(std::move(kid));
+      return true;
+    }
+    if (tok_.kind == Tok::LParen) {
+      next();
+      if (!parse_or(out)) return false;
+      if (tok_.kind != Tok::RParen) return fail("esperado ')'");
+      next();
+      return true;
+    }
+    return parse_comparison(out);
+  }
+
+  bool parse_comparison(Node& out) {
+    if (tok_.kind != Tok::Word) return fail("esperado um campo (status, endpoint, latency, time)");
+    const std::string_view field = tok_.text;
+    next();
+    if (tok_.kind != Tok::Cmp) return fail("esperado um operador de comparação depois de '" + std::string(field) + "'");
+    const Cmp cmp = tok_.cmp;
+    next();
+    if (tok_.kind != Tok::Word && tok_.kind != Tok::Quoted) return fail("esperado um valor");
+    const std::string_view value = tok_.text;
+
+    out = Node{};
+    Filter::Instr& in = out.pred;
+    std::int64_t lo = 0, hi = 0;
+    if (field == "status") {
+      if (!status_value(value, lo, hi)) return fail("status espera 404, 5xx ou 500-599");
+      in.op = Filter::Op::StatusIn;
+      out.stage = static_cast<int>(FilterStage::Status);
+    } else if (field == "latency") {
+      if (!latency_value(value, lo)) return fail("latency espera um número com unidade us, ms ou s");
+      hi = lo;
+      in.op = Filter::Op::LatencyIn;
+      out.stage = static_cast<int>(FilterStage::Latency);
+    } else if (field == "time") {
+      if (value.size() == 5) {
+        if (!day_minute_value(value, lo)) return fail("time espera HH:MM ou \"AAAA-MM-DD HH:MM\"");
+        hi = lo;
+        in.op = Filter::Op::DayMinuteIn;
+      } else {
+        const auto m = parse_minute_text(value);
+        if (!m) return fail("time espera HH:MM ou \"AAAA-MM-DD HH:MM\"");
+        lo = *m;
+        hi = (value.size() == 10) ? lo + 1439 : lo; // só a data: o dia inteiro
+        in.op = Filter::Op::MinuteIn;
+      }
+      out.stage = static_cast<int>(FilterStage::Time);
+    } else if (field == "endpoint" || field == "path") {
+      if (cmp != Cmp::Eq && cmp != Cmp::Ne) return fail("endpoint só aceita = e !=");
+      endpoint_pattern(value, in);
+      out.stage = static_cast<int>(FilterStage::Endpoint);
+      next();
+      return negate_if(cmp == Cmp::Ne, out);
+    } else {
+      return fail("campo desconhecido: '" + std::string(field) + "'");
+    }
+    next();
+
+    // Comparação -> faixa inclusiva [a, b] sobre a faixa do valor [lo, hi].
+    constexpr auto kMin = std::numeric_limits<std::int64_t>::min();
+    constexpr auto kMax = std::numeric_limits<std::int64_t>::max();
+    switch (cmp) {
+      case Cmp::Eq: case Cmp::Ne: in.a = lo; in.b = hi; break;
+      case Cmp::Lt: in.a = kMin; in.b = lo - 1; break;
+      case Cmp::Le: in.a = kMin; in.b = hi; break;
+      case Cmp::Gt: in.a = hi + 1; in.b = kMax; break;
+      case Cmp::Ge: in.a = lo; in.b = kMax; break;
+    }
+    if (in.op == Filter::Op::LatencyIn) in.a = std::max<std::int64_t>(in.a, 0);
+    if (in.op == Filter::Op::DayMinuteIn) {
+      in.a = std::max<std::int64_t>(in.a, 0);
+      in.b = std::min<std::int64_t>(in.b, 1439);
+    }
+    return negate_if(cmp == Cmp::Ne, out);
+  }
+
+  static bool negate_if(bool neg, Node& n) {
+    if (!neg) return true;
+    Node inner = std::move(n);
+    n = Node{};
+    n.kind = Node::Kind::Not;
+    n.stage = inner.stage;
+    n.kids.push_back(std::move(inner));
+    return true;
+  }
+
+  static bool int_value(std::string_view s, std::int64_t& v) {
+    auto res = std::from_chars(s.data(), s.data() + s.size(), v);
+    // Limite folgado só para as faixas (lo - 1, hi + 1) nunca estourarem.
+    return !s.empty() && res.ec == std::errc() && res.ptr == s.data() + s.size() && v > -(1ll << 50) &&
+           v < (1ll << 50);
+  }
+
+  static bool status_value(std::string_view s, std::int64_t& lo, std::int64_t& hi) {
+    if (s.size() == 3 && s[1] == 'x' && s[2] == 'x' && s[0] >= '1' && s[0] <= '9') {
+      lo = (s[0] - '0') * 100;
+      hi = lo + 99;
+      return true;
+    }
+    const auto dash = s.find('-', 1);
+    if (dash == std::string_view::npos) {
+      if (!int_value(s, lo)) return false;
+      hi = lo;
+      return true;
+    }
+    return int_value(s.substr(0, dash), lo) && int_value(s.substr(dash + 1), hi) && lo <= hi;
+  }
+
+  static bool latency_value(std::string_view s, std::int64_t& us) {
+    double mult = 1000.0; // ms
+    if (s.ends_with("us")) {
+      mult = 1.0;
+      s.remove_suffix(2);
+    } else if (s.ends_with("ms")) {
+      s.remove_suffix(2);
+    } else if (s.ends_with("s")) {
+      mult = 1e6;
+      s.remove_suffix(1);
+    }
+    double v = 0.0;
+    auto res = std::from_chars(s.data(), s.data() + s.size(), v);
+    if (s.empty() || res.ec != std::errc() || res.ptr != s.data() + s.size() || !(v >= 0.0) || v > 1e12) return false;
+    us = std::llround(v * mult);
+    return true;
+  }
+
+  static bool day_minute_value(std::string_view s, std::int64_t& m) {
+    std::int64_t hh = 0, mm = 0;
+    if (s[2] != ':' || !int_value(s.substr(0, 2), hh) || !int_value(s.substr(3, 2), mm) || hh > 23 || mm > 59 ||
+        hh < 0 || mm < 0)
+      return false;
+    m = hh * 60 + mm;
+    return true;
+  }
+
+  void endpoint_pattern(std::string_view p, Filter::Instr& in) {
+    const auto wild = p.find_first_of("*?");
+    if (wild == std::string_view::npos) {
+      in.op = Filter::Op::EndpointEq;
+    } else if (wild == p.size() - 1 && p.back() == '*') {
+      in.op = Filter::Op::EndpointPrefix;
+      p.remove_suffix(1);
+    } else {
+      in.op = Filter::Op::EndpointGlob;
+    }
+    in.str = static_cast<std::uint32_t>(f_.strings_.size());
+    f_.strings_.emplace_back(p);
+  }
+
+  static void flatten_and(const Node& n, std::vector<const Node*>& out) {
+    if (n.kind == Node::Kind::And) {
+      for (const auto& k : n.kids) flatten_and(k, out);
+    } else {
+      out.push_back(&n);
+    }
+  }
+
+  // Emite `n` com os destinos dados e devolve a instrução de entrada. Os filhos são
+  // emitidos do último para o primeiro, porque cada um precisa da entrada do seguinte.
+  std::int32_t emit(const Node& n, std::int32_t on_true, std::int32_t on_false) {
+    switch (n.kind) {
+      case Node::Kind::Pred: {
+        Filter::Instr in = n.pred;
+        in.on_true = on_true;
+        in.on_false = on_false;
+        f_.code_.push_back(in);
+        return static_cast<std::int32_t>(f_.code_.size() - 1);
+      }
+      case Node::Kind::Not:
+        return emit(n.kids[0], on_false, on_true);
+      case Node::Kind::And: {
+        std::int32_t pc = on_true;
+        for (auto it = n.kids.rbegin(); it != n.kids.rend(); ++it) pc = emit(*it, pc, on_false);
+        return pc;
+      }
+      case Node::Kind::Or: {
+        std::int32_t pc = on_false;
+        for (auto it = n.kids.rbegin(); it != n.kids.rend(); ++it) pc = emit(*it, on_true, pc);
+        return pc;
+      }
+    }
+    return on_true;
+  }
+};
+
+bool Filter::compile(std::string_view expr, std::string& err) {
+  *this = Filter{};
+  FilterCompiler c(expr, *this);
+  if (!c.run(err)) {
+    *this = Filter{};
+    return false;
+  }
+  return true;
+}
+
+} // namespace logforge
@@ -0,0 +1,60 @@
+#include "logforge/follow.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#include "logforge/file_tailer.hpp"
+#include "logforge/report_writer.hpp"
+
+namespace logforge {
+
+using SteadyClock = std::chrono::steady_clock;
+
+// Intervalo máximo entre checagens de `stop` enquanto espera o arquivo.
+static constexpr int kMaxWaitMs = 250;
+
+bool follow_file(const std::string& path, const std::string& out_dir, const IngestOptions& opt,
+                 const FollowOptions& fopt, Aggregator& agg, FollowStats* stats) {
+  FileTailer tailer(path);
+  if (!tailer.ok()) return false;
+
+  LinePipeline pipeline(opt, agg);
+  const auto on_line = [&](std::string_view line) { pipeline.process(line); };
+  const auto interval = std::chrono::seconds(std::max(1, fopt.interval_sec));
+
+  FollowStats local;
+  bool ok = true;
+  auto next_report = SteadyClock::now() + interval;
+  while (!(fopt.stop && fopt.stop->load(std::memory_order_relaxed))) {
+    local.bytes += tailer.poll(on_line);
+
+    const auto now = SteadyClock::now();
+    if (now >= next_report) {
+      if (!write_report_json(agg.finalize(), out_dir, agg.top_n())) {
+        ok = false;
+        break;
+      }
+      ++local.snapshots;
+      next_report = now + interval;
+    }
+
+    const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(next_report - now).count();
+    tailer.wait(static_cast<int>(std::clamp<long long>(left, 0, kMaxWaitMs)));
+  }
+
+  // Último flush: o que chegou até aqui entra no relatório final.
+  local.bytes += tailer.poll(on_line);
+  if (ok) {
+    const auto report = agg.finalize();
+    const auto view = make_report_view(report, agg.top_n());
+    // Numa thread só, como o report.json periódico: o --follow não cria threads de escrita.
+    ok = write_reports(report, view, out_dir, 1);
+  }
+
+  local.rotations = tailer.rotations();
+  local.truncations = tailer.truncations();
+  if (stats) *stats = local;
+  return ok;
+}
+
+} // namespace logforge
@@ -0,0 +1,386 @@
+#include "logforge/group_by.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <sstream>
+
+#include "logforge/endpoint_stats.hpp"
+#include "logforge/time_util.hpp"
+#include "logforge/varint.hpp"
+
+namespace logforge {
+
+static const char* const kDimNames[kGroupDims] = {"endpoint", "status", "status_class", "method", "ip", "ua", "minute"};
+
+const char* group_dim_name(GroupDim d) { return kDimNames[static_cast<int>(d)]; }
+
+static bool is_string_dim(GroupDim d) {
+  return d == GroupDim::Endpoint || d == GroupDim::Method || d == GroupDim::Ip || d == GroupDim::UserAgent;
+}
+
+static bool parse_dim(std::string_view name, GroupDim& out) {
+  static const struct {
+    const char* name;
+    GroupDim dim;
+  } names[] = {
+      {"endpoint", GroupDim::Endpoint}, {"path", GroupDim::Endpoint},          {"status", GroupDim::Status},
+      {"status_class", GroupDim::StatusClass}, {"class", GroupDim::StatusClass}, {"method", GroupDim::Method},
+      {"ip", GroupDim::Ip},             {"client", GroupDim::Ip},              {"remote_addr", GroupDim::Ip},
+      {"ua", GroupDim::UserAgent},      {"user_agent", GroupDim::UserAgent},   {"minute", GroupDim::Minute},
+  };
+  for (const auto& n : names) {
+    if (name == n.name) {
+      out = n.dim;
+      return true;
+    }
+  }
+  return false;
+}
+
+static std::string_view trim_spaces(std::string_view s) {
+  while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+  while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+  return s;
+}
+
+static std::vector<std::string_view> split_commas(std::string_view s) {
+  std::vector<std::string_view> out;
+  while (true) {
+    const auto comma = s.find(',');
+    out.push_back(trim_spaces(s.substr(0, comma)));
+    if (comma == std::string_view::npos) break;
+    s.remove_prefix(comma + 1);
+  }
+  return out;
+}
+
+// "95" -> 0.95, "99.9" -> 0.999
+static bool parse_percentile(std::string_view s, double& q) {
+  double pct = 0.0;
+  const auto res = std::from_chars(s.data(), s.data() + s.size(), pct);
+  if (s.empty() || res.ec != std::errc() || res.ptr != s.data() + s.size() || !(pct > 0.0 && pct <= 100.0)) return false;
+  q = pct / 100.0;
+  return true;
+}
+
+bool parse_group_by(std::string_view dims, std::string_view aggs, GroupBySpec& out, std::string& err) {
+  GroupBySpec spec;
+  for (auto name : split_commas(dims)) {
+    GroupDim d{};
+    if (!parse_dim(name, d)) {
+      err = "dimensão desconhecida: '" + std::string(name) +
+            "' (use endpoint, status, status_class, method, ip, ua ou minute)";
+      return false;
+    }
+    if (std::find(spec.dims.begin(), spec.dims.end(), d) != spec.dims.end()) {
+      err = "dimensão repetida: " + std::string(name);
+      return false;
+    }
+    spec.dims.push_back(d);
+  }
+  if (spec.dims.size() > GroupBySpec::kMaxDims) {
+    err = "no máximo " + std::to_string(GroupBySpec::kMaxDims) + " dimensões";
+    return false;
+  }
+
+  if (trim_spaces(aggs).empty()) aggs = "count";
+  for (auto a : split_commas(aggs)) {
+    bool repeated = false;
+    if (a == "count") {
+      continue;
+    } else if (a == "sum(bytes)") {
+      repeated = spec.sum_bytes;
+      spec.sum_bytes = true;
+    } else if (a.size() > 1 && a[0] == 'p' && a.find('(') == std::string_view::npos) {
+      double q = 0.0;
+      if (!parse_percentile(a.substr(1), q)) {
+        err = "percentil inválido: '" + std::string(a) + "' (ex.: p50, p95, p99.9)";
+        return false;
+      }
+      repeated = std::find(spec.quantiles.begin(), spec.quantiles.end(), q) != spec.quantiles.end();
+      spec.quantiles.push_back(q);
+    } else if (a.rfind("distinct(", 0) == 0 && a.back() == ')') {
+      GroupDim d{};
+      const auto name = trim_spaces(a.substr(9, a.size() - 10));
+      if (!parse_dim(name, d)) {
+        err = "dimensão desconhecida em " + std::string(a);
+        return false;
+      }
+      repeated = std::find(spec.distinct.begin(), spec.distinct.end(), d) != spec.distinct.end();
+      spec.distinct.push_back(d);
+    } else {
+      err = "agregado desconhecido: '" + std::string(a) + "' (use count, sum(bytes), pNN ou distinct(<dimensão>))";
+      return false;
+    }
+    if (repeated) {
+      err = "agregado repetido: " + std::string(a);
+      return false;
+    }
+  }
+  out = std::move(spec);
+  return true;
+}
+
+std::vector<std::string> GroupBySpec::aggregate_columns() const {
+  std::vector<std::string> cols{"count"};
+  if (sum_bytes) cols.push_back("sum_bytes");
+  for (double q : quantiles) {
+    std::ostringstream ss;
+    ss << "p" << q * 100.0 << "_ms";
+    cols.push_back(ss.str());
+  }
+  for (auto d : distinct) cols.push_back(std::string("distinct_") + group_dim_name(d));
+  return cols;
+}
+
+bool GroupBySpec::needs_client_fields() const {
+  auto client = [](GroupDim d) { return d == GroupDim::Method || d == GroupDim::Ip || d == GroupDim::UserAgent; };
+  return sum_bytes || std::any_of(dims.begin(), dims.end(), client) ||
+         std::any_of(distinct.begin(), distinct.end(), client);
+}
+
+static LatencySketch group_sketch() { return LatencySketch(EndpointStats::kLatencyError, EndpointStats::kMaxBuckets); }
+
+GroupBy::GroupBy(const GroupBySpec& spec) : spec_(spec) {
+  distinct_sets_.resize(spec_.distinct.size());
+  distinct_counts_.resize(spec_.distinct.size());
+}
+
+std::uint64_t GroupBy::value_of(GroupDim d, const LogEntry& e) {
+  switch (d) {
+    case GroupDim::Endpoint: return strings_[static_cast<int>(d)].intern(e.endpoint);
+    case GroupDim::Method: return strings_[static_cast<int>(d)].intern(e.method);
+    case GroupDim::Ip: return strings_[static_cast<int>(d)].intern(e.remote_addr);
+    case GroupDim::UserAgent: return strings_[static_cast<int>(d)].intern(e.user_agent);
+    case GroupDim::Status: return zigzag(e.status);
+    case GroupDim::StatusClass: return (e.status >= 100 && e.status < 600) ? static_cast<std::uint64_t>(e.status / 100) : 0;
+    case GroupDim::Minute: return zigzag(e.minute); // kNoMinute -> UINT64_MAX
+  }
+  return 0;
+}
+
+std::string GroupBy::format_value(GroupDim d, std::uint64_t v) const {
+  switch (d) {
+    case GroupDim::Endpoint:
+    case GroupDim::Method:
+    case GroupDim::Ip:
+    case GroupDim::UserAgent: {
+      const auto s = strings_[static_cast<int>(d)].name(static_cast<std::uint32_t>(v));
+      return s.empty() ? "-" : std::string(s);
+    }
+    case GroupDim::Status: return std::to_string(unzigzag(v));
+    case GroupDim::StatusClass: return v ? std::to_string(v) + "xx" : "other";
+    case GroupDim::Minute: {
+      const auto m = unzigzag(v);
+      return (m == kNoMinute) ? "-" : format_minute(m);
+    }
+  }
+  return "";
+}
+
+std::uint32_t GroupBy::group_of(const Key& k) {
+  bool inserted = false;
+  auto& id = index_.find_or_insert(k, inserted);
+  if (!inserted) return id;
+  id = static_cast<std::uint32_t>(keys_.size());
+  keys_.push_back(k);
+  counts_.push_back(0);
+  if (spec_.sum_bytes) bytes_.push_back(0);
+  if (!spec_.quantiles.empty()) latency_.push_back(group_sketch());
+  for (auto& c : distinct_counts_) c.push_back(0);
+  return id;
+}
+
+void GroupBy::add_distinct(std::size_t i, std::uint64_t group, std::uint64_t value) {
+  bool inserted = false;
+  distinct_sets_[i].find_or_insert(Pair{group, value}, inserted);
+  if (inserted) distinct_counts_[i][static_cast<std::size_t>(group)]++;
+}
+
+void GroupBy::add(const LogEntry& e) {
+  Key k{};
+  for (std::size_t i = 0; i < spec_.dims.size(); ++i) k[i] = value_of(spec_.dims[i], e);
+  const auto g = group_of(k);
+  counts_[g]++;
+  if (spec_.sum_bytes && e.bytes > 0) bytes_[g] += static_cast<std::uint64_t>(e.bytes);
+  if (!latency_.empty() && e.latency_us >= 0) latency_[g].add(static_cast<std::uint64_t>(e.latency_us));
+  for (std::size_t i = 0; i < spec_.distinct.size(); ++i) add_distinct(i, g, value_of(spec_.distinct[i], e));
+}
+
+void GroupBy::merge(const GroupBy& other) {
+  // Ids de string do outro lado -> ids daqui.
+  std::vector<std::uint64_t> remap[kGroupDims];
+  for (int d = 0; d < kGroupDims; ++d) {
+    remap[d].reserve(other.strings_[d].size());
+    for (std::uint32_t j = 0; j < other.strings_[d].size(); ++j) remap[d].push_back(strings_[d].intern(other.strings_[d].name(j)));
+  }
+  auto translate = [&](GroupDim d, std::uint64_t v) {
+    return is_string_dim(d) ? remap[static_cast<int>(d)][static_cast<std::size_t>(v)] : v;
+  };
+
+  std::vector<std::uint32_t> groups(other.keys_.size());
+  for (std::size_t og = 0; og < other.keys_.size(); ++og) {
+    Key k = other.keys_[og];
+    for (std::size_t i = 0; i < spec_.dims.size(); ++i) k[i] = translate(spec_.dims[i], k[i]);
+    const auto g = group_of(k);
+    groups[og] = g;
+    counts_[g] += other.counts_[og];
+    if (spec_.sum_bytes) bytes_[g] += other.bytes_[og];
+    if (!latency_.empty()) latency_[g].merge(other.latency_[og]);
+  }
+  for (std::size_t i = 0; i < spec_.distinct.size(); ++i) {
+    other.distinct_sets_[i].for_each([&](const Pair& p, std::uint8_t) {
+      add_distinct(i, groups[static_cast<std::size_t>(p[0])], translate(spec_.distinct[i], p[1]));
+    });
+  }
+}
+
+std::vector<GroupRow> GroupBy::rows() const {
+  std::vector<GroupRow> rows;
+  rows.reserve(keys_.size());
+  for (std::size_t g = 0; g < keys_.size(); ++g) {
+    GroupRow row;
+    for (std::size_t i = 0; i < spec_.dims.size(); ++i) row.key.push_back(format_value(spec_.dims[i], keys_[g][i]));
+    row.count = counts_[g];
+    if (spec_.sum_bytes) row.bytes = bytes_[g];
+    for (double q : spec_.quantiles) {
+      row.quantiles_ms.push_back(latency_[g].count() > 0 ? latency_[g].quantile(q) / 1000.0 : -1.0);
+    }
+    for (const auto& c : distinct_counts_) row.distinct.push_back(c[g]);
+    rows.push_back(std::move(row));
+  }
+  std::sort(rows.begin(), rows.end(), [](const GroupRow& a, const GroupRow& b) {
+    return (a.count == b.count) ? (a.key < b.key) : (a.count > b.count);
+  });
+  return rows;
+}
+
+static std::uint64_t double_bits(double d) {
+  std::uint64_t u = 0;
+  std::memcpy(&u, &d, sizeof(u));
+  return u;
+}
+
+static double bits_double(std::uint64_t u) {
+  double d = 0.0;
+  std::memcpy(&d, &u, sizeof(d));
+  return d;
+}
+
+void GroupBy::serialize(std::string& out) const {
+  put_varint(out, spec_.dims.size());
+  for (auto d : spec_.dims) put_varint(out, static_cast<std::uint64_t>(d));
+  put_varint(out, spec_.sum_bytes ? 1 : 0);
+  put_varint(out, spec_.quantiles.size());
+  for (double q : spec_.quantiles) put_varint(out, double_bits(q));
+  put_varint(out, spec_.distinct.size());
+  for (auto d : spec_.distinct) put_varint(out, static_cast<std::uint64_t>(d));
+
+  // Strings de cada dimensão: tamanhos, depois um blob único (como os endpoints do Aggregator).
+  for (const auto& t : strings_) {
+    put_varint(out, t.size());
+    for (std::uint32_t i = 0; i < t.size(); ++i) put_varint(out, t.name(i).size());
+    for (std::uint32_t i = 0; i < t.size(); ++i) out.append(t.name(i));
+  }
+
+  put_varint(out, keys_.size());
+  for (std::size_t g = 0; g < keys_.size(); ++g) {
+    for (std::size_t i = 0; i < spec_.dims.size(); ++i) put_varint(out, keys_[g][i]);
+    put_varint(out, counts_[g]);
+    if (spec_.sum_bytes) put_varint(out, bytes_[g]);
+    if (!latency_.empty()) latency_[g].serialize(out);
+  }
+
+  // Pares distintos ordenados: o snapshot não depende da ordem dos slots.
+  for (const auto& set : distinct_sets_) {
+    std::vector<Pair> pairs;
+    pairs.reserve(set.size());
+    set.for_each([&](const Pair& p, std::uint8_t) { pairs.push_back(p); });
+    std::sort(pairs.begin(), pairs.end());
+    put_varint(out, pairs.size());
+    for (const auto& p : pairs) {
+      put_varint(out, p[0]);
+      put_varint(out, p[1]);
+    }
+  }
+}
+
+static bool get_dim(std::string_view& in, GroupDim& d) {
+  std::uint64_t v = 0;
+  if (!get_varint(in, v) || v >= static_cast<std::uint64_t>(kGroupDims)) return false;
+  d = static_cast<GroupDim>(v);
+  return true;
+}
+
+bool GroupBy::deserialize(std::string_view& in) {
+  GroupBySpec spec;
+  std::uint64_t n = 0, flag = 0;
+  if (!get_varint(in, n) || n == 0 || n > GroupBySpec::kMaxDims) return false;
+  spec.dims.resize(static_cast<std::size_t>(n));
+  for (auto& d : spec.dims) {
+    if (!get_dim(in, d)) return false;
+  }
+  if (!get_varint(in, flag) || flag > 1) return false;
+  spec.sum_bytes = flag != 0;
+  if (!get_varint(in, n) || n > in.size()) return false;
+  for (std::uint64_t i = 0; i < n; ++i) {
+    std::uint64_t bits = 0;
+    if (!get_varint(in, bits)) return false;
+    spec.quantiles.push_back(bits_double(bits));
+  }
+  if (!get_varint(in, n) || n > kGroupDims) return false;
+  spec.distinct.resize(static_cast<std::size_t>(n));
+  for (auto& d : spec.distinct) {
+    if (!get_dim(in, d)) return false;
+  }
+
+  GroupBy g(spec);
+  for (auto& t : g.strings_) {
+    if (!get_varint(in, n) || n > in.size()) return false;
+    std::vector<std::uint64_t> lens(static_cast<std::size_t>(n));
+    std::uint64_t blob = 0;
+    for (auto& len : lens) {
+      if (!get_varint(in, len)) return false;
+      blob += len;
+    }
+    if (blob > in.size()) return false;
+    for (auto len : lens) {
+      const auto id = t.size();
+      if (t.intern(in.substr(0, static_cast<std::size_t>(len))) != id) return false; // repetida
+      in.remove_prefix(static_cast<std::size_t>(len));
+    }
+  }
+  auto valid = [&](GroupDim d, std::uint64_t v) {
+    return !is_string_dim(d) || v < g.strings_[static_cast<int>(d)].size();
+  };
+
+  std::uint64_t groups = 0;
+  if (!get_varint(in, groups) || groups > in.size()) return false;
+  for (std::uint64_t i = 0; i < groups; ++i) {
+    Key k{};
+    for (std::size_t j = 0; j < spec.dims.size(); ++j) {
+      if (!get_varint(in, k[j]) || !valid(spec.dims[j], k[j])) return false;
+    }
+    if (g.group_of(k) != i) return false; // chave repetida
+    if (!get_varint(in, g.counts_[i])) return false;
+    if (spec.sum_bytes && !get_varint(in, g.bytes_[i])) return false;
+    if (!g.latency_.empty() && !g.latency_[i].deserialize(in)) return false;
+  }
+
+  for (std::size_t i = 0; i < spec.distinct.size(); ++i) {
+    if (!get_varint(in, n) || n > in.size()) return false;
+    for (std::uint64_t j = 0; j < n; ++j) {
+      std::uint64_t group = 0, value = 0;
+      if (!get_varint(in, group) || !get_varint(in, value) || group >= groups || !valid(spec.distinct[i], value)) {
+        return false;
+      }
+      g.add_distinct(i, group, value);
+    }
+  }
+
+  *this = std::move(g);
+  return true;
+}
+
+} // namespace logforge
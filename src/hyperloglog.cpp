@@ -0,0 +1,219 @@
+#include "logforge/hyperloglog.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+
+#include "logforge/flat_hash.hpp"
+#include "logforge/varint.hpp"
+
+namespace logforge {
+
+std::uint64_t hll_hash(std::string_view s) {
+  std::uint64_t h = 14695981039346656037ULL;
+  for (unsigned char c : s) {
+    h ^= c;
+    h *= 1099511628211ULL;
+  }
+  return mix64(h);
+}
+
+HyperLogLog::HyperLogLog(int precision) : p_(precision) {
+  if (p_ != 0) p_ = std::clamp(p_, kMinPrecision, kMaxPrecision);
+}
+
+static std::uint32_t entry_index(std::uint32_t e) { return e >> 6; }
+static std::uint32_t entry_rho(std::uint32_t e) { return e & 63; }
+
+void HyperLogLog::add_sparse(std::uint32_t entry) {
+  auto it = std::lower_bound(sparse_.begin(), sparse_.end(), entry,
+                             [](std::uint32_t a, std::uint32_t b) { return entry_index(a) < entry_index(b); });
+  if (it != sparse_.end() && entry_index(*it) == entry_index(entry)) {
+    if (entry_rho(entry) > entry_rho(*it)) *it = entry;
+    return;
+  }
+  sparse_.insert(it, entry);
+}
+
+void HyperLogLog::add_dense_entry(std::uint32_t entry) {
+  // O índice de 25 bits carrega os p bits do registrador e mais (25 - p) bits da parte que
+  // conta os zeros: se algum deles for 1, rho sai dali; senão continua no rho esparso.
+  const int shift = kSparseBits - p_;
+  const std::uint32_t idx = entry_index(entry);
+  const std::uint32_t low = idx & ((1u << shift) - 1);
+  const auto rho = static_cast<std::uint8_t>(low ? shift - std::bit_width(low) + 1
+                                                 : shift + static_cast<int>(entry_rho(entry)));
+  auto& r = dense_[idx >> shift];
+  r = std::max(r, rho);
+}
+
+void HyperLogLog::to_dense() {
+  dense_.assign(std::size_t{1} << p_, 0);
+  for (auto e : sparse_) add_dense_entry(e);
+  sparse_.clear();
+  sparse_.shrink_to_fit();
+}
+
+void HyperLogLog::add_hash(std::uint64_t h) {
+  if (p_ == 0) return;
+  if (dense_.empty()) {
+    const auto idx = static_cast<std::uint32_t>(h >> (64 - kSparseBits));
+    const std::uint64_t w = h << kSparseBits;
+    const std::uint32_t rho = w ? static_cast<std::uint32_t>(std::countl_zero(w)) + 1 : 64 - kSparseBits + 1;
+    add_sparse((idx << 6) | rho);
+    // 4 bytes por entrada: passou do tamanho do denso, vira denso.
+    if (sparse_.size() * 4 > (std::size_t{1} << p_)) to_dense();
+    return;
+  }
+  const std::uint64_t w = h << p_;
+  const auto rho = static_cast<std::uint8_t>(w ? std::countl_zero(w) + 1 : 64 - p_ + 1);
+  auto& r = dense_[static_cast<std::size_t>(h >> (64 - p_))];
+  r = std::max(r, rho);
+}
+
+bool HyperLogLog::merge(const HyperLogLog& other) {
+  if (other.p_ == 0) return true;
+  if (p_ == 0) {
+    *this = other;
+    return true;
+  }
+  if (p_ != other.p_) return false;
+
+  if (!other.dense_.empty()) {
+    if (dense_.empty()) to_dense();
+    for (std::size_t i = 0; i < dense_.size(); ++i) dense_[i] = std::max(dense_[i], other.dense_[i]);
+    return true;
+  }
+  if (!dense_.empty()) {
+    for (auto e : other.sparse_) add_dense_entry(e);
+    return true;
+  }
+
+  // Dois esparsos: intercala as listas ordenadas (mesmo índice: maior rho).
+  std::vector<std::uint32_t> merged;
+  merged.reserve(sparse_.size() + other.sparse_.size());
+  std::size_t i = 0, j = 0;
+  while (i < sparse_.size() || j < other.sparse_.size()) {
+    if (j == other.sparse_.size() || (i < sparse_.size() && entry_index(sparse_[i]) < entry_index(other.sparse_[j]))) {
+      merged.push_back(sparse_[i++]);
+    } else if (i == sparse_.size() || entry_index(other.sparse_[j]) < entry_index(sparse_[i])) {
+      merged.push_back(other.sparse_[j++]);
+    } else {
+      merged.push_back(std::max(sparse_[i++], other.sparse_[j++])); // mesmo índice: compara o rho
+    }
+  }
+  sparse_.swap(merged);
+  if (sparse_.size() * 4 > (std::size_t{1} << p_)) to_dense();
+  return true;
+}
+
+// Funções auxiliares do estimador de Ertl ("New cardinality estimation algorithms for
+// HyperLogLog sketches", 2017).
+static double ertl_sigma(double x) {
+  if (x == 1.0) return std::numeric_limits<double>::infinity();
+  double y = 1.0, z = x, prev = 0.0;
+  do {
+    x *= x;
+    prev = z;
+    z += x * y;
+    y += y;
+  } while (z != prev);
+  return z;
+}
+
+static double ertl_tau(double x) {
+  if (x == 0.0 || x == 1.0) return 0.0;
+  double y = 1.0, z = 1.0 - x, prev = 0.0;
+  do {
+    x = std::sqrt(x);
+    prev = z;
+    y *= 0.5;
+    z -= (1.0 - x) * (1.0 - x) * y;
+  } while (z != prev);
+  return z / 3.0;
+}
+
+std::uint64_t HyperLogLog::estimate() const {
+  if (p_ == 0) return 0;
+  if (dense_.empty()) {
+    // Linear counting nos 2^25 buckets do esparso.
+    const double m = static_cast<double>(1u << kSparseBits);
+    return static_cast<std::uint64_t>(std::llround(m * std::log(m / (m - static_cast<double>(sparse_.size())))));
+  }
+
+  const int q = 64 - p_;
+  std::vector<std::uint32_t> c(static_cast<std::size_t>(q + 2), 0);
+  for (auto r : dense_) c[r]++;
+  const double m = static_cast<double>(dense_.size());
+  double z = m * ertl_tau(1.0 - c[static_cast<std::size_t>(q + 1)] / m);
+  for (int k = q; k >= 1; --k) z = 0.5 * (z + c[static_cast<std::size_t>(k)]);
+  z += m * ertl_sigma(c[0] / m);
+  const double alpha_inf = 0.5 / std::log(2.0);
+  return static_cast<std::uint64_t>(std::llround(alpha_inf * m * m / z));
+}
+
+double HyperLogLog::relative_error() const {
+  return p_ ? 1.04 / std::sqrt(static_cast<double>(std::size_t{1} << p_)) : 0.0;
+}
+
+void HyperLogLog::clear() {
+  sparse_.clear();
+  dense_.clear();
+}
+
+void HyperLogLog::serialize(std::string& out) const {
+  put_varint(out, static_cast<std::uint64_t>(p_));
+  if (p_ == 0) return;
+  put_varint(out, dense_.empty() ? 0 : 1);
+  if (dense_.empty()) {
+    put_varint(out, sparse_.size());
+    std::uint32_t prev = 0;
+    for (auto e : sparse_) {
+      put_varint(out, e - prev);
+      prev = e;
+    }
+  } else {
+    out.append(reinterpret_cast<const char*>(dense_.data()), dense_.size());
+  }
+}
+
+bool HyperLogLog::deserialize(std::string_view& in) {
+  std::uint64_t p = 0, dense = 0, n = 0;
+  if (!get_varint(in, p)) return false;
+  if (p == 0) {
+    *this = HyperLogLog();
+    return true;
+  }
+  if (p < kMinPrecision || p > kMaxPrecision || !get_varint(in, dense) || dense > 1) return false;
+  HyperLogLog h(static_cast<int>(p));
+  const std::size_t m = std::size_t{1} << p;
+  if (dense) {
+    if (in.size() < m) return false;
+    h.dense_.assign(in.begin(), in.begin() + static_cast<long>(m));
+    in.remove_prefix(m);
+    for (auto r : h.dense_) {
+      if (r > 64 - p + 1) return false;
+    }
+  } else {
+    if (!get_varint(in, n) || n * 4 > m) return false;
+    std::uint64_t e = 0;
+    for (std::uint64_t i = 0; i < n; ++i) {
+      std::uint64_t d = 0;
+      if (!get_varint(in, d)) return false;
+      e += d;
+      const auto entry = static_cast<std::uint32_t>(e);
+      // Índices estritamente crescentes, dentro dos 25 bits, rho em 1..40.
+      if (e >= (std::uint64_t{1} << (kSparseBits + 6)) || entry_rho(entry) < 1 ||
+          entry_rho(entry) > 64 - kSparseBits + 1 ||
+          (!h.sparse_.empty() && entry_index(entry) <= entry_index(h.sparse_.back()))) {
+        return false;
+      }
+      h.sparse_.push_back(entry);
+    }
+  }
+  *this = std::move(h);
+  return true;
+}
+
+} // namespace logforge
@@ -0,0 +1,442 @@
+#include "logforge/ingest.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+namespace logforge {
+
+// Avança `off` até o primeiro início de linha em [off, size].
+static std::uint64_t align_to_line(std::ifstream& ifs, std::uint64_t off, std::uint64_t size) {
+  if (off == 0 || off >= size) return std::min(off, size);
+
+  // Se o byte anterior já é '\n', `off` é início de linha.
+  ifs.clear();
+  ifs.seekg(static_cast<std::streamoff>(off - 1));
+  char buf[4096];
+  std::uint64_t pos = off - 1;
+  while (ifs.read(buf, sizeof(buf)) || ifs.gcount() > 0) {
+    const auto n = static_cast<std::size_t>(ifs.gcount());
+    const char* nl = std::find(buf, buf + n, '\n');
+    if (nl != buf + n) return pos + static_cast<std::uint64_t>(nl - buf) + 1;
+    pos += n;
+  }
+  return size;
+}
+
+std::vector<ByteRange> split_file(const std::string& path, int parts) {
+  std::error_code ec;
+  const auto st = std::filesystem::status(path, ec);
+  if (ec) return {};
+  if (!std::filesystem::is_regular_file(st)) return {ByteRange{0, UINT64_MAX}};
+
+  const auto size = static_cast<std::uint64_t>(std::filesystem::file_size(path, ec));
+  if (ec) return {};
+
+  std::ifstream ifs(path, std::ios::in | std::ios::binary);
+  if (!ifs.is_open()) return {};
+
+  if (parts < 1) parts = 1;
+  std::vector<ByteRange> ranges;
+  std::uint64_t begin = 0;
+  for (int i = 1; i <= parts; ++i) {
+    const std::uint64_t nominal = size / static_cast<std::uint64_t>(parts) * static_cast<std::uint64_t>(i);
+    const std::uint64_t end = (i == parts) ? size : align_to_line(ifs, std::max(nominal, begin), size);
+    if (end > begin) ranges.push_back({begin, end});
+    begin = end;
+  }
+  if (ranges.empty()) ranges.push_back({0, 0}); // arquivo vazio: uma faixa vazia
+  return ranges;
+}
+
+// Linha a linha com o --stats: a leitura de 1 em RunStats::kSampleEvery linhas é
+// cronometrada (o LinePipeline amostra parse e agregação do mesmo jeito).
+static void process_sampled(LineSource& reader, LinePipeline& pipeline, RunStats& stats) {
+  std::string_view line;
+  for (std::uint64_t i = 1;; ++i) {
+    const bool timed = i % RunStats::kSampleEvery == 0;
+    const std::uint64_t t0 = timed ? stats_clock() : 0;
+    if (!reader.next_line(line)) break;
+    if (timed) stats.add(Stage::Read, (stats_clock() - t0) * RunStats::kSampleEvery);
+    pipeline.process(line);
+  }
+}
+
+// Linhas em lotes de até EntryBatch::kCapacity (menos se a fonte pedir o release antes).
+// Com o --stats, a leitura conta do fim de um lote até o próximo lote completo.
+static void process_held(LineSource& reader, LinePipeline& pipeline, RunStats* stats) {
+  const bool timed = kStatsCompiled && stats;
+  std::uint64_t t = timed ? stats_clock() : 0;
+  std::string_view lines[EntryBatch::kCapacity];
+  std::size_t n = 0;
+  reader.hold_views();
+  while (reader.next_line(lines[n])) {
+    if (++n == EntryBatch::kCapacity || reader.release_due()) {
+      if (timed) stats->add(Stage::Read, stats_clock() - t);
+      pipeline.process_lines({lines, n});
+      reader.release_views();
+      n = 0;
+      if (timed) t = stats_clock();
+    }
+  }
+  if (timed) stats->add(Stage::Read, stats_clock() - t);
+  if (n > 0) pipeline.process_lines({lines, n});
+}
+
+bool ingest_range(const std::string& path, ByteRange range, const IngestOptions& opt,
+                  Aggregator& agg, SourceStats* sources) {
+  auto reader = open_line_source(path, opt.reader, range, opt.direct_io);
+  if (!reader->ok()) return false;
+
+  LinePipeline pipeline(opt, agg);
+  RunStats* stats = agg.stats();
+  const bool batched = opt.batch && reader->stable_views();
+  if (batched) {
+    process_held(*reader, pipeline, stats);
+  } else if (kStatsCompiled && stats) {
+    process_sampled(*reader, pipeline, *stats);
+  } else {
+    std::string_view line;
+    while (reader->next_line(line)) pipeline.process(line);
+  }
+  if (sources) record_source(*reader, batched, *sources);
+  return true;
+}
+
+// Resultado de uma faixa comprimida: bordas para a costura + medidas.
+struct CompressedPart {
+  bool ok = false;
+  bool saw_newline = false;
+  std::string head;
+  std::string tail;
+  std::uint64_t bytes = 0;
+  double decompress_sec = 0.0;
+  double parse_sec = 0.0;
+  SourceStats sources;
+};
+
+static CompressedPart ingest_compressed_range(const std::string& path, Compression c, ByteRange range,
+                                              bool capture_edges, const IngestOptions& opt, Aggregator& agg) {
+  CompressedPart part;
+  CompressedLineReader reader(open_decoder(path, c, range), capture_edges);
+  if (!reader.ok()) return part;
+
+  const auto t0 = std::chrono::steady_clock::now();
+  LinePipeline pipeline(opt, agg);
+  if (RunStats* stats = agg.stats(); kStatsCompiled && stats) {
+    process_sampled(reader, pipeline, *stats);
+  } else {
+    std::string_view line;
+    while (reader.next_line(line)) pipeline.process(line);
+  }
+  const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+  part.ok = reader.ok();
+  part.saw_newline = reader.saw_newline();
+  part.head = reader.head();
+  part.tail = reader.tail();
+  part.bytes = reader.decompressed_bytes();
+  part.decompress_sec = reader.decompress_seconds();
+  part.parse_sec = std::max(0.0, wall - reader.wait_seconds());
+  record_source(reader, false, part.sources);
+  return part;
+}
+
+// Costura as bordas das faixas de um arquivo comprimido (em ordem): tail da faixa i +
+// head da i+1 formam uma linha, que pode cruzar várias faixas sem '\n' nenhum.
+static void stitch_edges(const CompressedPart* parts, std::size_t n, LinePipeline& pipeline) {
+  std::string carry;
+  for (std::size_t i = 0; i < n; ++i) {
+    const auto& p = parts[i];
+    if (p.saw_newline) {
+      carry += p.head;
+      pipeline.process(carry);
+      carry = p.tail;
+    } else {
+      carry += p.tail;
+    }
+  }
+  if (!carry.empty()) pipeline.process(carry);
+}
+
+static bool ingest_compressed(const std::string& path, Compression c, const IngestOptions& opt,
+                              Aggregator& out, IngestStats* stats) {
+  if (!compression_supported(c)) return false;
+
+  auto ranges = (c == Compression::Zstd) ? split_zstd_frames(path, opt.threads) : std::vector<ByteRange>{{}};
+  if (ranges.empty()) return false;
+
+  std::vector<CompressedPart> parts(ranges.size());
+  if (ranges.size() == 1) {
+    parts[0] = ingest_compressed_range(path, c, ranges[0], false, opt, out);
+  } else {
+    std::vector<Aggregator> locals(ranges.size(), Aggregator(out.options()));
+    std::vector<std::thread> workers;
+    workers.reserve(ranges.size());
+    for (std::size_t i = 0; i < ranges.size(); ++i) {
+      workers.emplace_back([&, i] { parts[i] = ingest_compressed_range(path, c, ranges[i], true, opt, locals[i]); });
+    }
+    for (auto& t : workers) t.join();
+
+    for (std::size_t i = 0; i < ranges.size(); ++i) {
+      if (!parts[i].ok) return false;
+      out.merge(locals[i]);
+    }
+
+    LinePipeline pipeline(opt, out);
+    stitch_edges(parts.data(), parts.size(), pipeline);
+  }
+
+  if (stats) {
+    *stats = IngestStats{};
+    stats->compression = c;
+    stats->streams = static_cast<int>(parts.size());
+    for (const auto& p : parts) {
+      stats->decompressed_bytes += p.bytes;
+      stats->decompress_sec += p.decompress_sec;
+      stats->parse_sec += p.parse_sec;
+      stats->sources.merge(p.sources);
+    }
+  }
+  return std::all_of(parts.begin(), parts.end(), [](const CompressedPart& p) { return p.ok; });
+}
+
+bool ingest_file(const std::string& path, const IngestOptions& opt, Aggregator& out, IngestStats* stats) {
+  const Compression c = detect_compression(path);
+  if (c != Compression::None) return ingest_compressed(path, c, opt, out, stats);
+
+  auto ranges = split_file(path, opt.threads);
+  if (ranges.empty()) return false;
+  if (stats) *stats = IngestStats{};
+
+  if (ranges.size() == 1) return ingest_range(path, ranges[0], opt, out, stats ? &stats->sources : nullptr);
+
+  // Cada worker agrega localmente (sem locks); merge só no final.
+  std::vector<Aggregator> locals(ranges.size(), Aggregator(out.options()));
+  std::vector<SourceStats> sources(ranges.size());
+  std::vector<char> ok(ranges.size(), 0);
+  std::vector<std::thread> workers;
+  workers.reserve(ranges.size());
+  for (std::size_t i = 0; i < ranges.size(); ++i) {
+    workers.emplace_back([&, i] { ok[i] = ingest_range(path, ranges[i], opt, locals[i], &sources[i]) ? 1 : 0; });
+  }
+  for (auto& t : workers) t.join();
+
+  for (std::size_t i = 0; i < ranges.size(); ++i) {
+    if (!ok[i]) return false;
+    out.merge(locals[i]);
+    if (stats) stats->sources.merge(sources[i]);
+  }
+  return true;
+}
+
+// Um pedaço de arquivo para o escalonador multi-arquivo.
+struct IngestTask {
+  std::size_t file = 0;
+  ByteRange range;
+  Compression compression = Compression::None;
+  std::size_t chunk = 0;  // posição dentro do arquivo (costura das bordas zstd)
+  std::size_t chunks = 1;
+  std::uint64_t weight = 0;
+};
+
+// Pedaços menores que isso não compensam o custo de abrir/mapear e de mais um merge.
+static constexpr std::uint64_t kMinChunk = 4ull << 20;
+// Um byte comprimido custa bem mais que um byte de texto (descomprimir + ~5-10x mais linhas).
+static constexpr std::uint64_t kCompressedWeight = 8;
+
+static bool plan_tasks(const std::vector<std::string>& paths, int threads, std::vector<IngestTask>& tasks,
+                       std::string& failed) {
+  std::vector<std::uint64_t> sizes(paths.size());
+  std::vector<char> streamed(paths.size(), 0); // pipe/FIFO: tamanho desconhecido, uma tarefa só
+  std::uint64_t total = 0;
+  for (std::size_t i = 0; i < paths.size(); ++i) {
+    std::error_code ec;
+    const auto st = std::filesystem::status(paths[i], ec);
+    if (!ec && !std::filesystem::is_regular_file(st)) {
+      streamed[i] = 1;
+      continue;
+    }
+    sizes[i] = static_cast<std::uint64_t>(std::filesystem::file_size(paths[i], ec));
+    if (ec) {
+      failed = paths[i];
+      return false;
+    }
+    total += sizes[i];
+  }
+
+  const auto workers = static_cast<std::uint64_t>(std::max(1, threads));
+  const std::uint64_t target = std::max(kMinChunk, total / (workers * 4));
+  for (std::size_t i = 0; i < paths.size(); ++i) {
+    const Compression c = detect_compression(paths[i]);
+    if (!compression_supported(c)) {
+      failed = paths[i];
+      return false;
+    }
+    const auto parts = (workers == 1)
+                           ? 1
+                           : static_cast<int>(std::min<std::uint64_t>((sizes[i] + target - 1) / target, workers * 4));
+
+    std::vector<ByteRange> ranges;
+    if (c == Compression::None) ranges = split_file(paths[i], std::max(parts, 1));
+    else if (c == Compression::Zstd) ranges = split_zstd_frames(paths[i], std::max(parts, 1));
+    else ranges.push_back({});
+    if (ranges.empty()) {
+      failed = paths[i];
+      return false;
+    }
+
+    for (std::size_t k = 0; k < ranges.size(); ++k) {
+      IngestTask t;
+      t.file = i;
+      t.range = ranges[k];
+      t.compression = c;
+      t.chunk = k;
+      t.chunks = ranges.size();
+      const std::uint64_t bytes = std::min(ranges[k].end, sizes[i]) - std::min(ranges[k].begin, sizes[i]);
+      t.weight = (c == Compression::None) ? bytes : bytes * kCompressedWeight;
+      if (streamed[i]) t.weight = UINT64_MAX; // pode ser grande: começa primeiro
+      tasks.push_back(t);
+    }
+  }
+  return true;
+}
+
+// Filas de índices de tarefa, uma por worker. O dono consome da frente (maiores primeiro);
+// quem está sem trabalho rouba do fim de outra fila (os menores, bons para fechar a conta).
+class TaskQueues {
+public:
+  explicit TaskQueues(std::size_t workers) : queues_(workers) {}
+
+  void push(std::size_t worker, std::size_t task) { queues_[worker].tasks.push_back(task); }
+
+  bool pop(std::size_t worker, std::size_t& task, bool& stolen) {
+    {
+      Queue& q = queues_[worker];
+      std::lock_guard<std::mutex> lk(q.mu);
+      if (!q.tasks.empty()) {
+        task = q.tasks.front();
+        q.tasks.pop_front();
+        stolen = false;
+        return true;
+      }
+    }
+    for (std::size_t k = 1; k < queues_.size(); ++k) {
+      Queue& q = queues_[(worker + k) % queues_.size()];
+      std::lock_guard<std::mutex> lk(q.mu);
+      if (!q.tasks.empty()) {
+        task = q.tasks.back();
+        q.tasks.pop_back();
+        stolen = true;
+        return true;
+      }
+    }
+    return false; // nenhuma tarefa nova é criada depois do início: acabou
+  }
+
+private:
+  struct Queue {
+    std::mutex mu;
+    std::deque<std::size_t> tasks;
+  };
+  std::vector<Queue> queues_;
+};
+
+bool ingest_files(const std::vector<std::string>& paths, const IngestOptions& opt, Aggregator& out,
+                  IngestStats* stats) {
+  if (paths.size() == 1) {
+    const bool ok = ingest_file(paths[0], opt, out, stats);
+    if (stats) {
+      stats->files = 1;
+      if (!ok) stats->failed_path = paths[0];
+    }
+    return ok;
+  }
+
+  std::vector<IngestTask> tasks;
+  std::string failed;
+  if (!plan_tasks(paths, opt.threads, tasks, failed)) {
+    if (stats) stats->failed_path = failed;
+    return false;
+  }
+
+  const std::size_t nworkers = std::min<std::size_t>(static_cast<std::size_t>(std::max(1, opt.threads)), tasks.size());
+  std::vector<std::size_t> order(tasks.size());
+  for (std::size_t i = 0; i < order.size(); ++i) order[i] = i;
+  std::stable_sort(order.begin(), order.end(),
+                   [&](std::size_t a, std::size_t b) { return tasks[a].weight > tasks[b].weight; });
+  TaskQueues queues(nworkers);
+  for (std::size_t i = 0; i < order.size(); ++i) queues.push(i % nworkers, order[i]);
+
+  std::vector<Aggregator> locals(nworkers, Aggregator(out.options()));
+  std::vector<SourceStats> sources(nworkers);
+  std::vector<CompressedPart> parts(tasks.size());
+  std::atomic<bool> failed_any{false};
+  std::atomic<std::size_t> failed_task{tasks.size()};
+  std::atomic<std::uint64_t> steals{0};
+
+  auto run = [&](std::size_t w) {
+    std::size_t ti = 0;
+    bool stolen = false;
+    while (!failed_any.load(std::memory_order_relaxed) && queues.pop(w, ti, stolen)) {
+      if (stolen) steals.fetch_add(1, std::memory_order_relaxed);
+      const IngestTask& t = tasks[ti];
+      bool ok;
+      if (t.compression == Compression::None) {
+        ok = ingest_range(paths[t.file], t.range, opt, locals[w], &sources[w]);
+      } else {
+        parts[ti] = ingest_compressed_range(paths[t.file], t.compression, t.range, t.chunks > 1, opt, locals[w]);
+        ok = parts[ti].ok;
+      }
+      if (!ok) {
+        std::size_t expected = tasks.size();
+        failed_task.compare_exchange_strong(expected, ti);
+        failed_any = true;
+      }
+    }
+  };
+  std::vector<std::thread> workers;
+  workers.reserve(nworkers);
+  for (std::size_t w = 0; w < nworkers; ++w) workers.emplace_back(run, w);
+  for (auto& t : workers) t.join();
+
+  if (failed_any) {
+    if (stats) stats->failed_path = paths[tasks[failed_task].file];
+    return false;
+  }
+
+  for (auto& local : locals) out.merge(local);
+
+  // As tarefas de um arquivo são contíguas em `tasks`, em ordem de pedaço.
+  LinePipeline pipeline(opt, out);
+  for (std::size_t i = 0; i < tasks.size(); i += tasks[i].chunks) {
+    if (tasks[i].compression != Compression::None && tasks[i].chunks > 1) {
+      stitch_edges(&parts[i], tasks[i].chunks, pipeline);
+    }
+  }
+
+  if (stats) {
+    *stats = IngestStats{};
+    stats->files = paths.size();
+    stats->tasks = tasks.size();
+    stats->steals = steals;
+    for (const auto& src : sources) stats->sources.merge(src);
+    for (std::size_t i = 0; i < tasks.size(); ++i) {
+      if (tasks[i].compression == Compression::None) continue;
+      stats->compression = tasks[i].compression;
+      stats->streams++;
+      stats->decompressed_bytes += parts[i].bytes;
+      stats->decompress_sec += parts[i].decompress_sec;
+      stats->parse_sec += parts[i].parse_sec;
+      stats->sources.merge(parts[i].sources);
+    }
+  }
+  return true;
+}
+
+} // namespace logforge
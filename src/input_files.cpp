@@ -0,0 +1,68 @@
+#include "logforge/input_files.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <glob.h>
+#include <unordered_set>
+
+namespace logforge {
+
+static bool has_glob_chars(const std::string& s) { return s.find_first_of("*?[") != std::string::npos; }
+
+bool expand_inputs(const std::vector<std::string>& specs, std::vector<std::string>& out, std::string& err) {
+  std::unordered_set<std::string> seen;
+  auto push = [&](const std::string& p) {
+    if (seen.insert(p).second) out.push_back(p);
+  };
+
+  for (const auto& spec : specs) {
+    std::error_code ec;
+    if (std::filesystem::is_directory(spec, ec)) {
+      std::vector<std::string> files;
+      // increment(ec) em vez do range-for, cujo operator++ lança; cada entrada tem o seu
+      // error_code: um link quebrado é pulado sem derrubar a listagem.
+      std::filesystem::directory_iterator it(spec, ec);
+      for (; !ec && it != std::filesystem::directory_iterator(); it.increment(ec)) {
+        if (it->path().filename().string().front() == '.') continue;
+        std::error_code entry_ec;
+        if (it->is_regular_file(entry_ec)) files.push_back(it->path().string());
+      }
+      if (ec) {
+        err = "não foi possível listar o diretório: " + spec;
+        return false;
+      }
+      std::sort(files.begin(), files.end());
+      for (const auto& f : files) push(f);
+      continue;
+    }
+
+    if (has_glob_chars(spec) && !std::filesystem::exists(spec, ec)) {
+      glob_t g{};
+      const int rc = ::glob(spec.c_str(), 0, nullptr, &g); // glob(3) já devolve ordenado
+      if (rc != 0) {
+        ::globfree(&g);
+        err = "nenhum arquivo casa com: " + spec;
+        return false;
+      }
+      for (std::size_t i = 0; i < g.gl_pathc; ++i) {
+        if (std::filesystem::is_regular_file(g.gl_pathv[i], ec)) push(g.gl_pathv[i]);
+      }
+      ::globfree(&g);
+      continue;
+    }
+
+    if (!std::filesystem::exists(spec, ec)) {
+      err = "arquivo não encontrado: " + spec;
+      return false;
+    }
+    push(spec);
+  }
+
+  if (out.empty()) {
+    err = "nenhum arquivo de entrada";
+    return false;
+  }
+  return true;
+}
+
+} // namespace logforge
@@ -0,0 +1,269 @@
+#include "logforge/json_lines.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace logforge {
+
+static constexpr std::size_t npos = std::string_view::npos;
+
+static std::uint8_t group_of(FormatField f) {
+  switch (f) {
+    case FormatField::TimeLocal: case FormatField::TimeIso8601:
+    case FormatField::TimeEpoch: case FormatField::TimeEpochMs: return 0;
+    case FormatField::Status: return 1;
+    case FormatField::Request: case FormatField::Uri: return 2;
+    case FormatField::Method: return 3;
+    case FormatField::RemoteAddr: return 4;
+    case FormatField::UserAgent: return 5;
+    case FormatField::BodyBytes: return 6;
+    default: return 7; // latências
+  }
+}
+
+struct FieldName {
+  std::string_view name;
+  FormatField field;
+};
+
+// Nomes aceitos em --json-keys.
+static constexpr FieldName kFieldNames[] = {
+    {"time", FormatField::TimeLocal},         {"status", FormatField::Status},
+    {"request", FormatField::Request},        {"uri", FormatField::Uri},
+    {"method", FormatField::Method},          {"client", FormatField::RemoteAddr},
+    {"ua", FormatField::UserAgent},           {"bytes", FormatField::BodyBytes},
+    {"latency", FormatField::RequestTime},    {"latency_ms", FormatField::LatencyMs},
+    {"latency_us", FormatField::LatencyUs},
+};
+
+JsonLinesParser::JsonLinesParser(Isa isa) : isa_(isa_supported(isa) ? isa : Isa::Scalar) {
+  for (auto k : {"time_local", "time_iso8601", "time", "timestamp", "@timestamp", "ts", "msec"})
+    add_key(k, FormatField::TimeLocal);
+  for (auto k : {"status", "status_code"}) add_key(k, FormatField::Status);
+  add_key("request", FormatField::Request);
+  for (auto k : {"request_uri", "uri", "path", "url"}) add_key(k, FormatField::Uri);
+  for (auto k : {"request_method", "method"}) add_key(k, FormatField::Method);
+  for (auto k : {"remote_addr", "client_ip", "client", "ip"}) add_key(k, FormatField::RemoteAddr);
+  for (auto k : {"http_user_agent", "user_agent"}) add_key(k, FormatField::UserAgent);
+  for (auto k : {"body_bytes_sent", "bytes_sent", "bytes"}) add_key(k, FormatField::BodyBytes);
+  for (auto k : {"request_time", "duration"}) add_key(k, FormatField::RequestTime);
+  add_key("upstream_response_time", FormatField::UpstreamTime);
+  for (auto k : {"latency_ms", "duration_ms"}) add_key(k, FormatField::LatencyMs);
+  for (auto k : {"latency_us", "duration_us"}) add_key(k, FormatField::LatencyUs);
+}
+
+void JsonLinesParser::add_key(std::string_view name, FormatField field) {
+  // A mesma chave só pode apontar para um campo: a mais nova substitui.
+  keys_.erase(std::remove_if(keys_.begin(), keys_.end(), [&](const Key& k) { return k.name == name; }),
+              keys_.end());
+  keys_.push_back(Key{std::string(name), field, group_of(field)});
+
+  for (auto& v : by_len_) v.clear();
+  wanted_ = 0;
+  for (std::size_t i = 0; i < keys_.size(); ++i) {
+    if (keys_[i].name.size() < 32) by_len_[keys_[i].name.size()].push_back(static_cast<std::uint8_t>(i));
+    wanted_ |= 1u << keys_[i].group;
+  }
+}
+
+bool JsonLinesParser::set_keys(std::string_view spec, std::string& err) {
+  std::vector<Key> given;
+  while (!spec.empty()) {
+    const auto comma = spec.find(',');
+    std::string_view item = spec.substr(0, comma);
+    spec = (comma == npos) ? std::string_view{} : spec.substr(comma + 1);
+    while (!item.empty() && item.front() == ' ') item.remove_prefix(1);
+    while (!item.empty() && item.back() == ' ') item.remove_suffix(1);
+    if (item.empty()) continue;
+
+    const auto eq = item.find('=');
+    const std::string_view field = item.substr(0, eq);
+    const std::string_view key = (eq == npos) ? std::string_view{} : item.substr(eq + 1);
+    const auto it = std::find_if(std::begin(kFieldNames), std::end(kFieldNames),
+                                 [&](const FieldName& f) { return f.name == field; });
+    if (it == std::end(kFieldNames)) {
+      err = "--json-keys: campo desconhecido: " + std::string(field);
+      return false;
+    }
+    if (key.empty() || key.size() >= 32) {
+      err = "--json-keys: chave vazia ou longa demais para " + std::string(field);
+      return false;
+    }
+    given.push_back(Key{std::string(key), it->field, group_of(it->field)});
+  }
+  if (given.empty()) {
+    err = "--json-keys vazio";
+    return false;
+  }
+  if (keys_.size() + given.size() > 255) {
+    err = "--json-keys: chaves demais";
+    return false;
+  }
+
+  // Os grupos citados perdem as chaves padrão.
+  std::uint32_t groups = 0;
+  for (const auto& k : given) groups |= 1u << k.group;
+  std::vector<Key> old;
+  old.swap(keys_);
+  for (auto& k : old) {
+    if (!(groups & (1u << k.group))) add_key(k.name, k.field);
+  }
+  for (const auto& k : given) add_key(k.name, k.field);
+  return true;
+}
+
+const JsonLinesParser::Key* JsonLinesParser::find_key(std::string_view name) const {
+  if (name.size() >= 32) return nullptr;
+  for (auto i : by_len_[name.size()]) {
+    const Key& k = keys_[i];
+    if (std::memcmp(k.name.data(), name.data(), name.size()) == 0) return &k;
+  }
+  return nullptr;
+}
+
+static inline std::size_t skip_ws(std::string_view s, std::size_t pos) {
+  while (pos < s.size() && (s[pos] == ' ' || s[pos] == '\t' || s[pos] == '\r' || s[pos] == '\n')) ++pos;
+  return pos;
+}
+
+// Posição da aspa que fecha a string cujo conteúdo começa em `start` (npos se não fechar).
+template <typename NextQuote>
+static inline std::size_t string_end(std::string_view s, std::size_t start, NextQuote& next_quote) {
+  std::size_t from = start;
+  for (;;) {
+    const std::size_t q = next_quote(from);
+    if (q == npos) return npos;
+    std::size_t bs = 0;
+    while (q - bs > start && s[q - bs - 1] == '\\') ++bs;
+    if (bs % 2 == 0) return q;
+    from = q + 1;
+  }
+}
+
+// Pula o objeto/array que começa em `pos`; devolve a posição logo depois dele (npos se não
+// fechar). Só conta chaves e colchetes fora de strings.
+template <typename NextQuote>
+static std::size_t skip_nested(std::string_view s, std::size_t pos, NextQuote& next_quote) {
+  int depth = 0;
+  while (pos < s.size()) {
+    const char c = s[pos];
+    if (c == '"') {
+      pos = string_end(s, pos + 1, next_quote);
+      if (pos == npos) return npos;
+    } else if (c == '{' || c == '[') {
+      ++depth;
+    } else if (c == '}' || c == ']') {
+      if (--depth == 0) return pos + 1;
+    }
+    ++pos;
+  }
+  return npos;
+}
+
+// Tipo do valor de uma chave de tempo.
+static FormatField time_kind(std::string_view v, bool is_string) {
+  if (is_string) {
+    if (v.find('/') != npos) return FormatField::TimeLocal;
+    if (v.size() >= 10 && v[4] == '-') return FormatField::TimeIso8601;
+  }
+  // Número (ou string numérica, ex.: "$msec" entre aspas): época em s; com mais de 11
+  // dígitos inteiros, em ms.
+  const auto dot = v.find('.');
+  return (dot == npos ? v.size() : dot) > 11 ? FormatField::TimeEpochMs : FormatField::TimeEpoch;
+}
+
+template <typename NextQuote>
+ParseResult JsonLinesParser::parse_object(std::string_view line, NextQuote&& next_quote, const Filter* filter,
+                                          LogEntry& out) const {
+  std::string_view cap[kFormatFields];
+  bool has[kFormatFields] = {};
+  std::uint32_t found = 0;
+
+  std::size_t pos = skip_ws(line, 0);
+  if (pos == line.size() || line[pos] != '{') return ParseResult::Invalid;
+  pos = skip_ws(line, pos + 1);
+  if (pos < line.size() && line[pos] == '}') {
+    ++pos;
+  } else {
+    for (;;) {
+      if (pos >= line.size() || line[pos] != '"') return ParseResult::Invalid;
+      const auto ke = string_end(line, pos + 1, next_quote);
+      if (ke == npos) return ParseResult::Invalid;
+      const std::string_view name = line.substr(pos + 1, ke - pos - 1);
+      pos = skip_ws(line, ke + 1);
+      if (pos >= line.size() || line[pos] != ':') return ParseResult::Invalid;
+      pos = skip_ws(line, pos + 1);
+      if (pos >= line.size()) return ParseResult::Invalid;
+
+      std::string_view value;
+      bool is_string = false, is_scalar = true;
+      const char c = line[pos];
+      if (c == '"') {
+        const auto ve = string_end(line, pos + 1, next_quote);
+        if (ve == npos) return ParseResult::Invalid;
+        value = line.substr(pos + 1, ve - pos - 1);
+        is_string = true;
+        pos = ve + 1;
+      } else if (c == '{' || c == '[') {
+        pos = skip_nested(line, pos, next_quote);
+        if (pos == npos) return ParseResult::Invalid;
+        is_scalar = false;
+      } else {
+        std::size_t ve = pos;
+        while (ve < line.size() && line[ve] != ',' && line[ve] != '}' && line[ve] != ' ' && line[ve] != '\t') ++ve;
+        value = line.substr(pos, ve - pos);
+        pos = ve;
+      }
+
+      const Key* k = is_scalar ? find_key(name) : nullptr;
+      if (k && !(found & (1u << k->group)) && (is_string || value != "null")) {
+        const FormatField f = k->group == 0 ? time_kind(value, is_string) : k->field;
+        cap[static_cast<int>(f)] = value;
+        has[static_cast<int>(f)] = true;
+        found |= 1u << k->group;
+        // Todos os campos mapeados já apareceram: o resto da linha nem é lido.
+        if (found == wanted_) return finish_format_entry(has, cap, filter, out);
+      }
+
+      pos = skip_ws(line, pos);
+      if (pos < line.size() && line[pos] == ',') {
+        pos = skip_ws(line, pos + 1);
+        continue;
+      }
+      if (pos < line.size() && line[pos] == '}') {
+        ++pos;
+        break;
+      }
+      return ParseResult::Invalid;
+    }
+  }
+  if (skip_ws(line, pos) != line.size()) return ParseResult::Invalid;
+  if (!has[static_cast<int>(FormatField::Status)] ||
+      (!has[static_cast<int>(FormatField::Request)] && !has[static_cast<int>(FormatField::Uri)]))
+    return ParseResult::Invalid;
+  return finish_format_entry(has, cap, filter, out);
+}
+
+ParseResult JsonLinesParser::parse(std::string_view line, const Filter* filter, LogEntry& out) const {
+  if (line.size() <= StructuralMasks::kMaxLen) {
+    StructuralMasks m;
+    build_masks(isa_, line, m);
+    return parse_object(line, [&](std::size_t from) { return m.next(m.quote, from); }, filter, out);
+  }
+  // Linhas muito longas (raras): memchr.
+  return parse_object(
+      line,
+      [&](std::size_t from) {
+        if (from >= line.size()) return npos;
+        const void* hit = std::memchr(line.data() + from, '"', line.size() - from);
+        return hit ? static_cast<std::size_t>(static_cast<const char*>(hit) - line.data()) : npos;
+      },
+      filter, out);
+}
+
+void JsonLinesParser::parse_batch(std::span<const std::string_view> lines, const Filter* filter,
+                                  EntryBatch& out) const {
+  parse_rows(*this, lines, filter, out);
+}
+
+} // namespace logforge
@@ -0,0 +1,198 @@
+#include "logforge/latency_sketch.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#include "logforge/varint.hpp"
+
+namespace logforge {
+
+static constexpr int kMaxSubBits = 16;
+
+LatencySketch::LatencySketch(double relative_error, std::uint32_t max_buckets)
+    : sub_bits_(1), max_buckets_(max_buckets) {
+  // Menor b com 1 / 2^(b+1) <= erro pedido.
+  while (sub_bits_ < kMaxSubBits && 1.0 / static_cast<double>(1u << (sub_bits_ + 1)) > relative_error)
+    sub_bits_++;
+}
+
+double LatencySketch::relative_error() const { return 1.0 / static_cast<double>(1u << (sub_bits_ + 1)); }
+
+std::int64_t LatencySketch::index_of(std::uint64_t v) const {
+  const std::uint64_t m = std::uint64_t{1} << sub_bits_;
+  if (v < 2 * m) return static_cast<std::int64_t>(v);
+  const int e = std::bit_width(v) - sub_bits_ - 1;
+  return static_cast<std::int64_t>(static_cast<std::uint64_t>(e) * m + (v >> e));
+}
+
+std::uint64_t LatencySketch::lower_bound_of(std::int64_t idx) const {
+  const std::int64_t m = std::int64_t{1} << sub_bits_;
+  if (idx < 2 * m) return static_cast<std::uint64_t>(idx);
+  const std::int64_t e = idx / m - 1;
+  return static_cast<std::uint64_t>(idx - e * m) << e;
+}
+
+std::uint64_t LatencySketch::width_of(std::int64_t idx) const {
+  const std::int64_t m = std::int64_t{1} << sub_bits_;
+  if (idx < 2 * m) return 1;
+  return std::uint64_t{1} << (idx / m - 1);
+}
+
+void LatencySketch::add_at(std::int64_t idx, std::uint64_t n) {
+  if (counts_.empty()) {
+    offset_ = idx;
+    counts_.assign(1, n);
+    return;
+  }
+
+  const auto cap = static_cast<std::int64_t>(max_buckets_);
+  const std::int64_t top = offset_ + static_cast<std::int64_t>(counts_.size()) - 1;
+
+  // Com teto de buckets, tudo abaixo de (maior índice - cap + 1) cai no bucket mais baixo.
+  // O resultado só depende do maior índice visto, então merge continua exato.
+  if (cap && idx < top - cap + 1) idx = top - cap + 1;
+
+  if (idx < offset_) {
+    counts_.insert(counts_.begin(), static_cast<std::size_t>(offset_ - idx), 0);
+    offset_ = idx;
+  } else if (idx > top) {
+    if (cap && idx - offset_ + 1 > cap) {
+      const std::int64_t new_offset = idx - cap + 1;
+      std::vector<std::uint64_t> next(static_cast<std::size_t>(cap), 0);
+      for (std::size_t i = 0; i < counts_.size(); ++i) {
+        const std::int64_t j = std::max(offset_ + static_cast<std::int64_t>(i), new_offset);
+        next[static_cast<std::size_t>(j - new_offset)] += counts_[i];
+      }
+      counts_.swap(next);
+      offset_ = new_offset;
+    } else {
+      counts_.resize(static_cast<std::size_t>(idx - offset_ + 1), 0);
+    }
+  }
+  counts_[static_cast<std::size_t>(idx - offset_)] += n;
+}
+
+void LatencySketch::add(std::uint64_t value_us, std::uint64_t n) {
+  if (n == 0) return;
+  if (count_ == 0 || value_us < min_) min_ = value_us;
+  if (count_ == 0 || value_us > max_) max_ = value_us;
+  count_ += n;
+  sum_ += value_us * n;
+  add_at(index_of(value_us), n);
+}
+
+void LatencySketch::add_batch(const std::int64_t* values_us, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    if (values_us[i] < 0) continue;
+    const auto v = static_cast<std::uint64_t>(values_us[i]);
+    if (count_ == 0 || v < min_) min_ = v;
+    if (count_ == 0 || v > max_) max_ = v;
+    count_++;
+    sum_ += v;
+    // Caso comum: o bucket já existe.
+    const std::int64_t idx = index_of(v);
+    const auto k = static_cast<std::uint64_t>(idx - offset_);
+    if (!counts_.empty() && k < counts_.size()) {
+      counts_[k]++;
+    } else {
+      add_at(idx, 1);
+    }
+  }
+}
+
+void LatencySketch::clear() {
+  count_ = sum_ = min_ = max_ = 0;
+  offset_ = 0;
+  counts_.clear();
+}
+
+bool LatencySketch::merge(const LatencySketch& other) {
+  if (other.sub_bits_ != sub_bits_ || other.max_buckets_ != max_buckets_) return false;
+  if (other.count_ == 0) return true;
+
+  if (count_ == 0 || other.min_ < min_) min_ = other.min_;
+  if (count_ == 0 || other.max_ > max_) max_ = other.max_;
+  count_ += other.count_;
+  sum_ += other.sum_;
+
+  // Do maior para o menor: o topo é estabelecido antes, evitando crescer e colapsar à toa.
+  for (std::size_t i = other.counts_.size(); i-- > 0;) {
+    if (other.counts_[i]) add_at(other.offset_ + static_cast<std::int64_t>(i), other.counts_[i]);
+  }
+  return true;
+}
+
+double LatencySketch::quantile(double q) const {
+  if (count_ == 0) return -1.0;
+  if (q <= 0.0) return static_cast<double>(min_);
+  if (q >= 1.0) return static_cast<double>(max_);
+
+  const auto target =
+      std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(q * static_cast<double>(count_))));
+  std::uint64_t cum = 0;
+  for (std::size_t i = 0; i < counts_.size(); ++i) {
+    cum += counts_[i];
+    if (cum >= target) {
+      const std::int64_t idx = offset_ + static_cast<std::int64_t>(i);
+      const double mid = static_cast<double>(lower_bound_of(idx)) + static_cast<double>(width_of(idx) - 1) / 2.0;
+      return std::clamp(mid, static_cast<double>(min_), static_cast<double>(max_));
+    }
+  }
+  return static_cast<double>(max_);
+}
+
+void LatencySketch::serialize(std::string& out) const {
+  put_varint(out, static_cast<std::uint64_t>(sub_bits_));
+  put_varint(out, max_buckets_);
+  put_varint(out, count_);
+  put_varint(out, sum_);
+  put_varint(out, min_);
+  put_varint(out, max_);
+  put_varint(out, zigzag(offset_));
+
+  std::uint64_t nonzero = 0;
+  for (auto c : counts_) nonzero += (c != 0);
+  put_varint(out, nonzero);
+
+  std::size_t prev = 0;
+  for (std::size_t i = 0; i < counts_.size(); ++i) {
+    if (!counts_[i]) continue;
+    put_varint(out, i - prev);
+    put_varint(out, counts_[i]);
+    prev = i;
+  }
+}
+
+bool LatencySketch::deserialize(std::string_view& in) {
+  std::uint64_t sub_bits = 0, max_buckets = 0, offset = 0, nonzero = 0;
+  LatencySketch s;
+  if (!get_varint(in, sub_bits) || sub_bits < 1 || sub_bits > kMaxSubBits) return false;
+  if (!get_varint(in, max_buckets) || max_buckets > UINT32_MAX) return false;
+  if (!get_varint(in, s.count_) || !get_varint(in, s.sum_) || !get_varint(in, s.min_) ||
+      !get_varint(in, s.max_) || !get_varint(in, offset) || !get_varint(in, nonzero))
+    return false;
+
+  s.sub_bits_ = static_cast<int>(sub_bits);
+  s.max_buckets_ = static_cast<std::uint32_t>(max_buckets);
+  s.offset_ = unzigzag(offset);
+
+  // Índices válidos são limitados pela faixa de 64 bits.
+  const std::uint64_t max_index = static_cast<std::uint64_t>(66 - sub_bits) << sub_bits;
+  std::uint64_t pos = 0, total = 0;
+  for (std::uint64_t k = 0; k < nonzero; ++k) {
+    std::uint64_t delta = 0, c = 0;
+    if (!get_varint(in, delta) || !get_varint(in, c)) return false;
+    pos += delta;
+    if (pos >= max_index || (k > 0 && delta == 0)) return false;
+    if (s.counts_.size() <= pos) s.counts_.resize(static_cast<std::size_t>(pos + 1), 0);
+    s.counts_[static_cast<std::size_t>(pos)] = c;
+    total += c;
+  }
+  if (total != s.count_) return false;
+
+  *this = std::move(s);
+  return true;
+}
+
+} // namespace logforge
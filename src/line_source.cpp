@@ -0,0 +1,52 @@
+#include "logforge/line_source.hpp"
+
+#include "logforge/async_reader.hpp"
+#include "logforge/buffered_reader.hpp"
+#include "logforge/compressed_reader.hpp"
+#include "logforge/mmap_reader.hpp"
+
+#include <sys/stat.h>
+
+namespace logforge {
+
+std::unique_ptr<LineSource> open_line_source(const std::string& path, ReaderKind kind,
+                                             ByteRange range, bool direct) {
+  // Pipe/FIFO: só dá para ler uma vez, em sequência; os leitores que abrem para testar
+  // (mmap, uring) consumiriam a ponta de leitura.
+  struct stat st {};
+  if (::stat(path.c_str(), &st) == 0 && !S_ISREG(st.st_mode)) {
+    return std::make_unique<BufferedLineReader>(path, range.begin, range.end);
+  }
+
+  const Compression c = detect_compression(path);
+  if (c != Compression::None) return std::make_unique<CompressedLineReader>(open_decoder(path, c, range));
+
+  if (kind == ReaderKind::Mmap) {
+    auto mm = std::make_unique<MmapLineReader>(path, range);
+    if (mm->ok()) return mm;
+  }
+  if (kind == ReaderKind::Async) {
+    AsyncReadOptions opt;
+    opt.direct = direct;
+    auto as = std::make_unique<AsyncLineReader>(path, range, opt);
+    if (as->ok()) return as;
+  }
+  return std::make_unique<BufferedLineReader>(path, range.begin, range.end);
+}
+
+void record_source(const LineSource& src, bool batched, SourceStats& out) {
+  if (const auto* as = dynamic_cast<const AsyncLineReader*>(&src)) {
+    (as->backend() == AsyncBackend::Uring ? out.uring : out.pread)++;
+    if (as->direct()) out.direct++;
+    out.io_wait_sec += as->wait_seconds();
+  } else if (dynamic_cast<const MmapLineReader*>(&src)) {
+    out.mmap++;
+  } else if (dynamic_cast<const CompressedLineReader*>(&src)) {
+    out.compressed++;
+  } else {
+    out.stream++;
+  }
+  if (batched) out.batched++;
+}
+
+} // namespace logforge
@@ -0,0 +1,215 @@
+#include "logforge/log_format.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+
+#include "logforge/filter.hpp"
+#include "logforge/json_lines.hpp"
+#include "logforge/time_util.hpp"
+
+namespace logforge {
+
+static inline bool is_blank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+static inline std::string_view trim(std::string_view sv) {
+  while (!sv.empty() && is_blank(sv.front())) sv.remove_prefix(1);
+  while (!sv.empty() && is_blank(sv.back())) sv.remove_suffix(1);
+  return sv;
+}
+
+static inline bool parse_int(std::string_view sv, int& out) {
+  sv = trim(sv);
+  if (sv.empty()) return false;
+  auto res = std::from_chars(sv.data(), sv.data() + sv.size(), out);
+  return res.ec == std::errc() && res.ptr == sv.data() + sv.size();
+}
+
+static inline bool parse_double(std::string_view sv, double& out) {
+  sv = trim(sv);
+  if (sv.empty()) return false;
+  auto res = std::from_chars(sv.data(), sv.data() + sv.size(), out, std::chars_format::general);
+  return res.ec == std::errc() && res.ptr == sv.data() + sv.size();
+}
+
+// Latência numa unidade qualquer -> µs (-1 se inválida ou fora de [0, 1 h)).
+static std::int64_t latency_in_unit(std::string_view tok, double us_per_unit) {
+  double v = 0.0;
+  if (!parse_double(tok, v)) return -1;
+  const double us = v * us_per_unit;
+  if (us < 0.0 || us >= 3600.0 * 1e6) return -1;
+  return std::llround(us);
+}
+
+// $upstream_response_time: "0.010, 0.020 : 0.005" (um valor por upstream tentado, "-" se
+// não houve resposta). A latência do backend é a soma.
+static std::int64_t upstream_latency(std::string_view tok) {
+  std::int64_t total = -1;
+  while (!tok.empty()) {
+    const auto sep = tok.find_first_of(",:");
+    const auto us = latency_from_seconds(trim(tok.substr(0, sep)));
+    if (us >= 0) total = (total < 0 ? 0 : total) + us;
+    if (sep == std::string_view::npos) break;
+    tok.remove_prefix(sep + 1);
+  }
+  return total;
+}
+
+static std::optional<std::int64_t> epoch_to_minute(std::string_view tok, double sec_per_unit) {
+  double v = 0.0;
+  if (!parse_double(tok, v) || v < 0.0) return std::nullopt;
+  return static_cast<std::int64_t>(std::floor(v * sec_per_unit / 60.0));
+}
+
+// `present(f)` diz se o formato tem o campo. Nos planos embutidos ele é constante e os
+// ramos dos campos ausentes somem na compilação.
+template <class Present>
+static inline ParseResult finish_entry(Present present, const std::string_view* cap, const Filter* filter,
+                                       LogEntry& out) {
+  auto value = [&](FormatField f) { return cap[static_cast<int>(f)]; };
+  out = LogEntry{};
+
+  // 1) tempo (opcional; se estiver no formato, precisa ser válido)
+  std::optional<std::int64_t> minute;
+  if (present(FormatField::TimeLocal)) {
+    minute = parse_time_local(value(FormatField::TimeLocal));
+  } else if (present(FormatField::TimeIso8601)) {
+    minute = parse_time_iso8601(trim(value(FormatField::TimeIso8601)));
+  } else if (present(FormatField::TimeEpoch)) {
+    minute = epoch_to_minute(value(FormatField::TimeEpoch), 1.0);
+  } else if (present(FormatField::TimeEpochMs)) {
+    minute = epoch_to_minute(value(FormatField::TimeEpochMs), 1e-3);
+  } else {
+    minute = kNoMinute;
+  }
+  if (!minute) return ParseResult::Invalid;
+  out.minute = *minute;
+  // Um gate que falha não encerra a validação (ver Parser::parse): Filtered só se válida.
+  bool keep = !filter || filter->pass(FilterStage::Time, out);
+
+  // 2) status
+  if (!parse_int(value(FormatField::Status), out.status)) return ParseResult::Invalid;
+  keep = keep && (!filter || filter->pass(FilterStage::Status, out));
+
+  // 3) endpoint: da request (METHOD PATH PROTO, mesmas regras do NginxParser) ou da URI
+  if (present(FormatField::Request)) {
+    const std::string_view request = trim(value(FormatField::Request));
+    const auto sp1 = request.find(' ');
+    const auto sp2 = request.rfind(' ');
+    if (sp1 == std::string_view::npos || sp1 == sp2) return ParseResult::Invalid;
+    const std::string_view path = trim(request.substr(sp1 + 1, sp2 - (sp1 + 1)));
+    if (path.empty()) return ParseResult::Invalid;
+    out.endpoint = endpoint_from_path(path);
+    out.method = request.substr(0, sp1);
+  } else {
+    const std::string_view uri = trim(value(FormatField::Uri));
+    if (uri.empty() || uri == "-") return ParseResult::Invalid;
+    out.endpoint = endpoint_from_path(uri);
+  }
+  if (present(FormatField::Method)) out.method = trim(value(FormatField::Method));
+  if (!keep || (filter && !filter->pass(FilterStage::Endpoint, out))) return ParseResult::Filtered;
+
+  // 4) latência: a mais precisa entre as totais da request; a do upstream só na falta delas
+  if (present(FormatField::LatencyUs)) {
+    out.latency_us = latency_in_unit(value(FormatField::LatencyUs), 1.0);
+  } else if (present(FormatField::RequestTime)) {
+    out.latency_us = latency_from_seconds(value(FormatField::RequestTime));
+  } else if (present(FormatField::LatencyMs)) {
+    out.latency_us = latency_in_unit(value(FormatField::LatencyMs), 1e3);
+  } else if (present(FormatField::UpstreamTime)) {
+    out.latency_us = upstream_latency(value(FormatField::UpstreamTime));
+  }
+  if (filter && !filter->pass(FilterStage::Latency, out)) return ParseResult::Filtered;
+
+  // 5) campos do --group-by
+  if (present(FormatField::RemoteAddr)) out.remote_addr = trim(value(FormatField::RemoteAddr));
+  if (present(FormatField::UserAgent)) out.user_agent = value(FormatField::UserAgent);
+  if (present(FormatField::BodyBytes)) out.bytes = bytes_from_token(value(FormatField::BodyBytes));
+  return ParseResult::Ok;
+}
+
+ParseResult finish_format_entry(const bool* has, const std::string_view* cap, const Filter* filter, LogEntry& out) {
+  return finish_entry([has](FormatField f) { return has[static_cast<int>(f)]; }, cap, filter, out);
+}
+
+template <const FormatPlan& Plan>
+ParseResult finish_plan_entry(const std::string_view* cap, const Filter* filter, LogEntry& out) {
+  return finish_entry([](FormatField f) { return Plan.has[static_cast<int>(f)]; }, cap, filter, out);
+}
+
+template ParseResult finish_plan_entry<kCombinedPlan>(const std::string_view*, const Filter*, LogEntry&);
+template ParseResult finish_plan_entry<kTimedPlan>(const std::string_view*, const Filter*, LogEntry&);
+template ParseResult finish_plan_entry<kCommonPlan>(const std::string_view*, const Filter*, LogEntry&);
+
+FormatParser::FormatParser(const FormatPlan& plan, Isa isa)
+    : plan_(plan), isa_(isa_supported(isa) ? isa : Isa::Scalar) {
+  // Do embutido com o maior prefixo comum vêm os passos desenrolados; de um com os mesmos
+  // campos presentes, a conversão.
+  const auto borrow = [&](const FormatPlan& builtin, PrefixFn prefix, FinishFn finish) {
+    const std::size_t n = common_format_prefix(plan_, builtin);
+    if (n > prefix_len_) {
+      prefix_len_ = n;
+      prefix_ = prefix;
+    }
+    if (!finish_ && std::equal(plan_.has, plan_.has + kFormatFields, builtin.has)) finish_ = finish;
+  };
+  borrow(kCombinedPlan, run_plan_prefix<kCombinedPlan>, finish_plan_entry<kCombinedPlan>);
+  borrow(kTimedPlan, run_plan_prefix<kTimedPlan>, finish_plan_entry<kTimedPlan>);
+  borrow(kCommonPlan, run_plan_prefix<kCommonPlan>, finish_plan_entry<kCommonPlan>);
+}
+
+// log_format colado do nginx.conf: 'parte 1 ' 'parte 2' -> "parte 1 parte 2". Sem aspas
+// simples no começo, o texto é o próprio formato.
+static std::string join_conf_quotes(std::string_view s) {
+  s = trim(s);
+  if (s.empty() || s.front() != '\'') return std::string(s);
+  std::string out;
+  while (!s.empty() && s.front() == '\'') {
+    const auto close = s.find('\'', 1);
+    if (close == std::string_view::npos) return std::string(s); // aspa solta: usa como está
+    out.append(s.substr(1, close - 1));
+    s.remove_prefix(close + 1);
+    while (!s.empty() && (is_blank(s.front()) || s.front() == '\n' || s.front() == ';')) s.remove_prefix(1);
+  }
+  return out;
+}
+
+std::unique_ptr<Parser> make_parser(const FormatOptions& opt, std::string& err) {
+  const bool nginx_fmt = !opt.log_format.empty();
+  const bool apache_fmt = !opt.apache_format.empty();
+  if ((nginx_fmt && apache_fmt) || ((nginx_fmt || apache_fmt) && (opt.name != "nginx" || !opt.json_keys.empty()))) {
+    err = "use só um entre --format, --log-format e --apache-format";
+    return nullptr;
+  }
+  if (nginx_fmt || apache_fmt) {
+    const std::string fmt = nginx_fmt ? join_conf_quotes(opt.log_format) : opt.apache_format;
+    const FormatPlan plan =
+        compile_log_format(nginx_fmt ? FormatDialect::Nginx : FormatDialect::Apache, fmt);
+    if (plan.error) {
+      err = plan.error;
+      return nullptr;
+    }
+    // O combined colado do nginx.conf é o caso comum: fica com o plano desenrolado.
+    if (same_format_plan(plan, kCombinedPlan)) return std::make_unique<StaticFormatParser<kCombinedPlan>>(opt.isa);
+    if (same_format_plan(plan, kTimedPlan)) return std::make_unique<StaticFormatParser<kTimedPlan>>(opt.isa);
+    if (same_format_plan(plan, kCommonPlan)) return std::make_unique<StaticFormatParser<kCommonPlan>>(opt.isa);
+    return std::make_unique<FormatParser>(plan, opt.isa);
+  }
+
+  if (opt.name == "json" || !opt.json_keys.empty()) {
+    if (opt.name != "json" && opt.name != "nginx") {
+      err = "--json-keys só vale com --format json";
+      return nullptr;
+    }
+    auto p = std::make_unique<JsonLinesParser>(opt.isa);
+    if (!opt.json_keys.empty() && !p->set_keys(opt.json_keys, err)) return nullptr;
+    return p;
+  }
+  if (opt.name == "combined") return std::make_unique<StaticFormatParser<kCombinedPlan>>(opt.isa);
+  if (opt.name == "timed") return std::make_unique<StaticFormatParser<kTimedPlan>>(opt.isa);
+  if (opt.name == "common") return std::make_unique<StaticFormatParser<kCommonPlan>>(opt.isa);
+  if (opt.name != "nginx") err = "formato desconhecido: " + opt.name + " (use nginx, combined, common, timed ou json)";
+  return nullptr;
+}
+
+} // namespace logforge
@@ -1,23 +1,58 @@
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <csignal>
 #include <filesystem>
+#include <iomanip>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "logforge/aggregator.hpp"
-#include "logforge/buffered_reader.hpp"
-#include "logforge/parser_nginx.hpp"
+#include "logforge/async_reader.hpp"
+#include "logforge/column_index.hpp"
+#include "logforge/follow.hpp"
+#include "logforge/input_files.hpp"
+#include "logforge/ingest.hpp"
+#include "logforge/log_format.hpp"
+#include "logforge/perf_counters.hpp"
 #include "logforge/report_writer.hpp"
+#include "logforge/run_stats.hpp"
+#include "logforge/snapshot.hpp"
+#include "logforge/time_util.hpp"
 
 using SteadyClock = std::chrono::steady_clock;
 
+// Sinalizado por SIGINT/SIGTERM no modo --follow.
+static std::atomic<bool> g_stop{false};
+
+static void on_stop_signal(int) { g_stop.store(true); }
+
 static void usage() {
   std::cout
       << "LogForge (starter)\n"
       << "Uso:\n"
-      << "  logforge --in <arquivo.log> --out <diretorio_saida> [--top N] [--bench]\n\n"
+      << "  logforge --in <arquivo|diretorio|glob>... --out <diretorio_saida> [--top N] [--threads N]\n"
+      << "           [--reader mmap|stream|uring [--direct]] [--isa auto|scalar|sse2|avx2]\n"
+      << "           [--quantiles 0.5,0.9,0.999] [--latency-error 0.01]\n"
+      << "           [--endpoint-stats N] [--topk-mode exact|approx] [--topk-capacity M]\n"
+      << "           [--normalize] [--normalize-rules <arquivo>] [--bench] [--no-batch]\n"
+      << "           [--window 1m|5m|1h [--window-retention N] [--sliding K]]\n"
+      << "           [--follow [--interval S]] [--snapshot <arquivo.snap>] [--where <expressão>]\n"
+      << "           [--group-by endpoint,status_class [--agg count,sum(bytes),p95,distinct(ip)]]\n"
+      << "           [--unique-clients [--hll-precision 12]] [--stats]\n"
+      << "           [--format nginx|combined|common|timed|json [--json-keys status=code,...]]\n"
+      << "           [--log-format '<log_format do nginx>' | --apache-format '<LogFormat>']\n"
+      << "  logforge merge <a.snap> <b.snap>... --out <diretorio_saida> [--top N] [--snapshot <saida.snap>]\n"
+      << "  logforge index --in <arquivo|diretorio|glob>... --index <arquivo.lfx> [--reader ...] [--isa ...]\n"
+      << "           [--format ... | --log-format ... | --apache-format ...]\n"
+      << "  logforge query --index <arquivo.lfx> --out <diretorio_saida> [--from T] [--to T]\n"
+      << "           [--status 404|500-599|5xx] [--where <expressão>] [--threads N]\n"
+      << "           [opções de agregação/normalização] [--bench]\n\n"
       << "Exemplo:\n"
-      << "  logforge --in data/sample_nginx.log --out out --top 20\n";
+      << "  logforge --in data/sample_nginx.log --out out --top 20\n"
+      << "  logforge --in access.log --out out --where 'status = 5xx and endpoint = /api/* and time >= 13:00 and time < 14:00'\n";
 }
 
 static std::string arg_value(const std::vector<std::string>& args, const std::string& key,
@@ -28,17 +63,470 @@ static std::string arg_value(const std::vector<std::string>& args, const std::st
   return def;
 }
 
+// Todos os valores de `key`: a chave pode repetir e cada ocorrência aceita vários valores
+// até o próximo "--..." (ex.: --in logs/*.log depois da expansão do shell).
+static std::vector<std::string> arg_values(const std::vector<std::string>& args, const std::string& key) {
+  std::vector<std::string> out;
+  for (std::size_t i = 0; i < args.size(); ++i) {
+    if (args[i] != key) continue;
+    while (i + 1 < args.size() && args[i + 1].rfind("--", 0) != 0) out.push_back(args[++i]);
+  }
+  return out;
+}
+
 static bool has_flag(const std::vector<std::string>& args, const std::string& flag) {
   for (auto& a : args) if (a == flag) return true;
   return false;
 }
 
+static bool arg_double(const std::vector<std::string>& args, const std::string& key, double& out) {
+  auto v = arg_value(args, key, "");
+  if (v.empty()) return true;
+  try { out = std::stod(v); } catch (...) { return false; }
+  return true;
+}
+
+// "0.5,0.9,0.999" -> {0.5, 0.9, 0.999}; false se algum valor não estiver em [0, 1].
+static bool parse_quantiles(const std::string& s, std::vector<double>& out) {
+  std::size_t pos = 0;
+  while (pos < s.size()) {
+    auto comma = s.find(',', pos);
+    if (comma == std::string::npos) comma = s.size();
+    double q = 0.0;
+    try { q = std::stod(s.substr(pos, comma - pos)); } catch (...) { return false; }
+    if (q < 0.0 || q > 1.0) return false;
+    out.push_back(q);
+    pos = comma + 1;
+  }
+  return true;
+}
+
+// "1m", "5m", "1h", "90" (minutos) -> largura em minutos; false se inválido.
+static bool parse_window(const std::string& s, int& minutes) {
+  if (s.empty()) return false;
+  int mult = 1;
+  std::string num = s;
+  if (s.back() == 'm' || s.back() == 'h') {
+    mult = (s.back() == 'h') ? 60 : 1;
+    num.pop_back();
+  }
+  int v = 0;
+  try { v = std::stoi(num); } catch (...) { return false; }
+  if (v < 1) return false;
+  minutes = v * mult;
+  return true;
+}
+
 static int arg_int(const std::vector<std::string>& args, const std::string& key, int def) {
   auto v = arg_value(args, key, "");
   if (v.empty()) return def;
   try { return std::stoi(v); } catch (...) { return def; }
 }
 
+// Opções de agregação comuns ao modo normal e ao query; false (com a mensagem já
+// impressa) se alguma for inválida.
+static bool parse_aggregator_options(const std::vector<std::string>& args, logforge::AggregatorOptions& agg_opt) {
+  agg_opt.top_n = arg_int(args, "--top", 20);
+  agg_opt.endpoint_stats_capacity = static_cast<std::size_t>(std::max(0, arg_int(args, "--endpoint-stats", 0)));
+  // Com --endpoint-stats o top-K é sempre Space-Saving (memória limitada; ver AggregatorOptions).
+  const std::string topk_mode = arg_value(args, "--topk-mode", agg_opt.endpoint_stats_capacity > 0 ? "approx" : "exact");
+  if (topk_mode != "exact" && topk_mode != "approx") {
+    std::cerr << "Erro: --topk-mode deve ser exact ou approx.\n";
+    return false;
+  }
+  if (topk_mode == "exact" && agg_opt.endpoint_stats_capacity > 0) {
+    std::cerr << "Erro: --endpoint-stats usa --topk-mode approx (memória limitada); não combine com exact.\n";
+    return false;
+  }
+  agg_opt.topk_mode = (topk_mode == "approx") ? logforge::TopKMode::Approx : logforge::TopKMode::Exact;
+  agg_opt.topk_capacity = static_cast<std::size_t>(std::max(1, arg_int(args, "--topk-capacity", 10000)));
+  if (!parse_quantiles(arg_value(args, "--quantiles", ""), agg_opt.quantiles)) {
+    std::cerr << "Erro: --quantiles espera valores em [0, 1] separados por vírgula.\n";
+    return false;
+  }
+  if (!arg_double(args, "--latency-error", agg_opt.latency_error) || agg_opt.latency_error <= 0.0 ||
+      agg_opt.latency_error >= 1.0) {
+    std::cerr << "Erro: --latency-error deve estar em (0, 1).\n";
+    return false;
+  }
+
+  const std::string window = arg_value(args, "--window", "");
+  if (!window.empty()) {
+    if (!parse_window(window, agg_opt.windows.width_min)) {
+      std::cerr << "Erro: --window espera uma largura como 1m, 5m ou 1h.\n";
+      return false;
+    }
+    agg_opt.windows.ring = static_cast<std::size_t>(std::max(1, arg_int(args, "--window-retention", 60)));
+    agg_opt.windows.sliding = std::max(0, arg_int(args, "--sliding", 0));
+    // No --follow a memória fica limitada ao anel: janelas antigas são descartadas.
+    agg_opt.windows.keep_closed = !has_flag(args, "--follow");
+  }
+
+  // --hll-precision sozinho também liga o --unique-clients.
+  if (has_flag(args, "--unique-clients") || !arg_value(args, "--hll-precision", "").empty()) {
+    agg_opt.hll_precision = arg_int(args, "--hll-precision", logforge::HyperLogLog::kDefaultPrecision);
+    if (agg_opt.hll_precision < logforge::HyperLogLog::kMinPrecision ||
+        agg_opt.hll_precision > logforge::HyperLogLog::kMaxPrecision) {
+      std::cerr << "Erro: --hll-precision deve estar entre " << logforge::HyperLogLog::kMinPrecision << " e "
+                << logforge::HyperLogLog::kMaxPrecision << ".\n";
+      return false;
+    }
+  }
+
+  const std::string group_by = arg_value(args, "--group-by", "");
+  const std::string aggs = arg_value(args, "--agg", "");
+  if (!group_by.empty()) {
+    std::string err;
+    if (!logforge::parse_group_by(group_by, aggs, agg_opt.group_by, err)) {
+      std::cerr << "Erro: --group-by/--agg: " << err << "\n";
+      return false;
+    }
+  } else if (!aggs.empty()) {
+    std::cerr << "Erro: --agg exige --group-by.\n";
+    return false;
+  }
+  return true;
+}
+
+// --normalize / --normalize-rules (esta implica aquela); `active` aponta para `normalizer`
+// se ligado. false (com a mensagem já impressa) se as regras não carregarem.
+static bool setup_normalizer(const std::vector<std::string>& args, logforge::PathNormalizer& normalizer,
+                             const logforge::PathNormalizer*& active) {
+  const std::string rules_path = arg_value(args, "--normalize-rules", "");
+  if (!rules_path.empty()) {
+    std::string err;
+    if (!normalizer.load_rules(rules_path, err)) {
+      std::cerr << "Erro: --normalize-rules: " << err << "\n";
+      return false;
+    }
+  }
+  if (has_flag(args, "--normalize") || !rules_path.empty()) active = &normalizer;
+  return true;
+}
+
+// --where: compila em `filter` e aponta `active` para ele; false (com a mensagem já
+// impressa) se a expressão for inválida.
+static bool setup_filter(const std::vector<std::string>& args, logforge::Filter& filter,
+                         const logforge::Filter*& active) {
+  const std::string where = arg_value(args, "--where", "");
+  if (where.empty()) return true;
+  std::string err;
+  if (!filter.compile(where, err)) {
+    std::cerr << "Erro: --where: " << err << "\n";
+    return false;
+  }
+  active = &filter;
+  return true;
+}
+
+static bool setup_parser(const std::vector<std::string>& args, logforge::Isa isa,
+                         std::unique_ptr<logforge::Parser>& parser, const logforge::Parser*& active) {
+  logforge::FormatOptions fopt;
+  fopt.isa = isa;
+  fopt.name = arg_value(args, "--format", "nginx");
+  fopt.log_format = arg_value(args, "--log-format", "");
+  fopt.apache_format = arg_value(args, "--apache-format", "");
+  fopt.json_keys = arg_value(args, "--json-keys", "");
+  std::string err;
+  parser = logforge::make_parser(fopt, err);
+  if (!err.empty()) {
+    std::cerr << "Erro: formato: " << err << "\n";
+    return false;
+  }
+  active = parser.get();
+  return true;
+}
+
+static bool write_reports(const logforge::Report& report, int top_n, const std::string& out_dir) {
+  const auto view = logforge::make_report_view(report, top_n);
+  if (!logforge::write_reports(report, view, out_dir)) {
+    std::cerr << "Erro: falhou ao escrever report.json ou os CSVs em " << out_dir << "\n";
+    return false;
+  }
+  return true;
+}
+
+// "io_uring 4 (O_DIRECT em 4), stream 1": os leitores que rodaram, por fonte aberta.
+static std::string describe_sources(const logforge::SourceStats& s) {
+  std::string out;
+  auto add = [&](std::size_t n, const char* name) {
+    if (n == 0) return;
+    if (!out.empty()) out += ", ";
+    out += std::string(name) + " " + std::to_string(n);
+  };
+  add(s.mmap, "mmap");
+  add(s.uring, "io_uring");
+  add(s.pread, "pread");
+  if (s.direct) out += " (O_DIRECT em " + std::to_string(s.direct) + ")";
+  add(s.stream, "stream");
+  add(s.compressed, "descompressão");
+  return out.empty() ? "nenhuma fonte" : out;
+}
+
+// --stats: tempo por estágio (somado entre threads), motivos de recusa com amostras,
+// tamanho das estruturas do Aggregator e pico de memória.
+static void print_stats(const logforge::RunStats& st, const logforge::Aggregator& agg,
+                        const logforge::Report& report, const logforge::IngestStats& io, double ticks_per_ns) {
+  const auto lines = static_cast<double>(std::max<std::uint64_t>(report.total_lines, 1));
+  std::uint64_t total = 0;
+  for (auto t : st.ticks) total += t;
+
+  std::cout << "STATS\n";
+  std::cout << "  estagios (" << logforge::stats_clock_unit() << ", somados entre threads; linha a linha: 1 em "
+            << logforge::RunStats::kSampleEvery << " linhas, extrapolado):\n";
+  for (std::size_t i = 0; i < logforge::kStages; ++i) {
+    const auto t = st.ticks[i];
+    std::cout << "    " << std::left << std::setw(10) << logforge::stage_name(static_cast<logforge::Stage>(i))
+              << std::right << std::setw(14) << t << std::fixed << std::setprecision(1) << std::setw(7)
+              << (total ? 100.0 * static_cast<double>(t) / static_cast<double>(total) : 0.0) << "%  ~"
+              << static_cast<double>(t) / ticks_per_ns / lines << " ns/linha\n"
+              << std::defaultfloat;
+  }
+  if (io.sources.uring + io.sources.pread > 0) {
+    // Medida à parte (relógio de parede em cada espera), contida na leitura acima.
+    std::cout << "    espera de I/O (dentro da leitura): " << std::fixed << std::setprecision(1)
+              << io.sources.io_wait_sec * 1000.0 << " ms  ~" << io.sources.io_wait_sec * 1e9 / lines
+              << " ns/linha\n"
+              << std::defaultfloat;
+  }
+
+  std::cout << "  recusadas: " << report.invalid_lines << "\n";
+  for (std::size_t i = 0; i < logforge::kRejectReasons; ++i) {
+    if (st.rejects[i] == 0) continue;
+    std::cout << "    " << logforge::reject_reason_name(static_cast<logforge::RejectReason>(i)) << ": "
+              << st.rejects[i] << "\n";
+  }
+  for (const auto& s : st.samples) {
+    std::cout << "    exemplo [" << logforge::reject_reason_name(s.reason) << "]: " << s.line << "\n";
+  }
+
+  std::cout << "  estruturas:\n";
+  for (const auto& t : agg.table_stats()) {
+    std::cout << "    " << t.name << ": " << t.size;
+    if (t.capacity) {
+      std::cout << " / " << t.capacity << " (ocupacao " << std::fixed << std::setprecision(2)
+                << static_cast<double>(t.size) / static_cast<double>(t.capacity) << ")" << std::defaultfloat;
+    }
+    if (t.bytes) std::cout << ", ~" << (t.bytes + 1023) / 1024 << " KiB";
+    std::cout << "\n";
+  }
+  if (const auto rss = logforge::peak_rss_kib()) std::cout << "  pico de RSS: " << rss << " KiB\n";
+}
+
+// logforge merge a.snap b.snap ... --out dir [--top N] [--snapshot merged.snap]
+static int run_merge(const std::vector<std::string>& args) {
+  std::vector<std::string> specs;
+  for (std::size_t i = 1; i < args.size() && args[i].rfind("--", 0) != 0; ++i) specs.push_back(args[i]);
+  if (specs.empty()) {
+    std::cerr << "Erro: merge espera um ou mais snapshots.\n\n";
+    usage();
+    return 2;
+  }
+
+  std::vector<std::string> paths;
+  std::string err;
+  if (!logforge::expand_inputs(specs, paths, err)) {
+    std::cerr << "Erro: merge: " << err << "\n";
+    return 2;
+  }
+
+  const auto t0 = SteadyClock::now();
+  logforge::Aggregator agg;
+  if (!logforge::merge_snapshots(paths, agg, err)) {
+    std::cerr << "Erro: merge: " << err << "\n";
+    return 2;
+  }
+  const auto report = agg.finalize();
+  const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(SteadyClock::now() - t0).count();
+
+  const std::string out_dir = arg_value(args, "--out", "out");
+  const std::string snapshot_path = arg_value(args, "--snapshot", "");
+  std::filesystem::create_directories(out_dir);
+  if (!snapshot_path.empty() && !logforge::write_snapshot(agg, snapshot_path)) {
+    std::cerr << "Erro: falhou ao escrever snapshot: " << snapshot_path << "\n";
+    return 3;
+  }
+  if (!write_reports(report, arg_int(args, "--top", agg.top_n()), out_dir)) return 3;
+
+  std::cout << "OK ✅\n";
+  std::cout << "  snapshots=" << paths.size() << " total_lines=" << report.total_lines
+            << " parsed=" << report.parsed_lines << " invalid=" << report.invalid_lines << "\n";
+  std::cout << "  wrote: " << out_dir << "/report.json + CSVs\n";
+  std::cout << "  time: " << ms << " ms\n";
+  return 0;
+}
+
+// "404", "500-599" ou "5xx" -> faixa inclusiva; false se inválido.
+static bool parse_status_range(const std::string& s, int& lo, int& hi) {
+  try {
+    if (s.size() == 3 && s[1] == 'x' && s[2] == 'x' && s[0] >= '1' && s[0] <= '9') {
+      lo = (s[0] - '0') * 100;
+      hi = lo + 99;
+      return true;
+    }
+    const auto dash = s.find('-');
+    std::size_t used = 0;
+    lo = std::stoi(s.substr(0, dash), &used);
+    if (used != (dash == std::string::npos ? s.size() : dash)) return false;
+    hi = lo;
+    if (dash != std::string::npos) {
+      const std::string rest = s.substr(dash + 1);
+      hi = std::stoi(rest, &used);
+      if (used != rest.size()) return false;
+    }
+  } catch (...) {
+    return false;
+  }
+  return lo <= hi;
+}
+
+// --reader mmap|stream|uring e --direct (só com uring) -> opt.reader / opt.direct_io.
+static bool parse_reader(const std::vector<std::string>& args, logforge::IngestOptions& opt) {
+  const std::string reader = arg_value(args, "--reader", "mmap");
+  if (reader == "mmap") opt.reader = logforge::ReaderKind::Mmap;
+  else if (reader == "stream") opt.reader = logforge::ReaderKind::Stream;
+  else if (reader == "uring") opt.reader = logforge::ReaderKind::Async;
+  else {
+    std::cerr << "Erro: --reader deve ser mmap, stream ou uring.\n";
+    return false;
+  }
+  opt.direct_io = has_flag(args, "--direct");
+  if (opt.direct_io && opt.reader != logforge::ReaderKind::Async) {
+    std::cerr << "Erro: --direct só vale com --reader uring.\n";
+    return false;
+  }
+  return true;
+}
+
+// logforge index --in ... --index arquivo.lfx
+static int run_index(const std::vector<std::string>& args) {
+  const std::vector<std::string> in_specs = arg_values(args, "--in");
+  const std::string index_path = arg_value(args, "--index", "");
+  if (in_specs.empty() || index_path.empty()) {
+    std::cerr << "Erro: index espera --in e --index.\n\n";
+    usage();
+    return 2;
+  }
+  logforge::IngestOptions opt;
+  if (!parse_reader(args, opt)) return 2;
+  const std::string isa_arg = arg_value(args, "--isa", "auto");
+  if (!logforge::parse_isa(isa_arg, opt.isa) || !logforge::isa_supported(opt.isa)) {
+    std::cerr << "Erro: --isa inválida ou não suportada nesta CPU: " << isa_arg << "\n";
+    return 2;
+  }
+  std::unique_ptr<logforge::Parser> parser;
+  if (!setup_parser(args, opt.isa, parser, opt.parser)) return 2;
+
+  std::vector<std::string> inputs;
+  std::string err;
+  if (!logforge::expand_inputs(in_specs, inputs, err)) {
+    std::cerr << "Erro: --in: " << err << "\n";
+    return 2;
+  }
+
+  const auto t0 = SteadyClock::now();
+  logforge::IndexBuildStats st;
+  if (!logforge::build_index(inputs, opt, index_path, &st, err)) {
+    std::cerr << "Erro: index: " << err << "\n";
+    return 3;
+  }
+  const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(SteadyClock::now() - t0).count();
+
+  std::cout << "OK ✅\n";
+  std::cout << "  total_lines=" << st.total_lines << " indexed=" << st.rows << " invalid=" << (st.total_lines - st.rows)
+            << "\n";
+  std::cout << "  blocks=" << st.blocks << " endpoints=" << st.endpoints << " bytes=" << st.bytes << "\n";
+  std::cout << "  wrote: " << index_path << "\n";
+  std::cout << "  time: " << ms << " ms\n";
+  return 0;
+}
+
+// logforge query --index arquivo.lfx --out dir [--from T] [--to T] [--status R] [...]
+static int run_query(const std::vector<std::string>& args) {
+  const std::string index_path = arg_value(args, "--index", "");
+  if (index_path.empty()) {
+    std::cerr << "Erro: query espera --index.\n\n";
+    usage();
+    return 2;
+  }
+  logforge::AggregatorOptions agg_opt;
+  if (!parse_aggregator_options(args, agg_opt)) return 2;
+  if (!logforge::index_can_group(agg_opt.group_by)) {
+    std::cerr << "Erro: o índice não guarda method, ip, ua nem bytes; use --group-by/--agg só com endpoint, "
+                 "status, status_class, minute e latência, ou rode sobre o texto.\n";
+    return 2;
+  }
+  if (agg_opt.hll_precision != 0) {
+    std::cerr << "Erro: --unique-clients precisa do endereço do cliente, que o índice não guarda; rode sobre o texto.\n";
+    return 2;
+  }
+  logforge::PathNormalizer normalizer;
+  const logforge::PathNormalizer* active = nullptr;
+  if (!setup_normalizer(args, normalizer, active)) return 2;
+
+  logforge::IndexQuery q;
+  for (const char* key : {"--from", "--to"}) {
+    const std::string v = arg_value(args, key, "");
+    if (v.empty()) continue;
+    const auto m = logforge::parse_minute_text(v);
+    if (!m) {
+      std::cerr << "Erro: " << key << " espera \"AAAA-MM-DD HH:MM\" ou \"AAAA-MM-DD\".\n";
+      return 2;
+    }
+    (std::string(key) == "--from" ? q.from_minute : q.to_minute) = *m;
+  }
+  const std::string status = arg_value(args, "--status", "");
+  if (!status.empty() && !parse_status_range(status, q.status_min, q.status_max)) {
+    std::cerr << "Erro: --status espera 404, 500-599 ou 5xx.\n";
+    return 2;
+  }
+  logforge::Filter filter;
+  if (!setup_filter(args, filter, q.where)) return 2;
+
+  const auto t0 = SteadyClock::now();
+  logforge::ColumnIndex index;
+  std::string err;
+  if (!index.open(index_path, err)) {
+    std::cerr << "Erro: query: " << err << "\n";
+    return 2;
+  }
+  logforge::Aggregator agg(agg_opt);
+  logforge::IndexScanStats st;
+  logforge::query_index(index, q, active, arg_int(args, "--threads", 1), agg, &st);
+  const auto report = agg.finalize();
+  const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(SteadyClock::now() - t0).count();
+  const double sec = ms / 1000.0;
+  const double lps = (sec > 0.0) ? (static_cast<double>(st.rows_scanned) / sec) : 0.0;
+
+  if (has_flag(args, "--bench")) {
+    std::cout << "BENCH\n";
+    std::cout << "  linhas no índice: " << index.rows() << "\n";
+    std::cout << "  blocos: " << st.blocks << " (" << st.blocks_skipped << " pulados pelo zone map)\n";
+    std::cout << "  linhas varridas: " << st.rows_scanned << " (" << st.rows_matched << " no filtro)\n";
+    std::cout << "  tempo: " << ms << " ms\n";
+    std::cout << "  throughput: " << lps << " linhas/s\n";
+    return 0;
+  }
+
+  const std::string out_dir = arg_value(args, "--out", "out");
+  std::filesystem::create_directories(out_dir);
+  const std::string snapshot_path = arg_value(args, "--snapshot", "");
+  if (!snapshot_path.empty() && !logforge::write_snapshot(agg, snapshot_path)) {
+    std::cerr << "Erro: falhou ao escrever snapshot: " << snapshot_path << "\n";
+    return 3;
+  }
+  if (!write_reports(report, agg_opt.top_n, out_dir)) return 3;
+
+  std::cout << "OK ✅\n";
+  std::cout << "  total_lines=" << report.total_lines << " parsed=" << report.parsed_lines
+            << " invalid=" << report.invalid_lines << " filtered=" << report.filtered_lines << "\n";
+  std::cout << "  blocks=" << st.blocks << " skipped=" << st.blocks_skipped << " scanned=" << st.rows_scanned
+            << " matched=" << st.rows_matched << "\n";
+  std::cout << "  wrote: " << out_dir << "/report.json + CSVs\n";
+  std::cout << "  time: " << ms << " ms\n";
+  return 0;
+}
+
 int main(int argc, char** argv) {
   std::vector<std::string> args(argv + 1, argv + argc);
 
@@ -46,13 +534,30 @@ int main(int argc, char** argv) {
     usage();
     return 0;
   }
+  if (args[0] == "merge") return run_merge(args);
+  if (args[0] == "index") return run_index(args);
+  if (args[0] == "query") return run_query(args);
 
-  const std::string in_path = arg_value(args, "--in", "");
+  const std::vector<std::string> in_specs = arg_values(args, "--in");
   const std::string out_dir = arg_value(args, "--out", "out");
   const int top_n = arg_int(args, "--top", 20);
+  const int threads = arg_int(args, "--threads", 1);
+  const std::string reader = arg_value(args, "--reader", "mmap");
+  const std::string isa_arg = arg_value(args, "--isa", "auto");
   const bool bench = has_flag(args, "--bench");
+  const std::string snapshot_path = arg_value(args, "--snapshot", "");
+
+  logforge::AggregatorOptions agg_opt;
+  if (!parse_aggregator_options(args, agg_opt)) return 2;
+  if (has_flag(args, "--stats")) {
+    if (!logforge::kStatsCompiled) {
+      std::cerr << "Erro: --stats não está disponível neste build (compilado com -DLOGFORGE_WITH_STATS=OFF).\n";
+      return 2;
+    }
+    agg_opt.stats = true;
+  }
 
-  if (in_path.empty()) {
+  if (in_specs.empty()) {
     std::cerr << "Erro: --in é obrigatório.\n\n";
     usage();
     return 2;
@@ -60,59 +565,195 @@ int main(int argc, char** argv) {
 
   std::filesystem::create_directories(out_dir);
 
-  logforge::BufferedLineReader reader(in_path);
-  if (!reader.ok()) {
-    std::cerr << "Erro: não foi possível abrir: " << in_path << "\n";
+  logforge::Isa isa{};
+  if (!logforge::parse_isa(isa_arg, isa) || !logforge::isa_supported(isa)) {
+    std::cerr << "Erro: --isa inválida ou não suportada nesta CPU: " << isa_arg << "\n";
     return 2;
   }
 
-  logforge::NginxParser parser;
-  logforge::Aggregator agg(top_n);
+  logforge::IngestOptions opt;
+  opt.threads = threads;
+  if (!parse_reader(args, opt)) return 2;
+  opt.isa = isa;
+  opt.batch = !has_flag(args, "--no-batch");
+
+  logforge::PathNormalizer normalizer;
+  if (!setup_normalizer(args, normalizer, opt.normalizer)) return 2;
+  logforge::Filter filter;
+  if (!setup_filter(args, filter, opt.filter)) return 2;
+  std::unique_ptr<logforge::Parser> parser;
+  if (!setup_parser(args, opt.isa, parser, opt.parser)) return 2;
+
+  std::vector<std::string> inputs;
+  std::string in_err;
+  if (!logforge::expand_inputs(in_specs, inputs, in_err)) {
+    std::cerr << "Erro: --in: " << in_err << "\n";
+    return 2;
+  }
+  for (const auto& path : inputs) {
+    const auto c = logforge::detect_compression(path);
+    if (!logforge::compression_supported(c)) {
+      std::cerr << "Erro: entrada " << logforge::compression_name(c) << " não suportada neste build "
+                << "(biblioteca ausente na compilação): " << path << "\n";
+      return 2;
+    }
+  }
+
+  logforge::Aggregator agg(agg_opt);
+
+  if (has_flag(args, "--follow")) {
+    if (inputs.size() != 1 || logforge::detect_compression(inputs[0]) != logforge::Compression::None) {
+      std::cerr << "Erro: --follow aceita um único arquivo, não comprimido.\n";
+      return 2;
+    }
+    const std::string& in_path = inputs[0];
+    logforge::FollowOptions fopt;
+    fopt.interval_sec = std::max(1, arg_int(args, "--interval", 10));
+    fopt.stop = &g_stop;
+    std::signal(SIGINT, on_stop_signal);
+    std::signal(SIGTERM, on_stop_signal);
+
+    std::cout << "Acompanhando " << in_path << " (report.json a cada " << fopt.interval_sec
+              << " s; Ctrl+C para encerrar)\n";
+    logforge::FollowStats fstats;
+    if (!logforge::follow_file(in_path, out_dir, opt, fopt, agg, &fstats)) {
+      std::cerr << "Erro: falhou ao acompanhar " << in_path << " ou ao escrever relatórios\n";
+      return 3;
+    }
+    std::cout << "OK ✅\n";
+    std::cout << "  bytes=" << fstats.bytes << " snapshots=" << fstats.snapshots
+              << " rotations=" << fstats.rotations << " truncations=" << fstats.truncations << "\n";
+    std::cout << "  wrote: " << out_dir << "/report.json + CSVs\n";
+    return 0;
+  }
 
-  std::string line;
+  std::unique_ptr<logforge::PerfCounters> perf;
+  if (bench) {
+    perf = std::make_unique<logforge::PerfCounters>();
+    perf->start();
+  }
+  const std::uint64_t c0 = logforge::stats_clock();
   auto t0 = SteadyClock::now();
 
-  while (reader.next_line(line)) {
-    auto entry = parser.parse_line(line);
-    if (entry) agg.add_valid(*entry);
-    else agg.add_invalid();
+  logforge::IngestStats istats;
+  if (!logforge::ingest_files(inputs, opt, agg, &istats)) {
+    std::cerr << "Erro: não foi possível abrir: " << istats.failed_path << "\n";
+    return 2;
   }
 
+  const std::uint64_t c1 = logforge::stats_clock();
   auto report = agg.finalize();
   auto t1 = SteadyClock::now();
+  if (logforge::RunStats* st = agg.stats()) st->add(logforge::Stage::Finalize, logforge::stats_clock() - c1);
+  // Ciclos TSC por ns, calibrado contra o steady_clock na própria execução.
+  auto ticks_per_ns = [&] {
+    const double ns = std::chrono::duration<double, std::nano>(SteadyClock::now() - t0).count();
+    return ns > 0.0 ? static_cast<double>(logforge::stats_clock() - c0) / ns : 1.0;
+  };
+  const auto counters = perf ? perf->stop() : std::vector<logforge::PerfCounters::Reading>{};
 
   const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count();
   const double sec = ms / 1000.0;
   const double lps = (sec > 0.0) ? (static_cast<double>(report.total_lines) / sec) : 0.0;
 
   if (bench) {
+    // Bytes de entrada como estão no disco (comprimidos, no caso de gzip/zstd).
+    std::uint64_t in_bytes = 0;
+    for (const auto& path : inputs) {
+      std::error_code ec;
+      const auto n = std::filesystem::file_size(path, ec);
+      if (!ec) in_bytes += static_cast<std::uint64_t>(n);
+    }
+    const double mb_in = static_cast<double>(in_bytes) / (1024.0 * 1024.0);
     std::cout << "BENCH\n";
+    std::cout << "  threads: " << threads << "\n";
+    const logforge::SourceStats& src = istats.sources;
+    std::cout << "  reader: " << reader << (opt.direct_io ? " --direct" : "") << " (pedido); usado: "
+              << describe_sources(src) << "\n";
+    std::cout << "  isa: " << logforge::isa_name(isa) << "\n";
+    const std::string batches = "lotes de até " + std::to_string(logforge::EntryBatch::kCapacity) + " linhas";
+    std::cout << "  pipeline: "
+              << (src.batched == 0                  ? std::string("uma linha por vez")
+                  : src.batched == src.sources() ? batches
+                                                  : batches + " em " + std::to_string(src.batched) + " de " +
+                                                        std::to_string(src.sources()) +
+                                                        " fontes, as demais uma linha por vez")
+              << "\n";
+    if (src.uring + src.pread > 0) {
+      std::cout << "  espera de I/O: " << src.io_wait_sec * 1000.0
+                << " ms (leitor assíncrono parado esperando bloco, somado entre threads)\n";
+    }
+    std::cout << "  formato: "
+              << (!arg_value(args, "--log-format", "").empty()      ? "--log-format"
+                  : !arg_value(args, "--apache-format", "").empty() ? "--apache-format"
+                  : !arg_value(args, "--json-keys", "").empty()     ? "json"
+                                                                    : arg_value(args, "--format", "nginx"))
+              << "\n";
     std::cout << "  linhas: " << report.total_lines << "\n";
     std::cout << "  invalidas: " << report.invalid_lines << "\n";
+    if (opt.filter) std::cout << "  filtradas (--where): " << report.filtered_lines << "\n";
+    std::cout << "  endpoints distintos: " << report.endpoint_counts.size() << "\n";
+    if (report.group_by_enabled) std::cout << "  grupos (--group-by): " << report.group_by.size() << "\n";
     std::cout << "  tempo: " << ms << " ms\n";
-    std::cout << "  throughput: " << lps << " linhas/s\n";
+    std::cout << "  throughput: " << lps << " linhas/s, " << (sec > 0.0 ? mb_in / sec : 0.0)
+              << " MB/s (" << mb_in << " MB lidos)\n";
+    if (report.total_lines > 0) {
+      const double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+      std::cout << "  por linha: " << ns / static_cast<double>(report.total_lines) << " ns\n";
+    }
+    if (!perf->available()) {
+      std::cout << "  contadores de hardware: indisponíveis (" << perf->error() << ")\n";
+    }
+    for (const auto& c : counters) {
+      std::cout << "  " << c.name << ": " << c.value;
+      if (report.total_lines > 0)
+        std::cout << " (" << static_cast<double>(c.value) / static_cast<double>(report.total_lines) << " por linha)";
+      std::cout << "\n";
+    }
+    if (istats.files > 1) {
+      std::cout << "  arquivos: " << istats.files << " (" << istats.tasks << " pedaços, " << istats.steals
+                << " roubados)\n";
+    }
+    if (istats.compression != logforge::Compression::None) {
+      // Por núcleo: descompressão e parse rodam em threads separadas, sobrepostos.
+      const double mb = static_cast<double>(istats.decompressed_bytes) / (1024.0 * 1024.0);
+      std::cout << "  compressao: " << logforge::compression_name(istats.compression) << " ("
+                << istats.streams << " fluxo(s))\n";
+      std::cout << "  descompressao: " << (istats.decompress_sec > 0.0 ? mb / istats.decompress_sec : 0.0)
+                << " MB/s (" << mb << " MB descomprimidos)\n";
+      std::cout << "  parse: "
+                << (istats.parse_sec > 0.0 ? static_cast<double>(report.total_lines) / istats.parse_sec : 0.0)
+                << " linhas/s (sem a espera pela descompressão)\n";
+    }
+    if (const logforge::RunStats* st = agg.stats()) print_stats(*st, agg, report, istats, ticks_per_ns());
     return 0;
   }
 
-  // Escreve relatórios
-  if (!logforge::write_report_json(report, out_dir, top_n)) {
-    std::cerr << "Erro: falhou ao escrever report.json\n";
-    return 3;
-  }
-  if (!logforge::write_report_csv(report, out_dir, top_n)) {
-    std::cerr << "Erro: falhou ao escrever CSVs\n";
+  if (!snapshot_path.empty() && !logforge::write_snapshot(agg, snapshot_path)) {
+    std::cerr << "Erro: falhou ao escrever snapshot: " << snapshot_path << "\n";
     return 3;
   }
+  const std::uint64_t c2 = logforge::stats_clock();
+  if (!write_reports(report, top_n, out_dir)) return 3;
+  if (logforge::RunStats* st = agg.stats()) st->add(logforge::Stage::Write, logforge::stats_clock() - c2);
 
   std::cout << "OK ✅\n";
   std::cout << "  total_lines=" << report.total_lines
             << " parsed=" << report.parsed_lines
-            << " invalid=" << report.invalid_lines << "\n";
+            << " invalid=" << report.invalid_lines;
+  if (opt.filter) std::cout << " filtered=" << report.filtered_lines;
+  std::cout << "\n";
   std::cout << "  latency_ms: count=" << report.latency.count
             << " avg=" << report.latency.avg_ms
             << " p95~=" << report.latency.p95_ms << "\n";
+  if (report.unique_clients_enabled) {
+    std::cout << "  unique_clients~=" << report.unique_clients << " (±" << report.unique_clients_error * 100.0
+              << "%)\n";
+  }
   std::cout << "  wrote: " << out_dir << "/report.json + CSVs\n";
+  if (!snapshot_path.empty()) std::cout << "  snapshot: " << snapshot_path << "\n";
   std::cout << "  time: " << ms << " ms (" << lps << " linhas/s)\n";
+  if (const logforge::RunStats* st = agg.stats()) print_stats(*st, agg, report, istats, ticks_per_ns());
 
   return 0;
 }
@@ -0,0 +1,71 @@
+#include "logforge/mmap_reader.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace logforge {
+
+MmapLineReader::MmapLineReader(const std::string& path, ByteRange range) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return;
+
+  struct stat st {};
+  if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    ::close(fd);
+    return;
+  }
+
+  size_ = static_cast<std::size_t>(st.st_size);
+  pos_ = static_cast<std::size_t>(std::min<std::uint64_t>(range.begin, size_));
+  end_ = static_cast<std::size_t>(std::min<std::uint64_t>(range.end, size_));
+
+  if (size_ == 0) {
+    ::close(fd);
+    ok_ = true; // arquivo vazio: nada a ler
+    return;
+  }
+
+  void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd); // o mapeamento continua válido sem o fd
+  if (p == MAP_FAILED) return;
+  data_ = static_cast<const char*>(p);
+
+  // Dicas ao kernel: leitura sequencial (read-ahead agressivo) e, se suportado, huge pages.
+  // Falhas aqui não são erros.
+  const auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+  const std::size_t adv_begin = pos_ / page * page;
+  if (end_ > adv_begin) {
+    void* adv = const_cast<char*>(data_ + adv_begin);
+    ::madvise(adv, end_ - adv_begin, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+    ::madvise(adv, end_ - adv_begin, MADV_HUGEPAGE);
+#endif
+  }
+  ok_ = true;
+}
+
+MmapLineReader::~MmapLineReader() {
+  if (data_) ::munmap(const_cast<char*>(data_), size_);
+}
+
+bool MmapLineReader::next_line(std::string_view& out) {
+  if (pos_ >= end_) return false;
+
+  // A linha pode terminar depois de end_ (só precisa começar dentro da faixa).
+  const char* begin = data_ + pos_;
+  const auto* nl = static_cast<const char*>(std::memchr(begin, '\n', size_ - pos_));
+  if (nl) {
+    out = std::string_view(begin, static_cast<std::size_t>(nl - begin));
+    pos_ += out.size() + 1;
+  } else {
+    out = std::string_view(begin, size_ - pos_);
+    pos_ = size_;
+  }
+  return true;
+}
+
+} // namespace logforge
@@ -0,0 +1,169 @@
+#include "logforge/nginx_scan.hpp"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LOGFORGE_X86 1
+#endif
+
+namespace logforge {
+
+Isa detect_isa() {
+#ifdef LOGFORGE_X86
+  if (__builtin_cpu_supports("avx2")) return Isa::Avx2;
+  if (__builtin_cpu_supports("sse2")) return Isa::Sse2;
+#endif
+  return Isa::Scalar;
+}
+
+bool isa_supported(Isa isa) {
+  switch (isa) {
+    case Isa::Scalar: return true;
+#ifdef LOGFORGE_X86
+    case Isa::Sse2: return __builtin_cpu_supports("sse2");
+    case Isa::Avx2: return __builtin_cpu_supports("avx2");
+#else
+    default: return false;
+#endif
+  }
+  return false;
+}
+
+const char* isa_name(Isa isa) {
+  switch (isa) {
+    case Isa::Scalar: return "scalar";
+    case Isa::Sse2: return "sse2";
+    case Isa::Avx2: return "avx2";
+  }
+  return "?";
+}
+
+bool parse_isa(std::string_view name, Isa& out) {
+  if (name == "auto") out = detect_isa();
+  else if (name == "scalar") out = Isa::Scalar;
+  else if (name == "sse2") out = Isa::Sse2;
+  else if (name == "avx2") out = Isa::Avx2;
+  else return false;
+  return true;
+}
+
+std::size_t StructuralMasks::next(const std::uint64_t* m, std::size_t from) const {
+  if (from >= len) return npos;
+  std::size_t w = from / 64;
+  std::uint64_t bits = m[w] & (~std::uint64_t{0} << (from % 64));
+  const std::size_t words = (len + 63) / 64;
+  while (true) {
+    if (bits) return w * 64 + static_cast<std::size_t>(__builtin_ctzll(bits));
+    if (++w >= words) return npos;
+    bits = m[w];
+  }
+}
+
+std::size_t StructuralMasks::prev(const std::uint64_t* m, std::size_t before) const {
+  if (before > len) before = len;
+  if (before == 0) return npos;
+  std::size_t w = (before - 1) / 64;
+  const unsigned keep = static_cast<unsigned>((before - 1) % 64) + 1; // bits [0, keep)
+  std::uint64_t bits = m[w] & (keep == 64 ? ~std::uint64_t{0} : ((std::uint64_t{1} << keep) - 1));
+  while (true) {
+    if (bits) return w * 64 + 63 - static_cast<std::size_t>(__builtin_clzll(bits));
+    if (w == 0) return npos;
+    bits = m[--w];
+  }
+}
+
+// --- Um bloco de 64 bytes por ISA --------------------------------------------
+
+static inline void block_scalar(const char* p, std::uint64_t& o, std::uint64_t& c, std::uint64_t& q,
+                                std::uint64_t& s) {
+  o = c = q = s = 0;
+  for (unsigned i = 0; i < 64; ++i) {
+    const std::uint64_t bit = std::uint64_t{1} << i;
+    switch (p[i]) {
+      case '[': o |= bit; break;
+      case ']': c |= bit; break;
+      case '"': q |= bit; break;
+      case ' ': s |= bit; break;
+      default: break;
+    }
+  }
+}
+
+#ifdef LOGFORGE_X86
+static inline void block_sse2(const char* p, std::uint64_t& o, std::uint64_t& c, std::uint64_t& q,
+                              std::uint64_t& s) {
+  const __m128i vo = _mm_set1_epi8('['), vc = _mm_set1_epi8(']');
+  const __m128i vq = _mm_set1_epi8('"'), vs = _mm_set1_epi8(' ');
+  o = c = q = s = 0;
+  for (unsigned i = 0; i < 4; ++i) {
+    const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * i));
+    const unsigned sh = 16 * i;
+    o |= std::uint64_t(unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(x, vo)))) << sh;
+    c |= std::uint64_t(unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(x, vc)))) << sh;
+    q |= std::uint64_t(unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(x, vq)))) << sh;
+    s |= std::uint64_t(unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(x, vs)))) << sh;
+  }
+}
+
+__attribute__((target("avx2"))) static inline std::uint64_t eq_mask_avx2(__m256i lo, __m256i hi,
+                                                                       char ch) {
+  const __m256i v = _mm256_set1_epi8(ch);
+  const auto l = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, v)));
+  const auto h = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, v)));
+  return (std::uint64_t{h} << 32) | l;
+}
+
+__attribute__((target("avx2"))) static inline void block_avx2(const char* p, std::uint64_t& o,
+                                                              std::uint64_t& c, std::uint64_t& q,
+                                                              std::uint64_t& s) {
+  const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32));
+  o = eq_mask_avx2(lo, hi, '[');
+  c = eq_mask_avx2(lo, hi, ']');
+  q = eq_mask_avx2(lo, hi, '"');
+  s = eq_mask_avx2(lo, hi, ' ');
+}
+#endif
+
+template <void (*Block)(const char*, std::uint64_t&, std::uint64_t&, std::uint64_t&, std::uint64_t&)>
+static void build_with(std::string_view line, StructuralMasks& m) {
+  const std::size_t full = line.size() / 64;
+  for (std::size_t w = 0; w < full; ++w) {
+    Block(line.data() + 64 * w, m.open[w], m.close[w], m.quote[w], m.space[w]);
+  }
+  if (const std::size_t tail = line.size() % 64) {
+    // Último bloco parcial: copia para um buffer zerado (o '\0' não casa com nenhum delimitador).
+    alignas(64) char buf[64] = {};
+    std::memcpy(buf, line.data() + 64 * full, tail);
+    Block(buf, m.open[full], m.close[full], m.quote[full], m.space[full]);
+  }
+}
+
+#ifdef LOGFORGE_X86
+// Mesmo laço de build_with, mas compilado com AVX2 para que block_avx2 seja inlinado.
+__attribute__((target("avx2"))) static void build_avx2(std::string_view line, StructuralMasks& m) {
+  const std::size_t full = line.size() / 64;
+  for (std::size_t w = 0; w < full; ++w) {
+    block_avx2(line.data() + 64 * w, m.open[w], m.close[w], m.quote[w], m.space[w]);
+  }
+  if (const std::size_t tail = line.size() % 64) {
+    alignas(64) char buf[64] = {};
+    std::memcpy(buf, line.data() + 64 * full, tail);
+    block_avx2(buf, m.open[full], m.close[full], m.quote[full], m.space[full]);
+  }
+}
+#endif
+
+void build_masks(Isa isa, std::string_view line, StructuralMasks& out) {
+  out.len = line.size();
+  switch (isa) {
+#ifdef LOGFORGE_X86
+    case Isa::Avx2: build_avx2(line, out); return;
+    case Isa::Sse2: build_with<block_sse2>(line, out); return;
+#endif
+    default: build_with<block_scalar>(line, out); return;
+  }
+}
+
+} // namespace logforge
@@ -0,0 +1,66 @@
+#include "logforge/out_buffer.hpp"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace logforge {
+
+OutBuffer::~OutBuffer() {
+  if (fd_ >= 0) ::close(fd_);
+}
+
+bool OutBuffer::open(const std::string& path) {
+  if (fd_ >= 0) ::close(fd_);
+  fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666); // menos o umask
+  ok_ = fd_ >= 0;
+  len_ = 0;
+  return ok_;
+}
+
+bool OutBuffer::close() {
+  flush();
+  if (fd_ >= 0 && ::close(fd_) != 0) ok_ = false;
+  fd_ = -1;
+  return ok_;
+}
+
+void OutBuffer::flush() {
+  write_all(buf_.get(), len_);
+  len_ = 0;
+}
+
+// Maior que o espaço livre: completa o buffer, e o que ainda passar de um buffer inteiro
+// vai direto para o arquivo.
+void OutBuffer::write_long(std::string_view s) {
+  const std::size_t head = kCapacity - len_;
+  s.copy(buf_.get() + len_, head);
+  len_ = kCapacity;
+  flush();
+  s.remove_prefix(head);
+  if (s.size() >= kCapacity) {
+    write_all(s.data(), s.size());
+  } else {
+    s.copy(buf_.get(), s.size());
+    len_ = s.size();
+  }
+}
+
+void OutBuffer::write_all(const char* p, std::size_t n) {
+  if (fd_ < 0) {
+    ok_ = ok_ && n == 0;
+    return;
+  }
+  while (n > 0 && ok_) {
+    const ssize_t w = ::write(fd_, p, n);
+    if (w < 0) {
+      if (errno == EINTR) continue;
+      ok_ = false;
+      break;
+    }
+    p += w;
+    n -= static_cast<std::size_t>(w);
+  }
+}
+
+} // namespace logforge
@@ -1,11 +1,14 @@
 #include "logforge/parser_nginx.hpp"
 
+#include <algorithm>
 #include <charconv>
 #include <cctype>
-#include <cstdio>
+#include <cmath>
 #include <cstdlib>
 #include <string>
 
+#include "logforge/time_util.hpp"
+
 namespace logforge {
 
 static inline std::string_view ltrim(std::string_view sv) {
@@ -54,77 +57,107 @@ static inline bool parse_double_sv(std::string_view sv, double& out) {
 #endif
 }
 
-std::string NginxParser::strip_query(std::string_view path) {
+static inline bool is_space(char c) { return std::isspace(static_cast<unsigned char>(c)) != 0; }
+
+static inline std::string_view strip_query(std::string_view path) {
   auto q = path.find('?');
-  if (q == std::string_view::npos) return std::string(path);
-  return std::string(path.substr(0, q));
-}
-
-int NginxParser::month_to_int(std::string_view mon) {
-  if (mon == "Jan") return 1;
-  if (mon == "Feb") return 2;
-  if (mon == "Mar") return 3;
-  if (mon == "Apr") return 4;
-  if (mon == "May") return 5;
-  if (mon == "Jun") return 6;
-  if (mon == "Jul") return 7;
-  if (mon == "Aug") return 8;
-  if (mon == "Sep") return 9;
-  if (mon == "Oct") return 10;
-  if (mon == "Nov") return 11;
-  if (mon == "Dec") return 12;
-  return 0;
-}
-
-std::optional<std::string> NginxParser::parse_minute_key(std::string_view t) {
-  // "10/Oct/2000:13:55:36 -0700" -> "2000-10-10 13:55"
-  auto slash1 = t.find('/');
-  if (slash1 == std::string_view::npos) return std::nullopt;
-  auto slash2 = t.find('/', slash1 + 1);
-  if (slash2 == std::string_view::npos) return std::nullopt;
-  auto colon1 = t.find(':', slash2 + 1);
-  if (colon1 == std::string_view::npos) return std::nullopt;
-
-  std::string_view day_sv = t.substr(0, slash1);
-  std::string_view mon_sv = t.substr(slash1 + 1, slash2 - (slash1 + 1));
-  std::string_view year_sv = t.substr(slash2 + 1, colon1 - (slash2 + 1));
-
-  // HH:MM (logo depois do primeiro ':')
-  if (colon1 + 4 >= t.size()) return std::nullopt;
-  std::string_view hh_sv = t.substr(colon1 + 1, 2);
-  std::string_view mm_sv = t.substr(colon1 + 4, 2);
-
-  int day = 0, year = 0, hh = 0, mm = 0;
-  if (!parse_int_sv(day_sv, day)) return std::nullopt;
-  if (!parse_int_sv(year_sv, year)) return std::nullopt;
-  if (!parse_int_sv(hh_sv, hh)) return std::nullopt;
-  if (!parse_int_sv(mm_sv, mm)) return std::nullopt;
-
-  int mon = month_to_int(mon_sv);
-  if (mon == 0) return std::nullopt;
-
-  char buf[17];  // "YYYY-MM-DD HH:MM" + '\0' = 17
-  std::snprintf(buf, sizeof(buf), "%04d-%02d-%02d %02d:%02d", year, mon, day, hh, mm);
-  return std::string(buf);
+  if (q == std::string_view::npos) return path;
+  return path.substr(0, q);
 }
 
-std::optional<LogEntry> NginxParser::parse_line(std::string_view line) const {
+std::string_view endpoint_from_path(std::string_view path_sv) {
+  // Se vier URL absoluta, pega só o path
+  if (path_sv.rfind("http://", 0) == 0 || path_sv.rfind("https://", 0) == 0) {
+    auto scheme = path_sv.find("://");
+    if (scheme != std::string_view::npos) {
+      auto after = scheme + 3;
+      auto slash = path_sv.find('/', after);
+      path_sv = (slash == std::string_view::npos) ? std::string_view("/") : path_sv.substr(slash);
+    }
+  }
+
+  std::string_view endpoint = strip_query(path_sv);
+  if (endpoint.empty()) endpoint = "/";
+  return endpoint;
+}
+
+std::int64_t latency_from_seconds(std::string_view tok) {
+  double sec = 0.0;
+  if (parse_double_sv(tok, sec)) {
+    if (sec >= 0.0 && sec < 3600.0) return std::llround(sec * 1e6);
+  }
+  return -1;
+}
+
+std::int64_t bytes_from_token(std::string_view tok) {
+  tok = trim(tok);
+  std::int64_t v = 0;
+  auto res = std::from_chars(tok.data(), tok.data() + tok.size(), v);
+  if (res.ec != std::errc() || res.ptr != tok.data() + tok.size() || v < 0) return -1;
+  return v;
+}
+
+// Primeiro token de `head` (o endereço do cliente, antes do '[').
+static inline std::string_view first_token(std::string_view head) {
+  head = ltrim(head);
+  return head.substr(0, head.find(' '));
+}
+
+const char* reject_reason_name(RejectReason r) {
+  switch (r) {
+    case RejectReason::MissingBracket: return "sem [timestamp]";
+    case RejectReason::BadTimestamp: return "timestamp invalido";
+    case RejectReason::MissingQuote: return "sem \"request\" entre aspas";
+    case RejectReason::BadRequest: return "request invalido";
+    case RejectReason::BadStatus: return "status invalido";
+    case RejectReason::Mismatch: return "aceita pela referencia (divergencia do parser)";
+    case RejectReason::Other: return "outro (parser sem diagnostico)";
+  }
+  return "?";
+}
+
+NginxParser::NginxParser(Isa isa, bool client_fields)
+    : isa_(isa_supported(isa) ? isa : Isa::Scalar), client_fields_(client_fields) {}
+
+std::optional<LogEntry> NginxParser::parse_line_reference(std::string_view line) const {
+  RejectReason why = RejectReason::Other;
+  return parse_reference(line, why);
+}
+
+RejectReason NginxParser::reject_reason(std::string_view line) const {
+  RejectReason why = RejectReason::Other;
+  // A referência aceitar o que o caminho rápido recusou é divergência entre os dois; fica
+  // à vista no --stats em vez de se misturar aos "outros".
+  if (parse_reference(line, why)) return RejectReason::Mismatch;
+  return why;
+}
+
+std::optional<LogEntry> NginxParser::parse_reference(std::string_view line, RejectReason& why) const {
+  // Implementação original (find/rfind); referência para o teste diferencial e diagnóstico
+  // das linhas recusadas (`why` diz onde parou).
+  auto reject = [&](RejectReason r) {
+    why = r;
+    return std::nullopt;
+  };
+
   // 1) timestamp entre [ ... ]
   auto lb = line.find('[');
-  if (lb == std::string_view::npos) return std::nullopt;
+  if (lb == std::string_view::npos) return reject(RejectReason::MissingBracket);
 
   auto rb = line.find(']', lb + 1);
-  if (rb == std::string_view::npos || rb <= lb + 1) return std::nullopt;
+  if (rb == std::string_view::npos) return reject(RejectReason::MissingBracket);
+  if (rb <= lb + 1) return reject(RejectReason::BadTimestamp);
 
   std::string_view time_sv = line.substr(lb + 1, rb - (lb + 1));
-  auto minute_key = parse_minute_key(time_sv);
-  if (!minute_key) return std::nullopt;
+  auto minute = parse_time_local(time_sv);
+  if (!minute) return reject(RejectReason::BadTimestamp);
 
   // 2) request entre " ... " (primeiro par de aspas após ])
   auto q1 = line.find('"', rb);
-  if (q1 == std::string_view::npos) return std::nullopt;
+  if (q1 == std::string_view::npos) return reject(RejectReason::MissingQuote);
   auto q2 = line.find('"', q1 + 1);
-  if (q2 == std::string_view::npos || q2 <= q1 + 1) return std::nullopt;
+  if (q2 == std::string_view::npos) return reject(RejectReason::MissingQuote);
+  if (q2 <= q1 + 1) return reject(RejectReason::BadRequest);
 
   std::string_view request = line.substr(q1 + 1, q2 - (q1 + 1));
   request = trim(request);
@@ -132,24 +165,14 @@ std::optional<LogEntry> NginxParser::parse_line(std::string_view line) const {
   // request esperado: METHOD PATH PROTO
   auto sp1 = request.find(' ');
   auto sp2 = request.rfind(' ');
-  if (sp1 == std::string_view::npos || sp2 == std::string_view::npos || sp1 == sp2) return std::nullopt;
+  if (sp1 == std::string_view::npos || sp2 == std::string_view::npos || sp1 == sp2)
+    return reject(RejectReason::BadRequest);
 
   std::string_view path_sv = request.substr(sp1 + 1, sp2 - (sp1 + 1));
   path_sv = trim(path_sv);
-  if (path_sv.empty()) return std::nullopt;
+  if (path_sv.empty()) return reject(RejectReason::BadRequest);
 
-  // Se vier URL absoluta, pega só o path
-  if (path_sv.rfind("http://", 0) == 0 || path_sv.rfind("https://", 0) == 0) {
-    auto scheme = path_sv.find("://");
-    if (scheme != std::string_view::npos) {
-      auto after = scheme + 3;
-      auto slash = path_sv.find('/', after);
-      path_sv = (slash == std::string_view::npos) ? std::string_view("/") : path_sv.substr(slash);
-    }
-  }
-
-  std::string endpoint = strip_query(path_sv);
-  if (endpoint.empty()) endpoint = std::string{"/"};
+  std::string_view endpoint = endpoint_from_path(path_sv);
 
   // 3) status logo após o segundo quote
   std::string_view rest = line.substr(q2 + 1);
@@ -159,24 +182,152 @@ std::optional<LogEntry> NginxParser::parse_line(std::string_view line) const {
   std::string_view status_sv = (sp == std::string_view::npos) ? rest : rest.substr(0, sp);
 
   int status = 0;
-  if (!parse_int_sv(status_sv, status)) return std::nullopt;
+  if (!parse_int_sv(status_sv, status)) return reject(RejectReason::BadStatus);
 
   // 4) latência: tenta parsear o último token como double (segundos)
-  int latency_ms = -1;
-  {
-    std::string_view tok = last_token(line);
-    double sec = 0.0;
-    if (parse_double_sv(tok, sec)) {
-      if (sec >= 0.0 && sec < 3600.0) latency_ms = static_cast<int>(sec * 1000.0);
-    }
-  }
+  const std::int64_t latency_us = latency_from_seconds(last_token(line));
 
   LogEntry e;
-  e.endpoint = std::move(endpoint);
+  e.endpoint = endpoint;
   e.status = status;
-  e.latency_ms = latency_ms;
-  e.minute_key = std::move(*minute_key);
+  e.latency_us = latency_us;
+  e.minute = *minute;
+
+  // 5) campos do --group-by: cliente, método, bytes (token após o status) e user agent
+  // (terceiro par de aspas, depois do referer); nenhum deles invalida a linha.
+  e.remote_addr = first_token(line.substr(0, lb));
+  e.method = request.substr(0, sp1);
+  if (sp != std::string_view::npos) {
+    std::string_view after = ltrim(rest.substr(sp + 1));
+    e.bytes = bytes_from_token(after.substr(0, after.find(' ')));
+  }
+  auto q = q2;
+  std::size_t quotes[4] = {};
+  for (auto& pos : quotes) {
+    q = (q == std::string_view::npos) ? q : line.find('"', q + 1);
+    pos = q;
+  }
+  if (quotes[3] != std::string_view::npos) e.user_agent = line.substr(quotes[2] + 1, quotes[3] - quotes[2] - 1);
   return e;
 }
 
+// Caminho rápido; `gate(estágio, e)` é chamado com os campos extraídos até ali e pode
+// descartar a linha (sem filtro, o gate é constante e some na compilação). Um gate que
+// falha cedo não encerra a validação: os testes estruturais que faltam (aspas, status,
+// request) ainda rodam, e a linha só é Filtered se fosse válida — inválida continua
+// Invalid, como no índice, que só guarda linhas válidas. O que é só extração (endpoint,
+// latência, campos do --group-by) é pulado.
+template <typename Gate>
+ParseResult NginxParser::parse_fast(std::string_view line, LogEntry& e, Gate&& gate) const {
+  // Passada única: bitmasks de '[', ']', '"' e ' '; os campos saem das máscaras.
+  StructuralMasks m;
+  build_masks(isa_, line, m);
+  constexpr auto npos = StructuralMasks::npos;
+
+  // 1) timestamp entre [ ... ]
+  const auto lb = m.next(m.open, 0);
+  if (lb == npos) return ParseResult::Invalid;
+  const auto rb = m.next(m.close, lb + 1);
+  if (rb == npos || rb <= lb + 1) return ParseResult::Invalid;
+
+  auto minute = parse_time_local(line.substr(lb + 1, rb - (lb + 1)));
+  if (!minute) return ParseResult::Invalid;
+  e.minute = *minute;
+  bool keep = gate(FilterStage::Time, e);
+
+  // 2) request entre " ... " (primeiro par de aspas após ])
+  const auto q1 = m.next(m.quote, rb + 1);
+  if (q1 == npos) return ParseResult::Invalid;
+  const auto q2 = m.next(m.quote, q1 + 1);
+  if (q2 == npos || q2 <= q1 + 1) return ParseResult::Invalid;
+
+  // 3) status logo após o segundo quote (antes do path: é mais barato de filtrar)
+  std::size_t ss = q2 + 1;
+  while (ss < line.size() && is_space(line[ss])) ++ss;
+  const auto se = std::min(m.next(m.space, ss), line.size());
+
+  if (!parse_int_sv(line.substr(ss, se - ss), e.status)) return ParseResult::Invalid;
+  keep = keep && gate(FilterStage::Status, e);
+
+  // request [rs, re) já sem espaços nas pontas: METHOD PATH PROTO
+  std::size_t rs = q1 + 1, re = q2;
+  while (rs < re && is_space(line[rs])) ++rs;
+  while (re > rs && is_space(line[re - 1])) --re;
+  const auto sp1 = m.next(m.space, rs);
+  if (sp1 >= re) return ParseResult::Invalid;
+  const auto sp2 = m.prev(m.space, re);
+  if (sp1 == sp2) return ParseResult::Invalid;
+
+  std::string_view path_sv = trim(line.substr(sp1 + 1, sp2 - (sp1 + 1)));
+  if (path_sv.empty()) return ParseResult::Invalid;
+  // Daqui em diante nada invalida a linha.
+  if (!keep) return ParseResult::Filtered;
+  e.endpoint = endpoint_from_path(path_sv);
+  if (!gate(FilterStage::Endpoint, e)) return ParseResult::Filtered;
+
+  // 4) latência: último token (depois do último ' ' antes dos espaços finais)
+  std::size_t le = line.size();
+  while (le > 0 && is_space(line[le - 1])) --le;
+  const auto lsp = m.prev(m.space, le);
+  const std::size_t ls = (lsp == npos) ? 0 : lsp + 1;
+
+  e.latency_us = latency_from_seconds(line.substr(ls, le - ls));
+  if (!gate(FilterStage::Latency, e)) return ParseResult::Filtered;
+
+  // 5) campos do --group-by (depois do filtro: linha descartada não paga por eles), só
+  // quando alguém os usa
+  if (!client_fields_) return ParseResult::Ok;
+  e.remote_addr = first_token(line.substr(0, lb));
+  e.method = line.substr(rs, sp1 - rs);
+  std::size_t bs = se;
+  while (bs < line.size() && is_space(line[bs])) ++bs;
+  const auto be = std::min(m.next(m.space, bs), line.size());
+  e.bytes = bytes_from_token(line.substr(bs, be - bs));
+  std::size_t q = q2;
+  std::size_t quotes[4] = {};
+  for (auto& pos : quotes) {
+    q = (q == npos) ? q : m.next(m.quote, q + 1);
+    pos = q;
+  }
+  if (quotes[3] != npos) e.user_agent = line.substr(quotes[2] + 1, quotes[3] - quotes[2] - 1);
+  return ParseResult::Ok;
+}
+
+std::optional<LogEntry> NginxParser::parse_line(std::string_view line) const {
+  // Linhas muito longas (raras) ficam com o caminho escalar.
+  if (line.size() > StructuralMasks::kMaxLen) return parse_line_reference(line);
+
+  LogEntry e;
+  if (parse_fast(line, e, [](FilterStage, const LogEntry&) { return true; }) != ParseResult::Ok) return std::nullopt;
+  return e;
+}
+
+ParseResult NginxParser::parse_line(std::string_view line, const Filter& filter, LogEntry& out) const {
+  if (line.size() > StructuralMasks::kMaxLen) {
+    auto e = parse_line_reference(line);
+    if (!e) return ParseResult::Invalid;
+    out = *e;
+    return filter.matches(out) ? ParseResult::Ok : ParseResult::Filtered;
+  }
+  out = LogEntry{};
+  return parse_fast(line, out, [&](FilterStage s, const LogEntry& e) { return filter.pass(s, e); });
+}
+
+ParseResult NginxParser::parse(std::string_view line, const Filter* filter, LogEntry& out) const {
+  if (filter) return parse_line(line, *filter, out);
+  if (line.size() > StructuralMasks::kMaxLen) {
+    auto e = parse_line_reference(line);
+    if (!e) return ParseResult::Invalid;
+    out = *e;
+    return ParseResult::Ok;
+  }
+  out = LogEntry{};
+  return parse_fast(line, out, [](FilterStage, const LogEntry&) { return true; });
+}
+
+// Aqui parse_fast é visível: o laço do lote inlina o parser inteiro.
+void NginxParser::parse_batch(std::span<const std::string_view> lines, const Filter* filter, EntryBatch& out) const {
+  parse_rows(*this, lines, filter, out);
+}
+
 }  // namespace logforge
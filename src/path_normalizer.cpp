@@ -0,0 +1,195 @@
+#include "logforge/path_normalizer.hpp"
+
+#include <fstream>
+
+namespace logforge {
+
+static const std::string kTailOut = "**";
+
+static inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
+static inline bool is_hex(char c) { return is_digit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F'); }
+
+PathNormalizer::PathNormalizer() : nodes_(1) {}
+
+// Detectores embutidos; "" se o segmento deve ficar como está.
+std::string_view PathNormalizer::detect(std::string_view seg) {
+  if (seg.empty()) return {};
+
+  bool all_digits = true, all_hex = true, has_digit = false;
+  for (char c : seg) {
+    all_digits = all_digits && is_digit(c);
+    all_hex = all_hex && is_hex(c);
+    has_digit = has_digit || is_digit(c);
+  }
+  if (all_digits) return "{id}";
+  if (all_hex && has_digit && seg.size() >= 16) return "{hex}";
+
+  // UUID: 8-4-4-4-12
+  if (seg.size() == 36 && seg[8] == '-' && seg[13] == '-' && seg[18] == '-' && seg[23] == '-') {
+    for (std::size_t i = 0; i < seg.size(); ++i) {
+      if (i == 8 || i == 13 || i == 18 || i == 23) continue;
+      if (!is_hex(seg[i])) return {};
+    }
+    return "{uuid}";
+  }
+  return {};
+}
+
+bool PathNormalizer::add_rule(std::string_view pattern, std::string& error) {
+  if (pattern.empty() || pattern.front() != '/') {
+    error = "regra deve começar com '/': " + std::string(pattern);
+    return false;
+  }
+
+  std::uint32_t node = 0;
+  std::size_t pos = 0;
+  while (true) {
+    const auto slash = pattern.find('/', pos);
+    const auto seg = pattern.substr(pos, slash == std::string_view::npos ? std::string_view::npos : slash - pos);
+    const bool last = (slash == std::string_view::npos);
+
+    if (seg == "**") {
+      if (!last) {
+        error = "'**' só pode ser o último segmento: " + std::string(pattern);
+        return false;
+      }
+      nodes_[node].tail = true;
+      rules_++;
+      return true;
+    }
+
+    std::uint32_t next = 0;
+    if (seg.size() >= 2 && seg.front() == '{' && seg.back() == '}') {
+      if (nodes_[node].param < 0) {
+        nodes_[node].param = static_cast<std::int32_t>(nodes_.size());
+        nodes_[node].param_name = std::string(seg);
+        nodes_.emplace_back();
+      } else if (nodes_[node].param_name != seg) {
+        // Um só filho {param} por nó: outro nome na mesma posição seria trocado em silêncio.
+        error = "regra usa " + std::string(seg) + " onde outra regra já usa " + nodes_[node].param_name + ": " +
+                std::string(pattern);
+        return false;
+      }
+      next = static_cast<std::uint32_t>(nodes_[node].param);
+    } else {
+      bool found = false;
+      for (auto& [lit, child] : nodes_[node].literals) {
+        if (lit == seg) {
+          next = child;
+          found = true;
+          break;
+        }
+      }
+      if (!found) {
+        next = static_cast<std::uint32_t>(nodes_.size());
+        nodes_[node].literals.emplace_back(std::string(seg), next);
+        nodes_.emplace_back();
+      }
+    }
+    node = next;
+    if (last) break;
+    pos = slash + 1;
+  }
+  nodes_[node].terminal = true;
+  rules_++;
+  return true;
+}
+
+bool PathNormalizer::load_rules(const std::string& path, std::string& error) {
+  std::ifstream ifs(path);
+  if (!ifs.is_open()) {
+    error = "não foi possível abrir: " + path;
+    return false;
+  }
+  std::string line;
+  while (std::getline(ifs, line)) {
+    std::string_view sv = line;
+    while (!sv.empty() && (sv.back() == ' ' || sv.back() == '\t' || sv.back() == '\r')) sv.remove_suffix(1);
+    while (!sv.empty() && (sv.front() == ' ' || sv.front() == '\t')) sv.remove_prefix(1);
+    if (sv.empty() || sv.front() == '#') continue;
+    if (!add_rule(sv, error)) return false;
+  }
+  return true;
+}
+
+// DFS na trie: literal primeiro, depois {param}, depois '**'.
+// repl[i] = texto que substitui o segmento i (nullptr = mantém).
+bool PathNormalizer::match(std::uint32_t node, const std::string_view* segs, std::size_t i, std::size_t n,
+                           const std::string** repl) const {
+  const Node& nd = nodes_[node];
+  if (i == n) return nd.terminal;
+
+  for (auto& [lit, child] : nd.literals) {
+    if (lit == segs[i] && match(child, segs, i + 1, n, repl)) {
+      repl[i] = nullptr;
+      return true;
+    }
+  }
+  if (nd.param >= 0 && match(static_cast<std::uint32_t>(nd.param), segs, i + 1, n, repl)) {
+    repl[i] = &nd.param_name;
+    return true;
+  }
+  if (nd.tail) {
+    repl[i] = &kTailOut;
+    for (std::size_t k = i + 1; k < n; ++k) repl[k] = nullptr;
+    return true;
+  }
+  return false;
+}
+
+bool PathNormalizer::match_rules(std::string_view path, std::string& buf) const {
+  std::string_view segs[kMaxSegments];
+  std::size_t n = 0;
+  std::size_t pos = 0;
+  while (true) {
+    if (n == kMaxSegments) return false;
+    const auto slash = path.find('/', pos);
+    if (slash == std::string_view::npos) {
+      segs[n++] = path.substr(pos);
+      break;
+    }
+    segs[n++] = path.substr(pos, slash - pos);
+    pos = slash + 1;
+  }
+
+  const std::string* repl[kMaxSegments];
+  if (!match(0, segs, 0, n, repl)) return false;
+
+  buf.clear();
+  for (std::size_t i = 0; i < n; ++i) {
+    if (i) buf += '/';
+    if (repl[i] == &kTailOut) {
+      buf += kTailOut;
+      break;
+    }
+    buf += repl[i] ? std::string_view(*repl[i]) : segs[i];
+  }
+  return true;
+}
+
+std::string_view PathNormalizer::normalize(std::string_view path, std::string& buf) const {
+  if (rules_ && match_rules(path, buf)) return buf;
+
+  // Só copia a partir do primeiro segmento que muda; caso comum devolve `path` intacto.
+  std::size_t pos = 0;
+  bool copying = false;
+  while (pos <= path.size()) {
+    auto slash = path.find('/', pos);
+    if (slash == std::string_view::npos) slash = path.size();
+    const auto seg = path.substr(pos, slash - pos);
+    const auto rep = detect(seg);
+
+    if (!rep.empty() && !copying) {
+      buf.assign(path.substr(0, pos));
+      copying = true;
+    }
+    if (copying) {
+      buf += rep.empty() ? seg : rep;
+      if (slash < path.size()) buf += '/';
+    }
+    pos = slash + 1;
+  }
+  return copying ? std::string_view(buf) : path;
+}
+
+} // namespace logforge
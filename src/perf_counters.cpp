@@ -0,0 +1,89 @@
+#include "logforge/perf_counters.hpp"
+
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace logforge {
+
+#ifdef __linux__
+
+struct EventSpec {
+  const char* name;
+  std::uint32_t type;
+  std::uint64_t config;
+};
+
+static constexpr std::uint64_t cache_event(std::uint64_t cache) {
+  return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+static const EventSpec kEvents[] = {
+    {"ciclos", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instrucoes", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"L1d misses (leitura)", PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_L1D)},
+    {"LLC misses (leitura)", PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_LL)},
+};
+
+PerfCounters::PerfCounters() {
+  for (const auto& ev : kEvents) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = ev.type;
+    attr.config = ev.config;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    const long fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (fd < 0) {
+      if (error_.empty()) error_ = std::string("perf_event_open: ") + std::strerror(errno);
+      continue;
+    }
+    fds_.push_back(static_cast<int>(fd));
+    names_.push_back(ev.name);
+  }
+}
+
+PerfCounters::~PerfCounters() {
+  for (int fd : fds_) close(fd);
+}
+
+void PerfCounters::start() {
+  for (int fd : fds_) {
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+  }
+}
+
+std::vector<PerfCounters::Reading> PerfCounters::stop() {
+  std::vector<Reading> out;
+  for (std::size_t i = 0; i < fds_.size(); ++i) {
+    ioctl(fds_[i], PERF_EVENT_IOC_DISABLE, 0);
+    std::uint64_t v[3] = {};
+    if (read(fds_[i], v, sizeof(v)) != static_cast<ssize_t>(sizeof(v)) || v[2] == 0) continue;
+    // Multiplexado (mais eventos que contadores físicos): extrapola pelo tempo ativo.
+    const double scaled = static_cast<double>(v[0]) * static_cast<double>(v[1]) / static_cast<double>(v[2]);
+    out.push_back(Reading{names_[i], static_cast<std::uint64_t>(scaled)});
+  }
+  return out;
+}
+
+#else
+
+PerfCounters::PerfCounters() : error_("contadores de hardware só no Linux") {}
+PerfCounters::~PerfCounters() = default;
+void PerfCounters::start() {}
+std::vector<PerfCounters::Reading> PerfCounters::stop() { return {}; }
+
+#endif
+
+} // namespace logforge
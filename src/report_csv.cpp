@@ -1,93 +1,151 @@
 #include "logforge/report_writer.hpp"
 
-#include <algorithm>
-#include <filesystem>
-#include <fstream>
 #include <vector>
 
+#include "logforge/out_buffer.hpp"
+#include "logforge/time_util.hpp"
+
 namespace logforge {
 
-template <typename K, typename V>
-static std::vector<std::pair<K, V>> to_vec(const std::unordered_map<K, V>& m) {
-  std::vector<std::pair<K, V>> v;
-  v.reserve(m.size());
-  for (auto& kv : m) v.push_back(kv);
-  return v;
+// Campo entre aspas; aspas internas (ex.: num user agent) viram "".
+static void put_quoted(OutBuffer& out, std::string_view s) {
+  out << '"';
+  for (auto q = s.find('"'); q != std::string_view::npos; q = s.find('"')) {
+    out << s.substr(0, q + 1) << '"';
+    s.remove_prefix(q + 1);
+  }
+  out << s << '"';
 }
 
-static bool ensure_dir(const std::string& out_dir) {
-  std::error_code ec;
-  std::filesystem::create_directories(out_dir, ec);
-  return !ec;
+static void put_minute(OutBuffer& out, std::int64_t minute) {
+  out << '"';
+  char* p = out.reserve(kMinuteTextMax);
+  out.commit(format_minute(minute, p));
+  out << '"';
 }
 
 bool write_report_csv(const Report& r, const std::string& out_dir, int top_n) {
-  if (!ensure_dir(out_dir)) return false;
+  return write_report_csv(r, make_report_view(r, top_n), out_dir);
+}
 
-  // status_counts.csv
-  {
-    std::string path = out_dir + "/status_counts.csv";
-    std::ofstream ofs(path);
-    if (!ofs.is_open()) return false;
+bool write_report_csv(const Report& r, const ReportView& view, const std::string& out_dir) {
+  return publish_report_files(csv_report_files(r, view), out_dir);
+}
 
-    auto v = to_vec(r.status_counts);
-    std::sort(v.begin(), v.end(), [](auto& a, auto& b) { return a.first < b.first; });
+static void write_status_counts(const ReportView& view, OutBuffer& out) {
+  out << "status,count\n";
+  for (auto& [status, count] : view.status) out << status << ',' << count << '\n';
+}
 
-    ofs << "status,count\n";
-    for (auto& kv : v) {
-      ofs << kv.first << "," << kv.second << "\n";
-    }
+static void write_top_endpoints(const Report& r, const ReportView& view, OutBuffer& out) {
+  if (r.endpoint_counts_approximate) {
+    out << "endpoint,count,count_error\n";
+    for (auto& e : view.top_endpoints) out << '"' << e.endpoint << '"' << ',' << e.count << ',' << e.error << '\n';
+  } else {
+    out << "endpoint,count\n";
+    for (auto& e : view.top_endpoints) out << '"' << e.endpoint << '"' << ',' << e.count << '\n';
   }
+}
 
-  // top_endpoints.csv
-  {
-    std::string path = out_dir + "/top_endpoints.csv";
-    std::ofstream ofs(path);
-    if (!ofs.is_open()) return false;
-
-    auto v = to_vec(r.endpoint_counts);
-    std::sort(v.begin(), v.end(),
-              [](auto& a, auto& b) { return (a.second == b.second) ? (a.first < b.first) : (a.second > b.second); });
-    if (static_cast<int>(v.size()) > top_n) v.resize(static_cast<std::size_t>(top_n));
-
-    ofs << "endpoint,count\n";
-    for (auto& kv : v) {
-      ofs << '"' << kv.first << '"' << "," << kv.second << "\n";
-    }
+static void write_requests_per_minute(const ReportView& view, OutBuffer& out) {
+  out << "minute,count\n";
+  for (auto& [minute, count] : view.minutes) {
+    put_minute(out, minute);
+    out << ',' << count << '\n';
   }
+}
 
-  // requests_per_minute.csv
-  {
-    std::string path = out_dir + "/requests_per_minute.csv";
-    std::ofstream ofs(path);
-    if (!ofs.is_open()) return false;
+static void write_latency_summary(const Report& r, OutBuffer& out) {
+  out << "key,value\n";
+  out << "count," << r.latency.count << "\n";
+  out << "min_ms," << r.latency.min_ms << "\n";
+  out << "avg_ms," << r.latency.avg_ms << "\n";
+  out << "p50_ms," << r.latency.p50_ms << "\n";
+  out << "p95_ms," << r.latency.p95_ms << "\n";
+  out << "p99_ms," << r.latency.p99_ms << "\n";
+  out << "max_ms," << r.latency.max_ms << "\n";
+  for (auto& [q, ms] : r.latency.quantiles) out << "q" << q << "_ms," << ms << "\n";
+  out << "relative_error," << r.latency.relative_error << "\n";
+}
+
+static void write_unique_clients(const Report& r, OutBuffer& out) {
+  out << "key,value\n";
+  out << "unique_clients," << r.unique_clients << "\n";
+  out << "precision," << r.unique_clients_precision << "\n";
+  out << "relative_error," << r.unique_clients_error << "\n";
+}
 
-    auto v = to_vec(r.per_minute_counts);
-    std::sort(v.begin(), v.end(), [](auto& a, auto& b) { return a.first < b.first; });
+static void write_endpoint_latency(const Report& r, OutBuffer& out) {
+  out << "endpoint,count,count_error,1xx,2xx,3xx,4xx,5xx,error_rate,p50_ms,p95_ms,p99_ms";
+  if (r.unique_clients_enabled) out << ",unique_clients";
+  out << "\n";
+  for (auto& row : r.endpoint_latency) {
+    out << '"' << row.endpoint << '"' << ',' << row.count << ',' << row.count_error;
+    for (auto c : row.status_classes) out << ',' << c;
+    out << ',' << row.error_rate << ',' << row.p50_ms << ',' << row.p95_ms << ',' << row.p99_ms;
+    if (r.unique_clients_enabled) out << ',' << row.unique_clients;
+    out << '\n';
+  }
+}
 
-    ofs << "minute,count\n";
-    for (auto& kv : v) {
-      ofs << '"' << kv.first << '"' << "," << kv.second << "\n";
+static void write_windows(const Report& r, OutBuffer& out) {
+  out << "window_start,count,rps,1xx,2xx,3xx,4xx,5xx,error_rate,p50_ms,p95_ms,p99_ms";
+  if (r.window_sliding > 0) out << ",sliding_count,sliding_rps,sliding_error_rate,sliding_p99_ms";
+  if (r.unique_clients_enabled) out << (r.window_sliding > 0 ? ",unique_clients,sliding_unique_clients" : ",unique_clients");
+  out << "\n";
+  for (auto& w : r.windows) {
+    put_minute(out, w.start_minute);
+    out << ',' << w.count << ',' << w.rps;
+    for (auto c : w.status_classes) out << ',' << c;
+    out << ',' << w.error_rate << ',' << w.p50_ms << ',' << w.p95_ms << ',' << w.p99_ms;
+    if (r.window_sliding > 0) {
+      out << ',' << w.sliding_count << ',' << w.sliding_rps << ',' << w.sliding_error_rate << ',' << w.sliding_p99_ms;
+    }
+    if (r.unique_clients_enabled) {
+      out << ',' << w.unique_clients;
+      if (r.window_sliding > 0) out << ',' << w.sliding_unique_clients;
     }
+    out << '\n';
   }
+}
 
-  // latency_summary.csv
-  {
-    std::string path = out_dir + "/latency_summary.csv";
-    std::ofstream ofs(path);
-    if (!ofs.is_open()) return false;
-
-    ofs << "key,value\n";
-    ofs << "count," << r.latency.count << "\n";
-    ofs << "min_ms," << r.latency.min_ms << "\n";
-    ofs << "avg_ms," << r.latency.avg_ms << "\n";
-    ofs << "p50_ms," << r.latency.p50_ms << "\n";
-    ofs << "p95_ms," << r.latency.p95_ms << "\n";
-    ofs << "p99_ms," << r.latency.p99_ms << "\n";
-    ofs << "max_ms," << r.latency.max_ms << "\n";
+// Todos os grupos (o JSON leva só os top N).
+static void write_group_by(const Report& r, OutBuffer& out) {
+  const auto& spec = r.group_by_spec;
+  for (auto d : spec.dims) out << group_dim_name(d) << ",";
+  const auto cols = spec.aggregate_columns();
+  for (std::size_t i = 0; i < cols.size(); ++i) out << (i ? "," : "") << cols[i];
+  out << "\n";
+  for (auto& row : r.group_by) {
+    for (auto& k : row.key) {
+      put_quoted(out, k);
+      out << ',';
+    }
+    out << row.count;
+    if (spec.sum_bytes) out << ',' << row.bytes;
+    for (double ms : row.quantiles_ms) out << ',' << ms;
+    for (auto c : row.distinct) out << ',' << c;
+    out << '\n';
   }
+}
 
-  return true;
+// Os que podem ser grandes (um por minuto, por grupo, por endpoint) vêm primeiro, para
+// começarem antes no publish_report_files.
+std::vector<ReportFile> csv_report_files(const Report& r, const ReportView& view) {
+  std::vector<ReportFile> files;
+  files.push_back({"requests_per_minute.csv", [&view](OutBuffer& out) { write_requests_per_minute(view, out); }});
+  if (r.group_by_enabled) files.push_back({"group_by.csv", [&r](OutBuffer& out) { write_group_by(r, out); }});
+  if (r.endpoint_latency_enabled) {
+    files.push_back({"endpoint_latency.csv", [&r](OutBuffer& out) { write_endpoint_latency(r, out); }});
+  }
+  if (r.windows_enabled) files.push_back({"windows.csv", [&r](OutBuffer& out) { write_windows(r, out); }});
+  files.push_back({"status_counts.csv", [&view](OutBuffer& out) { write_status_counts(view, out); }});
+  files.push_back({"top_endpoints.csv", [&r, &view](OutBuffer& out) { write_top_endpoints(r, view, out); }});
+  files.push_back({"latency_summary.csv", [&r](OutBuffer& out) { write_latency_summary(r, out); }});
+  if (r.unique_clients_enabled) {
+    files.push_back({"unique_clients.csv", [&r](OutBuffer& out) { write_unique_clients(r, out); }});
+  }
+  return files;
 }
 
 } // namespace logforge
@@ -1,104 +1,200 @@
 #include "logforge/report_writer.hpp"
 
 #include <algorithm>
-#include <fstream>
-#include <sstream>
 #include <vector>
 
+#include "logforge/out_buffer.hpp"
+#include "logforge/time_util.hpp"
+
 namespace logforge {
 
-static std::string json_escape(const std::string& s) {
-  std::string out;
-  out.reserve(s.size() + 8);
-  for (char c : s) {
+// String JSON entre aspas, escapada direto no buffer: trechos sem nada a escapar são
+// copiados de uma vez. Caracteres de controle sem escape curto são omitidos.
+static void put_json_string(OutBuffer& out, std::string_view s) {
+  out << '"';
+  std::size_t run = 0;
+  for (std::size_t i = 0; i < s.size(); ++i) {
+    const auto c = static_cast<unsigned char>(s[i]);
+    if (c >= 0x20 && c != '"' && c != '\\') continue;
+    out << s.substr(run, i - run);
+    run = i + 1;
     switch (c) {
-      case '\\': out += "\\\\"; break;
-      case '"': out += "\\\""; break;
-      case '\n': out += "\\n"; break;
-      case '\r': out += "\\r"; break;
-      case '\t': out += "\\t"; break;
-      default:
-        if (static_cast<unsigned char>(c) < 0x20) {
-          // omite controle (simples)
-        } else {
-          out += c;
-        }
+      case '\\': out << "\\\\"; break;
+      case '"': out << "\\\""; break;
+      case '\n': out << "\\n"; break;
+      case '\r': out << "\\r"; break;
+      case '\t': out << "\\t"; break;
+      default: break;
     }
   }
-  return out;
+  out << s.substr(run) << '"';
 }
 
-template <typename K, typename V>
-static std::vector<std::pair<K, V>> to_vec(const std::unordered_map<K, V>& m) {
-  std::vector<std::pair<K, V>> v;
-  v.reserve(m.size());
-  for (auto& kv : m) v.push_back(kv);
-  return v;
+static void put_minute(OutBuffer& out, std::int64_t minute) {
+  char* p = out.reserve(kMinuteTextMax);
+  out.commit(format_minute(minute, p));
 }
 
 bool write_report_json(const Report& r, const std::string& out_dir, int top_n) {
-  std::string path = out_dir;
-  if (!path.empty() && path.back() != '/') path += '/';
-  path += "report.json";
-
-  std::ofstream ofs(path);
-  if (!ofs.is_open()) return false;
-
-  auto status = to_vec(r.status_counts);
-  std::sort(status.begin(), status.end(), [](auto& a, auto& b) { return a.first < b.first; });
-
-  auto endpoints = to_vec(r.endpoint_counts);
-  std::sort(endpoints.begin(), endpoints.end(),
-            [](auto& a, auto& b) { return (a.second == b.second) ? (a.first < b.first) : (a.second > b.second); });
-  if (static_cast<int>(endpoints.size()) > top_n) endpoints.resize(static_cast<std::size_t>(top_n));
-
-  auto minutes = to_vec(r.per_minute_counts);
-  std::sort(minutes.begin(), minutes.end(), [](auto& a, auto& b) { return a.first < b.first; });
-
-  std::ostringstream ss;
-  ss << "{\n";
-  ss << "  \"summary\": {\n";
-  ss << "    \"total_lines\": " << r.total_lines << ",\n";
-  ss << "    \"parsed_lines\": " << r.parsed_lines << ",\n";
-  ss << "    \"invalid_lines\": " << r.invalid_lines << "\n";
-  ss << "  },\n";
-
-  ss << "  \"latency_ms\": {\n";
-  ss << "    \"count\": " << r.latency.count << ",\n";
-  ss << "    \"min\": " << r.latency.min_ms << ",\n";
-  ss << "    \"avg\": " << r.latency.avg_ms << ",\n";
-  ss << "    \"p50\": " << r.latency.p50_ms << ",\n";
-  ss << "    \"p95\": " << r.latency.p95_ms << ",\n";
-  ss << "    \"p99\": " << r.latency.p99_ms << ",\n";
-  ss << "    \"max\": " << r.latency.max_ms << "\n";
-  ss << "  },\n";
-
-  ss << "  \"status_counts\": [\n";
+  return write_report_json(r, make_report_view(r, top_n), out_dir);
+}
+
+bool write_report_json(const Report& r, const ReportView& view, const std::string& out_dir) {
+  return publish_report_files(json_report_files(r, view), out_dir, 1);
+}
+
+static void write_json(const Report& r, const ReportView& view, OutBuffer& out) {
+  const auto& status = view.status;
+  const auto& endpoints = view.top_endpoints;
+  const auto& minutes = view.minutes;
+
+  out << "{\n";
+  out << "  \"summary\": {\n";
+  out << "    \"total_lines\": " << r.total_lines << ",\n";
+  out << "    \"parsed_lines\": " << r.parsed_lines << ",\n";
+  out << "    \"invalid_lines\": " << r.invalid_lines << ",\n";
+  out << "    \"filtered_lines\": " << r.filtered_lines << "\n";
+  out << "  },\n";
+
+  out << "  \"latency_ms\": {\n";
+  out << "    \"count\": " << r.latency.count << ",\n";
+  out << "    \"min\": " << r.latency.min_ms << ",\n";
+  out << "    \"avg\": " << r.latency.avg_ms << ",\n";
+  out << "    \"p50\": " << r.latency.p50_ms << ",\n";
+  out << "    \"p95\": " << r.latency.p95_ms << ",\n";
+  out << "    \"p99\": " << r.latency.p99_ms << ",\n";
+  out << "    \"max\": " << r.latency.max_ms << ",\n";
+  out << "    \"relative_error\": " << r.latency.relative_error << ",\n";
+  out << "    \"quantiles\": [";
+  for (std::size_t i = 0; i < r.latency.quantiles.size(); ++i) {
+    out << (i ? ", " : "") << "{\"q\": " << r.latency.quantiles[i].first << ", \"ms\": " << r.latency.quantiles[i].second
+        << "}";
+  }
+  out << "]\n";
+  out << "  },\n";
+
+  if (r.unique_clients_enabled) {
+    out << "  \"unique_clients\": {\"estimate\": " << r.unique_clients << ", \"precision\": "
+        << r.unique_clients_precision << ", \"relative_error\": " << r.unique_clients_error << "},\n";
+  }
+
+  out << "  \"status_counts\": [\n";
   for (std::size_t i = 0; i < status.size(); ++i) {
-    ss << "    {\"status\": " << status[i].first << ", \"count\": " << status[i].second << "}";
-    ss << (i + 1 < status.size() ? "," : "") << "\n";
+    out << "    {\"status\": " << status[i].first << ", \"count\": " << status[i].second << "}";
+    out << (i + 1 < status.size() ? "," : "") << "\n";
   }
-  ss << "  ],\n";
+  out << "  ],\n";
 
-  ss << "  \"top_endpoints\": [\n";
+  if (r.endpoint_counts_approximate) out << "  \"top_endpoints_approximate\": true,\n";
+  out << "  \"top_endpoints\": [\n";
   for (std::size_t i = 0; i < endpoints.size(); ++i) {
-    ss << "    {\"endpoint\": \"" << json_escape(endpoints[i].first) << "\", \"count\": " << endpoints[i].second
-       << "}";
-    ss << (i + 1 < endpoints.size() ? "," : "") << "\n";
+    out << "    {\"endpoint\": ";
+    put_json_string(out, endpoints[i].endpoint);
+    out << ", \"count\": " << endpoints[i].count;
+    if (r.endpoint_counts_approximate) out << ", \"count_error\": " << endpoints[i].error;
+    out << "}";
+    out << (i + 1 < endpoints.size() ? "," : "") << "\n";
   }
-  ss << "  ],\n";
+  out << "  ],\n";
 
-  ss << "  \"requests_per_minute\": [\n";
+  out << "  \"requests_per_minute\": [\n";
   for (std::size_t i = 0; i < minutes.size(); ++i) {
-    ss << "    {\"minute\": \"" << json_escape(minutes[i].first) << "\", \"count\": " << minutes[i].second << "}";
-    ss << (i + 1 < minutes.size() ? "," : "") << "\n";
+    out << "    {\"minute\": \"";
+    put_minute(out, minutes[i].first);
+    out << "\", \"count\": " << minutes[i].second << "}";
+    out << (i + 1 < minutes.size() ? "," : "") << "\n";
+  }
+  out << "  ]";
+
+  // Top N endpoints com estatísticas próprias (lista completa em endpoint_latency.csv).
+  if (r.endpoint_latency_enabled) {
+    const std::size_t n = std::min(r.endpoint_latency.size(), static_cast<std::size_t>(std::max(view.top_n, 0)));
+    out << ",\n";
+    out << "  \"endpoint_latency\": {\n";
+    out << "    \"approximate\": " << (r.endpoint_latency_approximate ? "true" : "false") << ",\n";
+    out << "    \"endpoints\": [\n";
+    for (std::size_t i = 0; i < n; ++i) {
+      const auto& row = r.endpoint_latency[i];
+      out << "      {\"endpoint\": ";
+      put_json_string(out, row.endpoint);
+      out << ", \"count\": " << row.count << ", \"count_error\": " << row.count_error << ", \"status_classes\": [";
+      for (int k = 0; k < 5; ++k) out << (k ? ", " : "") << row.status_classes[k];
+      out << "], \"error_rate\": " << row.error_rate << ", \"p50\": " << row.p50_ms << ", \"p95\": " << row.p95_ms
+          << ", \"p99\": " << row.p99_ms;
+      if (r.unique_clients_enabled) out << ", \"unique_clients\": " << row.unique_clients;
+      out << "}" << (i + 1 < n ? "," : "") << "\n";
+    }
+    out << "    ]\n";
+    out << "  }";
+  }
+
+  // Janelas de tempo (--window). Em --follow é só o anel: tamanho limitado.
+  if (r.windows_enabled) {
+    out << ",\n";
+    out << "  \"windows\": {\n";
+    out << "    \"width_min\": " << r.window_width_min << ",\n";
+    out << "    \"sliding\": " << r.window_sliding << ",\n";
+    out << "    \"late\": " << r.window_late << ",\n";
+    out << "    \"windows\": [\n";
+    for (std::size_t i = 0; i < r.windows.size(); ++i) {
+      const auto& w = r.windows[i];
+      out << "      {\"start\": \"";
+      put_minute(out, w.start_minute);
+      out << "\", \"count\": " << w.count << ", \"rps\": " << w.rps << ", \"status_classes\": [";
+      for (int k = 0; k < 5; ++k) out << (k ? ", " : "") << w.status_classes[k];
+      out << "], \"error_rate\": " << w.error_rate << ", \"p50\": " << w.p50_ms << ", \"p95\": " << w.p95_ms
+          << ", \"p99\": " << w.p99_ms;
+      if (r.unique_clients_enabled) out << ", \"unique_clients\": " << w.unique_clients;
+      if (r.window_sliding > 0) {
+        out << ", \"sliding\": {\"count\": " << w.sliding_count << ", \"rps\": " << w.sliding_rps
+            << ", \"error_rate\": " << w.sliding_error_rate << ", \"p99\": " << w.sliding_p99_ms;
+        if (r.unique_clients_enabled) out << ", \"unique_clients\": " << w.sliding_unique_clients;
+        out << "}";
+      }
+      out << "}" << (i + 1 < r.windows.size() ? "," : "") << "\n";
+    }
+    out << "    ]\n";
+    out << "  }";
   }
-  ss << "  ]\n";
 
-  ss << "}\n";
+  // --group-by: top N grupos por count (lista completa em group_by.csv).
+  if (r.group_by_enabled) {
+    const auto& spec = r.group_by_spec;
+    const auto cols = spec.aggregate_columns();
+    const std::size_t n = std::min(r.group_by.size(), static_cast<std::size_t>(std::max(view.top_n, 0)));
+    out << ",\n";
+    out << "  \"group_by\": {\n";
+    out << "    \"dimensions\": [";
+    for (std::size_t i = 0; i < spec.dims.size(); ++i) out << (i ? ", " : "") << "\"" << group_dim_name(spec.dims[i]) << "\"";
+    out << "],\n";
+    out << "    \"groups\": " << r.group_by.size() << ",\n";
+    out << "    \"rows\": [\n";
+    for (std::size_t i = 0; i < n; ++i) {
+      const auto& row = r.group_by[i];
+      out << "      {\"key\": {";
+      for (std::size_t k = 0; k < spec.dims.size(); ++k) {
+        out << (k ? ", " : "") << "\"" << group_dim_name(spec.dims[k]) << "\": ";
+        put_json_string(out, row.key[k]);
+      }
+      out << "}, \"count\": " << row.count;
+      std::size_t c = 1;
+      if (spec.sum_bytes) out << ", \"" << cols[c++] << "\": " << row.bytes;
+      for (double ms : row.quantiles_ms) out << ", \"" << cols[c++] << "\": " << ms;
+      for (auto d : row.distinct) out << ", \"" << cols[c++] << "\": " << d;
+      out << "}" << (i + 1 < n ? "," : "") << "\n";
+    }
+    out << "    ]\n";
+    out << "  }";
+  }
+  out << "\n";
+
+  out << "}\n";
+}
 
-  ofs << ss.str();
-  return true;
+std::vector<ReportFile> json_report_files(const Report& r, const ReportView& view) {
+  std::vector<ReportFile> files;
+  files.push_back({"report.json", [&r, &view](OutBuffer& out) { write_json(r, view, out); }});
+  return files;
 }
 
 } // namespace logforge
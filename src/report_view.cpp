@@ -0,0 +1,90 @@
+#include "logforge/report_writer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <thread>
+
+#include "logforge/out_buffer.hpp"
+
+namespace logforge {
+
+ReportView make_report_view(const Report& r, int top_n) {
+  ReportView view;
+  view.top_n = top_n;
+
+  auto& v = view.top_endpoints;
+  v.reserve(r.endpoint_counts.size());
+  for (auto& kv : r.endpoint_counts) v.push_back({kv.first, kv.second, 0});
+
+  const auto n = std::min(v.size(), static_cast<std::size_t>(std::max(top_n, 0)));
+  std::partial_sort(v.begin(), v.begin() + static_cast<long>(n), v.end(), [](auto& a, auto& b) {
+    return (a.count == b.count) ? (a.endpoint < b.endpoint) : (a.count > b.count);
+  });
+  v.resize(n);
+
+  if (r.endpoint_counts_approximate) {
+    for (auto& e : v) {
+      auto it = r.endpoint_count_errors.find(std::string(e.endpoint));
+      if (it != r.endpoint_count_errors.end()) e.error = it->second;
+    }
+  }
+
+  view.status.assign(r.status_counts.begin(), r.status_counts.end());
+  std::sort(view.status.begin(), view.status.end());
+  view.minutes.assign(r.per_minute_counts.begin(), r.per_minute_counts.end());
+  std::sort(view.minutes.begin(), view.minutes.end());
+  return view;
+}
+
+static bool publish_one(const ReportFile& f, const std::string& dir, OutBuffer& out) {
+  const std::string path = dir + f.name;
+  const std::string tmp_path = path + ".tmp";
+  if (!out.open(tmp_path)) return false;
+  // O rename troca o arquivo inteiro: um relatório que já existe mantém o modo que tinha
+  // (ex.: chmod feito por quem o lê), não o do .tmp recém-criado.
+  std::error_code ec;
+  const auto old = std::filesystem::status(path, ec);
+  if (!ec && std::filesystem::is_regular_file(old)) std::filesystem::permissions(tmp_path, old.permissions(), ec);
+  f.write(out);
+  if (out.close()) {
+    std::filesystem::rename(tmp_path, path, ec);
+    if (!ec) return true;
+  }
+  std::filesystem::remove(tmp_path, ec);
+  return false;
+}
+
+bool publish_report_files(const std::vector<ReportFile>& files, const std::string& out_dir, int threads) {
+  std::error_code ec;
+  std::filesystem::create_directories(out_dir, ec);
+  if (ec) return false;
+  std::string dir = out_dir;
+  if (!dir.empty() && dir.back() != '/') dir += '/';
+
+  // Cada thread pega o próximo arquivo da lista; a lista vem com os grandes primeiro
+  // (report.json, minutos), então eles começam logo.
+  if (threads <= 0) threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+  const auto n = std::min(files.size(), static_cast<std::size_t>(threads));
+  std::atomic<std::size_t> next{0};
+  std::atomic<bool> ok{true};
+  auto worker = [&] {
+    OutBuffer out;
+    for (std::size_t i = next++; i < files.size(); i = next++) {
+      if (!publish_one(files[i], dir, out)) ok = false;
+    }
+  };
+  std::vector<std::thread> pool;
+  for (std::size_t t = 1; t < n; ++t) pool.emplace_back(worker);
+  worker();
+  for (auto& t : pool) t.join();
+  return ok;
+}
+
+bool write_reports(const Report& r, const ReportView& view, const std::string& out_dir, int threads) {
+  auto files = json_report_files(r, view);
+  for (auto& f : csv_report_files(r, view)) files.push_back(std::move(f));
+  return publish_report_files(files, out_dir, threads);
+}
+
+} // namespace logforge
@@ -0,0 +1,61 @@
+#include "logforge/run_stats.hpp"
+
+#include <algorithm>
+
+#ifdef __unix__
+#include <sys/resource.h>
+#endif
+
+namespace logforge {
+
+const char* stage_name(Stage s) {
+  switch (s) {
+    case Stage::Read: return "leitura";
+    case Stage::Parse: return "parse";
+    case Stage::Aggregate: return "agregacao";
+    case Stage::Finalize: return "finalize";
+    case Stage::Write: return "escrita";
+  }
+  return "?";
+}
+
+const char* stats_clock_unit() {
+#if defined(__x86_64__) || defined(__i386__)
+  return "ciclos TSC";
+#else
+  return "ns";
+#endif
+}
+
+void RunStats::reject(RejectReason r, std::string_view line) {
+  rejects[static_cast<std::size_t>(r)]++;
+  if (rejects[static_cast<std::size_t>(r)] <= kSamplesPerReason) {
+    samples.push_back(Sample{r, std::string(line.substr(0, kSampleChars))});
+  }
+}
+
+void RunStats::merge(const RunStats& o) {
+  for (std::size_t i = 0; i < kStages; ++i) ticks[i] += o.ticks[i];
+  for (const auto& s : o.samples) {
+    const auto kept =
+        std::count_if(samples.begin(), samples.end(), [&](const Sample& x) { return x.reason == s.reason; });
+    if (static_cast<std::size_t>(kept) < kSamplesPerReason) samples.push_back(s);
+  }
+  for (std::size_t i = 0; i < kRejectReasons; ++i) rejects[i] += o.rejects[i];
+}
+
+std::uint64_t peak_rss_kib() {
+#ifdef __unix__
+  rusage ru{};
+  if (getrusage(RUSAGE_SELF, &ru) == 0) {
+#ifdef __APPLE__
+    return static_cast<std::uint64_t>(ru.ru_maxrss) / 1024; // bytes no macOS
+#else
+    return static_cast<std::uint64_t>(ru.ru_maxrss);
+#endif
+  }
+#endif
+  return 0;
+}
+
+} // namespace logforge
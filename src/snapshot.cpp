@@ -0,0 +1,128 @@
+#include "logforge/snapshot.hpp"
+
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace logforge {
+
+static constexpr char kMagic[6] = {'L', 'F', 'S', 'N', 'A', 'P'};
+static constexpr std::size_t kHeaderSize = sizeof(kMagic) + 2 + 8 + 8;
+
+static std::uint64_t fnv1a(std::string_view data) {
+  std::uint64_t h = 1469598103934665603ull;
+  for (char c : data) {
+    h ^= static_cast<unsigned char>(c);
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+static void put_le(char* p, std::uint64_t v, int bytes) {
+  for (int i = 0; i < bytes; ++i) p[i] = static_cast<char>((v >> (8 * i)) & 0xff);
+}
+
+static std::uint64_t get_le(const char* p, int bytes) {
+  std::uint64_t v = 0;
+  for (int i = 0; i < bytes; ++i) v |= static_cast<std::uint64_t>(static_cast<unsigned char>(p[i])) << (8 * i);
+  return v;
+}
+
+bool write_snapshot(const Aggregator& agg, const std::string& path) {
+  // Cabeçalho reservado na frente do buffer: o arquivo sai num write só.
+  std::string buf(kHeaderSize, '\0');
+  agg.serialize(buf);
+  const std::string_view payload(buf.data() + kHeaderSize, buf.size() - kHeaderSize);
+  std::memcpy(buf.data(), kMagic, sizeof(kMagic));
+  put_le(buf.data() + 6, kSnapshotVersion, 2);
+  put_le(buf.data() + 8, payload.size(), 8);
+  put_le(buf.data() + 16, fnv1a(payload), 8);
+
+  const std::string tmp_path = path + ".tmp";
+  bool written = false;
+  {
+    std::ofstream ofs(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!ofs.is_open()) return false;
+    ofs.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+    ofs.close();
+    written = static_cast<bool>(ofs);
+  }
+  std::error_code ec;
+  if (written) {
+    std::filesystem::rename(tmp_path, path, ec);
+    if (!ec) return true;
+  }
+  std::filesystem::remove(tmp_path, ec); // como no publish_one: sem .tmp para trás
+  return false;
+}
+
+bool read_snapshot(const std::string& path, Aggregator& out, std::string& err) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    err = "não foi possível abrir: " + path;
+    return false;
+  }
+  struct stat st {};
+  if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < kHeaderSize) {
+    ::close(fd);
+    err = "snapshot truncado: " + path;
+    return false;
+  }
+  const auto size = static_cast<std::size_t>(st.st_size);
+  void* p = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (p == MAP_FAILED) {
+    err = "falha no mmap: " + path;
+    return false;
+  }
+  ::madvise(p, size, MADV_SEQUENTIAL);
+  const auto* data = static_cast<const char*>(p);
+
+  bool ok = false;
+  if (std::memcmp(data, kMagic, sizeof(kMagic)) != 0) {
+    err = "não é um snapshot do LogForge: " + path;
+  } else if (get_le(data + 6, 2) < kSnapshotVersion) {
+    err = "snapshot de versão antiga (" + std::to_string(get_le(data + 6, 2)) +
+          ", minutos no horário local); gere de novo a partir dos logs: " + path;
+  } else if (get_le(data + 6, 2) != kSnapshotVersion) {
+    err = "versão de snapshot não suportada (" + std::to_string(get_le(data + 6, 2)) + "): " + path;
+  } else if (get_le(data + 8, 8) != size - kHeaderSize) {
+    err = "snapshot truncado: " + path;
+  } else {
+    std::string_view payload(data + kHeaderSize, size - kHeaderSize);
+    if (fnv1a(payload) != get_le(data + 16, 8)) {
+      err = "checksum inválido: " + path;
+    } else if (!out.deserialize(payload) || !payload.empty()) {
+      err = "snapshot corrompido: " + path;
+    } else {
+      ok = true;
+    }
+  }
+  ::munmap(p, size);
+  return ok;
+}
+
+bool merge_snapshots(const std::vector<std::string>& paths, Aggregator& out, std::string& err) {
+  if (paths.empty()) {
+    err = "nenhum snapshot";
+    return false;
+  }
+  if (!read_snapshot(paths[0], out, err)) return false;
+
+  Aggregator next;
+  for (std::size_t i = 1; i < paths.size(); ++i) {
+    if (!read_snapshot(paths[i], next, err)) return false;
+    if (!out.mergeable_with(next)) {
+      err = "snapshot com configuração incompatível com " + paths[0] + ": " + paths[i];
+      return false;
+    }
+    out.merge(next);
+  }
+  return true;
+}
+
+} // namespace logforge
@@ -0,0 +1,47 @@
+#include "logforge/symbol_table.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace logforge {
+
+SymbolTable::SymbolTable(const SymbolTable& other) { *this = other; }
+
+SymbolTable& SymbolTable::operator=(const SymbolTable& other) {
+  if (this == &other) return *this;
+  // As views apontam para a arena do outro objeto: re-interna tudo (mesmos ids).
+  chunks_.clear();
+  chunk_used_ = chunk_cap_ = 0;
+  names_.clear();
+  index_.clear();
+  names_.reserve(other.names_.size());
+  index_.reserve(other.names_.size());
+  for (auto s : other.names_) intern(s);
+  return *this;
+}
+
+std::string_view SymbolTable::store(std::string_view s) {
+  if (s.empty()) return {};
+  if (chunk_cap_ - chunk_used_ < s.size()) {
+    // Strings maiores que o bloco ganham um bloco só para elas.
+    chunk_cap_ = std::max(kChunkSize, s.size());
+    chunks_.push_back(std::make_unique<char[]>(chunk_cap_));
+    chunk_used_ = 0;
+  }
+  char* dst = chunks_.back().get() + chunk_used_;
+  std::memcpy(dst, s.data(), s.size());
+  chunk_used_ += s.size();
+  return std::string_view(dst, s.size());
+}
+
+std::uint32_t SymbolTable::intern(std::string_view s, std::uint64_t hash) {
+  if (const auto id = index_.find(s, hash); id != StringIndex::kNone) return id;
+
+  const auto id = static_cast<std::uint32_t>(names_.size());
+  auto stored = store(s);
+  names_.push_back(stored);
+  index_.insert(stored, hash, id);
+  return id;
+}
+
+} // namespace logforge
@@ -0,0 +1,260 @@
+#include "logforge/time_util.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cctype>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+
+namespace logforge {
+
+// Algoritmos de H. Hinnant ("chrono-compatible low-level date algorithms").
+std::int64_t days_from_civil(int year, int month, int day) {
+  const std::int64_t y = year - (month <= 2 ? 1 : 0);
+  const std::int64_t era = (y >= 0 ? y : y - 399) / 400;
+  const std::int64_t yoe = y - era * 400;
+  const std::int64_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  const std::int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+static void civil_from_days(std::int64_t z, int& year, int& month, int& day) {
+  z += 719468;
+  const std::int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+  const std::int64_t doe = z - era * 146097;
+  const std::int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const std::int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const std::int64_t mp = (5 * doy + 2) / 153;
+  day = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+  month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+  year = static_cast<int>(yoe + era * 400 + (month <= 2 ? 1 : 0));
+}
+
+std::int64_t epoch_minute(int year, int month, int day, int hour, int minute) {
+  return days_from_civil(year, month, day) * 1440 + hour * 60 + minute;
+}
+
+static void put2(char* p, int v) {
+  p[0] = static_cast<char>('0' + v / 10);
+  p[1] = static_cast<char>('0' + v % 10);
+}
+
+std::size_t format_minute(std::int64_t epoch_min, char* out) {
+  std::int64_t days = epoch_min / 1440;
+  std::int64_t rem = epoch_min % 1440;
+  if (rem < 0) {
+    rem += 1440;
+    days -= 1;
+  }
+  int year = 0, month = 0, day = 0;
+  civil_from_days(days, year, month, day);
+  const int hour = static_cast<int>(rem / 60), minute = static_cast<int>(rem % 60);
+
+  if (year < 0 || year > 9999) {
+    const int n = std::snprintf(out, kMinuteTextMax, "%04d-%02d-%02d %02d:%02d", year, month, day, hour, minute);
+    return static_cast<std::size_t>(n);
+  }
+  put2(out, year / 100);
+  put2(out + 2, year % 100);
+  out[4] = '-';
+  put2(out + 5, month);
+  out[7] = '-';
+  put2(out + 8, day);
+  out[10] = ' ';
+  put2(out + 11, hour);
+  out[13] = ':';
+  put2(out + 14, minute);
+  return 16;
+}
+
+std::string format_minute(std::int64_t epoch_min) {
+  char buf[kMinuteTextMax];
+  return std::string(buf, format_minute(epoch_min, buf));
+}
+
+static bool fixed_int(std::string_view s, std::size_t pos, std::size_t len, int& out) {
+  if (pos + len > s.size()) return false;
+  auto res = std::from_chars(s.data() + pos, s.data() + pos + len, out);
+  return res.ec == std::errc() && res.ptr == s.data() + pos + len;
+}
+
+std::optional<std::int64_t> parse_minute_text(std::string_view s) {
+  int year = 0, month = 0, day = 0, hour = 0, minute = 0;
+  if (s.size() != 10 && s.size() != 16) return std::nullopt;
+  if (!fixed_int(s, 0, 4, year) || s[4] != '-' || !fixed_int(s, 5, 2, month) || s[7] != '-' ||
+      !fixed_int(s, 8, 2, day))
+    return std::nullopt;
+  if (s.size() == 16 &&
+      ((s[10] != ' ' && s[10] != 'T') || !fixed_int(s, 11, 2, hour) || s[13] != ':' || !fixed_int(s, 14, 2, minute)))
+    return std::nullopt;
+  if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59) return std::nullopt;
+  return epoch_minute(year, month, day, hour, minute);
+}
+
+// Mês de 3 letras ("Jan".."Dec") pelos 3 bytes empacotados: hash perfeito para 32 slots
+// (multiplicação e shift) e uma comparação com a chave guardada. 0 se não for um mês.
+static constexpr std::uint32_t month_key(char a, char b, char c) {
+  return static_cast<std::uint32_t>(static_cast<unsigned char>(a)) |
+         static_cast<std::uint32_t>(static_cast<unsigned char>(b)) << 8 |
+         static_cast<std::uint32_t>(static_cast<unsigned char>(c)) << 16;
+}
+static constexpr std::uint32_t month_slot(std::uint32_t key) { return (key * 2059u) >> 27; }
+
+struct MonthSlot {
+  std::uint32_t key = 0;
+  int month = 0;
+};
+static constexpr auto kMonths = [] {
+  const char* names[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+  std::array<MonthSlot, 32> t{};
+  for (int m = 0; m < 12; ++m) {
+    const auto key = month_key(names[m][0], names[m][1], names[m][2]);
+    t[month_slot(key)] = {key, m + 1};
+  }
+  return t;
+}();
+
+static int month_to_int(std::string_view mon) {
+  if (mon.size() != 3) return 0;
+  const auto key = month_key(mon[0], mon[1], mon[2]);
+  const auto& slot = kMonths[month_slot(key)];
+  return slot.key == key ? slot.month : 0;
+}
+
+static bool trimmed_int(std::string_view sv, int& out) {
+  while (!sv.empty() && std::isspace(static_cast<unsigned char>(sv.front()))) sv.remove_prefix(1);
+  while (!sv.empty() && std::isspace(static_cast<unsigned char>(sv.back()))) sv.remove_suffix(1);
+  if (sv.empty()) return false;
+  auto res = std::from_chars(sv.data(), sv.data() + sv.size(), out);
+  return res.ec == std::errc() && res.ptr == sv.data() + sv.size();
+}
+
+// "+hhmm", "-hhmm" ou "+hh:mm" -> minutos a leste de UTC; false se não for um fuso.
+static bool utc_offset(std::string_view s, int& minutes) {
+  if (s.size() == 6 && s[3] == ':') {
+    char buf[5] = {s[0], s[1], s[2], s[4], s[5]};
+    return utc_offset(std::string_view(buf, 5), minutes);
+  }
+  if (s.size() != 5 || (s[0] != '+' && s[0] != '-')) return false;
+  // Quatro dígitos (from_chars aceitaria "+-530").
+  int hhmm = 0;
+  for (std::size_t i = 1; i < 5; ++i) {
+    if (s[i] < '0' || s[i] > '9') return false;
+    hhmm = hhmm * 10 + (s[i] - '0');
+  }
+  minutes = (hhmm / 100 * 60 + hhmm % 100) * (s[0] == '-' ? -1 : 1);
+  return true;
+}
+
+// Formato qualquer ("1/Oct/2000:...", espaços, sem fuso): o parse de antes, com find.
+static std::optional<std::int64_t> parse_time_local_slow(std::string_view t) {
+  auto slash1 = t.find('/');
+  if (slash1 == std::string_view::npos) return std::nullopt;
+  auto slash2 = t.find('/', slash1 + 1);
+  if (slash2 == std::string_view::npos) return std::nullopt;
+  auto colon1 = t.find(':', slash2 + 1);
+  if (colon1 == std::string_view::npos) return std::nullopt;
+
+  std::string_view day_sv = t.substr(0, slash1);
+  std::string_view mon_sv = t.substr(slash1 + 1, slash2 - (slash1 + 1));
+  std::string_view year_sv = t.substr(slash2 + 1, colon1 - (slash2 + 1));
+
+  // HH:MM (logo depois do primeiro ':')
+  if (colon1 + 4 >= t.size()) return std::nullopt;
+  std::string_view hh_sv = t.substr(colon1 + 1, 2);
+  std::string_view mm_sv = t.substr(colon1 + 4, 2);
+
+  int day = 0, year = 0, hh = 0, mm = 0;
+  if (!trimmed_int(day_sv, day)) return std::nullopt;
+  if (!trimmed_int(year_sv, year)) return std::nullopt;
+  if (!trimmed_int(hh_sv, hh)) return std::nullopt;
+  if (!trimmed_int(mm_sv, mm)) return std::nullopt;
+
+  int mon = month_to_int(mon_sv);
+  if (mon == 0) return std::nullopt;
+
+  // Fuso: o token depois do horário; sem ele, o horário já é tomado como UTC.
+  int offset = 0;
+  auto rest = t.substr(colon1);
+  while (!rest.empty() && std::isspace(static_cast<unsigned char>(rest.back()))) rest.remove_suffix(1);
+  const auto sp = rest.rfind(' ');
+  if (sp != std::string_view::npos && !utc_offset(rest.substr(sp + 1), offset)) return std::nullopt;
+
+  return epoch_minute(year, mon, day, hh, mm) - offset;
+}
+
+static std::uint64_t load8(const char* p) {
+  std::uint64_t v;
+  std::memcpy(&v, p, 8);
+  return v;
+}
+
+// Bytes 18..25 sem os dois primeiros (os segundos, que não mudam o minuto).
+static constexpr std::uint64_t kNoSeconds =
+    std::endian::native == std::endian::little ? ~std::uint64_t{0xFFFF} : ~(std::uint64_t{0xFFFF} << 48);
+
+// "dd/Mon/yyyy:HH:MM:SS +zzzz" em largura fixa (26 bytes), sem desvios até o fim: dígitos,
+// separadores e mês são validados num acumulador só.
+static bool decode_fixed(const char* p, std::int64_t& minute) {
+  auto d = [p](int i) { return static_cast<unsigned>(static_cast<unsigned char>(p[i])) - '0'; };
+  static constexpr int kDigits[] = {0, 1, 7, 8, 9, 10, 12, 13, 15, 16, 22, 23, 24, 25};
+  unsigned bad = 0;
+  for (int i : kDigits) bad |= static_cast<unsigned>(d(i) > 9);
+  bad |= static_cast<unsigned>(p[2] != '/') | static_cast<unsigned>(p[6] != '/') |
+         static_cast<unsigned>(p[11] != ':') | static_cast<unsigned>(p[14] != ':') |
+         static_cast<unsigned>(p[17] != ':') | static_cast<unsigned>(p[20] != ' ') |
+         (static_cast<unsigned>(p[21] != '+') & static_cast<unsigned>(p[21] != '-'));
+  const auto key = month_key(p[3], p[4], p[5]);
+  const auto& slot = kMonths[month_slot(key)];
+  bad |= static_cast<unsigned>(slot.key != key);
+  if (bad) return false;
+
+  const int day = static_cast<int>(d(0) * 10 + d(1));
+  const int year = static_cast<int>(d(7) * 1000 + d(8) * 100 + d(9) * 10 + d(10));
+  const int hh = static_cast<int>(d(12) * 10 + d(13));
+  const int mm = static_cast<int>(d(15) * 10 + d(16));
+  const int offset = static_cast<int>((d(22) * 10 + d(23)) * 60 + d(24) * 10 + d(25));
+  minute = epoch_minute(year, slot.month, day, hh, mm) - (p[21] == '-' ? -offset : offset);
+  return true;
+}
+
+// Último $time_local de largura fixa decodificado, por thread (o parser é compartilhado
+// entre as threads da ingestão). Linhas vizinhas quase sempre caem no mesmo minuto e fuso.
+struct TimeLocalCache {
+  std::uint64_t w0 = 0, w1 = 0, w2 = 0; // bytes 0..7, 8..15 e 18..25 (sem os segundos)
+  char c16 = 0;                         // byte 16 (unidade do minuto)
+  std::int64_t minute = 0;
+  bool valid = false;
+};
+static thread_local TimeLocalCache t_time_cache;
+
+std::optional<std::int64_t> parse_time_local(std::string_view t) {
+  // "10/Oct/2000:13:55:36 -0700" -> minutos UTC desde a época de "2000-10-10 20:55"
+  if (t.size() != 26) return parse_time_local_slow(t);
+  const char* p = t.data();
+  auto& c = t_time_cache;
+  const auto w0 = load8(p), w1 = load8(p + 8), w2 = load8(p + 18) & kNoSeconds;
+  if (c.valid && ((w0 ^ c.w0) | (w1 ^ c.w1) | (w2 ^ c.w2) | static_cast<std::uint64_t>(p[16] ^ c.c16)) == 0) {
+    return c.minute;
+  }
+  std::int64_t minute = 0;
+  if (!decode_fixed(p, minute)) return parse_time_local_slow(t);
+  c = TimeLocalCache{w0, w1, w2, p[16], minute, true};
+  return minute;
+}
+
+std::optional<std::int64_t> parse_time_iso8601(std::string_view t) {
+  // "AAAA-MM-DDTHH:MM", depois ":SS", frações e o fuso ('Z', "+hh:mm" ou "+hhmm").
+  if (t.size() < 16 || (t.size() > 16 && t[16] != ':')) return std::nullopt;
+  const auto minute = parse_minute_text(t.substr(0, 16));
+  if (!minute) return std::nullopt;
+  std::size_t i = std::min<std::size_t>(19, t.size());
+  while (i < t.size() && (t[i] == '.' || std::isdigit(static_cast<unsigned char>(t[i])))) ++i;
+  int offset = 0;
+  if (i < t.size() && t.substr(i) != "Z" && !utc_offset(t.substr(i), offset)) return std::nullopt;
+  return *minute - offset;
+}
+
+} // namespace logforge
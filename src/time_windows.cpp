@@ -0,0 +1,285 @@
+#include "logforge/time_windows.hpp"
+
+#include <algorithm>
+#include <string_view>
+
+#include "logforge/varint.hpp"
+
+namespace logforge {
+
+static double us_to_ms(double us) { return us / 1000.0; }
+
+TimeWindows::TimeWindows(const WindowOptions& opt) : opt_(opt) {
+  if (opt_.width_min < 1) opt_.width_min = 1;
+  if (opt_.ring < 1) opt_.ring = 1;
+  if (opt_.sliding < 0) opt_.sliding = 0;
+  if (opt_.hll_precision != 0) {
+    opt_.hll_precision = std::clamp(opt_.hll_precision, HyperLogLog::kMinPrecision, HyperLogLog::kMaxPrecision);
+  }
+  ring_.resize(opt_.ring);
+  for (auto& s : ring_) s.stats.clients = HyperLogLog(opt_.hll_precision);
+}
+
+std::int64_t TimeWindows::window_of(std::int64_t minute) const {
+  // Divisão com piso: minutos antes de 1970 também caem na janela certa.
+  const std::int64_t w = opt_.width_min;
+  return (minute >= 0) ? minute / w : -((-minute + w - 1) / w);
+}
+
+TimeWindows::Slot& TimeWindows::slot(std::int64_t id) {
+  const auto n = static_cast<std::int64_t>(ring_.size());
+  Slot& s = ring_[static_cast<std::size_t>(((id % n) + n) % n)];
+  if (s.id != id) {
+    s.id = id;
+    s.stats.clear(); // reaproveita os buckets da janela anterior deste slot
+  }
+  return s;
+}
+
+bool TimeWindows::in_ring(std::int64_t id) const {
+  return head_ != kNoWindow && id <= head_ && id > head_ - static_cast<std::int64_t>(ring_.size());
+}
+
+void TimeWindows::close(Slot& s) {
+  if (s.id == kNoWindow) return;
+  if (opt_.keep_closed) merge_closed(s.id, s.stats);
+  s.id = kNoWindow;
+  s.stats.clear();
+}
+
+void TimeWindows::advance(std::int64_t id) {
+  if (head_ != kNoWindow && id <= head_) return;
+  if (head_ != kNoWindow) {
+    // Saem do anel as janelas em (head_ - n, id - n]; no máximo n slots a visitar.
+    const auto n = static_cast<std::int64_t>(ring_.size());
+    const std::int64_t first = head_ - n + 1;
+    const std::int64_t last = std::min(head_, id - n);
+    for (std::int64_t w = first; w <= last; ++w) {
+      Slot& s = ring_[static_cast<std::size_t>(((w % n) + n) % n)];
+      if (s.id == w) close(s);
+    }
+  }
+  head_ = id;
+}
+
+EndpointStats TimeWindows::open(const ClosedWindow& c) {
+  EndpointStats st;
+  st.count = c.count;
+  for (int i = 0; i < 5; ++i) st.status_classes[i] = c.status_classes[i];
+  std::string_view in = c.latency;
+  st.latency.deserialize(in);
+  st.clients = c.clients;
+  return st;
+}
+
+TimeWindows::ClosedWindow TimeWindows::compact(const EndpointStats& st) {
+  ClosedWindow c;
+  c.count = st.count;
+  for (int i = 0; i < 5; ++i) c.status_classes[i] = st.status_classes[i];
+  st.latency.serialize(c.latency);
+  c.clients = st.clients;
+  return c;
+}
+
+void TimeWindows::merge_closed(std::int64_t id, const EndpointStats& st) {
+  auto it = closed_.find(id);
+  if (it == closed_.end()) {
+    closed_.emplace(id, compact(st));
+    return;
+  }
+  EndpointStats merged = open(it->second);
+  merged.merge(st);
+  it->second = compact(merged);
+}
+
+void TimeWindows::add(std::int64_t minute, int status, std::int64_t latency_us, const std::uint64_t* client_hash) {
+  const std::int64_t id = window_of(minute);
+  if (head_ == kNoWindow || id > head_) advance(id);
+  else if (!in_ring(id)) {
+    if (!opt_.keep_closed) {
+      late_++;
+      return;
+    }
+    auto [it, fresh] = late_windows_.try_emplace(id);
+    if (fresh) it->second.clients = HyperLogLog(opt_.hll_precision);
+    it->second.add(status, latency_us, client_hash);
+    return;
+  }
+  slot(id).stats.add(status, latency_us, client_hash);
+}
+
+std::vector<std::pair<std::int64_t, EndpointStats>> TimeWindows::closed_stats() const {
+  std::vector<std::pair<std::int64_t, EndpointStats>> out;
+  out.reserve(closed_.size() + late_windows_.size());
+  auto late = late_windows_.begin();
+  for (const auto& [id, c] : closed_) {
+    for (; late != late_windows_.end() && late->first < id; ++late) out.emplace_back(*late);
+    out.emplace_back(id, open(c));
+    if (late != late_windows_.end() && late->first == id) out.back().second.merge((late++)->second);
+  }
+  for (; late != late_windows_.end(); ++late) out.emplace_back(*late);
+  return out;
+}
+
+std::size_t TimeWindows::closed_count() const {
+  std::size_t n = closed_.size();
+  for (const auto& kv : late_windows_) n += !closed_.count(kv.first);
+  return n;
+}
+
+void TimeWindows::merge_window(std::int64_t id, const EndpointStats& st) {
+  if (head_ == kNoWindow || id > head_) advance(id);
+  if (in_ring(id)) {
+    slot(id).stats.merge(st);
+  } else if (opt_.keep_closed) {
+    merge_closed(id, st);
+  } else {
+    late_ += st.count;
+  }
+}
+
+void TimeWindows::merge(const TimeWindows& other) {
+  late_ += other.late_;
+  // Em ordem crescente, para o anel avançar uma vez só.
+  for (const auto& [id, st] : other.closed_stats()) merge_window(id, st);
+
+  std::vector<const Slot*> open_slots;
+  for (const auto& s : other.ring_) if (s.id != kNoWindow) open_slots.push_back(&s);
+  std::sort(open_slots.begin(), open_slots.end(), [](const Slot* a, const Slot* b) { return a->id < b->id; });
+  for (const Slot* s : open_slots) merge_window(s->id, s->stats);
+}
+
+void TimeWindows::serialize(std::string& out) const {
+  put_varint(out, static_cast<std::uint64_t>(opt_.width_min));
+  put_varint(out, opt_.ring);
+  put_varint(out, static_cast<std::uint64_t>(opt_.sliding));
+  put_varint(out, opt_.keep_closed ? 1 : 0);
+  put_varint(out, static_cast<std::uint64_t>(opt_.hll_precision));
+  put_varint(out, late_);
+  put_varint(out, head_ == kNoWindow ? 0 : 1);
+  if (head_ != kNoWindow) put_varint(out, zigzag(head_));
+
+  // Fechadas: ids em delta (crescentes no map), sketch já serializado. As linhas atrasadas
+  // entram na janela delas: quem lê vê só fechadas.
+  put_varint(out, closed_count());
+  std::int64_t prev = 0;
+  auto put_closed = [&](std::int64_t id, const ClosedWindow& c) {
+    put_varint(out, zigzag(id - prev));
+    prev = id;
+    put_varint(out, c.count);
+    for (auto v : c.status_classes) put_varint(out, v);
+    put_varint(out, c.latency.size());
+    out.append(c.latency);
+    c.clients.serialize(out);
+  };
+  if (late_windows_.empty()) {
+    for (const auto& [id, c] : closed_) put_closed(id, c);
+  } else {
+    for (const auto& [id, st] : closed_stats()) put_closed(id, compact(st));
+  }
+
+  std::uint64_t open_slots = 0;
+  for (const auto& s : ring_) open_slots += (s.id != kNoWindow);
+  put_varint(out, open_slots);
+  for (const auto& s : ring_) {
+    if (s.id == kNoWindow) continue;
+    put_varint(out, zigzag(s.id));
+    s.stats.serialize(out);
+  }
+}
+
+bool TimeWindows::deserialize(std::string_view& in) {
+  std::uint64_t width = 0, ring = 0, sliding = 0, keep = 0, hll = 0, has_head = 0, n = 0, v = 0;
+  if (!get_varint(in, width) || !get_varint(in, ring) || !get_varint(in, sliding) || !get_varint(in, keep) ||
+      !get_varint(in, hll))
+    return false;
+  if (width < 1 || width > (1u << 20) || ring < 1 || ring > (1u << 20) || sliding > (1u << 20) || keep > 1 ||
+      hll > HyperLogLog::kMaxPrecision)
+    return false;
+
+  WindowOptions opt;
+  opt.width_min = static_cast<int>(width);
+  opt.ring = static_cast<std::size_t>(ring);
+  opt.sliding = static_cast<int>(sliding);
+  opt.keep_closed = (keep != 0);
+  opt.hll_precision = static_cast<int>(hll);
+  TimeWindows tw(opt);
+
+  if (!get_varint(in, tw.late_) || !get_varint(in, has_head)) return false;
+  if (has_head) {
+    if (!get_varint(in, v)) return false;
+    tw.head_ = unzigzag(v);
+  }
+
+  if (!get_varint(in, n)) return false;
+  std::int64_t id = 0;
+  for (std::uint64_t i = 0; i < n; ++i) {
+    ClosedWindow c;
+    std::uint64_t len = 0;
+    if (!get_varint(in, v) || !get_varint(in, c.count)) return false;
+    id += unzigzag(v);
+    for (auto& cls : c.status_classes) {
+      if (!get_varint(in, cls)) return false;
+    }
+    if (!get_varint(in, len) || len > in.size()) return false;
+    c.latency.assign(in.substr(0, static_cast<std::size_t>(len)));
+    in.remove_prefix(static_cast<std::size_t>(len));
+    if (!c.clients.deserialize(in)) return false;
+    tw.closed_.emplace(id, std::move(c));
+  }
+
+  if (!get_varint(in, n) || n > tw.ring_.size()) return false;
+  for (std::uint64_t i = 0; i < n; ++i) {
+    if (!get_varint(in, v)) return false;
+    const std::int64_t sid = unzigzag(v);
+    if (!tw.in_ring(sid)) return false;
+    if (!tw.slot(sid).stats.deserialize(in)) return false;
+  }
+
+  *this = std::move(tw);
+  return true;
+}
+
+std::vector<WindowRow> TimeWindows::rows() const {
+  std::vector<std::pair<std::int64_t, EndpointStats>> all = closed_stats();
+  all.reserve(all.size() + ring_.size());
+  for (const auto& s : ring_) if (s.id != kNoWindow) all.emplace_back(s.id, s.stats);
+  std::sort(all.begin(), all.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+  const double width_sec = 60.0 * opt_.width_min;
+  std::vector<WindowRow> rows;
+  rows.reserve(all.size());
+  std::size_t lo = 0; // primeira janela dentro do agregado deslizante
+  for (std::size_t i = 0; i < all.size(); ++i) {
+    const auto& [id, st] = all[i];
+    WindowRow row;
+    row.start_minute = id * opt_.width_min;
+    row.count = st.count;
+    for (int k = 0; k < 5; ++k) row.status_classes[k] = st.status_classes[k];
+    row.rps = static_cast<double>(st.count) / width_sec;
+    if (st.count > 0) row.error_rate = static_cast<double>(st.status_classes[4]) / static_cast<double>(st.count);
+    if (st.latency.count() > 0) {
+      row.p50_ms = us_to_ms(st.latency.quantile(0.50));
+      row.p95_ms = us_to_ms(st.latency.quantile(0.95));
+      row.p99_ms = us_to_ms(st.latency.quantile(0.99));
+    }
+    row.unique_clients = st.clients.estimate();
+
+    if (opt_.sliding > 0) {
+      while (all[lo].first <= id - opt_.sliding) ++lo;
+      EndpointStats acc;
+      for (std::size_t j = lo; j <= i; ++j) acc.merge(all[j].second);
+      row.sliding_count = acc.count;
+      row.sliding_rps = static_cast<double>(acc.count) / (width_sec * opt_.sliding);
+      if (acc.count > 0) {
+        row.sliding_error_rate = static_cast<double>(acc.status_classes[4]) / static_cast<double>(acc.count);
+      }
+      if (acc.latency.count() > 0) row.sliding_p99_ms = us_to_ms(acc.latency.quantile(0.99));
+      row.sliding_unique_clients = acc.clients.estimate();
+    }
+    rows.push_back(row);
+  }
+  return rows;
+}
+
+} // namespace logforge
@@ -1,12 +1,16 @@
 #include <catch2/catch_test_macros.hpp>
 #include "logforge/aggregator.hpp"
+#include "logforge/time_util.hpp"
+
+static const std::int64_t kMin0 = logforge::epoch_minute(2025, 1, 1, 0, 0);
+static const std::int64_t kMin1 = kMin0 + 1;
 
 TEST_CASE("Aggregator counts status and endpoints") {
   logforge::Aggregator agg(10);
 
-  logforge::LogEntry a{"/a", 200, 100, "2025-01-01 00:00"};
-  logforge::LogEntry b{"/b", 404, 200, "2025-01-01 00:00"};
-  logforge::LogEntry c{"/a", 200, 300, "2025-01-01 00:01"};
+  logforge::LogEntry a{"/a", 200, 100000, kMin0};
+  logforge::LogEntry b{"/b", 404, 200000, kMin0};
+  logforge::LogEntry c{"/a", 200, 300000, kMin1};
 
   agg.add_valid(a);
   agg.add_valid(b);
@@ -23,10 +27,45 @@ TEST_CASE("Aggregator counts status and endpoints") {
   CHECK(r.status_counts.at(404) == 1);
   CHECK(r.endpoint_counts.at("/a") == 2);
   CHECK(r.endpoint_counts.at("/b") == 1);
-  CHECK(r.per_minute_counts.at("2025-01-01 00:00") == 2);
-  CHECK(r.per_minute_counts.at("2025-01-01 00:01") == 1);
+  CHECK(r.per_minute_counts.at(kMin0) == 2);
+  CHECK(r.per_minute_counts.at(kMin1) == 1);
 
   CHECK(r.latency.count == 3);
   CHECK(r.latency.min_ms == 100);
   CHECK(r.latency.max_ms == 300);
 }
+
+TEST_CASE("Aggregator merge matches single aggregator") {
+  logforge::LogEntry a{"/a", 200, 100000, kMin0};
+  logforge::LogEntry b{"/b", 500, 20000000, kMin0};
+  logforge::LogEntry c{"/a", 200, 7000, kMin1};
+
+  logforge::Aggregator all(10);
+  all.add_valid(a);
+  all.add_valid(b);
+  all.add_invalid();
+  all.add_valid(c);
+
+  logforge::Aggregator left(10), right(10), empty(10);
+  left.add_valid(a);
+  left.add_valid(b);
+  right.add_invalid();
+  right.add_valid(c);
+  left.merge(right);
+  left.merge(empty);
+
+  auto r1 = all.finalize();
+  auto r2 = left.finalize();
+
+  CHECK(r2.total_lines == r1.total_lines);
+  CHECK(r2.invalid_lines == r1.invalid_lines);
+  CHECK(r2.status_counts == r1.status_counts);
+  CHECK(r2.endpoint_counts == r1.endpoint_counts);
+  CHECK(r2.per_minute_counts == r1.per_minute_counts);
+  CHECK(r2.latency.count == r1.latency.count);
+  CHECK(r2.latency.min_ms == 7);
+  CHECK(r2.latency.max_ms == 20000);
+  CHECK(r2.latency.avg_ms == r1.latency.avg_ms);
+  CHECK(r2.latency.p50_ms == r1.latency.p50_ms);
+  CHECK(r2.latency.p99_ms == r1.latency.p99_ms);
+}
@@ -0,0 +1,51 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string_view>
+
+#include "logforge/aggregator.hpp"
+#include "logforge/parser_nginx.hpp"
+
+// Alocador global com contador: substitui operator new/delete só neste binário de teste.
+static std::atomic<std::uint64_t> g_allocs{0};
+
+void* operator new(std::size_t n) {
+  g_allocs.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(n ? n : 1)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+TEST_CASE("Parse + aggregate allocate nothing per line in steady state") {
+  const std::string_view lines[] = {
+      "127.0.0.1 - - [10/Oct/2000:13:55:36 -0700] \"GET /api/items?id=1 HTTP/1.1\" 200 2326 \"-\" "
+      "\"Mozilla/5.0\" 0.245",
+      "2001:db8::1 - - [10/Oct/2000:13:56:01 -0700] \"POST https://example.com/api/checkout "
+      "HTTP/1.1\" 500 42 \"-\" \"Mozilla/5.0\" 0.510",
+      "127.0.0.1 - - [10/Oct/2000:13:56:15 -0700] \"GET /health HTTP/1.1\" 200 5 \"-\" \"curl\"",
+      "MALFORMED LINE SHOULD BE COUNTED AS INVALID",
+  };
+
+  logforge::NginxParser parser;
+  logforge::Aggregator agg(10);
+  auto feed = [&] {
+    for (auto line : lines) {
+      auto e = parser.parse_line(line);
+      if (e) agg.add_valid(*e);
+      else agg.add_invalid();
+    }
+  };
+
+  feed(); // aquece: primeiras ocorrências de endpoint/status/minuto alocam nós
+
+  const auto before = g_allocs.load();
+  REQUIRE(before > 0); // o contador está de fato ativo
+  for (int i = 0; i < 1000; ++i) feed();
+  const auto after = g_allocs.load();
+
+  CHECK(after - before == 0);
+  CHECK(agg.finalize().total_lines == 4 * 1001);
+}
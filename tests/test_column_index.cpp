@@ -0,0 +1,267 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "logforge/column_index.hpp"
+#include "logforge/filter.hpp"
+#include "logforge/ingest.hpp"
+#include "logforge/time_util.hpp"
+
+static const std::int64_t kMin0 = logforge::epoch_minute(2025, 1, 1, 0, 0);
+
+static std::string temp_path(const std::string& name) {
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+static std::string write_log(const std::string& name, int lines) {
+  auto path = temp_path(name);
+  std::ofstream ofs(path);
+  const char* eps[] = {"/a", "/b?x=1", "/users/42", "/users/7", "/api/items"};
+  for (int i = 0; i < lines; ++i) {
+    if (i % 13 == 0) {
+      ofs << "not a log line " << i << "\n";
+      continue;
+    }
+    const int minute = i / 20;
+    ofs << "10.0.0.1 - - [01/Jan/2025:" << (minute / 60 < 10 ? "0" : "") << minute / 60 << ":"
+        << (minute % 60 < 10 ? "0" : "") << minute % 60 << ":00 -0300] \"GET " << eps[i % 5] << " HTTP/1.1\" "
+        << (i % 7 ? 200 : 503) << " 12 \"-\" \"curl/8.0\"";
+    if (i % 11) ofs << " 0." << (100 + i % 900);
+    ofs << "\n";
+  }
+  return path;
+}
+
+static void check_same(const logforge::Report& a, const logforge::Report& b) {
+  CHECK(a.total_lines == b.total_lines);
+  CHECK(a.parsed_lines == b.parsed_lines);
+  CHECK(a.invalid_lines == b.invalid_lines);
+  CHECK(a.filtered_lines == b.filtered_lines);
+  CHECK(a.status_counts == b.status_counts);
+  CHECK(a.endpoint_counts == b.endpoint_counts);
+  CHECK(a.per_minute_counts == b.per_minute_counts);
+  CHECK(a.latency.count == b.latency.count);
+  CHECK(a.latency.min_ms == b.latency.min_ms);
+  CHECK(a.latency.max_ms == b.latency.max_ms);
+  CHECK(a.latency.p99_ms == b.latency.p99_ms);
+}
+
+TEST_CASE("query over the index reproduces the text report") {
+  const auto log = write_log("logforge_index.log", 5000);
+  const auto idx_path = temp_path("logforge_index.lfx");
+
+  logforge::IndexBuildStats st;
+  std::string err;
+  REQUIRE(logforge::build_index({log}, logforge::IngestOptions{}, idx_path, &st, err));
+  CHECK(st.total_lines == 5000);
+  CHECK(st.endpoints == 5);
+
+  logforge::ColumnIndex index;
+  REQUIRE(index.open(idx_path, err));
+  CHECK(index.total_lines() == 5000);
+  CHECK(index.rows() + index.invalid_lines() == 5000);
+
+  logforge::PathNormalizer normalizer;
+  for (const logforge::PathNormalizer* norm : {static_cast<const logforge::PathNormalizer*>(nullptr),
+                                               static_cast<const logforge::PathNormalizer*>(&normalizer)}) {
+    // Caminho por coluna (padrão) e por linha (--endpoint-stats / --window).
+    for (bool rows : {false, true}) {
+      INFO("normalize=" << (norm != nullptr) << " rows=" << rows);
+      logforge::AggregatorOptions opt;
+      if (rows) {
+        opt.endpoint_stats_capacity = 8;
+        opt.windows.width_min = 5;
+      }
+      logforge::IngestOptions iopt;
+      iopt.normalizer = norm;
+      logforge::Aggregator text(opt);
+      REQUIRE(logforge::ingest_file(log, iopt, text));
+
+      for (int threads : {1, 3}) {
+        logforge::Aggregator scanned(opt);
+        logforge::query_index(index, logforge::IndexQuery{}, norm, threads, scanned);
+        const auto a = text.finalize();
+        const auto b = scanned.finalize();
+        check_same(a, b);
+        CHECK(a.endpoint_latency.size() == b.endpoint_latency.size());
+        CHECK(a.windows.size() == b.windows.size());
+      }
+    }
+  }
+  std::remove(log.c_str());
+  std::remove(idx_path.c_str());
+}
+
+TEST_CASE("query --where counts invalid and filtered lines like the text run") {
+  // Linhas inválidas depois de um timestamp válido, dentro e fora do filtro de tempo.
+  const auto log = temp_path("logforge_where_invalid.log");
+  {
+    std::ofstream ofs(log);
+    for (int i = 0; i < 600; ++i) {
+      const int hour = i / 100;
+      ofs << "10.0.0.1 - - [01/Jan/2025:0" << hour << ":00:00 -0300] ";
+      if (i % 9 == 0) ofs << "\"GET\" 200 1\n";                        // sem path
+      else if (i % 9 == 1) ofs << "\"GET /a HTTP/1.1\" abc 1\n";       // status inválido
+      else ofs << "\"GET /a HTTP/1.1\" " << (i % 4 ? 200 : 500) << " 1 \"-\" \"x\" 0.1\n";
+    }
+  }
+  const auto idx_path = temp_path("logforge_where_invalid.lfx");
+  std::string err;
+  REQUIRE(logforge::build_index({log}, logforge::IngestOptions{}, idx_path, nullptr, err));
+  logforge::ColumnIndex index;
+  REQUIRE(index.open(idx_path, err));
+
+  logforge::Filter f;
+  REQUIRE(f.compile("time >= 05:00 and status = 5xx", err));
+  logforge::IngestOptions iopt;
+  iopt.filter = &f;
+  logforge::Aggregator text(10);
+  REQUIRE(logforge::ingest_file(log, iopt, text));
+
+  logforge::IndexQuery q;
+  q.where = &f;
+  logforge::Aggregator scanned(10);
+  logforge::query_index(index, q, nullptr, 1, scanned);
+  const auto a = text.finalize();
+  const auto b = scanned.finalize();
+  check_same(a, b);
+  CHECK(a.invalid_lines == 134);
+  std::remove(log.c_str());
+  std::remove(idx_path.c_str());
+}
+
+TEST_CASE("zone maps skip blocks outside the time and status filter") {
+  const auto idx_path = temp_path("logforge_zone.lfx");
+  logforge::IndexWriter w(idx_path, 100);
+  REQUIRE(w.ok());
+  logforge::Aggregator expected(10);
+  logforge::IndexQuery q;
+  q.from_minute = kMin0 + 30;
+  q.to_minute = kMin0 + 45;
+  q.status_min = 500;
+  q.status_max = 599;
+  for (int i = 0; i < 1000; ++i) {
+    logforge::LogEntry e;
+    e.endpoint = (i % 3) ? "/x" : "/y";
+    e.status = (i % 10 == 0) ? 500 : 200;
+    e.latency_us = i;
+    e.minute = kMin0 + i / 10; // 10 linhas por minuto, 100 por bloco
+    w.add_valid(e);
+    if (e.minute >= q.from_minute && e.minute < q.to_minute && e.status >= 500) {
+      expected.add_valid(e);
+    } else {
+      expected.add_filtered();
+    }
+  }
+  w.add_invalid();
+  expected.add_invalid();
+  REQUIRE(w.finish());
+
+  logforge::ColumnIndex index;
+  std::string err;
+  REQUIRE(index.open(idx_path, err));
+  CHECK(index.block_count() == 10);
+
+  logforge::Aggregator got(10);
+  logforge::IndexScanStats st;
+  logforge::query_index(index, q, nullptr, 1, got, &st);
+  check_same(expected.finalize(), got.finalize());
+  CHECK(st.blocks_skipped == 8); // só os blocos dos minutos 20-39 e 40-59 são lidos
+  CHECK(st.rows_scanned == 200);
+  CHECK(st.rows_matched == 15);
+  CHECK(got.finalize().invalid_lines == 1);
+  CHECK(got.finalize().filtered_lines == 985);
+
+  // Filtro numa classe que nenhum bloco tem: nada é lido.
+  logforge::IndexQuery q4;
+  q4.status_min = 400;
+  q4.status_max = 499;
+  logforge::Aggregator none(10);
+  logforge::query_index(index, q4, nullptr, 2, none, &st);
+  CHECK(st.blocks_skipped == 10);
+  CHECK(none.finalize().parsed_lines == 0);
+  std::remove(idx_path.c_str());
+}
+
+TEST_CASE("wide status and latency columns round-trip") {
+  const auto idx_path = temp_path("logforge_wide.lfx");
+  logforge::IndexWriter w(idx_path, 4);
+  logforge::Aggregator expected(10);
+  const std::int64_t latencies[] = {-1, 0, 5'000'000'000, 12, -1, 7};
+  const int statuses[] = {200, 70000, -1, 404, 200, 200};
+  for (int i = 0; i < 6; ++i) {
+    logforge::LogEntry e;
+    e.endpoint = "/w";
+    e.status = statuses[i];
+    e.latency_us = latencies[i];
+    e.minute = kMin0 - i; // fora de ordem: deltas negativos
+    w.add_valid(e);
+    expected.add_valid(e);
+  }
+  REQUIRE(w.finish());
+
+  logforge::ColumnIndex index;
+  std::string err;
+  REQUIRE(index.open(idx_path, err));
+  CHECK(index.block(0).status_width == 4);
+  CHECK(index.block(0).latency_width == 8);
+  CHECK(index.block(1).status_width == 2);
+  CHECK(index.block(1).latency_width == 4);
+
+  logforge::Aggregator got(10);
+  logforge::query_index(index, logforge::IndexQuery{}, nullptr, 1, got);
+  check_same(expected.finalize(), got.finalize());
+  std::remove(idx_path.c_str());
+}
+
+TEST_CASE("damaged index files are rejected") {
+  const auto idx_path = temp_path("logforge_bad.lfx");
+  {
+    logforge::IndexWriter w(idx_path, 8);
+    for (int i = 0; i < 50; ++i) {
+      logforge::LogEntry e;
+      e.endpoint = "/e";
+      e.status = 200;
+      e.minute = kMin0;
+      w.add_valid(e);
+    }
+    REQUIRE(w.finish());
+  }
+  std::string bytes;
+  {
+    std::ifstream ifs(idx_path, std::ios::binary);
+    bytes.assign(std::istreambuf_iterator<char>(ifs), {});
+  }
+  auto write_variant = [&](const std::string& data) {
+    std::ofstream ofs(idx_path, std::ios::binary | std::ios::trunc);
+    ofs.write(data.data(), static_cast<std::streamsize>(data.size()));
+  };
+
+  logforge::ColumnIndex index;
+  std::string err;
+  REQUIRE(index.open(idx_path, err));
+
+  write_variant(bytes.substr(0, bytes.size() - 10));
+  CHECK_FALSE(index.open(idx_path, err));
+
+  std::string bad = bytes;
+  bad[6] = 9; // versão
+  write_variant(bad);
+  CHECK_FALSE(index.open(idx_path, err));
+  CHECK(err.find("versão") != std::string::npos);
+  bad[6] = 1; // minutos no horário local
+  write_variant(bad);
+  CHECK_FALSE(index.open(idx_path, err));
+  CHECK(err.find("versão antiga") != std::string::npos);
+
+  bad = bytes;
+  bad[bytes.size() - 64 * 7 + 8] = 100; // linhas de um bloco além de block_rows
+  write_variant(bad);
+  CHECK_FALSE(index.open(idx_path, err));
+
+  CHECK_FALSE(index.open(temp_path("logforge_missing.lfx"), err));
+  std::remove(idx_path.c_str());
+}
@@ -0,0 +1,146 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "logforge/compressed_reader.hpp"
+#include "logforge/ingest.hpp"
+
+#ifdef LOGFORGE_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef LOGFORGE_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+static std::string make_log(int lines) {
+  std::string s;
+  const char* eps[] = {"/a", "/b?x=1", "/c", "/api/items"};
+  for (int i = 0; i < lines; ++i) {
+    if (i % 13 == 0) {
+      s += "garbage line " + std::to_string(i) + "\n";
+      continue;
+    }
+    s += "10.0.0.1 - - [01/Jan/2025:00:" + std::to_string(10 + (i / 60) % 50) + ":" +
+         std::to_string(10 + i % 50) + " -0300] \"GET " + eps[i % 4] + " HTTP/1.1\" " +
+         (i % 5 ? "200" : "503") + " 12 \"-\" \"curl/8.0\" 0." + std::to_string(100 + i % 900) + "\n";
+  }
+  s += "127.0.0.1 - - [01/Jan/2025:01:00:00 -0300] \"GET /tail HTTP/1.1\" 200 1 \"-\" \"x\" 0.001";
+  return s;
+}
+
+static std::string write_file(const std::string& name, const std::string& data) {
+  auto path = (fs::temp_directory_path() / name).string();
+  std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+  ofs << data;
+  return path;
+}
+
+static void check_same(const logforge::Report& a, const logforge::Report& b) {
+  CHECK(a.total_lines == b.total_lines);
+  CHECK(a.parsed_lines == b.parsed_lines);
+  CHECK(a.invalid_lines == b.invalid_lines);
+  CHECK(a.status_counts == b.status_counts);
+  CHECK(a.endpoint_counts == b.endpoint_counts);
+  CHECK(a.per_minute_counts == b.per_minute_counts);
+  CHECK(a.latency.p99_ms == b.latency.p99_ms);
+}
+
+static logforge::Report ingest(const std::string& path, int threads = 1) {
+  logforge::IngestOptions opt;
+  opt.threads = threads;
+  logforge::Aggregator agg(10);
+  REQUIRE(logforge::ingest_file(path, opt, agg));
+  return agg.finalize();
+}
+
+TEST_CASE("Compression is detected by magic bytes, not by extension") {
+  CHECK(logforge::detect_compression(write_file("logforge_magic.gz", "plain text\n")) == logforge::Compression::None);
+  CHECK(logforge::detect_compression(write_file("logforge_magic.log", "\x1f\x8b\x08")) == logforge::Compression::Gzip);
+  CHECK(logforge::detect_compression(write_file("logforge_magic2.log", "\x28\xb5\x2f\xfd")) ==
+        logforge::Compression::Zstd);
+}
+
+#ifdef LOGFORGE_HAVE_ZLIB
+TEST_CASE("Gzip input (multi-member, lines across blocks) matches plain input") {
+  const std::string text = make_log(4000);
+  const auto plain = write_file("logforge_plain.log", text);
+  const auto gz = (fs::temp_directory_path() / "logforge_input.log.gz").string();
+
+  // Dois membros concatenados, com a fronteira no meio de uma linha.
+  const std::size_t cut = text.size() / 2 + 17;
+  gzFile f = gzopen(gz.c_str(), "wb");
+  REQUIRE(f);
+  gzwrite(f, text.data(), static_cast<unsigned>(cut));
+  gzclose(f);
+  f = gzopen(gz.c_str(), "ab");
+  gzwrite(f, text.data() + cut, static_cast<unsigned>(text.size() - cut));
+  gzclose(f);
+
+  check_same(ingest(plain), ingest(gz, 4));
+
+  // Blocos minúsculos: quase toda linha atravessa a fronteira entre blocos do anel.
+  auto src = logforge::open_line_source(plain, logforge::ReaderKind::Mmap);
+  logforge::CompressedLineReader tiny(logforge::open_decoder(gz, logforge::Compression::Gzip), false, 7, 2);
+  std::string_view a, b;
+  std::size_t n = 0;
+  while (src->next_line(a)) {
+    REQUIRE(tiny.next_line(b));
+    REQUIRE(a == b);
+    ++n;
+  }
+  CHECK_FALSE(tiny.next_line(b));
+  CHECK(tiny.ok());
+  CHECK(tiny.decompressed_bytes() == text.size());
+  CHECK(n == 4001);
+
+  // gzip não tem ponto de entrada no meio: faixa parcial é recusada, não lida do início.
+  CHECK(logforge::open_decoder(gz, logforge::Compression::Gzip, {0, 100}) == nullptr);
+  CHECK_FALSE(logforge::open_line_source(gz, logforge::ReaderKind::Mmap, {100, UINT64_MAX})->ok());
+
+  // Truncado no meio do membro: erro, não um relatório parcial silencioso.
+  const auto size = fs::file_size(gz);
+  fs::resize_file(gz, size - 40);
+  logforge::Aggregator agg(10);
+  CHECK_FALSE(logforge::ingest_file(gz, logforge::IngestOptions{}, agg));
+}
+#endif
+
+#ifdef LOGFORGE_HAVE_ZSTD
+TEST_CASE("Multi-frame zstd is decompressed in parallel and stitched at frame edges") {
+  const std::string text = make_log(6000);
+  const auto plain = write_file("logforge_plain_zst.log", text);
+
+  // Frames de tamanho fixo (como zstd -T0 / pzstd): as fronteiras caem no meio das linhas.
+  std::string zst;
+  const std::size_t frame = text.size() / 9;
+  for (std::size_t pos = 0; pos < text.size(); pos += frame) {
+    const std::size_t n = std::min(frame, text.size() - pos);
+    std::string out(ZSTD_compressBound(n), '\0');
+    const std::size_t z = ZSTD_compress(out.data(), out.size(), text.data() + pos, n, 3);
+    REQUIRE_FALSE(ZSTD_isError(z));
+    zst.append(out.data(), z);
+  }
+  const auto path = write_file("logforge_input.log.zst", zst);
+
+  CHECK(logforge::split_zstd_frames(path, 4).size() == 4);
+  CHECK(logforge::split_zstd_frames(path, 1).size() == 1);
+
+  const auto expected = ingest(plain);
+  for (int threads : {1, 3, 4, 16}) {
+    INFO("threads " << threads);
+    logforge::IngestOptions opt;
+    opt.threads = threads;
+    logforge::Aggregator agg(10);
+    logforge::IngestStats stats;
+    REQUIRE(logforge::ingest_file(path, opt, agg, &stats));
+    check_same(expected, agg.finalize());
+    CHECK(stats.compression == logforge::Compression::Zstd);
+    CHECK(stats.decompressed_bytes == text.size());
+  }
+}
+#endif
@@ -0,0 +1,157 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "logforge/aggregator.hpp"
+#include "logforge/dense_counts.hpp"
+#include "logforge/flat_hash.hpp"
+
+TEST_CASE("hash_string depends on every byte and on the length") {
+  const std::string base = "/api/v1/items/123456789/detail";
+  for (std::size_t len = 0; len <= base.size(); ++len) {
+    const std::string s = base.substr(0, len);
+    if (len > 0) CHECK(logforge::hash_string(s) != logforge::hash_string(base.substr(0, len - 1)));
+    for (std::size_t i = 0; i < len; ++i) {
+      std::string t = s;
+      t[i] ^= 1;
+      INFO("len " << len << " byte " << i);
+      CHECK(logforge::hash_string(t) != logforge::hash_string(s));
+    }
+  }
+  CHECK(logforge::hash_string(std::string("ab\0", 3)) != logforge::hash_string("ab"));
+}
+
+TEST_CASE("StringIndex matches std::unordered_map under random insert/erase") {
+  std::mt19937 rng(5);
+  std::vector<std::string> pool;
+  for (int i = 0; i < 3000; ++i) pool.push_back("/k" + std::to_string(i * 7919 % 100003));
+  pool.push_back("");
+
+  logforge::StringIndex index;
+  std::unordered_map<std::string, std::uint32_t> ref;
+  for (int op = 0; op < 200000; ++op) {
+    const std::string& key = pool[rng() % pool.size()];
+    const auto h = logforge::hash_string(key);
+    const auto it = ref.find(key);
+    switch (rng() % 3) {
+      case 0: {
+        const auto id = static_cast<std::uint32_t>(op);
+        CHECK(index.insert(key, h, id) == (it == ref.end()));
+        if (it == ref.end()) ref.emplace(key, id);
+        break;
+      }
+      case 1:
+        index.erase(key, h);
+        if (it != ref.end()) ref.erase(it);
+        break;
+      default:
+        CHECK(index.find(key, h) == (it == ref.end() ? logforge::StringIndex::kNone : it->second));
+    }
+    REQUIRE(index.size() == ref.size());
+  }
+  for (const auto& [key, id] : ref) CHECK(index.find(key, logforge::hash_string(key)) == id);
+  CHECK(index.load_factor() <= 0.75);
+
+  // Objeto movido fica vazio, mas utilizável.
+  logforge::StringIndex moved = std::move(index);
+  CHECK(moved.size() == ref.size());
+  CHECK(index.find("/k0", logforge::hash_string("/k0")) == logforge::StringIndex::kNone);
+  CHECK(index.insert("/k0", logforge::hash_string("/k0"), 7));
+  CHECK(index.find("/k0", logforge::hash_string("/k0")) == 7);
+}
+
+TEST_CASE("StatusCounts keeps codes outside 0..599 in order") {
+  logforge::StatusCounts counts;
+  for (int s : {200, 200, 404, 599, 600, 999, -1, 0, 42, 1000000}) counts.add(s);
+  counts.add(200, 5);
+
+  std::vector<std::pair<int, std::uint64_t>> seen;
+  counts.for_each([&](int s, std::uint64_t c) { seen.emplace_back(s, c); });
+  const std::vector<std::pair<int, std::uint64_t>> want = {{-1, 1},  {0, 1},   {42, 1},  {200, 7},
+                                                           {404, 1}, {599, 1}, {600, 1}, {999, 1},
+                                                           {1000000, 1}};
+  CHECK(seen == want);
+  CHECK(counts.size() == want.size());
+
+  logforge::StatusCounts other;
+  other.add(999, 2);
+  other.add(500);
+  counts.merge(other);
+  const auto m = counts.to_map();
+  CHECK(m.at(999) == 3);
+  CHECK(m.at(500) == 1);
+  CHECK(m.size() == want.size() + 1);
+}
+
+TEST_CASE("MinuteCounts grows both ways and keeps far outliers sparse") {
+  std::mt19937 rng(9);
+  logforge::MinuteCounts counts;
+  std::map<std::int64_t, std::uint64_t> ref;
+  auto add = [&](std::int64_t m, std::uint64_t n) {
+    counts.add(m, n);
+    ref[m] += n;
+  };
+
+  const std::int64_t t0 = 29000000; // ~2025 em minutos desde a época
+  for (int i = 0; i < 50000; ++i) add(t0 + i / 20 - static_cast<std::int64_t>(rng() % 3), 1);
+  // Fora de ordem, para trás.
+  for (int i = 0; i < 100; ++i) add(t0 - 500 - i * 7, 2);
+  // Longe demais para o vetor denso: ficam no esparso...
+  add(t0 + 10 * static_cast<std::int64_t>(logforge::MinuteCounts::kMaxSpan), 1);
+  add(-5, 4);
+  add(INT64_MIN, 1);
+  add(INT64_MAX, 1);
+  // ...e este, perto o bastante, é absorvido quando o vetor cresce até ele.
+  add(t0 + static_cast<std::int64_t>(logforge::MinuteCounts::kMaxSpan) / 2, 3);
+  for (std::int64_t m = t0 + 2500; m < t0 + static_cast<std::int64_t>(logforge::MinuteCounts::kMaxSpan) / 2;
+       m += 4096)
+    add(m, 1);
+
+  std::vector<std::pair<std::int64_t, std::uint64_t>> seen;
+  counts.for_each([&](std::int64_t m, std::uint64_t c) { seen.emplace_back(m, c); });
+  const std::vector<std::pair<std::int64_t, std::uint64_t>> want(ref.begin(), ref.end());
+  CHECK(seen == want);
+  CHECK(counts.size() == ref.size());
+
+  logforge::MinuteCounts merged;
+  merged.add(INT64_MIN, 1);
+  merged.add(t0, 1);
+  merged.merge(counts);
+  const auto m = merged.to_map();
+  CHECK(m.size() == ref.size());
+  CHECK(m.at(INT64_MIN) == 2);
+  CHECK(m.at(t0) == ref[t0] + 1);
+}
+
+TEST_CASE("Report keeps the same status and minute maps through snapshots and merges") {
+  logforge::Aggregator a, b;
+  std::unordered_map<int, std::uint64_t> status;
+  std::unordered_map<std::int64_t, std::uint64_t> minutes;
+  std::mt19937 rng(1);
+  for (int i = 0; i < 5000; ++i) {
+    logforge::LogEntry e;
+    e.endpoint = (i % 3) ? "/a" : "/b";
+    e.status = (i % 97 == 0) ? 777 : 200 + static_cast<int>(rng() % 4) * 100;
+    e.minute = (i % 500 == 0) ? logforge::kNoMinute : 29000000 + i / 60 - static_cast<std::int64_t>(rng() % 5);
+    e.latency_us = 1000;
+    (i % 2 ? a : b).add_valid(e);
+    status[e.status]++;
+    if (e.minute != logforge::kNoMinute) minutes[e.minute]++;
+  }
+
+  std::string bytes;
+  b.serialize(bytes);
+  std::string_view in(bytes);
+  logforge::Aggregator restored;
+  REQUIRE(restored.deserialize(in));
+  a.merge(restored);
+
+  const auto r = a.finalize();
+  CHECK(r.status_counts == status);
+  CHECK(r.per_minute_counts == minutes);
+  CHECK(r.endpoint_counts.at("/b") == 1667);
+}
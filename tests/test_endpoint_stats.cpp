@@ -0,0 +1,164 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+
+#include "logforge/aggregator.hpp"
+#include "logforge/entry_batch.hpp"
+#include "logforge/report_writer.hpp"
+#include "logforge/space_saving.hpp"
+
+TEST_CASE("SpaceSaving is exact under capacity and bounded above it") {
+  logforge::SpaceSaving<logforge::NoPayload> ss(50);
+  std::map<std::string, std::uint64_t> truth;
+
+  // Poucas chaves frequentes + muitas chaves únicas (ex.: IDs no path).
+  std::mt19937 rng(3);
+  for (int i = 0; i < 100000; ++i) {
+    std::string key = (rng() % 2) ? "/hot/" + std::to_string(rng() % 5) : "/users/" + std::to_string(i);
+    truth[key]++;
+    ss.offer(key);
+  }
+
+  CHECK(ss.size() == 50);
+  CHECK(ss.approximate());
+  CHECK(ss.total() == 100000);
+  const std::uint64_t bound = ss.total() / ss.capacity();
+  for (int k = 0; k < 5; ++k) {
+    const auto key = "/hot/" + std::to_string(k);
+    const auto* e = ss.find(key);
+    REQUIRE(e != nullptr); // freq > N / capacity => monitorado
+    CHECK(e->count >= truth[key]);
+    CHECK(e->count - e->error <= truth[key]);
+    CHECK(e->error <= bound);
+  }
+
+  logforge::SpaceSaving<logforge::NoPayload> small(10);
+  small.offer("/a");
+  small.offer("/a");
+  small.offer("/b");
+  CHECK_FALSE(small.approximate());
+  CHECK(small.find("/a")->count == 2);
+  CHECK(small.find("/a")->error == 0);
+}
+
+TEST_CASE("Aggregator per-endpoint stats: percentiles, status classes, merge") {
+  logforge::AggregatorOptions opt;
+  opt.endpoint_stats_capacity = 100;
+
+  logforge::Aggregator a(opt), b(opt);
+  for (int i = 1; i <= 100; ++i) {
+    logforge::LogEntry e{"/api/items", (i % 10 == 0) ? 503 : 200, i * 1000, 0};
+    (i % 2 ? a : b).add_valid(e);
+  }
+  a.add_valid(logforge::LogEntry{"/health", 204, -1, 0});
+  a.merge(b);
+
+  auto r = a.finalize();
+  REQUIRE(r.endpoint_latency_enabled);
+  CHECK_FALSE(r.endpoint_latency_approximate);
+  REQUIRE(r.endpoint_latency.size() == 2);
+
+  const auto& items = r.endpoint_latency[0];
+  CHECK(items.endpoint == "/api/items");
+  CHECK(items.count == 100);
+  CHECK(items.count_error == 0);
+  CHECK(items.status_classes[1] == 90);
+  CHECK(items.status_classes[4] == 10);
+  CHECK(items.error_rate == 0.1);
+  CHECK(items.p50_ms >= 50 * 0.95);
+  CHECK(items.p50_ms <= 50 * 1.05);
+  CHECK(items.p99_ms >= 99 * 0.95);
+
+  const auto& health = r.endpoint_latency[1];
+  CHECK(health.endpoint == "/health");
+  CHECK(health.p50_ms == -1);
+}
+
+TEST_CASE("Aggregator per-endpoint stats stay bounded with high cardinality") {
+  logforge::AggregatorOptions opt;
+  opt.endpoint_stats_capacity = 64;
+  logforge::Aggregator agg(opt);
+
+  for (int i = 0; i < 200000; ++i) {
+    const std::string path = (i % 4 == 0) ? "/checkout" : "/users/" + std::to_string(i);
+    agg.add_valid(logforge::LogEntry{path, 200, 1000 + i % 500, 0});
+  }
+  auto r = agg.finalize();
+  CHECK(r.endpoint_latency_approximate);
+  CHECK(r.endpoint_latency.size() == 64);
+  CHECK(r.endpoint_latency[0].endpoint == "/checkout");
+  CHECK(r.endpoint_latency[0].count - r.endpoint_latency[0].count_error <= 50000);
+  CHECK(r.endpoint_latency[0].count >= 50000);
+}
+
+TEST_CASE("Endpoint stats bound every endpoint structure, not only the sketches") {
+  logforge::AggregatorOptions opt;
+  opt.endpoint_stats_capacity = 64;
+  opt.topk_capacity = 1000;
+  logforge::Aggregator agg(opt);
+  CHECK(agg.options().topk_mode == logforge::TopKMode::Approx);
+
+  // Linha a linha e em lotes: 300k paths distintos, bem acima dos dois orçamentos.
+  auto batch = std::make_unique<logforge::EntryBatch>();
+  std::vector<std::string> paths(logforge::EntryBatch::kCapacity);
+  for (int i = 0; i < 150000; ++i) agg.add_valid(logforge::LogEntry{"/a/" + std::to_string(i), 200, 1000, 0});
+  for (int i = 0; i < 150000;) {
+    batch->clear();
+    for (std::size_t k = 0; k < logforge::EntryBatch::kCapacity; ++k, ++i) {
+      paths[k] = "/b/" + std::to_string(i);
+      batch->push(logforge::LogEntry{paths[k], 200, 1000, 0});
+    }
+    agg.add_batch(*batch);
+  }
+
+  for (const auto& t : agg.table_stats()) {
+    INFO(t.name);
+    CHECK(t.name != "endpoints"); // a tabela exata, sem limite, não existe
+    if (t.name == "endpoints (top-K)") CHECK(t.size <= 1000);
+    if (t.name == "endpoint-stats") CHECK(t.size <= 64);
+  }
+  const auto r = agg.finalize();
+  CHECK(r.endpoint_counts_approximate);
+  CHECK(r.endpoint_counts.size() <= 1000);
+  CHECK(r.endpoint_latency.size() <= 64);
+}
+
+TEST_CASE("Approx top-K keeps heavy hitters with bounded error in fixed memory") {
+  logforge::AggregatorOptions opt;
+  opt.topk_mode = logforge::TopKMode::Approx;
+  opt.topk_capacity = 32;
+
+  logforge::Aggregator left(opt), right(opt);
+  for (int i = 0; i < 100000; ++i) {
+    std::string path = (i % 10 < 3) ? "/api/items" : (i % 10 < 5) ? "/login" : "/users/" + std::to_string(i);
+    (i % 2 ? left : right).add_valid(logforge::LogEntry{path, 200, -1, 0});
+  }
+  left.merge(right);
+  auto r = left.finalize();
+
+  CHECK(r.endpoint_counts_approximate);
+  CHECK(r.endpoint_counts.size() == 32);
+
+  auto view = logforge::make_report_view(r, 2);
+  REQUIRE(view.top_endpoints.size() == 2);
+  CHECK(view.top_endpoints[0].endpoint == "/api/items");
+  CHECK(view.top_endpoints[1].endpoint == "/login");
+  for (auto& e : view.top_endpoints) CHECK(e.error <= r.parsed_lines / opt.topk_capacity);
+  CHECK(view.top_endpoints[0].count >= 30000);
+  CHECK(view.top_endpoints[0].count - view.top_endpoints[0].error <= 30000);
+}
+
+TEST_CASE("Report view ranks endpoints by count then name") {
+  logforge::Report r;
+  r.endpoint_counts = {{"/b", 5}, {"/a", 5}, {"/c", 9}, {"/d", 1}};
+
+  auto view = logforge::make_report_view(r, 3);
+  REQUIRE(view.top_endpoints.size() == 3);
+  CHECK(view.top_endpoints[0].endpoint == "/c");
+  CHECK(view.top_endpoints[1].endpoint == "/a");
+  CHECK(view.top_endpoints[2].endpoint == "/b");
+  CHECK(logforge::make_report_view(r, 10).top_endpoints.size() == 4);
+}
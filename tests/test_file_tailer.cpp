@@ -0,0 +1,120 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "logforge/file_tailer.hpp"
+#include "logforge/follow.hpp"
+
+namespace fs = std::filesystem;
+
+static void append(const std::string& path, const std::string& data) {
+  std::ofstream ofs(path, std::ios::binary | std::ios::app);
+  ofs << data;
+}
+
+// Espera `cond` com prazo, em vez de supor quanto tempo a outra thread leva.
+template <typename Cond>
+static bool wait_for(Cond cond, std::chrono::milliseconds deadline = std::chrono::seconds(10)) {
+  const auto until = std::chrono::steady_clock::now() + deadline;
+  while (!cond()) {
+    if (std::chrono::steady_clock::now() >= until) return false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  return true;
+}
+
+static std::vector<std::string> poll_lines(logforge::FileTailer& t) {
+  std::vector<std::string> lines;
+  t.poll([&](std::string_view line) { lines.emplace_back(line); });
+  return lines;
+}
+
+TEST_CASE("FileTailer reads only appended bytes and buffers partial lines") {
+  const auto dir = fs::temp_directory_path() / "logforge_tail";
+  fs::remove_all(dir);
+  fs::create_directories(dir);
+  const auto path = (dir / "access.log").string();
+  append(path, "a\nb\n");
+
+  logforge::FileTailer t(path, 4); // buffer pequeno: linhas cruzam leituras
+  REQUIRE(t.ok());
+  CHECK(poll_lines(t) == std::vector<std::string>{"a", "b"});
+  CHECK(poll_lines(t).empty());
+
+  append(path, "partial");
+  CHECK(poll_lines(t).empty());
+  append(path, " line\nc\n");
+  CHECK(poll_lines(t) == std::vector<std::string>{"partial line", "c"});
+  CHECK(t.offset() == fs::file_size(path));
+}
+
+TEST_CASE("FileTailer survives copytruncate and rename rotation") {
+  const auto dir = fs::temp_directory_path() / "logforge_tail_rot";
+  fs::remove_all(dir);
+  fs::create_directories(dir);
+  const auto path = (dir / "access.log").string();
+  append(path, "one\ntwo\n");
+
+  logforge::FileTailer t(path);
+  REQUIRE(t.ok());
+  CHECK(poll_lines(t).size() == 2);
+
+  // copytruncate: o mesmo arquivo volta a zero e recomeça.
+  fs::resize_file(path, 0);
+  append(path, "three\n");
+  CHECK(poll_lines(t) == std::vector<std::string>{"three"});
+  CHECK(t.truncations() == 1);
+
+  // rename + create: o resto do antigo é drenado antes de abrir o novo.
+  append(path, "four\ntail-without-newline");
+  fs::rename(path, dir / "access.log.1");
+  CHECK(poll_lines(t) == std::vector<std::string>{"four"}); // ainda não recriado
+  append(path, "five\n");
+  CHECK(poll_lines(t) == std::vector<std::string>{"tail-without-newline", "five"});
+  CHECK(t.rotations() == 1);
+}
+
+TEST_CASE("follow_file writes reports incrementally and on stop") {
+  const auto dir = fs::temp_directory_path() / "logforge_follow";
+  fs::remove_all(dir);
+  fs::create_directories(dir / "out");
+  const auto path = (dir / "access.log").string();
+  const std::string line =
+      "127.0.0.1 - - [10/Oct/2000:13:55:36 -0700] \"GET /api/users?id=1 HTTP/1.1\" 200 2326 \"-\" \"UA\" 0.120\n";
+  append(path, line);
+
+  std::atomic<bool> stop{false};
+  logforge::FollowOptions fopt;
+  fopt.interval_sec = 1;
+  fopt.stop = &stop;
+
+  logforge::Aggregator agg(5);
+  logforge::FollowStats stats;
+  bool ok = false;
+  std::thread follower([&] {
+    ok = logforge::follow_file(path, (dir / "out").string(), logforge::IngestOptions{}, fopt, agg, &stats);
+  });
+
+  // Snapshot periódico (depois de interval_sec); o follower não para se a checagem falhar.
+  CHECK(wait_for([&] { return fs::exists(dir / "out" / "report.json"); }));
+  // Sem espera: ao parar, o follow faz um último poll antes do relatório final.
+  append(path, line + "garbage\n");
+  stop = true;
+  follower.join();
+
+  REQUIRE(ok);
+  CHECK(stats.snapshots >= 1);
+  CHECK(fs::exists(dir / "out" / "status_counts.csv"));
+  CHECK_FALSE(fs::exists(dir / "out" / "report.json.tmp"));
+
+  const auto r = agg.finalize();
+  CHECK(r.total_lines == 3);
+  CHECK(r.parsed_lines == 2);
+  CHECK(r.endpoint_counts.at("/api/users") == 2);
+}
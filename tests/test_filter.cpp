@@ -0,0 +1,214 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "logforge/filter.hpp"
+#include "logforge/ingest.hpp"
+#include "logforge/log_format.hpp"
+#include "logforge/parser_nginx.hpp"
+#include "logforge/time_util.hpp"
+
+static logforge::LogEntry entry(std::string_view ep, int status, std::int64_t latency_us, int hh, int mm) {
+  logforge::LogEntry e;
+  e.endpoint = ep;
+  e.status = status;
+  e.latency_us = latency_us;
+  e.minute = logforge::epoch_minute(2025, 1, 1, hh, mm);
+  return e;
+}
+
+static logforge::Filter compile(const std::string& expr) {
+  logforge::Filter f;
+  std::string err;
+  INFO(expr);
+  REQUIRE(f.compile(expr, err));
+  return f;
+}
+
+TEST_CASE("glob_match handles stars and single-character wildcards") {
+  CHECK(logforge::glob_match("/api/*", "/api/items"));
+  CHECK(logforge::glob_match("/api/*", "/api/"));
+  CHECK_FALSE(logforge::glob_match("/api/*", "/apix"));
+  CHECK(logforge::glob_match("/users/*/orders", "/users/42/orders"));
+  CHECK_FALSE(logforge::glob_match("/users/*/orders", "/users/42/order"));
+  CHECK(logforge::glob_match("*.css", "/static/a/b.css"));
+  CHECK(logforge::glob_match("/v?/x", "/v1/x"));
+  CHECK_FALSE(logforge::glob_match("/v?/x", "/v10/x"));
+  CHECK(logforge::glob_match("*a*b*", "xxaxxbxx"));
+}
+
+TEST_CASE("where expressions evaluate status, endpoint, latency and time") {
+  const auto api_500 = entry("/api/items", 503, 1'500'000, 13, 30);
+  const auto health = entry("/health", 200, 2'000, 9, 5);
+  const auto no_latency = entry("/api/items", 404, -1, 13, 59);
+
+  auto f = compile("status = 5xx and endpoint = /api/* and time >= 13:00 and time < 14:00");
+  CHECK(f.matches(api_500));
+  CHECK_FALSE(f.matches(health));
+  CHECK_FALSE(f.matches(no_latency));
+
+  f = compile("status != 500-599");
+  CHECK_FALSE(f.matches(api_500));
+  CHECK(f.matches(health));
+
+  f = compile("status >= 400 && status < 500");
+  CHECK(f.matches(no_latency));
+  CHECK_FALSE(f.matches(api_500));
+
+  f = compile("latency > 1s");
+  CHECK(f.matches(api_500));
+  CHECK_FALSE(f.matches(health));
+  CHECK_FALSE(f.matches(no_latency)); // sem latência não satisfaz comparação
+  CHECK(compile("not latency > 1s").matches(no_latency));
+  CHECK(compile("latency <= 2ms").matches(health));
+  CHECK(compile("latency = 2000us").matches(health));
+  CHECK_FALSE(compile("latency < 2").matches(health)); // ms por padrão
+
+  f = compile("time = \"2025-01-01 09:05\" or time > 2025-01-01");
+  CHECK(f.matches(health));
+  CHECK_FALSE(f.matches(api_500));
+  CHECK(compile("time = 2025-01-01").matches(api_500)); // só a data: o dia inteiro
+  CHECK(compile("time < \"2025-01-01T10:00\"").matches(health));
+
+  f = compile("endpoint = /health or (status = 404 and not path = /api/items)");
+  CHECK(f.matches(health));
+  CHECK_FALSE(f.matches(no_latency));
+  CHECK(compile("endpoint != /health").matches(api_500));
+  CHECK(compile("endpoint = /api/?tems").matches(api_500));
+
+  // and tem precedência sobre or.
+  f = compile("status = 200 or status = 503 and endpoint = /nope");
+  CHECK(f.matches(health));
+  CHECK_FALSE(f.matches(api_500));
+}
+
+TEST_CASE("where terms are grouped by the stage of the fields they read") {
+  auto f = compile("time >= 13:00 and status = 5xx and (endpoint = /api/* or latency > 1s)");
+  const auto early = entry("/api/items", 200, -1, 12, 0);
+  const auto late_500 = entry("/x", 500, 10, 13, 10);
+
+  // Só os termos de tempo rodam no estágio Time: decide antes de status/endpoint/latência.
+  CHECK_FALSE(f.pass(logforge::FilterStage::Time, early));
+  CHECK(f.pass(logforge::FilterStage::Time, late_500));
+  CHECK(f.pass(logforge::FilterStage::Status, late_500));
+  CHECK(f.pass(logforge::FilterStage::Endpoint, late_500)); // o or também lê latência
+  CHECK_FALSE(f.pass(logforge::FilterStage::Latency, late_500));
+  CHECK_FALSE(f.matches(late_500));
+}
+
+TEST_CASE("invalid where expressions are rejected with a position") {
+  for (const char* bad : {"", "status", "status =", "status = abc", "foo = 1", "endpoint > /a",
+                          "(status = 200", "status = 200 status = 300", "latency > 3 parsecs",
+                          "time >= 25:00", "time = \"2025-01-01", "status = 200 and"}) {
+    INFO(bad);
+    logforge::Filter f;
+    std::string err;
+    CHECK_FALSE(f.compile(bad, err));
+    CHECK(err.find("posição") != std::string::npos);
+    CHECK(f.empty());
+  }
+}
+
+TEST_CASE("parser applies the where filter stage by stage") {
+  const logforge::NginxParser parser;
+  // O tempo é UTC: 13:05 -0300 são 16:05.
+  auto f = compile("time >= 16:00 and status = 5xx");
+
+  const std::string ok = "1.2.3.4 - - [01/Jan/2025:13:05:00 -0300] \"GET /a?x=1 HTTP/1.1\" 502 1 \"-\" \"x\" 0.25";
+  const std::string wrong_status = "1.2.3.4 - - [01/Jan/2025:13:05:00 -0300] \"GET /a HTTP/1.1\" 200 1 \"-\" \"x\" 0.25";
+  // Fora do horário, mas inválida: o resto da validação ainda roda, então é Invalid
+  // (como no índice, que só guarda linhas válidas).
+  const std::string early_broken = "1.2.3.4 - - [01/Jan/2025:12:05:00 -0300] garbage";
+  const std::string late_broken = "1.2.3.4 - - [01/Jan/2025:13:05:00 -0300] garbage";
+
+  logforge::LogEntry e;
+  REQUIRE(parser.parse_line(ok, f, e) == logforge::ParseResult::Ok);
+  const auto ref = parser.parse_line(ok);
+  REQUIRE(ref);
+  CHECK(e.endpoint == ref->endpoint);
+  CHECK(e.status == ref->status);
+  CHECK(e.latency_us == ref->latency_us);
+  CHECK(e.minute == ref->minute);
+  CHECK(parser.parse_line(wrong_status, f, e) == logforge::ParseResult::Filtered);
+  CHECK(parser.parse_line(early_broken, f, e) == logforge::ParseResult::Invalid);
+  CHECK(parser.parse_line(late_broken, f, e) == logforge::ParseResult::Invalid);
+  const std::string early_bad_status = "1.2.3.4 - - [01/Jan/2025:12:05:00 -0300] \"GET /a HTTP/1.1\" abc 1";
+  const std::string early_no_path = "1.2.3.4 - - [01/Jan/2025:12:05:00 -0300] \"GET  HTTP/1.1\" 502 1";
+  CHECK(parser.parse_line(early_bad_status, f, e) == logforge::ParseResult::Invalid);
+  CHECK(parser.parse_line(early_no_path, f, e) == logforge::ParseResult::Invalid);
+  // Status fora do filtro com o path ainda por validar.
+  const std::string bad_path_200 = "1.2.3.4 - - [01/Jan/2025:13:05:00 -0300] \"GET\" 200 1";
+  CHECK(parser.parse_line(bad_path_200, f, e) == logforge::ParseResult::Invalid);
+
+  // Os formatos gerados seguem a mesma regra.
+  std::string err;
+  logforge::FormatOptions fopt;
+  fopt.name = "timed";
+  const auto timed = logforge::make_parser(fopt, err);
+  REQUIRE(timed);
+  const std::string early_bad_status_full =
+      "1.2.3.4 - - [01/Jan/2025:12:05:00 -0300] \"GET /a HTTP/1.1\" abc 1 \"-\" \"x\" 0.25";
+  CHECK(timed->parse(early_bad_status_full, &f, e) == logforge::ParseResult::Invalid);
+  CHECK(timed->parse(wrong_status, &f, e) == logforge::ParseResult::Filtered);
+}
+
+TEST_CASE("ingest with --where aggregates only matching lines") {
+  auto path = (std::filesystem::temp_directory_path() / "logforge_where.log").string();
+  {
+    std::ofstream ofs(path);
+    const char* eps[] = {"/api/a", "/api/b", "/static/x.css", "/health"};
+    for (int i = 0; i < 3000; ++i) {
+      const int minute = i / 5; // 10:00 .. 19:59
+      if (i % 29 == 0) {
+        ofs << "broken " << i << "\n";
+        continue;
+      }
+      if (i % 31 == 0) {
+        // Timestamp válido (às vezes fora do --where) e request quebrada: continua inválida.
+        ofs << "10.0.0.1 - - [01/Jan/2025:" << 10 + minute / 60 << ":00:00 -0300] \"GET\" 200 1\n";
+        continue;
+      }
+      ofs << "10.0.0.1 - - [01/Jan/2025:" << 10 + minute / 60 << ":" << (minute % 60 < 10 ? "0" : "")
+          << minute % 60 << ":00 -0300] \"GET " << eps[i % 4] << " HTTP/1.1\" " << (i % 6 ? 200 : 500)
+          << " 1 \"-\" \"x\" 0." << (100 + i % 900) << "\n";
+    }
+  }
+  const std::string expr = "(status = 5xx or latency >= 900ms) and endpoint = /api/* and time < 15:30";
+  auto f = compile(expr);
+
+  // Referência: parse completo e a expressão inteira depois.
+  const logforge::NginxParser parser;
+  std::uint64_t expected = 0, invalid = 0, lines = 0;
+  {
+    std::ifstream ifs(path);
+    std::string line;
+    while (std::getline(ifs, line)) {
+      lines++;
+      auto e = parser.parse_line(line);
+      if (!e) {
+        invalid++;
+      } else if (f.matches(*e)) {
+        expected++;
+      }
+    }
+  }
+
+  for (int threads : {1, 3}) {
+    logforge::IngestOptions opt;
+    opt.threads = threads;
+    opt.filter = &f;
+    logforge::Aggregator agg(10);
+    REQUIRE(logforge::ingest_file(path, opt, agg));
+    const auto r = agg.finalize();
+    CHECK(r.total_lines == lines);
+    CHECK(r.parsed_lines == expected);
+    // Inválidas contam como inválidas mesmo quando o filtro as descartaria.
+    CHECK(r.invalid_lines == invalid);
+    CHECK(r.parsed_lines + r.invalid_lines + r.filtered_lines == r.total_lines);
+    for (auto& [ep, count] : r.endpoint_counts) CHECK(ep.rfind("/api/", 0) == 0);
+  }
+  std::remove(path.c_str());
+}
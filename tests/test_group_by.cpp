@@ -0,0 +1,210 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "logforge/aggregator.hpp"
+#include "logforge/flat_hash.hpp"
+#include "logforge/group_by.hpp"
+#include "logforge/ingest.hpp"
+#include "logforge/time_util.hpp"
+
+static logforge::LogEntry entry(std::string_view ep, int status, std::string_view ip, std::int64_t bytes,
+                                std::int64_t latency_us) {
+  logforge::LogEntry e;
+  e.endpoint = ep;
+  e.status = status;
+  e.remote_addr = ip;
+  e.method = "GET";
+  e.bytes = bytes;
+  e.latency_us = latency_us;
+  e.minute = logforge::epoch_minute(2025, 1, 1, 10, 0);
+  return e;
+}
+
+static logforge::GroupBySpec spec(const char* dims, const char* aggs) {
+  logforge::GroupBySpec s;
+  std::string err;
+  INFO(dims << " / " << aggs);
+  REQUIRE(logforge::parse_group_by(dims, aggs, s, err));
+  return s;
+}
+
+static void check_same_rows(const std::vector<logforge::GroupRow>& a, const std::vector<logforge::GroupRow>& b) {
+  REQUIRE(a.size() == b.size());
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    CHECK(a[i].key == b[i].key);
+    CHECK(a[i].count == b[i].count);
+    CHECK(a[i].bytes == b[i].bytes);
+    CHECK(a[i].quantiles_ms == b[i].quantiles_ms);
+    CHECK(a[i].distinct == b[i].distinct);
+  }
+}
+
+struct U64Hash {
+  std::uint64_t operator()(std::uint64_t x) const { return logforge::mix64(x); }
+};
+
+TEST_CASE("FlatHashMap grows and keeps every key") {
+  logforge::FlatHashMap<std::uint64_t, std::uint64_t, U64Hash> m;
+  for (std::uint64_t i = 0; i < 100000; ++i) m[i * 7919] += i;
+  for (std::uint64_t i = 0; i < 100000; i += 3) m[i * 7919] += 1;
+  CHECK(m.size() == 100000);
+  for (std::uint64_t i = 0; i < 100000; ++i) {
+    const auto* v = m.find(i * 7919);
+    REQUIRE(v != nullptr);
+    CHECK(*v == i + (i % 3 == 0 ? 1 : 0));
+  }
+  CHECK(m.find(1) == nullptr);
+  std::uint64_t seen = 0;
+  m.for_each([&](std::uint64_t, std::uint64_t) { seen++; });
+  CHECK(seen == 100000);
+}
+
+TEST_CASE("group-by specs parse dimensions and aggregates") {
+  auto s = spec("endpoint, status_class", "count,sum(bytes),p50,p99.9,distinct(ip)");
+  REQUIRE(s.dims.size() == 2);
+  CHECK(s.dims[1] == logforge::GroupDim::StatusClass);
+  CHECK(s.sum_bytes);
+  CHECK(s.aggregate_columns() == std::vector<std::string>{"count", "sum_bytes", "p50_ms", "p99.9_ms", "distinct_ip"});
+  CHECK(spec("path,client,ua", "").aggregate_columns() == std::vector<std::string>{"count"});
+  // Só estes precisam que o parser extraia os campos do cliente.
+  CHECK(s.needs_client_fields());
+  CHECK(spec("endpoint,method", "").needs_client_fields());
+  CHECK(spec("minute", "distinct(ua)").needs_client_fields());
+  CHECK_FALSE(spec("endpoint,status_class,minute", "count,p95,distinct(status)").needs_client_fields());
+
+  for (auto [dims, aggs] : {std::pair{"", ""}, std::pair{"host", ""}, std::pair{"ip,ip", ""},
+                            std::pair{"endpoint,status,method,ip,ua", ""}, std::pair{"ip", "avg(bytes)"},
+                            std::pair{"ip", "p0"}, std::pair{"ip", "p101"}, std::pair{"ip", "distinct(x)"},
+                            std::pair{"ip", "p95,p95"}}) {
+    INFO(dims << " / " << aggs);
+    logforge::GroupBySpec out;
+    std::string err;
+    CHECK_FALSE(logforge::parse_group_by(dims, aggs, out, err));
+    CHECK_FALSE(err.empty());
+  }
+}
+
+TEST_CASE("group-by computes count, bytes, quantiles and distinct per group") {
+  logforge::GroupBy g(spec("endpoint,status_class", "sum(bytes),p50,distinct(ip)"));
+  g.add(entry("/a", 200, "1.1.1.1", 100, 1000));
+  g.add(entry("/a", 204, "1.1.1.1", 50, 3000));
+  g.add(entry("/a", 201, "2.2.2.2", -1, -1)); // sem bytes nem latência
+  g.add(entry("/a", 503, "3.3.3.3", 10, 9000));
+  g.add(entry("/b", 200, "1.1.1.1", 7, 2000));
+  g.add(entry("/b", 700, "", 0, 2000));
+  CHECK(g.size() == 4);
+
+  const auto rows = g.rows();
+  REQUIRE(rows.size() == 4);
+  CHECK(rows[0].key == std::vector<std::string>{"/a", "2xx"});
+  CHECK(rows[0].count == 3);
+  CHECK(rows[0].bytes == 150);
+  CHECK(rows[0].distinct == std::vector<std::uint64_t>{2});
+  REQUIRE(rows[0].quantiles_ms.size() == 1);
+  CHECK(rows[0].quantiles_ms[0] > 0.9);
+  CHECK(rows[0].quantiles_ms[0] < 3.2);
+  // Empates em count: chave asc.
+  CHECK(rows[1].key == std::vector<std::string>{"/a", "5xx"});
+  CHECK(rows[2].key == std::vector<std::string>{"/b", "2xx"});
+  CHECK(rows[3].key == std::vector<std::string>{"/b", "other"});
+  CHECK(rows[3].distinct == std::vector<std::uint64_t>{1}); // ip vazio também é um valor
+
+  logforge::GroupBy m(spec("method,minute", ""));
+  logforge::LogEntry no_minute = entry("/x", 200, "", -1, -1);
+  no_minute.minute = logforge::kNoMinute;
+  m.add(no_minute);
+  m.add(entry("/x", 200, "", -1, -1));
+  const auto mrows = m.rows();
+  REQUIRE(mrows.size() == 2);
+  CHECK(mrows[0].key == std::vector<std::string>{"GET", "-"});
+  CHECK(mrows[1].key == std::vector<std::string>{"GET", "2025-01-01 10:00"});
+}
+
+TEST_CASE("group-by merge and snapshot round-trip match serial processing") {
+  const auto s = spec("ip,status", "sum(bytes),p95,distinct(endpoint)");
+  logforge::GroupBy serial(s), left(s), right(s);
+  const char* ips[] = {"10.0.0.1", "10.0.0.2", "10.0.0.3"};
+  const char* eps[] = {"/a", "/b", "/c", "/d", "/e"};
+  for (int i = 0; i < 5000; ++i) {
+    // Cada lado interna as strings numa ordem diferente.
+    const auto e = entry(eps[(i * 7) % 5], (i % 9) ? 200 : 500, ips[(i * (i < 2500 ? 1 : 2)) % 3], i % 300,
+                         1000 + (i % 97) * 100);
+    serial.add(e);
+    (i < 2500 ? left : right).add(e);
+  }
+  left.merge(right);
+  check_same_rows(serial.rows(), left.rows());
+
+  std::string bytes;
+  left.serialize(bytes);
+  logforge::GroupBy back(logforge::GroupBySpec{});
+  std::string_view in = bytes;
+  REQUIRE(back.deserialize(in));
+  CHECK(in.empty());
+  CHECK(back.spec() == s);
+  check_same_rows(serial.rows(), back.rows());
+
+  for (std::size_t cut : {std::size_t{0}, bytes.size() / 2, bytes.size() - 1}) {
+    std::string_view truncated = std::string_view(bytes).substr(0, cut);
+    logforge::GroupBy bad(logforge::GroupBySpec{});
+    CHECK_FALSE(bad.deserialize(truncated));
+  }
+}
+
+TEST_CASE("ingest with --group-by gives the same groups for any thread count") {
+  auto path = (std::filesystem::temp_directory_path() / "logforge_group_by.log").string();
+  {
+    std::ofstream ofs(path);
+    const char* methods[] = {"GET", "POST", "PUT"};
+    for (int i = 0; i < 4000; ++i) {
+      if (i % 31 == 0) {
+        ofs << "broken line " << i << "\n";
+        continue;
+      }
+      ofs << "10.0.0." << i % 17 << " - - [01/Jan/2025:10:" << (i / 100 < 10 ? "0" : "") << i / 100
+          << ":00 -0300] \"" << methods[i % 3] << " /api/" << i % 5 << " HTTP/1.1\" " << (i % 8 ? 200 : 502) << " "
+          << i % 1000 << " \"-\" \"agent/" << i % 4 << "\" 0." << (100 + i % 800) << "\n";
+    }
+  }
+
+  logforge::AggregatorOptions opt;
+  opt.group_by = spec("method,status_class", "sum(bytes),p99,distinct(ip),distinct(ua)");
+  std::vector<logforge::GroupRow> first;
+  for (int threads : {1, 4}) {
+    logforge::IngestOptions iopt;
+    iopt.threads = threads;
+    logforge::Aggregator agg(opt);
+    REQUIRE(logforge::ingest_file(path, iopt, agg));
+    const auto r = agg.finalize();
+    REQUIRE(r.group_by_enabled);
+    CHECK(r.group_by.size() == 6);
+    std::uint64_t total = 0;
+    for (const auto& row : r.group_by) {
+      total += row.count;
+      CHECK(row.distinct[0] == 17);
+      CHECK(row.distinct[1] == (row.key[1] == "5xx" ? 1u : 4u)); // i % 8 == 0 implica i % 4 == 0
+    }
+    CHECK(total == r.parsed_lines);
+    if (first.empty()) {
+      first = r.group_by;
+    } else {
+      check_same_rows(first, r.group_by);
+    }
+
+    // O estado do --group-by viaja no snapshot do Aggregator.
+    std::string bytes;
+    agg.serialize(bytes);
+    logforge::Aggregator back;
+    std::string_view in = bytes;
+    REQUIRE(back.deserialize(in));
+    CHECK(back.options().group_by == opt.group_by);
+    CHECK(back.mergeable_with(agg));
+    CHECK_FALSE(back.mergeable_with(logforge::Aggregator(20)));
+    check_same_rows(first, back.finalize().group_by);
+  }
+  std::remove(path.c_str());
+}
@@ -0,0 +1,146 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "logforge/aggregator.hpp"
+#include "logforge/hyperloglog.hpp"
+#include "logforge/ingest.hpp"
+
+static std::string ip(std::uint64_t i) {
+  return std::to_string(10 + (i >> 24) % 200) + "." + std::to_string((i >> 16) & 255) + "." +
+         std::to_string((i >> 8) & 255) + "." + std::to_string(i & 255);
+}
+
+TEST_CASE("HyperLogLog is practically exact while sparse") {
+  logforge::HyperLogLog h(12);
+  CHECK(h.estimate() == 0);
+  for (std::uint64_t i = 0; i < 1000; ++i) {
+    h.add(ip(i));
+    h.add(ip(i)); // repetidos não contam
+  }
+  CHECK(h.sparse());
+  CHECK(h.estimate() >= 998);
+  CHECK(h.estimate() <= 1002);
+  CHECK(h.memory_bytes() < 8 * 1024);
+
+  logforge::HyperLogLog off;
+  off.add("1.2.3.4");
+  CHECK_FALSE(off.enabled());
+  CHECK(off.estimate() == 0);
+}
+
+TEST_CASE("HyperLogLog stays within a few standard errors and bounded memory") {
+  for (int p : {10, 12, 14}) {
+    for (std::uint64_t n : {5000u, 60000u, 300000u}) {
+      logforge::HyperLogLog h(p);
+      for (std::uint64_t i = 0; i < n; ++i) h.add(ip(i * 2654435761u));
+      const double err = std::abs(static_cast<double>(h.estimate()) - static_cast<double>(n)) / static_cast<double>(n);
+      INFO("p=" << p << " n=" << n << " estimate=" << h.estimate());
+      CHECK_FALSE(h.sparse());
+      CHECK(err < 4 * h.relative_error());
+      CHECK(h.memory_bytes() <= (std::size_t{1} << p) + 256);
+    }
+  }
+}
+
+TEST_CASE("HyperLogLog merge equals the sketch of the union") {
+  for (std::uint64_t n : {300u, 3000u, 200000u}) {
+    logforge::HyperLogLog all(11), parts[3] = {logforge::HyperLogLog(11), logforge::HyperLogLog(11),
+                                               logforge::HyperLogLog(11)};
+    for (std::uint64_t i = 0; i < n; ++i) {
+      all.add(ip(i));
+      // Partes de tamanhos bem diferentes: misturam esparso e denso.
+      parts[i % 7 == 0 ? 0 : (i % 3 == 0 ? 1 : 2)].add(ip(i));
+      if (i % 5 == 0) parts[0].add(ip(i)); // sobreposição entre partes
+    }
+    logforge::HyperLogLog merged;
+    for (auto& p : parts) REQUIRE(merged.merge(p));
+    INFO("n=" << n);
+    CHECK(merged.sparse() == all.sparse());
+    CHECK(merged.estimate() == all.estimate());
+  }
+  logforge::HyperLogLog a(10), b(12);
+  CHECK_FALSE(a.merge(b));
+}
+
+TEST_CASE("HyperLogLog round-trips and rejects damaged data") {
+  for (std::uint64_t n : {0u, 50u, 100000u}) {
+    logforge::HyperLogLog h(12);
+    for (std::uint64_t i = 0; i < n; ++i) h.add(ip(i));
+    std::string bytes;
+    h.serialize(bytes);
+    logforge::HyperLogLog back;
+    std::string_view in = bytes;
+    REQUIRE(back.deserialize(in));
+    CHECK(in.empty());
+    CHECK(back.precision() == 12);
+    CHECK(back.estimate() == h.estimate());
+    if (n == 0) continue;
+    std::string_view truncated = std::string_view(bytes).substr(0, bytes.size() - 1);
+    CHECK_FALSE(back.deserialize(truncated));
+  }
+  std::string bad;
+  logforge::put_varint(bad, 30); // precisão fora da faixa
+  std::string_view in = bad;
+  logforge::HyperLogLog h;
+  CHECK_FALSE(h.deserialize(in));
+}
+
+TEST_CASE("unique clients per endpoint and window match across threads and snapshots") {
+  auto path = (std::filesystem::temp_directory_path() / "logforge_hll.log").string();
+  {
+    std::ofstream ofs(path);
+    for (int i = 0; i < 6000; ++i) {
+      // /a: 750 clientes (i % 1000 com i % 4 != 0); /b: 25. Cada minuto (100 linhas) tem
+      // 75 clientes de /a e 25 de /b.
+      const bool a = i % 4 != 0;
+      ofs << (a ? ip(static_cast<std::uint64_t>(i % 1000)) : ip(100000 + static_cast<std::uint64_t>(i % 50)))
+          << " - - [01/Jan/2025:10:" << (i / 100 < 10 ? "0" : "") << i / 100 << ":00 -0300] \"GET "
+          << (a ? "/a" : "/b") << " HTTP/1.1\" 200 1 \"-\" \"x\" 0.010\n";
+    }
+  }
+  logforge::AggregatorOptions opt;
+  opt.hll_precision = 12;
+  opt.endpoint_stats_capacity = 8;
+  opt.windows.width_min = 1;
+
+  std::uint64_t first_global = 0;
+  for (int threads : {1, 3}) {
+    logforge::IngestOptions iopt;
+    iopt.threads = threads;
+    logforge::Aggregator agg(opt);
+    REQUIRE(logforge::ingest_file(path, iopt, agg));
+    const auto r = agg.finalize();
+    REQUIRE(r.unique_clients_enabled);
+    CHECK(r.unique_clients_precision == 12);
+    CHECK(r.unique_clients >= 770); // 775 ainda cabe no esparso: quase exato
+    CHECK(r.unique_clients <= 780);
+    if (first_global == 0) first_global = r.unique_clients;
+    CHECK(r.unique_clients == first_global);
+
+    REQUIRE(r.endpoint_latency.size() == 2);
+    CHECK(r.endpoint_latency[0].endpoint == "/a");
+    CHECK(r.endpoint_latency[0].unique_clients >= 745);
+    CHECK(r.endpoint_latency[0].unique_clients <= 755);
+    CHECK(r.endpoint_latency[1].unique_clients == 25);
+    REQUIRE(r.windows.size() == 60);
+    for (const auto& w : r.windows) CHECK(w.unique_clients == 100);
+
+    std::string bytes;
+    agg.serialize(bytes);
+    logforge::Aggregator back;
+    std::string_view in = bytes;
+    REQUIRE(back.deserialize(in));
+    CHECK(back.options().hll_precision == 12);
+    const auto rb = back.finalize();
+    CHECK(rb.unique_clients == r.unique_clients);
+    CHECK(rb.endpoint_latency[0].unique_clients == r.endpoint_latency[0].unique_clients);
+    CHECK(rb.windows[7].unique_clients == r.windows[7].unique_clients);
+    CHECK_FALSE(back.mergeable_with(logforge::Aggregator(20)));
+  }
+  std::remove(path.c_str());
+}
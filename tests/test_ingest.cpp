@@ -0,0 +1,194 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+
+#include "logforge/ingest.hpp"
+#include "logforge/input_files.hpp"
+
+static std::string write_temp_log(const std::string& name, int lines) {
+  auto path = (std::filesystem::temp_directory_path() / name).string();
+  std::ofstream ofs(path);
+  const char* eps[] = {"/a", "/b?x=1", "/c", "/api/items"};
+  for (int i = 0; i < lines; ++i) {
+    if (i % 17 == 0) {
+      ofs << "garbage line " << i << "\n";
+      continue;
+    }
+    ofs << "10.0.0." << (i % 7) << " - - [01/Jan/2025:00:" << (10 + (i / 60) % 50) << ":"
+        << (10 + i % 50) << " -0300] \"GET " << eps[i % 4] << " HTTP/1.1\" " << (i % 5 ? 200 : 503)
+        << " 12 \"-\" \"curl/8.0\" 0." << (100 + i % 900) << "\n";
+  }
+  ofs << "127.0.0.1 - - [01/Jan/2025:01:00:00 -0300] \"GET /tail HTTP/1.1\" 200 1 \"-\" \"x\" 0.001";
+  return path;
+}
+
+TEST_CASE("split_file produces contiguous newline-aligned ranges") {
+  auto path = write_temp_log("logforge_split.log", 500);
+  auto size = std::filesystem::file_size(path);
+
+  auto ranges = logforge::split_file(path, 7);
+  REQUIRE(!ranges.empty());
+  CHECK(ranges.front().begin == 0);
+  CHECK(ranges.back().end == size);
+
+  std::ifstream ifs(path, std::ios::binary);
+  for (std::size_t i = 0; i < ranges.size(); ++i) {
+    if (i > 0) {
+      CHECK(ranges[i].begin == ranges[i - 1].end);
+      ifs.seekg(static_cast<std::streamoff>(ranges[i].begin - 1));
+      CHECK(ifs.get() == '\n');
+    }
+  }
+  std::remove(path.c_str());
+}
+
+TEST_CASE("ingest_file with threads matches single-thread output") {
+  auto path = write_temp_log("logforge_threads.log", 3000);
+
+  logforge::Aggregator single(10);
+  REQUIRE(logforge::ingest_file(path, logforge::IngestOptions{}, single));
+  auto r1 = single.finalize();
+
+  for (int threads : {2, 3, 4, 8}) {
+    logforge::IngestOptions opt;
+    opt.threads = threads;
+    opt.reader = (threads == 3)   ? logforge::ReaderKind::Stream
+                 : (threads == 4) ? logforge::ReaderKind::Async
+                                  : logforge::ReaderKind::Mmap;
+    logforge::Aggregator multi(10);
+    logforge::IngestStats stats;
+    REQUIRE(logforge::ingest_file(path, opt, multi, &stats));
+    auto r2 = multi.finalize();
+
+    // Os leitores que rodaram de fato; mmap e uring em lotes, stream linha a linha.
+    const auto& src = stats.sources;
+    CHECK(src.sources() == static_cast<std::size_t>(threads));
+    CHECK(src.batched == (threads == 3 ? 0u : src.sources()));
+    if (threads == 4) CHECK(src.uring + src.pread == 4u);
+
+    CHECK(r2.total_lines == r1.total_lines);
+    CHECK(r2.parsed_lines == r1.parsed_lines);
+    CHECK(r2.invalid_lines == r1.invalid_lines);
+    CHECK(r2.status_counts == r1.status_counts);
+    CHECK(r2.endpoint_counts == r1.endpoint_counts);
+    CHECK(r2.per_minute_counts == r1.per_minute_counts);
+    CHECK(r2.latency.count == r1.latency.count);
+    CHECK(r2.latency.avg_ms == r1.latency.avg_ms);
+    CHECK(r2.latency.p95_ms == r1.latency.p95_ms);
+  }
+  CHECK(r1.total_lines == 3001);
+  std::remove(path.c_str());
+}
+
+TEST_CASE("Pipes and FIFOs are read as one unsplit stream") {
+  const auto path = write_temp_log("logforge_fifo_src.log", 2000);
+  std::string text;
+  {
+    std::ifstream ifs(path, std::ios::binary);
+    text.assign(std::istreambuf_iterator<char>(ifs), {});
+  }
+  logforge::Aggregator regular(10);
+  REQUIRE(logforge::ingest_file(path, logforge::IngestOptions{}, regular));
+  const auto r1 = regular.finalize();
+
+  const auto fifo = (std::filesystem::temp_directory_path() / "logforge_ingest.fifo").string();
+  std::remove(fifo.c_str());
+  REQUIRE(::mkfifo(fifo.c_str(), 0600) == 0);
+  const auto ranges = logforge::split_file(fifo, 4);
+  REQUIRE(ranges.size() == 1);
+  CHECK(ranges[0].begin == 0);
+  CHECK(ranges[0].end == UINT64_MAX);
+
+  // Leitores que testam a entrada (mmap, uring) e o multi-arquivo não podem consumir a FIFO.
+  for (auto reader : {logforge::ReaderKind::Mmap, logforge::ReaderKind::Async}) {
+    for (bool multi_file : {false, true}) {
+      INFO("reader " << static_cast<int>(reader) << " multi_file " << multi_file);
+      std::thread writer([&] { std::ofstream(fifo, std::ios::binary) << text; });
+      logforge::IngestOptions opt;
+      opt.threads = 4;
+      opt.reader = reader;
+      logforge::Aggregator agg(10);
+      logforge::IngestStats stats;
+      const bool ok = multi_file ? logforge::ingest_files({fifo, path}, opt, agg, &stats)
+                                 : logforge::ingest_file(fifo, opt, agg, &stats);
+      writer.join();
+      REQUIRE(ok);
+      CHECK(stats.sources.stream == 1); // a FIFO caiu para o stream, seja qual for o --reader
+      CHECK(stats.sources.sources() == (multi_file ? 2u : 1u));
+      const auto r2 = agg.finalize();
+      const std::uint64_t copies = multi_file ? 2 : 1;
+      CHECK(r2.total_lines == r1.total_lines * copies);
+      CHECK(r2.invalid_lines == r1.invalid_lines * copies);
+      CHECK(r2.latency.count == r1.latency.count * copies);
+    }
+  }
+  std::remove(fifo.c_str());
+  std::remove(path.c_str());
+}
+
+TEST_CASE("expand_inputs handles directories, globs and missing paths") {
+  const auto dir = std::filesystem::temp_directory_path() / "logforge_inputs";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir / "sub");
+  for (const char* name : {"b.log", "a.log", "c.log.gz", ".hidden"}) std::ofstream(dir / name) << "x\n";
+  // Links quebrado e em laço: pulados, sem derrubar a listagem do diretório.
+  std::filesystem::create_symlink(dir / "missing.log", dir / "dangling.log");
+  std::filesystem::create_symlink(dir / "loop.log", dir / "loop.log");
+
+  std::vector<std::string> files;
+  std::string err;
+  REQUIRE(logforge::expand_inputs({dir.string()}, files, err));
+  CHECK(files == std::vector<std::string>{(dir / "a.log").string(), (dir / "b.log").string(),
+                                          (dir / "c.log.gz").string()});
+
+  files.clear();
+  REQUIRE(logforge::expand_inputs({(dir / "*.log").string(), (dir / "a.log").string()}, files, err));
+  CHECK(files == std::vector<std::string>{(dir / "a.log").string(), (dir / "b.log").string()});
+
+  files.clear();
+  CHECK_FALSE(logforge::expand_inputs({(dir / "*.txt").string()}, files, err));
+  CHECK_FALSE(logforge::expand_inputs({(dir / "nope.log").string()}, files, err));
+  CHECK_FALSE(err.empty());
+}
+
+TEST_CASE("ingest_files balances one huge file and many small ones into one report") {
+  // Um arquivo grande o bastante para virar vários pedaços (> 4 MiB) e vários pequenos.
+  std::vector<std::string> paths = {write_temp_log("logforge_multi_big.log", 90000)};
+  for (int i = 0; i < 6; ++i) paths.push_back(write_temp_log("logforge_multi_" + std::to_string(i) + ".log", 50 + i * 40));
+
+  logforge::Aggregator serial(10);
+  for (const auto& p : paths) REQUIRE(logforge::ingest_file(p, logforge::IngestOptions{}, serial));
+  const auto r1 = serial.finalize();
+
+  for (int threads : {1, 4}) {
+    INFO("threads " << threads);
+    logforge::IngestOptions opt;
+    opt.threads = threads;
+    logforge::Aggregator multi(10);
+    logforge::IngestStats stats;
+    REQUIRE(logforge::ingest_files(paths, opt, multi, &stats));
+    const auto r2 = multi.finalize();
+
+    CHECK(stats.files == paths.size());
+    if (threads > 1) CHECK(stats.tasks > paths.size());
+    CHECK(r2.total_lines == r1.total_lines);
+    CHECK(r2.invalid_lines == r1.invalid_lines);
+    CHECK(r2.status_counts == r1.status_counts);
+    CHECK(r2.endpoint_counts == r1.endpoint_counts);
+    CHECK(r2.per_minute_counts == r1.per_minute_counts);
+    CHECK(r2.latency.p99_ms == r1.latency.p99_ms);
+  }
+
+  logforge::Aggregator bad(10);
+  logforge::IngestStats stats;
+  CHECK_FALSE(logforge::ingest_files({paths[1], "/nonexistent/logforge.log"}, logforge::IngestOptions{}, bad, &stats));
+  CHECK(stats.failed_path == "/nonexistent/logforge.log");
+
+  for (const auto& p : paths) std::remove(p.c_str());
+}
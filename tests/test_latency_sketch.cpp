@@ -0,0 +1,83 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "logforge/latency_sketch.hpp"
+
+static double exact_quantile(std::vector<std::uint64_t> v, double q) {
+  std::sort(v.begin(), v.end());
+  auto rank = static_cast<std::size_t>(std::ceil(q * static_cast<double>(v.size())));
+  return static_cast<double>(v[std::max<std::size_t>(rank, 1) - 1]);
+}
+
+TEST_CASE("LatencySketch quantiles stay within the relative error") {
+  std::mt19937_64 rng(7);
+  std::lognormal_distribution<double> dist(std::log(20000.0), 1.5); // ~20 ms, cauda longa
+
+  logforge::LatencySketch sk(0.01);
+  std::vector<std::uint64_t> values;
+  for (int i = 0; i < 50000; ++i) {
+    auto v = static_cast<std::uint64_t>(dist(rng));
+    values.push_back(v);
+    sk.add(v);
+  }
+  sk.add(3'600'000'000ull); // 1 h: sem bucket de overflow
+  values.push_back(3'600'000'000ull);
+
+  REQUIRE(sk.relative_error() <= 0.01);
+  for (double q : {0.01, 0.5, 0.9, 0.95, 0.99, 0.999}) {
+    const double exact = exact_quantile(values, q);
+    const double est = sk.quantile(q);
+    INFO("q=" << q << " exact=" << exact << " est=" << est);
+    CHECK(std::abs(est - exact) <= exact * sk.relative_error() + 0.5);
+  }
+  CHECK(sk.quantile(1.0) == 3'600'000'000.0);
+  CHECK(sk.bucket_count() < 4000);
+}
+
+TEST_CASE("LatencySketch merge equals single sketch, also with bucket cap") {
+  for (std::uint32_t cap : {0u, 16u}) {
+    std::mt19937_64 rng(11);
+    logforge::LatencySketch all(0.02, cap), a(0.02, cap), b(0.02, cap);
+    for (int i = 0; i < 20000; ++i) {
+      const std::uint64_t v = rng() % 2'000'000;
+      all.add(v);
+      (i % 3 ? a : b).add(v);
+    }
+    REQUIRE(a.merge(b));
+    if (cap) CHECK(a.bucket_count() <= cap);
+
+    std::string sa, sall;
+    a.serialize(sa);
+    all.serialize(sall);
+    CHECK(sa == sall);
+  }
+
+  logforge::LatencySketch p1(0.01), p2(0.1);
+  CHECK_FALSE(p1.merge(p2));
+}
+
+TEST_CASE("LatencySketch serialization round-trips") {
+  logforge::LatencySketch sk(0.01);
+  for (std::uint64_t v : {0ull, 1ull, 245000ull, 90000ull, 510000ull, 123456789ull}) sk.add(v);
+
+  std::string buf;
+  sk.serialize(buf);
+
+  logforge::LatencySketch back(0.5);
+  std::string_view in = buf;
+  REQUIRE(back.deserialize(in));
+  CHECK(in.empty());
+  CHECK(back.count() == sk.count());
+  CHECK(back.sum() == sk.sum());
+  CHECK(back.min() == 0);
+  CHECK(back.max() == 123456789);
+  CHECK(back.quantile(0.5) == sk.quantile(0.5));
+
+  std::string_view truncated(buf.data(), buf.size() - 1);
+  CHECK_FALSE(back.deserialize(truncated));
+}
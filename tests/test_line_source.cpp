@@ -0,0 +1,152 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "logforge/async_reader.hpp"
+#include "logforge/line_source.hpp"
+
+static std::vector<std::string> read_all(const std::string& path, logforge::ReaderKind kind,
+                                         logforge::ByteRange range = {}) {
+  std::vector<std::string> lines;
+  auto src = logforge::open_line_source(path, kind, range);
+  REQUIRE(src->ok());
+  std::string_view line;
+  while (src->next_line(line)) lines.emplace_back(line);
+  return lines;
+}
+
+TEST_CASE("Mmap and stream line sources return the same lines") {
+  auto path = (std::filesystem::temp_directory_path() / "logforge_lines.log").string();
+
+  const std::vector<std::string> contents = {
+      "",
+      "\n",
+      "one line without newline",
+      "a\nb\n",
+      "a\n\nb\r\nlast",
+  };
+  for (const auto& c : contents) {
+    {
+      std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+      ofs << c;
+    }
+    auto stream = read_all(path, logforge::ReaderKind::Stream);
+    auto mmap = read_all(path, logforge::ReaderKind::Mmap);
+    CHECK(mmap == stream);
+    CHECK(read_all(path, logforge::ReaderKind::Async) == stream);
+  }
+
+  // Faixa no meio do arquivo: só linhas que começam dentro dela.
+  {
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    ofs << "aa\nbb\ncc\ndd\n";
+  }
+  logforge::ByteRange mid{3, 9};
+  CHECK(read_all(path, logforge::ReaderKind::Mmap, mid) == std::vector<std::string>{"bb", "cc"});
+  CHECK(read_all(path, logforge::ReaderKind::Stream, mid) == std::vector<std::string>{"bb", "cc"});
+  CHECK(read_all(path, logforge::ReaderKind::Async, mid) == std::vector<std::string>{"bb", "cc"});
+
+  std::remove(path.c_str());
+}
+
+TEST_CASE("Async reader stitches lines across block edges on every backend") {
+  auto path = (std::filesystem::temp_directory_path() / "logforge_async.log").string();
+
+  // Linhas de tamanhos variados (algumas maiores que um bloco de 4 KiB), sem '\n' no fim.
+  std::string text;
+  for (int i = 0; i < 3000; ++i) {
+    const std::size_t len = (i % 50 == 0) ? 6000 : static_cast<std::size_t>(i * 37 % 300);
+    text += "line " + std::to_string(i) + " " + std::string(len, 'x');
+    if (i + 1 < 3000) text += '\n';
+  }
+  {
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    ofs << text;
+  }
+  const auto expected = read_all(path, logforge::ReaderKind::Mmap);
+
+  for (auto backend : {logforge::AsyncBackend::Pread, logforge::AsyncBackend::Auto}) {
+    for (bool direct : {false, true}) {
+      logforge::AsyncReadOptions opt;
+      opt.block_size = 4096;
+      opt.depth = 3;
+      opt.direct = direct;
+      opt.backend = backend;
+
+      logforge::AsyncLineReader r(path, {}, opt);
+      REQUIRE(r.ok());
+      std::vector<std::string> got;
+      std::string_view line;
+      while (r.next_line(line)) got.emplace_back(line);
+      CHECK(r.ok());
+      CHECK(got == expected);
+      CHECK(r.bytes_read() == text.size());
+
+      // Faixas alinhadas em linha, como as do --threads: juntas, as linhas do arquivo inteiro.
+      const std::uint64_t cut = text.find('\n', text.size() / 3) + 1;
+      std::vector<std::string> parts;
+      for (logforge::ByteRange range : {logforge::ByteRange{0, cut}, logforge::ByteRange{cut, UINT64_MAX}}) {
+        logforge::AsyncLineReader pr(path, range, opt);
+        while (pr.next_line(line)) parts.emplace_back(line);
+      }
+      CHECK(parts == expected);
+    }
+  }
+
+  std::remove(path.c_str());
+}
+
+TEST_CASE("Async reader keeps a batch's views valid until release") {
+  auto path = (std::filesystem::temp_directory_path() / "logforge_async_hold.log").string();
+
+  // Linhas maiores que o anel livre (3 blocos de 4 KiB) forçam o bloco avulso.
+  std::string text;
+  for (int i = 0; i < 4000; ++i) {
+    const std::size_t len = (i % 97 == 0) ? 13000 : static_cast<std::size_t>(i * 53 % 500);
+    text += "line " + std::to_string(i) + " " + std::string(len, static_cast<char>('a' + i % 26)) + "\n";
+  }
+  {
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    ofs << text;
+  }
+  const auto expected = read_all(path, logforge::ReaderKind::Mmap);
+
+  for (auto backend : {logforge::AsyncBackend::Pread, logforge::AsyncBackend::Auto}) {
+    for (std::size_t depth : {2, 3}) {
+      logforge::AsyncReadOptions opt;
+      opt.block_size = 4096;
+      opt.depth = depth;
+      opt.backend = backend;
+      logforge::AsyncLineReader r(path, {}, opt);
+      REQUIRE(r.stable_views());
+      r.hold_views();
+
+      // Confere o lote inteiro só na hora do release: as views antigas não podem ter mudado.
+      std::string_view batch[128];
+      std::size_t n = 0, seen = 0, batches = 0, bad = 0;
+      auto flush = [&] {
+        for (std::size_t k = 0; k < n; ++k) {
+          if (seen + k >= expected.size() || batch[k] != expected[seen + k]) ++bad;
+        }
+        seen += n;
+        n = 0;
+        ++batches;
+        r.release_views();
+      };
+      while (r.next_line(batch[n])) {
+        if (++n == 128 || r.release_due()) flush();
+      }
+      if (n > 0) flush();
+      CHECK(r.ok());
+      CHECK(bad == 0);
+      CHECK(seen == expected.size());
+      CHECK(batches > expected.size() / 128);
+    }
+  }
+
+  std::remove(path.c_str());
+}
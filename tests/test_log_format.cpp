@@ -0,0 +1,371 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "logforge/aggregator.hpp"
+#include "logforge/filter.hpp"
+#include "logforge/ingest.hpp"
+#include "logforge/json_lines.hpp"
+#include "logforge/log_format.hpp"
+#include "logforge/parser_nginx.hpp"
+#include "logforge/time_util.hpp"
+
+static void check_same(const logforge::LogEntry& a, const logforge::LogEntry& b) {
+  CHECK(a.endpoint == b.endpoint);
+  CHECK(a.status == b.status);
+  CHECK(a.latency_us == b.latency_us);
+  CHECK(a.minute == b.minute);
+  CHECK(a.method == b.method);
+  CHECK(a.remote_addr == b.remote_addr);
+  CHECK(a.bytes == b.bytes);
+  CHECK(a.user_agent == b.user_agent);
+}
+
+static logforge::FormatPlan plan(logforge::FormatDialect d, std::string_view fmt) {
+  const auto p = logforge::compile_log_format(d, fmt);
+  INFO(fmt << " -> " << (p.error ? p.error : "ok"));
+  REQUIRE(p.error == nullptr);
+  return p;
+}
+
+static logforge::LogEntry parse_ok(const logforge::Parser& p, std::string_view line) {
+  logforge::LogEntry e;
+  INFO(line);
+  REQUIRE(p.parse(line, nullptr, e) == logforge::ParseResult::Ok);
+  return e;
+}
+
+TEST_CASE("generated parsers match the hand-written nginx parser on its layout") {
+  std::mt19937 rng(7);
+  const char* methods[] = {"GET", "POST", "DELETE"};
+  const char* paths[] = {"/api/items?id=1", "/health", "https://example.com/x/y?z", "/a%20b"};
+  const char* agents[] = {"Mozilla/5.0 (X11; Linux)", "curl/8.0", "-"};
+
+  const logforge::NginxParser nginx;
+  const logforge::FormatParser runtime(logforge::kTimedPlan);
+  std::vector<logforge::StaticFormatParser<logforge::kTimedPlan>> statics;
+  for (auto isa : {logforge::Isa::Scalar, logforge::Isa::Sse2, logforge::Isa::Avx2}) {
+    if (logforge::isa_supported(isa)) statics.emplace_back(isa);
+  }
+  const logforge::JsonLinesParser json;
+
+  for (int i = 0; i < 3000; ++i) {
+    const std::string ip = "10.0." + std::to_string(rng() % 256) + "." + std::to_string(rng() % 256);
+    const std::string time = std::to_string(1 + rng() % 28) + "/Mar/2025:" + std::to_string(10 + rng() % 14) + ":" +
+                             std::to_string(10 + rng() % 50) + ":07 -0300";
+    const std::string request = std::string(methods[rng() % 3]) + " " + paths[rng() % 4] + " HTTP/1.1";
+    const int status = 100 + static_cast<int>(rng() % 500);
+    const std::string bytes = (rng() % 5) ? std::to_string(rng() % 100000) : "-";
+    const std::string ua = agents[rng() % 3];
+    const std::string rt = (rng() % 7) ? std::to_string(rng() % 3) + "." + std::to_string(100 + rng() % 900) : "-";
+    // Linhas longas passam do limite das máscaras (4 KiB) e caem no memchr.
+    const std::string pad = (i % 50 == 0) ? std::string(5000, 'p') : "";
+
+    const std::string line = ip + " - - [" + time + "] \"" + request + "\" " + std::to_string(status) + " " + bytes +
+                             " \"https://ref/" + pad + "\" \"" + ua + "\" " + rt;
+    const std::string jline = "{\"request_time\":" + (rt == "-" ? std::string("null") : rt) + ",\"ref\":{\"a\":[1,\"}\"]}," +
+                              "\"time_local\":\"" + time + "\",\"remote_addr\":\"" + ip + "\",\"request\":\"" +
+                              request + "\",\"status\":" + std::to_string(status) + ",\"body_bytes_sent\":" +
+                              (bytes == "-" ? std::string("null") : bytes) + ",\"http_user_agent\":\"" + ua +
+                              "\",\"pad\":\"" + pad + "\"}";
+
+    INFO(line);
+    const auto expected = nginx.parse_line(line);
+    REQUIRE(expected.has_value());
+    check_same(parse_ok(runtime, line), *expected);
+    for (const auto& p : statics) check_same(parse_ok(p, line), *expected);
+    check_same(parse_ok(json, jline), *expected);
+  }
+}
+
+// O plano passo a passo, sem nada emprestado dos embutidos: referência do FormatParser.
+static logforge::ParseResult interpret(const logforge::FormatPlan& p, std::string_view line, logforge::LogEntry& out) {
+  std::string_view cap[logforge::kFormatFields];
+  std::size_t pos = 0;
+  for (std::size_t i = 0; i < p.size; ++i) {
+    if (!logforge::run_format_step(p.steps[i], line, pos, cap, nullptr)) return logforge::ParseResult::Invalid;
+  }
+  if (!logforge::format_rest_blank(line, pos)) return logforge::ParseResult::Invalid;
+  return logforge::finish_format_entry(p.has, cap, nullptr, out);
+}
+
+TEST_CASE("runtime and static plans agree on mutated lines") {
+  std::mt19937 rng(99);
+  const std::string seed =
+      "127.0.0.1 - - [10/Oct/2000:13:55:36 -0700] \"GET /api/items?id=1 HTTP/1.1\" 200 2326 \"-\" \"Mo\\\"z\" 0.245";
+  const char alphabet[] = "[]\" \\/?:.-0123456789";
+  const logforge::FormatParser runtime(logforge::kTimedPlan, logforge::Isa::Scalar);
+  const logforge::StaticFormatParser<logforge::kTimedPlan> fast;
+  int valid = 0;
+  for (int iter = 0; iter < 20000; ++iter) {
+    std::string s = seed;
+    if (rng() % 8 == 0) s.insert(rng() % s.size(), std::string(rng() % 5000, ' '));
+    for (int m = static_cast<int>(rng() % 4); m > 0 && !s.empty(); --m) {
+      const auto pos = rng() % s.size();
+      switch (rng() % 3) {
+        case 0: s[pos] = alphabet[rng() % (sizeof(alphabet) - 1)]; break;
+        case 1: s.insert(s.begin() + static_cast<long>(pos), alphabet[rng() % (sizeof(alphabet) - 1)]); break;
+        case 2: s.erase(pos, 1 + rng() % 4); break;
+      }
+    }
+    logforge::LogEntry a, b, c;
+    const auto ra = runtime.parse(s, nullptr, a);
+    INFO(s);
+    REQUIRE(fast.parse(s, nullptr, b) == ra);
+    REQUIRE(interpret(logforge::kTimedPlan, s, c) == ra);
+    if (ra != logforge::ParseResult::Ok) continue;
+    valid++;
+    check_same(a, b);
+    check_same(a, c);
+  }
+  CHECK(valid > 1000);
+  CHECK(valid < 19000);
+}
+
+TEST_CASE("a built-in layout with extra fields borrows the unrolled steps") {
+  const auto extended = plan(logforge::FormatDialect::Nginx,
+                             "$remote_addr - $remote_user [$time_local] \"$request\" $status $body_bytes_sent "
+                             "\"$http_referer\" \"$http_user_agent\" $request_time $host \"$http_x_id\"");
+  const logforge::FormatParser runtime(extended, logforge::Isa::Scalar);
+  CHECK(runtime.unrolled_steps() == logforge::kTimedPlan.size - 1); // o $request_time muda de delimitador
+  const auto other = plan(logforge::FormatDialect::Nginx, "$status \"$request\" $remote_addr");
+  CHECK(logforge::FormatParser(other).unrolled_steps() == 0);
+
+  std::mt19937 rng(5);
+  const std::string seed = "127.0.0.1 - - [10/Oct/2000:13:55:36 -0700] \"GET /api/items?id=1 HTTP/1.1\" 200 2326 "
+                           "\"-\" \"Mo\\\"z\" 0.245 api.example.com \"x-1\"";
+  const char alphabet[] = "[]\" \\/?:.-0123456789";
+  int valid = 0;
+  for (int iter = 0; iter < 20000; ++iter) {
+    std::string s = seed;
+    if (rng() % 8 == 0) s.insert(rng() % s.size(), std::string(rng() % 5000, ' '));
+    for (int m = static_cast<int>(rng() % 4); m > 0 && !s.empty(); --m) {
+      const auto pos = rng() % s.size();
+      switch (rng() % 3) {
+        case 0: s[pos] = alphabet[rng() % (sizeof(alphabet) - 1)]; break;
+        case 1: s.insert(s.begin() + static_cast<long>(pos), alphabet[rng() % (sizeof(alphabet) - 1)]); break;
+        case 2: s.erase(pos, 1 + rng() % 4); break;
+      }
+    }
+    logforge::LogEntry a, b;
+    const auto ra = runtime.parse(s, nullptr, a);
+    INFO(s);
+    REQUIRE(interpret(extended, s, b) == ra);
+    if (ra != logforge::ParseResult::Ok) continue;
+    valid++;
+    check_same(a, b);
+  }
+  CHECK(valid > 1000);
+  CHECK(valid < 19000);
+}
+
+TEST_CASE("nginx log_format with the latency in the middle") {
+  // Cópia do nginx.conf, em partes entre aspas simples.
+  logforge::FormatOptions opt;
+  opt.log_format = "'$remote_addr [$time_iso8601] $request_method $request_uri $status ' "
+                   "'urt=$upstream_response_time ${request_length}b ua=\"$http_user_agent\" $host';";
+  std::string err;
+  const auto p = logforge::make_parser(opt, err);
+  REQUIRE(p != nullptr);
+
+  auto e = parse_ok(*p, "10.1.1.1 [2025-03-01T10:15:59-03:00] POST /api/orders?x=1 502 urt=0.250,0.100 "
+                        "512b ua=\"curl/8 \\\"q\\\"\" api.example.com");
+  CHECK(e.remote_addr == "10.1.1.1");
+  CHECK(logforge::format_minute(e.minute) == "2025-03-01 13:15"); // -03:00 -> UTC
+  CHECK(e.method == "POST");
+  CHECK(e.endpoint == "/api/orders");
+  CHECK(e.status == 502);
+  CHECK(e.latency_us == 350000); // upstreams somados
+  CHECK(e.user_agent == "curl/8 \\\"q\\\"");
+
+  e = parse_ok(*p, "::1 [2025-03-01T10:16:00Z] GET / 200 urt=- 0b ua=\"\" h");
+  CHECK(e.latency_us == -1);
+
+  logforge::LogEntry bad;
+  for (const char* line : {"10.1.1.1 [2025-03-01T10:15:59-03:00] GET /x 200 urt=0.1 1b ua=\"\"",  // sem $host
+                           "10.1.1.1 [bad] GET /x 200 urt=0.1 1b ua=\"\" h",
+                           "10.1.1.1 [2025-03-01T10:15:59-03:00] GET /x abc urt=0.1 1b ua=\"\" h"}) {
+    INFO(line);
+    CHECK(p->parse(line, nullptr, bad) == logforge::ParseResult::Invalid);
+  }
+}
+
+TEST_CASE("Apache LogFormat directives") {
+  const logforge::StaticFormatParser<logforge::kCommonPlan> common;
+  auto e = parse_ok(common, "192.168.0.9 - frank [10/Oct/2000:13:55:36 -0700] \"GET /apache_pb.gif HTTP/1.0\" 200 2326");
+  CHECK(e.endpoint == "/apache_pb.gif");
+  CHECK(e.bytes == 2326);
+  CHECK(e.latency_us == -1);
+  CHECK(logforge::format_minute(e.minute) == "2000-10-10 20:55"); // -0700 -> UTC
+
+  const logforge::FormatParser timed(
+      plan(logforge::FormatDialect::Apache, "%a %{sec}t \\\"%m %U%q\\\" %>s %O %D \\\"%{User-agent}i\\\" %{ms}T"));
+  e = parse_ok(timed, "10.0.0.1 1735736460 \"PUT /v1/x?y=2\" 201 17 1500 \"UA \\\"quoted\\\"\" 2");
+  CHECK(e.remote_addr == "10.0.0.1");
+  CHECK(logforge::format_minute(e.minute) == "2025-01-01 13:01"); // época: UTC
+  CHECK(e.method == "PUT");
+  CHECK(e.endpoint == "/v1/x");
+  CHECK(e.status == 201);
+  CHECK(e.latency_us == 1500); // %D tem prioridade sobre %{ms}T
+  CHECK(e.user_agent == "UA \\\"quoted\\\"");
+}
+
+TEST_CASE("a format equal to a built-in one gets the unrolled parser") {
+  std::string err;
+  logforge::FormatOptions opt;
+  opt.log_format = "'$remote_addr - $remote_user [$time_local] \"$request\" '\n"
+                   "'$status $body_bytes_sent \"$http_referer\" \"${http_user_agent}\"'";
+  auto p = logforge::make_parser(opt, err);
+  CHECK(dynamic_cast<const logforge::StaticFormatParser<logforge::kCombinedPlan>*>(p.get()) != nullptr);
+
+  opt.log_format.clear();
+  opt.apache_format = "%a %l %u %t \\\"%r\\\" %s %B";
+  p = logforge::make_parser(opt, err);
+  CHECK(dynamic_cast<const logforge::StaticFormatParser<logforge::kCommonPlan>*>(p.get()) != nullptr);
+
+  opt.apache_format = "%a %l %u %t \\\"%r\\\" %s %B %D";
+  p = logforge::make_parser(opt, err);
+  CHECK(dynamic_cast<const logforge::FormatParser*>(p.get()) != nullptr);
+}
+
+TEST_CASE("format compiler rejects formats it cannot parse") {
+  using logforge::FormatDialect;
+  for (auto [d, fmt] : {std::pair{FormatDialect::Nginx, "$remote_addr $request"},      // sem status
+                        std::pair{FormatDialect::Nginx, "$status $remote_addr"},       // sem request/uri
+                        std::pair{FormatDialect::Nginx, "$status$request"},            // colados
+                        std::pair{FormatDialect::Nginx, "$status ${request"},          // chave aberta
+                        std::pair{FormatDialect::Nginx, "$status $ $request"},         // variável vazia
+                        std::pair{FormatDialect::Apache, "%>s %r %"},                  // diretiva incompleta
+                        std::pair{FormatDialect::Apache, "%>s %{User-agent i %r"}}) {
+    INFO(fmt);
+    CHECK(logforge::compile_log_format(d, fmt).error != nullptr);
+  }
+  std::string long_fmt = "$status \"$request\"";
+  for (int i = 0; i < 60; ++i) long_fmt += " x$host";
+  CHECK(logforge::compile_log_format(FormatDialect::Nginx, long_fmt).error != nullptr);
+
+  std::string err;
+  logforge::FormatOptions opt;
+  opt.name = "xml";
+  CHECK(logforge::make_parser(opt, err) == nullptr);
+  CHECK_FALSE(err.empty());
+  opt = logforge::FormatOptions{};
+  CHECK(logforge::make_parser(opt, err = "") == nullptr); // nginx: o NginxParser embutido
+  CHECK(err.empty());
+  opt.log_format = "$status $request";
+  opt.apache_format = "%>s %r";
+  CHECK(logforge::make_parser(opt, err) == nullptr);
+}
+
+TEST_CASE("JSON lines parser pulls only the mapped keys") {
+  const logforge::JsonLinesParser p;
+  auto e = parse_ok(p, R"(  {"msg":"a \"quoted\" } text","uri":"/x/y?q=1","status":"404","nested":{"status":500},)"
+                       R"("ts":1735736460.5,"method":"GET","duration_ms":12.5,"client_ip":"::1"}  )");
+  CHECK(e.endpoint == "/x/y");
+  CHECK(e.status == 404);
+  CHECK(e.method == "GET");
+  CHECK(logforge::format_minute(e.minute) == "2025-01-01 13:01");
+  CHECK(e.latency_us == 12500);
+  CHECK(e.remote_addr == "::1");
+
+  e = parse_ok(p, R"({"@timestamp":"2025-03-01T10:15:59.123Z","status":200,"path":"/","ts":1})");
+  CHECK(logforge::format_minute(e.minute) == "2025-03-01 10:15"); // primeira chave de tempo ganha
+  e = parse_ok(p, R"({"time":1735736460123,"status":200,"url":"/"})");
+  CHECK(logforge::format_minute(e.minute) == "2025-01-01 13:01"); // em ms
+
+  logforge::LogEntry bad;
+  for (const char* line : {"", "[]", "{}", R"({"status":200})", R"({"uri":"/x"})", R"({"status":200,"uri":"/x")",
+                           R"({"status":200 "uri":"/x"})", R"({"status":200,"uri":"/x"} trailing)",
+                           R"({"status":"abc","uri":"/x"})", R"({"status":200,"uri":"/x","time":"bad"})"}) {
+    INFO(line);
+    CHECK(p.parse(line, nullptr, bad) == logforge::ParseResult::Invalid);
+  }
+
+  logforge::JsonLinesParser custom;
+  std::string err;
+  REQUIRE(custom.set_keys("status=code, uri=req.path, latency_us=took", err));
+  e = parse_ok(custom, R"({"status":999,"code":201,"uri":"/ignored","req.path":"/mine","took":42})");
+  CHECK(e.status == 201);
+  CHECK(e.endpoint == "/mine");
+  CHECK(e.latency_us == 42);
+  CHECK(custom.parse(R"({"status":200,"uri":"/x"})", nullptr, bad) == logforge::ParseResult::Invalid);
+  for (const char* spec : {"", "foo=bar", "status=", "uri"}) {
+    INFO(spec);
+    CHECK_FALSE(custom.set_keys(spec, err));
+  }
+}
+
+TEST_CASE("generated parsers apply --where stage by stage") {
+  logforge::Filter f;
+  std::string err;
+  REQUIRE(f.compile("status = 5xx and endpoint = /api/*", err));
+  const logforge::StaticFormatParser<logforge::kCombinedPlan> combined;
+  const logforge::JsonLinesParser json;
+  logforge::LogEntry e;
+  CHECK(combined.parse("1.1.1.1 - - [01/Jan/2025:10:00:00 -0300] \"GET /api/x HTTP/1.1\" 503 1 \"-\" \"ua\"", &f, e) ==
+        logforge::ParseResult::Ok);
+  CHECK(e.user_agent == "ua");
+  CHECK(combined.parse("1.1.1.1 - - [01/Jan/2025:10:00:00 -0300] \"GET /web HTTP/1.1\" 503 1 \"-\" \"ua\"", &f, e) ==
+        logforge::ParseResult::Filtered);
+  // Reprovada no status, mas a request quebrada ainda a torna inválida.
+  CHECK(combined.parse("1.1.1.1 - - [01/Jan/2025:10:00:00 -0300] \"broken\" 200 1 \"-\" \"ua\"", &f, e) ==
+        logforge::ParseResult::Invalid);
+  CHECK(json.parse(R"({"status":200,"uri":"/api/x"})", &f, e) == logforge::ParseResult::Filtered);
+  CHECK(json.parse(R"({"status":500,"uri":"/api/x"})", &f, e) == logforge::ParseResult::Ok);
+}
+
+TEST_CASE("ingest with a generated parser gives the same report as the nginx parser") {
+  const auto dir = std::filesystem::temp_directory_path();
+  const auto text = (dir / "logforge_fmt.log").string();
+  const auto jsonl = (dir / "logforge_fmt.jsonl").string();
+  {
+    std::ofstream t(text), j(jsonl);
+    for (int i = 0; i < 3000; ++i) {
+      const std::string minute = (i / 100 < 10 ? "0" : "") + std::to_string(i / 100);
+      const std::string path = "/api/" + std::to_string(i % 7);
+      const int status = i % 9 ? 200 : 500;
+      const std::string rt = "0." + std::to_string(100 + i % 800);
+      if (i % 97 == 0) {
+        t << "garbage\n";
+        j << "{not json\n";
+        continue;
+      }
+      t << "10.0.0." << i % 13 << " - - [01/Jan/2025:10:" << minute << ":00 -0300] \"GET " << path
+        << " HTTP/1.1\" " << status << " " << i << " \"-\" \"ua\" " << rt << "\n";
+      j << "{\"remote_addr\":\"10.0.0." << i % 13 << "\",\"time_local\":\"01/Jan/2025:10:" << minute
+        << ":00 -0300\",\"request\":\"GET " << path << " HTTP/1.1\",\"status\":" << status << ",\"body_bytes_sent\":" << i
+        << ",\"request_time\":" << rt << "}\n";
+    }
+  }
+
+  logforge::AggregatorOptions aopt;
+  aopt.endpoint_stats_capacity = 16;
+  aopt.hll_precision = 12;
+  auto run = [&](const std::string& path, const logforge::Parser* parser) {
+    logforge::IngestOptions opt;
+    opt.threads = 2;
+    opt.parser = parser;
+    logforge::Aggregator agg(aopt);
+    REQUIRE(logforge::ingest_file(path, opt, agg));
+    return agg.finalize();
+  };
+  const auto expected = run(text, nullptr);
+  const logforge::StaticFormatParser<logforge::kTimedPlan> timed;
+  const logforge::JsonLinesParser json;
+  for (const auto& r : {run(text, &timed), run(jsonl, &json)}) {
+    CHECK(r.total_lines == expected.total_lines);
+    CHECK(r.invalid_lines == expected.invalid_lines);
+    CHECK(r.status_counts == expected.status_counts);
+    CHECK(r.endpoint_counts == expected.endpoint_counts);
+    CHECK(r.per_minute_counts == expected.per_minute_counts);
+    CHECK(r.latency.p95_ms == expected.latency.p95_ms);
+    CHECK(r.unique_clients == expected.unique_clients);
+  }
+  std::remove(text.c_str());
+  std::remove(jsonl.c_str());
+}
@@ -1,5 +1,9 @@
 #include <catch2/catch_test_macros.hpp>
+
+#include <cstdio>
+
 #include "logforge/parser_nginx.hpp"
+#include "logforge/time_util.hpp"
 
 TEST_CASE("NginxParser parses line without request_time (latency missing)") {
   logforge::NginxParser p;
@@ -12,8 +16,8 @@ TEST_CASE("NginxParser parses line without request_time (latency missing)") {
   REQUIRE(e.has_value());
   CHECK(e->status == 304);
   CHECK(e->endpoint == "/health");
-  CHECK(e->latency_ms == -1);
-  CHECK(e->minute_key == "2000-10-10 13:55");
+  CHECK(e->latency_us == -1);
+  CHECK(logforge::format_minute(e->minute) == "2000-10-10 20:55"); // UTC
 }
 
 TEST_CASE("NginxParser parses IPv6 + query + trailing spaces") {
@@ -27,8 +31,8 @@ TEST_CASE("NginxParser parses IPv6 + query + trailing spaces") {
   REQUIRE(e.has_value());
   CHECK(e->status == 200);
   CHECK(e->endpoint == "/search");
-  CHECK(e->latency_ms == 10);
-  CHECK(e->minute_key == "2025-01-01 00:00");
+  CHECK(e->latency_us == 10000);
+  CHECK(logforge::format_minute(e->minute) == "2025-01-01 03:00");
 }
 
 TEST_CASE("NginxParser parses absolute URL in request path") {
@@ -42,7 +46,113 @@ TEST_CASE("NginxParser parses absolute URL in request path") {
   REQUIRE(e.has_value());
   CHECK(e->status == 200);
   CHECK(e->endpoint == "/api/items");
-  CHECK(e->latency_ms == 123);
-  CHECK(e->minute_key == "2025-01-01 00:00");
+  CHECK(e->latency_us == 123000);
+  CHECK(logforge::format_minute(e->minute) == "2025-01-01 03:00");
+}
+
+TEST_CASE("NginxParser extracts method, client, bytes and user agent") {
+  logforge::NginxParser p;
+
+  const char* line =
+      "10.1.2.3 - - [01/Jan/2025:00:00:59 -0300] "
+      "\"POST /api/items HTTP/1.1\" 201 4521 \"https://ref/\" \"Mozilla/5.0 (X11)\" 0.123";
+  auto e = p.parse_line(line);
+  REQUIRE(e.has_value());
+  CHECK(e->method == "POST");
+  CHECK(e->remote_addr == "10.1.2.3");
+  CHECK(e->bytes == 4521);
+  CHECK(e->user_agent == "Mozilla/5.0 (X11)");
+
+  // Sem bytes ("-") e sem referer/UA: a linha continua válida.
+  e = p.parse_line("::1 - - [01/Jan/2025:00:00:59 -0300] \"GET /x HTTP/1.1\" 304 - 0.002");
+  REQUIRE(e.has_value());
+  CHECK(e->method == "GET");
+  CHECK(e->remote_addr == "::1");
+  CHECK(e->bytes == -1);
+  CHECK(e->user_agent.empty());
+  CHECK(e->latency_us == 2000);
+}
+
+TEST_CASE("NginxParser without client fields skips only their extraction") {
+  const logforge::NginxParser full;
+  const logforge::NginxParser lean(logforge::detect_isa(), false);
+  const char* line =
+      "10.1.2.3 - - [01/Jan/2025:00:00:59 -0300] "
+      "\"POST /api/items?x=1 HTTP/1.1\" 201 4521 \"https://ref/\" \"Mozilla/5.0 (X11)\" 0.123";
+  auto a = full.parse_line(line);
+  auto b = lean.parse_line(line);
+  REQUIRE(a.has_value());
+  REQUIRE(b.has_value());
+  CHECK(b->endpoint == a->endpoint);
+  CHECK(b->status == a->status);
+  CHECK(b->latency_us == a->latency_us);
+  CHECK(b->minute == a->minute);
+  CHECK(b->method.empty());
+  CHECK(b->remote_addr.empty());
+  CHECK(b->bytes == -1);
+  CHECK(b->user_agent.empty());
+  CHECK_FALSE(lean.parse_line("10.1.2.3 - - [01/Jan/2025:00:00:59 -0300] \"POST\" 201 1").has_value());
+}
+
+TEST_CASE("epoch_minute and format_minute round-trip") {
+  CHECK(logforge::epoch_minute(1970, 1, 1, 0, 0) == 0);
+  CHECK(logforge::format_minute(logforge::epoch_minute(2000, 10, 10, 13, 55)) == "2000-10-10 13:55");
+  CHECK(logforge::format_minute(logforge::epoch_minute(2024, 2, 29, 23, 59)) == "2024-02-29 23:59");
+  CHECK(logforge::format_minute(logforge::epoch_minute(1969, 12, 31, 23, 59)) == "1969-12-31 23:59");
+  CHECK(logforge::epoch_minute(2025, 3, 1, 0, 0) - logforge::epoch_minute(2025, 2, 28, 0, 0) == 1440);
 }
 
+TEST_CASE("parse_time_local normalizes the UTC offset") {
+  using logforge::epoch_minute;
+  using logforge::parse_time_local;
+  CHECK(parse_time_local("10/Oct/2000:13:55:36 -0700") == epoch_minute(2000, 10, 10, 20, 55));
+  CHECK(parse_time_local("10/Oct/2000:13:55:36 +0000") == epoch_minute(2000, 10, 10, 13, 55));
+  CHECK(parse_time_local("01/Jan/2025:01:10:00 +0530") == epoch_minute(2024, 12, 31, 19, 40));
+  CHECK(parse_time_local("31/Dec/2024:23:50:00 -0330") == epoch_minute(2025, 1, 1, 3, 20));
+  // Fora da largura fixa: o parse geral, com e sem fuso.
+  CHECK(parse_time_local("1/Oct/2000:13:55:36 -0700") == epoch_minute(2000, 10, 1, 20, 55));
+  CHECK(parse_time_local("10/Oct/2000:13:55") == epoch_minute(2000, 10, 10, 13, 55));
+  CHECK(logforge::parse_time_iso8601("2025-03-01T10:15:59.123-03:00") == epoch_minute(2025, 3, 1, 13, 15));
+  CHECK(logforge::parse_time_iso8601("2025-03-01T10:15:59+0100") == epoch_minute(2025, 3, 1, 9, 15));
+  CHECK(logforge::parse_time_iso8601("2025-03-01T10:15:59Z") == epoch_minute(2025, 3, 1, 10, 15));
+
+  for (const char* bad : {"10/Okt/2000:13:55:36 -0700", "1x/Oct/2000:13:55:36 -0700", "10/Oct/2000 13:55:36 -0700",
+                          "", "10/Oct", "10/Oct/2000:13:55:36 +-530", "1/Oct/2000:13:55:36 +-530",
+                          "1/Oct/2000:13:55:36 +05 3"}) {
+    INFO(bad);
+    CHECK_FALSE(parse_time_local(bad).has_value());
+  }
+  CHECK_FALSE(logforge::parse_time_iso8601("2025-03-01T10:15:59+-5:30").has_value());
+}
+
+TEST_CASE("parse_time_local cache never returns a stale minute") {
+  using logforge::epoch_minute;
+  using logforge::parse_time_local;
+  static const char* kMonths[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+  // Sequência que varia um campo por vez (e às vezes nenhum, só os segundos), comparada com
+  // o valor calculado à parte.
+  unsigned x = 12345;
+  auto next = [&](unsigned n) {
+    x = x * 1103515245u + 12345u;
+    return (x >> 8) % n;
+  };
+  int day = 15, mon = 6, year = 2024, hh = 12, mm = 30, off = -300;
+  for (int i = 0; i < 20000; ++i) {
+    switch (next(8)) {
+      case 0: day = 1 + static_cast<int>(next(28)); break;
+      case 1: mon = 1 + static_cast<int>(next(12)); break;
+      case 2: year = 1990 + static_cast<int>(next(60)); break;
+      case 3: hh = static_cast<int>(next(24)); break;
+      case 4: mm = static_cast<int>(next(60)); break;
+      case 5: off = (static_cast<int>(next(27)) - 12) * 100 + (next(2) ? 30 : 0); break;
+      default: break;
+    }
+    char buf[64]; // folga para o -Wformat-truncation, que não conhece as faixas dos campos
+    std::snprintf(buf, sizeof(buf), "%02d/%s/%04d:%02d:%02d:%02u %c%04d", day, kMonths[mon - 1], year, hh, mm,
+                  next(60), off < 0 ? '-' : '+', off < 0 ? -off : off);
+    const int off_min = (off < 0 ? -1 : 1) * ((off < 0 ? -off : off) / 100 * 60 + (off < 0 ? -off : off) % 100);
+    INFO(buf);
+    REQUIRE(parse_time_local(buf) == epoch_minute(year, mon, day, hh, mm) - off_min);
+    if (next(50) == 0) CHECK_FALSE(parse_time_local("10/Oct/2000:13:55:36 -07x0").has_value());
+  }
+}
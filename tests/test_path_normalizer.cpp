@@ -0,0 +1,48 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+
+#include "logforge/path_normalizer.hpp"
+
+TEST_CASE("PathNormalizer built-in detectors") {
+  logforge::PathNormalizer n;
+  std::string buf;
+
+  CHECK(n.normalize("/api/items/42", buf) == "/api/items/{id}");
+  CHECK(n.normalize("/api/items/42/", buf) == "/api/items/{id}/");
+  CHECK(n.normalize("/users/3f2b6c1e-8a4d-4c1b-9e7f-0a1b2c3d4e5f/orders", buf) == "/users/{uuid}/orders");
+  CHECK(n.normalize("/blobs/9f86d081884c7d659a2feaa0c55ad015", buf) == "/blobs/{hex}");
+  CHECK(n.normalize("/v2/7/9", buf) == "/v2/{id}/{id}");
+
+  // Sem mudanças: devolve o próprio path (sem cópia).
+  const std::string_view same = "/api/checkout";
+  CHECK(n.normalize(same, buf).data() == same.data());
+  CHECK(n.normalize("/", buf) == "/");
+  CHECK(n.normalize("/deadbeef", buf) == "/deadbeef");         // hex curto
+  CHECK(n.normalize("/abcdefabcdefabcdef", buf) == "/abcdefabcdefabcdef"); // sem dígito
+}
+
+TEST_CASE("PathNormalizer user rules take precedence and support ** tails") {
+  logforge::PathNormalizer n;
+  std::string err, buf;
+  REQUIRE(n.add_rule("/api/users/{user}/orders", err));
+  REQUIRE(n.add_rule("/api/users/me/orders", err));
+  REQUIRE(n.add_rule("/static/**", err));
+  REQUIRE(n.add_rule("/shop/{slug}", err));
+  CHECK(n.rule_count() == 4);
+
+  CHECK(n.normalize("/api/users/alice/orders", buf) == "/api/users/{user}/orders");
+  CHECK(n.normalize("/api/users/me/orders", buf) == "/api/users/me/orders");
+  CHECK(n.normalize("/static/js/app.min.js", buf) == "/static/**");
+  CHECK(n.normalize("/shop/red-shoes", buf) == "/shop/{slug}");
+  // Sem regra que case: caem nos detectores.
+  CHECK(n.normalize("/shop/red-shoes/12", buf) == "/shop/red-shoes/{id}");
+
+  CHECK_FALSE(n.add_rule("no-slash", err));
+  CHECK_FALSE(n.add_rule("/a/**/b", err));
+  // Nome de parâmetro divergente na mesma posição de outra regra.
+  REQUIRE(n.add_rule("/users/{user}/orders", err));
+  CHECK(n.add_rule("/users/{user}/cart", err));
+  CHECK_FALSE(n.add_rule("/users/{id}/profile", err));
+  CHECK(err.find("{user}") != std::string::npos);
+}
@@ -0,0 +1,166 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include "logforge/aggregator.hpp"
+#include "logforge/out_buffer.hpp"
+#include "logforge/parser_nginx.hpp"
+#include "logforge/report_writer.hpp"
+#include "logforge/time_util.hpp"
+
+namespace fs = std::filesystem;
+
+static std::string read_file(const fs::path& p) {
+  std::ifstream ifs(p, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+}
+
+TEST_CASE("OutBuffer formats numbers like ostream") {
+  std::mt19937_64 rng(11);
+  std::vector<double> doubles = {0.0, -0.0, 1.0, 0.1, 1e-5, 123456.0, 1234567.0, 1e21, 227.47215, -3.25,
+                                 std::numeric_limits<double>::infinity()};
+  for (int i = 0; i < 2000; ++i) {
+    const double mant = std::uniform_real_distribution<double>(-10.0, 10.0)(rng);
+    doubles.push_back(mant * std::pow(10.0, static_cast<int>(rng() % 24) - 12));
+  }
+  std::vector<std::int64_t> ints = {0, -1, std::numeric_limits<std::int64_t>::min(),
+                                    std::numeric_limits<std::int64_t>::max()};
+  for (int i = 0; i < 2000; ++i) ints.push_back(static_cast<std::int64_t>(rng()) >> (rng() % 63));
+
+  const auto path = fs::temp_directory_path() / "logforge_out_buffer.txt";
+  std::ostringstream expected;
+  logforge::OutBuffer out;
+  REQUIRE(out.open(path.string()));
+  for (double d : doubles) {
+    expected << d << ' ';
+    out << d << ' ';
+  }
+  for (auto v : ints) {
+    expected << v << ',' << static_cast<std::uint64_t>(v) << ',' << static_cast<int>(v) << '\n';
+    out << v << ',' << static_cast<std::uint64_t>(v) << ',' << static_cast<int>(v) << '\n';
+  }
+  REQUIRE(out.close());
+  CHECK(read_file(path) == expected.str());
+  fs::remove(path);
+}
+
+TEST_CASE("OutBuffer handles writes larger than its buffer") {
+  std::string big(3 * logforge::OutBuffer::kCapacity + 17, 'a');
+  for (std::size_t i = 0; i < big.size(); ++i) big[i] = static_cast<char>('a' + i % 26);
+
+  const auto path = fs::temp_directory_path() / "logforge_out_buffer_big.txt";
+  logforge::OutBuffer out;
+  REQUIRE(out.open(path.string()));
+  std::string expected;
+  for (int i = 0; i < 3; ++i) {
+    out << "x" << big << 42;
+    expected += "x" + big + "42";
+  }
+  REQUIRE(out.close());
+  CHECK(read_file(path) == expected);
+  fs::remove(path);
+
+  logforge::OutBuffer closed;
+  closed << "sem arquivo";
+  CHECK_FALSE(closed.close());
+}
+
+TEST_CASE("format_minute into a buffer matches the string version") {
+  char buf[logforge::kMinuteTextMax];
+  for (std::int64_t m : {std::int64_t{0}, std::int64_t{-1}, std::int64_t{28'000'000}, std::int64_t{-100'000'000},
+                         std::int64_t{6'000'000'000}}) {
+    INFO(m);
+    const auto n = logforge::format_minute(m, buf);
+    CHECK(std::string(buf, n) == logforge::format_minute(m));
+  }
+  CHECK(logforge::format_minute(logforge::epoch_minute(2025, 1, 2, 3, 4)) == "2025-01-02 03:04");
+}
+
+static logforge::Report sample_report() {
+  logforge::AggregatorOptions ao;
+  ao.top_n = 3;
+  logforge::Aggregator agg(ao);
+  const logforge::NginxParser p;
+  const std::vector<std::string> lines = {
+      "1.1.1.1 - - [01/Jan/2025:00:12:00 -0300] \"GET /b HTTP/1.1\" 500 5 \"-\" \"x\" 0.5",
+      "1.1.1.1 - - [01/Jan/2025:00:10:00 -0300] \"GET /a HTTP/1.1\" 200 5 \"-\" \"x\" 0.1",
+      "1.1.1.1 - - [01/Jan/2025:00:11:00 -0300] \"GET /a HTTP/1.1\" 404 5 \"-\" \"x\" 0.2",
+      "1.1.1.1 - - [01/Jan/2025:00:10:00 -0300] \"GET /q\\\\uo\\ttab HTTP/1.1\" 200 5 \"-\" \"x\" 0.3",
+  };
+  for (const auto& l : lines) {
+    auto e = p.parse_line(l);
+    REQUIRE(e.has_value());
+    agg.add_valid(*e);
+  }
+  return agg.finalize();
+}
+
+TEST_CASE("write_reports publishes every file atomically with a shared order") {
+  const auto r = sample_report();
+  const auto view = logforge::make_report_view(r, 3);
+  REQUIRE(view.status.size() == 3);
+  CHECK(view.status.front().first == 200);
+  REQUIRE(view.minutes.size() == 3);
+  CHECK(view.minutes[0].first < view.minutes[1].first);
+
+  const auto dir = fs::temp_directory_path() / "logforge_writer_out";
+  fs::remove_all(dir);
+  REQUIRE(logforge::write_reports(r, view, dir.string()));
+
+  std::vector<std::string> names;
+  for (const auto& f : fs::directory_iterator(dir)) names.push_back(f.path().filename().string());
+  for (const auto& n : names) CHECK(n.find(".tmp") == std::string::npos);
+  for (const char* want : {"report.json", "status_counts.csv", "top_endpoints.csv", "requests_per_minute.csv",
+                           "latency_summary.csv"}) {
+    INFO(want);
+    CHECK(fs::exists(dir / want));
+  }
+
+  CHECK(read_file(dir / "status_counts.csv") == "status,count\n200,2\n404,1\n500,1\n");
+  const auto minutes = read_file(dir / "requests_per_minute.csv");
+  CHECK(minutes.find("\"2025-01-01 03:10\",2\n\"2025-01-01 03:11\",1\n\"2025-01-01 03:12\",1\n") !=
+        std::string::npos);
+  const auto json = read_file(dir / "report.json");
+  CHECK(json.find("{\"endpoint\": \"/a\", \"count\": 2}") != std::string::npos);
+  CHECK(json.find("\"minute\": \"2025-01-01 03:10\", \"count\": 2") != std::string::npos);
+  CHECK(json.find("\"/q\\\\\\\\uo\\\\ttab\"") != std::string::npos); // barras escapadas
+
+  // Diretório de saída inválido (é um arquivo): falha sem deixar lixo.
+  const auto file = fs::temp_directory_path() / "logforge_writer_not_a_dir";
+  std::ofstream(file) << "x";
+  CHECK_FALSE(logforge::write_reports(r, view, file.string()));
+  fs::remove(file);
+  fs::remove_all(dir);
+}
+
+TEST_CASE("write_reports follows the umask and keeps the mode of existing files") {
+  const auto r = sample_report();
+  const auto view = logforge::make_report_view(r, 3);
+  const auto dir = fs::temp_directory_path() / "logforge_writer_mode";
+  fs::remove_all(dir);
+  const auto perms = [&](const char* name) { return fs::status(dir / name).permissions() & fs::perms::all; };
+
+  const mode_t old_mask = ::umask(002);
+  const bool ok = logforge::write_reports(r, view, dir.string(), 1);
+  ::umask(old_mask);
+  REQUIRE(ok);
+  const auto group_rw = fs::perms::owner_read | fs::perms::owner_write | fs::perms::group_read |
+                        fs::perms::group_write | fs::perms::others_read;
+  CHECK(perms("report.json") == group_rw);
+
+  // Reescrita (como no --follow): o modo trocado por quem lê continua.
+  fs::permissions(dir / "report.json", fs::perms::owner_read | fs::perms::owner_write);
+  REQUIRE(logforge::write_report_json(r, view, dir.string()));
+  CHECK(perms("report.json") == (fs::perms::owner_read | fs::perms::owner_write));
+  CHECK(perms("status_counts.csv") == group_rw);
+}
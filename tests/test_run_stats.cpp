@@ -0,0 +1,125 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "logforge/ingest.hpp"
+#include "logforge/parser_nginx.hpp"
+#include "logforge/run_stats.hpp"
+
+using logforge::RejectReason;
+
+static const char* kGood =
+    "10.0.0.1 - - [01/Jan/2025:00:10:10 -0300] \"GET /a HTTP/1.1\" 200 12 \"-\" \"curl/8.0\" 0.120";
+
+static std::size_t reason_index(RejectReason r) { return static_cast<std::size_t>(r); }
+
+TEST_CASE("NginxParser reports why a line was rejected") {
+  const logforge::NginxParser p;
+  CHECK(p.reject_reason("garbage line") == RejectReason::MissingBracket);
+  CHECK(p.reject_reason("10.0.0.1 - - [01/Jan/2025:00:10:10 -0300") == RejectReason::MissingBracket);
+  CHECK(p.reject_reason("10.0.0.1 - - [bad] \"GET /a HTTP/1.1\" 200 12") == RejectReason::BadTimestamp);
+  CHECK(p.reject_reason("10.0.0.1 - - [01/Jan/2025:00:10:10 -0300] GET /a HTTP/1.1 200 12") ==
+        RejectReason::MissingQuote);
+  CHECK(p.reject_reason("10.0.0.1 - - [01/Jan/2025:00:10:10 -0300] \"GET\" 200 12") == RejectReason::BadRequest);
+  CHECK(p.reject_reason("10.0.0.1 - - [01/Jan/2025:00:10:10 -0300] \"GET /a HTTP/1.1\" abc 12") ==
+        RejectReason::BadStatus);
+
+  // Toda linha com diagnóstico é de fato recusada pelo parse normal.
+  for (const char* l : {"garbage line", "10.0.0.1 - - [bad] \"GET /a HTTP/1.1\" 200 12",
+                        "10.0.0.1 - - [01/Jan/2025:00:10:10 -0300] \"GET /a HTTP/1.1\" abc 12"}) {
+    INFO(l);
+    CHECK_FALSE(p.parse_line(l).has_value());
+  }
+  CHECK(p.parse_line(kGood).has_value());
+  // Linha que a referência aceita: se o parse a recusou, é divergência, não "outro".
+  CHECK(p.reject_reason(kGood) == RejectReason::Mismatch);
+  for (std::size_t i = 0; i < logforge::kRejectReasons; ++i) {
+    CHECK(std::string(logforge::reject_reason_name(static_cast<RejectReason>(i))).size() > 0);
+  }
+}
+
+TEST_CASE("RunStats keeps a few samples per reason and merges counts") {
+  logforge::RunStats a, b;
+  for (int i = 0; i < 5; ++i) a.reject(RejectReason::BadStatus, "linha " + std::to_string(i));
+  a.reject(RejectReason::Other, std::string(1000, 'x'));
+  b.reject(RejectReason::BadStatus, "outra");
+  b.reject(RejectReason::BadTimestamp, "ts");
+  a.add(logforge::Stage::Parse, 10);
+  b.add(logforge::Stage::Parse, 5);
+
+  CHECK(a.samples.size() == logforge::RunStats::kSamplesPerReason + 1);
+  CHECK(a.samples.back().line.size() == logforge::RunStats::kSampleChars);
+
+  a.merge(b);
+  CHECK(a.rejects[reason_index(RejectReason::BadStatus)] == 6);
+  CHECK(a.rejects[reason_index(RejectReason::BadTimestamp)] == 1);
+  CHECK(a.ticks[static_cast<std::size_t>(logforge::Stage::Parse)] == 15);
+  // BadStatus já tinha o máximo de amostras; só a de BadTimestamp entra.
+  CHECK(a.samples.size() == logforge::RunStats::kSamplesPerReason + 2);
+  CHECK(a.samples.back().reason == RejectReason::BadTimestamp);
+}
+
+TEST_CASE("Reject breakdown matches in batch and line-by-line modes") {
+  const auto path = (std::filesystem::temp_directory_path() / "logforge_run_stats.log").string();
+  {
+    std::ofstream ofs(path);
+    for (int i = 0; i < 2000; ++i) {
+      switch (i % 10) {
+        case 3: ofs << "garbage line " << i << "\n"; break;
+        case 6: ofs << "10.0.0.1 - - [01/Jan/2025:00:10:10 -0300] \"GET /a HTTP/1.1\" x" << i << " 1\n"; break;
+        default: ofs << kGood << "\n";
+      }
+    }
+  }
+
+  for (bool batch : {true, false}) {
+    INFO("batch " << batch);
+    logforge::AggregatorOptions ao;
+    ao.stats = true;
+    logforge::Aggregator agg(ao);
+    logforge::IngestOptions opt;
+    opt.batch = batch;
+    opt.threads = 2;
+    REQUIRE(logforge::ingest_file(path, opt, agg));
+    const auto r = agg.finalize();
+    CHECK(r.invalid_lines == 400);
+
+    const logforge::RunStats* st = agg.stats();
+    if (!logforge::kStatsCompiled) {
+      CHECK(st == nullptr);
+      continue;
+    }
+    REQUIRE(st != nullptr);
+    CHECK(st->rejects[reason_index(RejectReason::MissingBracket)] == 200);
+    CHECK(st->rejects[reason_index(RejectReason::BadStatus)] == 200);
+    CHECK(st->samples.size() == 2 * logforge::RunStats::kSamplesPerReason);
+    CHECK(st->ticks[static_cast<std::size_t>(logforge::Stage::Parse)] > 0);
+    CHECK(st->ticks[static_cast<std::size_t>(logforge::Stage::Aggregate)] > 0);
+  }
+
+  // Sem a opção, nada é medido.
+  logforge::Aggregator plain;
+  REQUIRE(logforge::ingest_file(path, logforge::IngestOptions{}, plain));
+  CHECK(plain.stats() == nullptr);
+  std::remove(path.c_str());
+}
+
+TEST_CASE("table_stats reports the aggregator structures") {
+  logforge::AggregatorOptions ao;
+  ao.stats = true;
+  logforge::Aggregator agg(ao);
+  const logforge::NginxParser p;
+  agg.add_valid(*p.parse_line(kGood));
+  bool endpoints = false;
+  for (const auto& t : agg.table_stats()) {
+    if (t.name == "endpoints") {
+      endpoints = true;
+      CHECK(t.size == 1);
+      CHECK(t.capacity >= t.size);
+    }
+  }
+  CHECK(endpoints);
+}
@@ -0,0 +1,199 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "logforge/snapshot.hpp"
+#include "logforge/time_util.hpp"
+
+static const std::int64_t kMin0 = logforge::epoch_minute(2025, 1, 1, 0, 0);
+
+static std::string temp_path(const std::string& name) {
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+static logforge::AggregatorOptions full_options(logforge::TopKMode mode) {
+  logforge::AggregatorOptions opt;
+  opt.top_n = 7;
+  opt.quantiles = {0.999};
+  opt.endpoint_stats_capacity = 16;
+  opt.topk_mode = mode;
+  opt.topk_capacity = 32;
+  opt.windows.width_min = 5;
+  opt.windows.ring = 3;
+  opt.windows.sliding = 2;
+  return opt;
+}
+
+static void feed(logforge::Aggregator& agg, int from, int to) {
+  std::vector<std::string> eps;
+  for (int i = 0; i < 50; ++i) eps.push_back("/ep/" + std::to_string(i));
+  for (int i = from; i < to; ++i) {
+    if (i % 11 == 0) {
+      agg.add_invalid();
+      continue;
+    }
+    logforge::LogEntry e;
+    e.endpoint = eps[(i * i) % (i % 3 ? 5 : 50)];
+    e.status = (i % 9 == 0) ? 502 : (i % 4 ? 200 : 404);
+    e.latency_us = (i % 13 == 0) ? -1 : 500 + (i * 7919) % 250000;
+    e.minute = kMin0 + i / 30;
+    agg.add_valid(e);
+  }
+}
+
+static void check_same(const logforge::Report& a, const logforge::Report& b) {
+  CHECK(a.total_lines == b.total_lines);
+  CHECK(a.parsed_lines == b.parsed_lines);
+  CHECK(a.invalid_lines == b.invalid_lines);
+  CHECK(a.status_counts == b.status_counts);
+  CHECK(a.endpoint_counts == b.endpoint_counts);
+  CHECK(a.endpoint_count_errors == b.endpoint_count_errors);
+  CHECK(a.per_minute_counts == b.per_minute_counts);
+  CHECK(a.latency.p99_ms == b.latency.p99_ms);
+  CHECK(a.latency.quantiles == b.latency.quantiles);
+  REQUIRE(a.endpoint_latency.size() == b.endpoint_latency.size());
+  for (std::size_t i = 0; i < a.endpoint_latency.size(); ++i) {
+    CHECK(a.endpoint_latency[i].endpoint == b.endpoint_latency[i].endpoint);
+    CHECK(a.endpoint_latency[i].p95_ms == b.endpoint_latency[i].p95_ms);
+  }
+  REQUIRE(a.windows.size() == b.windows.size());
+  for (std::size_t i = 0; i < a.windows.size(); ++i) {
+    CHECK(a.windows[i].count == b.windows[i].count);
+    CHECK(a.windows[i].p99_ms == b.windows[i].p99_ms);
+    CHECK(a.windows[i].sliding_p99_ms == b.windows[i].sliding_p99_ms);
+  }
+  CHECK(a.window_late == b.window_late);
+}
+
+TEST_CASE("Aggregator state round-trips through a snapshot file") {
+  for (auto mode : {logforge::TopKMode::Exact, logforge::TopKMode::Approx}) {
+    logforge::Aggregator agg(full_options(mode));
+    feed(agg, 0, 3000);
+
+    const auto path = temp_path("logforge_roundtrip.snap");
+    REQUIRE(logforge::write_snapshot(agg, path));
+
+    logforge::Aggregator loaded;
+    std::string err;
+    REQUIRE(logforge::read_snapshot(path, loaded, err));
+    CHECK(loaded.top_n() == 7);
+    check_same(agg.finalize(), loaded.finalize());
+
+    // O estado carregado continua agregando como o original.
+    feed(agg, 3000, 3500);
+    feed(loaded, 3000, 3500);
+    check_same(agg.finalize(), loaded.finalize());
+  }
+}
+
+TEST_CASE("Merging snapshots equals aggregating everything at once") {
+  const auto opt = full_options(logforge::TopKMode::Exact);
+  logforge::Aggregator all(opt), a(opt), b(opt), c(opt);
+  feed(all, 0, 3000);
+  feed(a, 0, 1000);
+  feed(b, 1000, 2000);
+  feed(c, 2000, 3000);
+
+  std::vector<std::string> paths = {temp_path("logforge_a.snap"), temp_path("logforge_b.snap"),
+                                    temp_path("logforge_c.snap")};
+  REQUIRE(logforge::write_snapshot(a, paths[0]));
+  REQUIRE(logforge::write_snapshot(b, paths[1]));
+  REQUIRE(logforge::write_snapshot(c, paths[2]));
+
+  logforge::Aggregator merged;
+  std::string err;
+  REQUIRE(logforge::merge_snapshots(paths, merged, err));
+  auto r1 = all.finalize();
+  auto r2 = merged.finalize();
+  CHECK(r2.total_lines == 3000);
+  CHECK(r2.status_counts == r1.status_counts);
+  CHECK(r2.endpoint_counts == r1.endpoint_counts);
+  CHECK(r2.per_minute_counts == r1.per_minute_counts);
+  CHECK(r2.latency.p99_ms == r1.latency.p99_ms);
+
+  // Configuração diferente: o merge perderia dados, então é recusado.
+  auto other = opt;
+  other.latency_error = 0.05;
+  logforge::Aggregator d(other);
+  feed(d, 0, 10);
+  REQUIRE(logforge::write_snapshot(d, temp_path("logforge_d.snap")));
+  CHECK_FALSE(logforge::merge_snapshots({paths[0], temp_path("logforge_d.snap")}, merged, err));
+
+  // Capacidades do top-K aproximado / --endpoint-stats diferentes: o limite de erro por
+  // entrada não valeria depois do merge.
+  for (auto [es_cap, topk_cap] : {std::pair<std::size_t, std::size_t>{17, 32}, {16, 64}}) {
+    auto cap = opt;
+    cap.endpoint_stats_capacity = es_cap;
+    cap.topk_capacity = topk_cap;
+    logforge::Aggregator e(cap);
+    feed(e, 0, 10);
+    INFO(es_cap << " / " << topk_cap);
+    CHECK_FALSE(a.mergeable_with(e));
+    REQUIRE(logforge::write_snapshot(e, temp_path("logforge_e.snap")));
+    CHECK_FALSE(logforge::merge_snapshots({paths[0], temp_path("logforge_e.snap")}, merged, err));
+  }
+  // No modo exato a capacidade do top-K não é usada.
+  logforge::AggregatorOptions exact, exact_cap;
+  exact_cap.topk_capacity = 5;
+  CHECK(logforge::Aggregator(exact).mergeable_with(logforge::Aggregator(exact_cap)));
+}
+
+TEST_CASE("A failed snapshot write leaves no temporary file behind") {
+  logforge::Aggregator agg(full_options(logforge::TopKMode::Exact));
+  feed(agg, 0, 100);
+  // O destino é um diretório: o rename falha.
+  const auto path = temp_path("logforge_dir.snap");
+  std::filesystem::remove_all(path);
+  std::filesystem::create_directories(path + "/x");
+  CHECK_FALSE(logforge::write_snapshot(agg, path));
+  CHECK_FALSE(std::filesystem::exists(path + ".tmp"));
+  std::filesystem::remove_all(path);
+}
+
+TEST_CASE("Corrupt, truncated and foreign snapshot files are rejected") {
+  logforge::Aggregator agg(full_options(logforge::TopKMode::Exact));
+  feed(agg, 0, 500);
+  const auto path = temp_path("logforge_bad.snap");
+  REQUIRE(logforge::write_snapshot(agg, path));
+
+  std::string bytes;
+  {
+    std::ifstream ifs(path, std::ios::binary);
+    bytes.assign(std::istreambuf_iterator<char>(ifs), {});
+  }
+  auto write = [&](const std::string& data) {
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    ofs << data;
+  };
+
+  logforge::Aggregator out;
+  std::string err;
+
+  auto flipped = bytes;
+  flipped[flipped.size() / 2] ^= 0x40;
+  write(flipped);
+  CHECK_FALSE(logforge::read_snapshot(path, out, err));
+
+  write(bytes.substr(0, bytes.size() - 3));
+  CHECK_FALSE(logforge::read_snapshot(path, out, err));
+
+  auto other_version = bytes;
+  other_version[6] = 9;
+  write(other_version);
+  CHECK_FALSE(logforge::read_snapshot(path, out, err));
+
+  // Versões anteriores à 5 têm minutos no horário local: recusadas, com o motivo.
+  other_version[6] = 4;
+  write(other_version);
+  CHECK_FALSE(logforge::read_snapshot(path, out, err));
+  CHECK(err.find("versão antiga") != std::string::npos);
+
+  write("not a snapshot at all, just text\n");
+  CHECK_FALSE(logforge::read_snapshot(path, out, err));
+  CHECK_FALSE(err.empty());
+
+  CHECK_FALSE(logforge::read_snapshot(temp_path("logforge_missing.snap"), out, err));
+}
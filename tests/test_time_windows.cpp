@@ -0,0 +1,181 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "logforge/aggregator.hpp"
+#include "logforge/time_util.hpp"
+#include "logforge/time_windows.hpp"
+
+static const std::int64_t kMin0 = logforge::epoch_minute(2025, 1, 1, 0, 0);
+
+static logforge::WindowOptions windows(int width, std::size_t ring, int sliding = 0, bool keep = true) {
+  logforge::WindowOptions w;
+  w.width_min = width;
+  w.ring = ring;
+  w.sliding = sliding;
+  w.keep_closed = keep;
+  return w;
+}
+
+TEST_CASE("Tumbling windows carry status classes and latency per window") {
+  logforge::TimeWindows tw(windows(5, 4));
+  tw.add(kMin0 + 0, 200, 10'000);
+  tw.add(kMin0 + 4, 500, 20'000);
+  tw.add(kMin0 + 5, 200, 30'000);
+  tw.add(kMin0 + 12, 404, -1);
+
+  const auto rows = tw.rows();
+  REQUIRE(rows.size() == 3);
+  CHECK(rows[0].start_minute == kMin0);
+  CHECK(rows[0].count == 2);
+  CHECK(rows[0].status_classes[1] == 1);
+  CHECK(rows[0].status_classes[4] == 1);
+  CHECK(rows[0].error_rate == 0.5);
+  CHECK(rows[0].rps == 2.0 / 300.0);
+  CHECK(rows[1].start_minute == kMin0 + 5);
+  CHECK(rows[1].p99_ms > 29.0);
+  CHECK(rows[1].p99_ms < 31.0);
+  CHECK(rows[2].start_minute == kMin0 + 10);
+  CHECK(rows[2].p50_ms == -1.0); // sem latência
+}
+
+TEST_CASE("Ring evicts old windows; late lines join closed windows or count as late") {
+  logforge::TimeWindows keep(windows(1, 3));
+  logforge::TimeWindows drop(windows(1, 3, 0, false));
+  for (auto* tw : {&keep, &drop}) {
+    for (int m = 0; m < 10; ++m) tw->add(kMin0 + m, 200, 1000);
+    tw->add(kMin0 + 8, 200, 1000); // fora de ordem, ainda no anel
+    tw->add(kMin0 + 2, 200, 1000); // atrasada demais
+  }
+
+  // Batch: a linha atrasada entra na janela dela, já fechada.
+  const auto kept = keep.rows();
+  REQUIRE(kept.size() == 10);
+  CHECK(kept[2].count == 2);
+  CHECK(keep.closed_count() == 7);
+  CHECK(keep.late() == 0);
+
+  const auto rows = drop.rows();
+  REQUIRE(rows.size() == 3); // só o anel
+  CHECK(rows[0].start_minute == kMin0 + 7);
+  CHECK(rows[1].count == 2);
+  CHECK(drop.closed_count() == 0);
+  CHECK(drop.late() == 1);
+}
+
+TEST_CASE("Sliding aggregate spans the last K windows including gaps") {
+  logforge::TimeWindows tw(windows(1, 8, 3));
+  tw.add(kMin0 + 0, 200, 1000);
+  tw.add(kMin0 + 1, 500, 1000);
+  tw.add(kMin0 + 2, 200, 1000);
+  tw.add(kMin0 + 4, 200, 1000);
+
+  const auto rows = tw.rows();
+  REQUIRE(rows.size() == 4);
+  CHECK(rows[2].sliding_count == 3);
+  CHECK(rows[2].sliding_error_rate * 3 == 1.0);
+  CHECK(rows[3].sliding_count == 2); // janelas 2..4 (a 3 está vazia)
+  CHECK(rows[3].sliding_rps == 2.0 / 180.0);
+}
+
+TEST_CASE("Window merge equals serial processing") {
+  logforge::AggregatorOptions opt;
+  opt.windows = windows(1, 4, 2);
+
+  logforge::Aggregator all(opt), left(opt), right(opt);
+  for (int i = 0; i < 400; ++i) {
+    logforge::LogEntry e;
+    e.endpoint = "/a";
+    e.status = (i % 7 == 0) ? 503 : 200;
+    e.latency_us = 1000 + 37 * i;
+    e.minute = kMin0 + i / 20;
+    all.add_valid(e);
+    (i < 170 ? left : right).add_valid(e);
+  }
+  left.merge(right);
+
+  const auto r1 = all.finalize();
+  const auto r2 = left.finalize();
+  REQUIRE(r1.windows_enabled);
+  REQUIRE(r2.windows.size() == r1.windows.size());
+  CHECK(r1.windows.size() == 20);
+  for (std::size_t i = 0; i < r1.windows.size(); ++i) {
+    INFO("window " << i);
+    CHECK(r2.windows[i].start_minute == r1.windows[i].start_minute);
+    CHECK(r2.windows[i].count == r1.windows[i].count);
+    CHECK(r2.windows[i].status_classes[4] == r1.windows[i].status_classes[4]);
+    CHECK(r2.windows[i].p99_ms == r1.windows[i].p99_ms);
+    CHECK(r2.windows[i].sliding_p99_ms == r1.windows[i].sliding_p99_ms);
+  }
+}
+
+TEST_CASE("Windows over shuffled input do not depend on the number of shards") {
+  logforge::AggregatorOptions opt;
+  opt.windows = windows(5, 4, 3);
+  opt.windows.hll_precision = 10;
+  opt.hll_precision = 10;
+
+  std::vector<logforge::LogEntry> entries(6000);
+  for (std::size_t i = 0; i < entries.size(); ++i) {
+    auto& e = entries[i];
+    e.endpoint = "/a";
+    e.status = (i % 11 == 0) ? 500 : 200;
+    e.latency_us = 500 + 13 * static_cast<std::int64_t>(i % 997);
+    e.minute = kMin0 + static_cast<std::int64_t>(i / 20);
+    e.remote_addr = (i % 3 == 0) ? "10.0.0.1" : "10.0.0.2";
+  }
+  std::mt19937 rng(7);
+  std::shuffle(entries.begin(), entries.end(), rng); // muito fora de ordem: quase tudo atrasado
+
+  logforge::Aggregator serial(opt);
+  for (const auto& e : entries) serial.add_valid(e);
+  const auto r1 = serial.finalize();
+  REQUIRE(r1.windows.size() == 60);
+  CHECK(r1.window_late == 0);
+
+  for (std::size_t shards : {2u, 4u, 7u}) {
+    // Fatias contíguas, como as threads do ingest.
+    std::vector<std::unique_ptr<logforge::Aggregator>> parts;
+    for (std::size_t s = 0; s < shards; ++s) parts.push_back(std::make_unique<logforge::Aggregator>(opt));
+    for (std::size_t i = 0; i < entries.size(); ++i) parts[i * shards / entries.size()]->add_valid(entries[i]);
+    for (std::size_t s = 1; s < shards; ++s) parts[0]->merge(*parts[s]);
+    const auto r2 = parts[0]->finalize();
+    INFO("shards " << shards);
+    CHECK(r2.window_late == 0);
+    REQUIRE(r2.windows.size() == r1.windows.size());
+    for (std::size_t i = 0; i < r1.windows.size(); ++i) {
+      INFO("window " << i);
+      const auto &a = r1.windows[i], &b = r2.windows[i];
+      CHECK(b.start_minute == a.start_minute);
+      CHECK(b.count == a.count);
+      CHECK(std::equal(a.status_classes, a.status_classes + 5, b.status_classes));
+      CHECK(b.p50_ms == a.p50_ms);
+      CHECK(b.p99_ms == a.p99_ms);
+      CHECK(b.sliding_count == a.sliding_count);
+      CHECK(b.sliding_p99_ms == a.sliding_p99_ms);
+      CHECK(b.unique_clients == a.unique_clients);
+      CHECK(b.sliding_unique_clients == a.sliding_unique_clients);
+    }
+  }
+
+  // As linhas atrasadas ainda não juntadas às fechadas sobrevivem ao serialize.
+  logforge::TimeWindows tw(opt.windows);
+  for (const auto& e : entries) tw.add(e.minute, e.status, e.latency_us);
+  std::string buf;
+  tw.serialize(buf);
+  logforge::TimeWindows back(opt.windows);
+  std::string_view in = buf;
+  REQUIRE(back.deserialize(in));
+  CHECK(in.empty());
+  const auto ra = tw.rows(), rb = back.rows();
+  REQUIRE(ra.size() == rb.size());
+  for (std::size_t i = 0; i < ra.size(); ++i) {
+    CHECK(rb[i].count == ra[i].count);
+    CHECK(rb[i].p95_ms == ra[i].p95_ms);
+  }
+  CHECK(back.closed_count() == tw.closed_count());
+}